@@ -0,0 +1,207 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/CrowdBackendBase.h"
+
+#include "Algo/StableSort.h"
+#include "FiniteStateMachine/FiniteStateMachineLog.h"
+
+void FFSM_CrowdBackendBase::OnActiveStateChanged(int32 AgentIndex, int32 PreviousStateIndex, int32 NewStateIndex)
+{
+	// Empty
+}
+
+void FFSM_CrowdBackendBase::ApplyTransitionRequests()
+{
+	// Transitions requested by the events are performed in the next iteration
+	for (int32 Iteration = 0; !TransitionRequests.IsEmpty(); Iteration++)
+	{
+		if (Iteration >= MaxTransitionIterations)
+		{
+			FSM_LOG(Warning, "Crowd events keep requesting transitions. [%d] requests have been dropped.",
+				TransitionRequests.Num());
+			TransitionRequests.Reset();
+			break;
+		}
+
+		Swap(TransitionRequests, TransitionRequestsBatch);
+		for (const FTransitionRequest& Request : TransitionRequestsBatch)
+		{
+			FAgentState Agent;
+			if (!GetAgentState(Request.AgentIndex, Agent))
+			{
+				continue;
+			}
+
+			const int32 PreviousState = *Agent.StackDepth > 0 ? *Agent.ActiveState : INDEX_NONE;
+			ApplyTransitionRequest(Request, Agent);
+
+			const int32 NewState = *Agent.StackDepth > 0 ? *Agent.ActiveState : INDEX_NONE;
+			if (NewState != PreviousState)
+			{
+				OnActiveStateChanged(Request.AgentIndex, PreviousState, NewState);
+			}
+		}
+
+		TransitionRequestsBatch.Reset();
+		DispatchPendingEvents();
+	}
+}
+
+void FFSM_CrowdBackendBase::ForEachChunk(TConstArrayView<int32> Agents, float DeltaTime,
+	TFunctionRef<void(const FFSM_CrowdChunk& Chunk)> Function)
+{
+	FFSM_CrowdChunk Chunk;
+	Chunk.Backend = this;
+	Chunk.DeltaTime = DeltaTime;
+
+	for (int32 ChunkStart = 0; ChunkStart < Agents.Num(); ChunkStart += ChunkSize)
+	{
+		Chunk.Agents = Agents.Slice(ChunkStart, FMath::Min(ChunkSize, Agents.Num() - ChunkStart));
+		Function(Chunk);
+	}
+}
+
+void FFSM_CrowdBackendBase::EmptyTransitionRequests()
+{
+	TransitionRequests.Empty();
+	TransitionRequestsBatch.Empty();
+	PendingEvents.Empty();
+	EventAgents.Empty();
+}
+
+void FFSM_CrowdBackendBase::ApplyTransitionRequest(const FTransitionRequest& Request, const FAgentState& Agent)
+{
+	const int32 AgentIndex = Request.AgentIndex;
+	uint8& StackDepth = *Agent.StackDepth;
+
+	// Backends may store the initial state of an agent as its active one before it begins
+	const bool bHasActiveState = StackDepth > 0;
+	const int32 ActiveState = *Agent.ActiveState;
+
+	switch (Request.Type)
+	{
+	case ETransitionType::Goto:
+		if (bHasActiveState)
+		{
+			PendingEvents.Add({ AgentIndex, ActiveState, EStateAction::End });
+		}
+		else
+		{
+			StackDepth = 1;
+		}
+		break;
+
+	case ETransitionType::GotoLabel:
+		// The state has changed since the request
+		if (bHasActiveState && ActiveState == Request.StateIndex)
+		{
+			*Agent.ActiveLabel = Request.LabelIndex;
+			*Agent.LabelTime = 0.f;
+		}
+		return;
+
+	case ETransitionType::Push:
+		if (StackDepth >= MaxStackDepth)
+		{
+			FSM_LOG(Warning, "Crowd agent [%d] of backend [%s] can't push state [%s]; its stack is full.", AgentIndex,
+				*GetBackendName().ToString(), *GetStateByIndex(Request.StateIndex)->GetClass()->GetName());
+			return;
+		}
+
+		if (bHasActiveState)
+		{
+			Agent.StackStates[StackDepth - 1] = ActiveState;
+			Agent.StackLabels[StackDepth - 1] = *Agent.ActiveLabel;
+			PendingEvents.Add({ AgentIndex, ActiveState, EStateAction::Pause });
+		}
+
+		StackDepth++;
+		break;
+
+	case ETransitionType::Pop:
+		if (!bHasActiveState)
+		{
+			return;
+		}
+
+		PendingEvents.Add({ AgentIndex, ActiveState, EStateAction::End });
+		StackDepth--;
+
+		if (StackDepth > 0)
+		{
+			const int32 ResumedState = Agent.StackStates[StackDepth - 1];
+			*Agent.ActiveState = ResumedState;
+			*Agent.ActiveLabel = Agent.StackLabels[StackDepth - 1];
+			PendingEvents.Add({ AgentIndex, ResumedState, EStateAction::Resume });
+		}
+		else
+		{
+			// Don't begin it again as an initial state
+			*Agent.ActiveState = INDEX_NONE;
+			*Agent.ActiveLabel = INDEX_NONE;
+		}
+
+		// Timers are not kept for the paused states
+		*Agent.StateTime = 0.f;
+		*Agent.LabelTime = 0.f;
+		return;
+	}
+
+	// Goto and Push activate the requested state
+	*Agent.ActiveState = Request.StateIndex;
+	*Agent.ActiveLabel = Request.LabelIndex;
+	*Agent.StateTime = 0.f;
+	*Agent.LabelTime = 0.f;
+	PendingEvents.Add({ AgentIndex, Request.StateIndex, EStateAction::Begin });
+}
+
+void FFSM_CrowdBackendBase::DispatchPendingEvents()
+{
+	if (PendingEvents.IsEmpty())
+	{
+		return;
+	}
+
+	// Agents leave their states before entering the new ones; the order among the agents is kept
+	auto GetActionOrder = [] (EStateAction Action)
+	{
+		switch (Action)
+		{
+		case EStateAction::End: return 0;
+		case EStateAction::Pause: return 1;
+		case EStateAction::Resume: return 2;
+		default: return 3;
+		}
+	};
+
+	Algo::StableSort(PendingEvents, [&GetActionOrder] (const FPendingEvent& Lhs, const FPendingEvent& Rhs)
+	{
+		const int32 LhsOrder = GetActionOrder(Lhs.Action);
+		const int32 RhsOrder = GetActionOrder(Rhs.Action);
+		return LhsOrder != RhsOrder ? LhsOrder < RhsOrder : Lhs.StateIndex < Rhs.StateIndex;
+	});
+
+	for (int32 GroupStart = 0; GroupStart < PendingEvents.Num(); )
+	{
+		const FPendingEvent& First = PendingEvents[GroupStart];
+
+		EventAgents.Reset();
+		int32 GroupEnd = GroupStart;
+		for (; GroupEnd < PendingEvents.Num() && PendingEvents[GroupEnd].StateIndex == First.StateIndex &&
+			PendingEvents[GroupEnd].Action == First.Action; GroupEnd++)
+		{
+			EventAgents.Add(PendingEvents[GroupEnd].AgentIndex);
+		}
+
+		UCrowdMachineState* State = GetStateByIndex(First.StateIndex);
+		const EStateAction Action = First.Action;
+		ForEachChunk(EventAgents, 0.f, [State, Action] (const FFSM_CrowdChunk& Chunk)
+		{
+			State->DispatchEvent(Action, Chunk);
+		});
+
+		GroupStart = GroupEnd;
+	}
+
+	PendingEvents.Reset();
+}
@@ -0,0 +1,133 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/CrowdMachineState.h"
+
+#include "FiniteStateMachine/FiniteStateMachineLog.h"
+
+int32 FFSM_CrowdChunk::Num() const
+{
+	return Agents.Num();
+}
+
+int32 FFSM_CrowdChunk::GetAgentIndex(int32 i) const
+{
+	return Agents[i];
+}
+
+float FFSM_CrowdChunk::GetStateTime(int32 i) const
+{
+	return Backend->GetStateTime(Agents[i]);
+}
+
+float FFSM_CrowdChunk::GetLabelTime(int32 i) const
+{
+	return Backend->GetLabelTime(Agents[i]);
+}
+
+void FFSM_CrowdChunk::GotoState(int32 i, TSubclassOf<UCrowdMachineState> InStateClass, FGameplayTag Label) const
+{
+	Backend->RequestGotoState(Agents[i], InStateClass, Label);
+}
+
+void FFSM_CrowdChunk::GotoLabel(int32 i, FGameplayTag Label) const
+{
+	Backend->RequestGotoLabel(Agents[i], Label);
+}
+
+void FFSM_CrowdChunk::PushState(int32 i, TSubclassOf<UCrowdMachineState> InStateClass, FGameplayTag Label) const
+{
+	Backend->RequestPushState(Agents[i], InStateClass, Label);
+}
+
+void FFSM_CrowdChunk::PopState(int32 i) const
+{
+	Backend->RequestPopState(Agents[i]);
+}
+
+UCrowdMachineState::UCrowdMachineState()
+{
+	// Default place to register all your labels
+	REGISTER_LABEL(Default);
+}
+
+bool UCrowdMachineState::ContainsLabel(FGameplayTag Label) const
+{
+	return RegisteredLabels.Contains(Label);
+}
+
+const TArray<FGameplayTag>& UCrowdMachineState::GetRegisteredLabels() const
+{
+	return RegisteredLabels;
+}
+
+int32 UCrowdMachineState::FindLabelIndex(FGameplayTag Label) const
+{
+	return RegisteredLabels.IndexOfByKey(Label);
+}
+
+void UCrowdMachineState::ExecuteLabel(int32 LabelIndex, const FFSM_CrowdChunk& Chunk)
+{
+	LabelFunctions[LabelIndex].Execute(Chunk);
+}
+
+void UCrowdMachineState::DispatchEvent(EStateAction Action, const FFSM_CrowdChunk& Chunk)
+{
+	switch (Action)
+	{
+	case EStateAction::Begin: OnBegan(Chunk); break;
+	case EStateAction::End: OnEnded(Chunk); break;
+	case EStateAction::Pause: OnPaused(Chunk); break;
+	case EStateAction::Resume: OnResumed(Chunk); break;
+	default: checkNoEntry();
+	}
+}
+
+bool UCrowdMachineState::RegisterLabel(FGameplayTag Label, const FLabelSignature& Callback)
+{
+	if (!UMachineState::IsLabelTagCorrect(Label))
+	{
+		FSM_LOG(Warning, "Label [%s] is of wrong tag hierarchy.", *Label.ToString());
+		return false;
+	}
+
+	if (!Callback.IsBound())
+	{
+		FSM_LOG(Warning, "Label [%s]'s callback is not bound.", *Label.ToString());
+		return false;
+	}
+
+	if (ContainsLabel(Label))
+	{
+		FSM_LOG(Warning, "Label [%s] is already present in state [%s].", *Label.ToString(), *GetName());
+		return false;
+	}
+
+	RegisteredLabels.Add(Label);
+	LabelFunctions.Add(Callback);
+	return true;
+}
+
+void UCrowdMachineState::Label_Default(const FFSM_CrowdChunk& Chunk)
+{
+	// Empty
+}
+
+void UCrowdMachineState::OnBegan(const FFSM_CrowdChunk& Chunk)
+{
+	// Empty
+}
+
+void UCrowdMachineState::OnEnded(const FFSM_CrowdChunk& Chunk)
+{
+	// Empty
+}
+
+void UCrowdMachineState::OnPaused(const FFSM_CrowdChunk& Chunk)
+{
+	// Empty
+}
+
+void UCrowdMachineState::OnResumed(const FFSM_CrowdChunk& Chunk)
+{
+	// Empty
+}
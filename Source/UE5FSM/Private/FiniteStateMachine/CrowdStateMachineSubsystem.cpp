@@ -0,0 +1,547 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/CrowdStateMachineSubsystem.h"
+
+#include "Engine/World.h"
+#include "FiniteStateMachine/FiniteStateMachineLog.h"
+
+DECLARE_CYCLE_STAT(TEXT("Tick crowd"), STAT_FSM_TickCrowd, STATGROUP_FiniteStateMachine);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd agents"), STAT_FSM_CrowdAgents, STATGROUP_FiniteStateMachine);
+
+const FName UCrowdStateMachineSubsystem::BackendName = "Subsystem";
+
+void UCrowdStateMachineSubsystem::Deinitialize()
+{
+	States.Empty();
+	StateIndices.Empty();
+	StateBucketOffsets.Empty();
+	StateAgentsNums.Empty();
+	Serials.Empty();
+	AgentsInUse.Empty();
+	AgentsPendingRemoval.Empty();
+	ActiveStates.Empty();
+	ActiveLabels.Empty();
+	StateTimes.Empty();
+	LabelTimes.Empty();
+	StackDepths.Empty();
+	StackStates.Empty();
+	StackLabels.Empty();
+	FreeAgentIndices.Empty();
+	SortedAgents.Empty();
+	BucketOffsets.Empty();
+	BucketCursors.Empty();
+	PendingRemovals.Empty();
+	EmptyTransitionRequests();
+	AgentsNum = 0;
+
+	Super::Deinitialize();
+}
+
+void UCrowdStateMachineSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_FSM_CrowdAgents, AgentsNum);
+	if (AgentsNum == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_FSM_TickCrowd);
+
+	SortAgentsByLabel();
+
+	// States registered while processing have no agents in them yet
+	const int32 StatesNum = StateBucketOffsets.Num();
+
+	bIsProcessing = true;
+	for (int32 StateIndex = 0; StateIndex < StatesNum; StateIndex++)
+	{
+		UCrowdMachineState* State = States[StateIndex];
+		for (int32 LabelIndex = 0; LabelIndex < State->GetRegisteredLabels().Num(); LabelIndex++)
+		{
+			const int32 Bucket = StateBucketOffsets[StateIndex] + LabelIndex;
+			const int32 BucketStart = BucketOffsets[Bucket];
+			const int32 BucketNum = BucketOffsets[Bucket + 1] - BucketStart;
+			if (BucketNum == 0)
+			{
+				continue;
+			}
+
+			ForEachChunk(TConstArrayView<int32>(SortedAgents).Slice(BucketStart, BucketNum), DeltaTime,
+				[State, LabelIndex] (const FFSM_CrowdChunk& Chunk)
+				{
+					State->ExecuteLabel(LabelIndex, Chunk);
+				});
+		}
+	}
+	bIsProcessing = false;
+
+	// Free slots are advanced as well; they're reset when reused
+	const int32 SlotsNum = StateTimes.Num();
+	float* RESTRICT StateTimesData = StateTimes.GetData();
+	float* RESTRICT LabelTimesData = LabelTimes.GetData();
+	for (int32 i = 0; i < SlotsNum; i++)
+	{
+		StateTimesData[i] += DeltaTime;
+		LabelTimesData[i] += DeltaTime;
+	}
+
+	// Removes the agents removed while processing as well
+	ProcessTransitionRequests();
+}
+
+TStatId UCrowdStateMachineSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCrowdStateMachineSubsystem, STATGROUP_Tickables);
+}
+
+FName UCrowdStateMachineSubsystem::GetBackendName() const
+{
+	return BackendName;
+}
+
+float UCrowdStateMachineSubsystem::GetStateTime(int32 AgentIndex) const
+{
+	return StateTimes[AgentIndex];
+}
+
+float UCrowdStateMachineSubsystem::GetLabelTime(int32 AgentIndex) const
+{
+	return LabelTimes[AgentIndex];
+}
+
+void UCrowdStateMachineSubsystem::RequestGotoState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+	FGameplayTag Label)
+{
+	GotoState(GetAgentHandle(AgentIndex), InStateClass, Label);
+}
+
+void UCrowdStateMachineSubsystem::RequestGotoLabel(int32 AgentIndex, FGameplayTag Label)
+{
+	GotoLabel(GetAgentHandle(AgentIndex), Label);
+}
+
+void UCrowdStateMachineSubsystem::RequestPushState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+	FGameplayTag Label)
+{
+	PushState(GetAgentHandle(AgentIndex), InStateClass, Label);
+}
+
+void UCrowdStateMachineSubsystem::RequestPopState(int32 AgentIndex)
+{
+	PopState(GetAgentHandle(AgentIndex));
+}
+
+UCrowdStateMachineSubsystem* UCrowdStateMachineSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return IsValid(World) ? World->GetSubsystem<UCrowdStateMachineSubsystem>() : nullptr;
+}
+
+bool UCrowdStateMachineSubsystem::RegisterState(TSubclassOf<UCrowdMachineState> InStateClass)
+{
+	return FindOrRegisterState(InStateClass) != INDEX_NONE;
+}
+
+FFSM_CrowdAgentHandle UCrowdStateMachineSubsystem::AddAgent(TSubclassOf<UCrowdMachineState> InitialState,
+	FGameplayTag Label)
+{
+	int32 StateIndex = INDEX_NONE;
+	int32 LabelIndex = INDEX_NONE;
+	if (IsValid(InitialState) && !ResolveStateLabel(InitialState, Label, StateIndex, LabelIndex))
+	{
+		return FFSM_CrowdAgentHandle();
+	}
+
+	int32 AgentIndex;
+	if (!FreeAgentIndices.IsEmpty())
+	{
+		AgentIndex = FreeAgentIndices.Pop();
+	}
+	else
+	{
+		AgentIndex = Serials.Add(0);
+		AgentsInUse.Add(false);
+		AgentsPendingRemoval.Add(false);
+		ActiveStates.Add(INDEX_NONE);
+		ActiveLabels.Add(INDEX_NONE);
+		StateTimes.Add(0.f);
+		LabelTimes.Add(0.f);
+		StackDepths.Add(0);
+		StackStates.AddUninitialized(MaxStackDepth);
+		StackLabels.AddUninitialized(MaxStackDepth);
+	}
+
+	AgentsInUse[AgentIndex] = true;
+	ActiveStates[AgentIndex] = INDEX_NONE;
+	ActiveLabels[AgentIndex] = INDEX_NONE;
+	StackDepths[AgentIndex] = 0;
+	AgentsNum++;
+
+	if (StateIndex != INDEX_NONE)
+	{
+		RequestTransition({ AgentIndex, StateIndex, LabelIndex, ETransitionType::Goto });
+	}
+
+	return FFSM_CrowdAgentHandle(AgentIndex, Serials[AgentIndex]);
+}
+
+bool UCrowdStateMachineSubsystem::RemoveAgent(FFSM_CrowdAgentHandle Agent)
+{
+	if (!IsAgentValid(Agent))
+	{
+		return false;
+	}
+
+	if (bIsProcessing)
+	{
+		// The agent is invalid from now on, so it can't be removed twice
+		AgentsPendingRemoval[Agent.Index] = true;
+		PendingRemovals.Add(Agent.Index);
+	}
+	else
+	{
+		RemoveAgent_Implementation(Agent.Index);
+	}
+
+	return true;
+}
+
+bool UCrowdStateMachineSubsystem::IsAgentValid(FFSM_CrowdAgentHandle Agent) const
+{
+	return IsAgentIndexValid(Agent.Index) && Serials[Agent.Index] == Agent.Serial &&
+		!AgentsPendingRemoval[Agent.Index];
+}
+
+int32 UCrowdStateMachineSubsystem::GetAgentsNum() const
+{
+	return AgentsNum;
+}
+
+bool UCrowdStateMachineSubsystem::GotoState(FFSM_CrowdAgentHandle Agent, TSubclassOf<UCrowdMachineState> InStateClass,
+	FGameplayTag Label)
+{
+	int32 StateIndex;
+	int32 LabelIndex;
+	if (!IsAgentValid(Agent) || !ResolveStateLabel(InStateClass, Label, StateIndex, LabelIndex))
+	{
+		return false;
+	}
+
+	RequestTransition({ Agent.Index, StateIndex, LabelIndex, ETransitionType::Goto });
+	return true;
+}
+
+bool UCrowdStateMachineSubsystem::GotoLabel(FFSM_CrowdAgentHandle Agent, FGameplayTag Label)
+{
+	if (!IsAgentValid(Agent) || ActiveStates[Agent.Index] == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// The label is bound to the state that is active at the moment of the request
+	const int32 StateIndex = ActiveStates[Agent.Index];
+	const int32 LabelIndex = States[StateIndex]->FindLabelIndex(Label);
+	if (LabelIndex == INDEX_NONE)
+	{
+		FSM_LOG(Warning, "Label [%s] is not present in state [%s].", *Label.ToString(),
+			*States[StateIndex]->GetClass()->GetName());
+		return false;
+	}
+
+	RequestTransition({ Agent.Index, StateIndex, LabelIndex, ETransitionType::GotoLabel });
+	return true;
+}
+
+bool UCrowdStateMachineSubsystem::PushState(FFSM_CrowdAgentHandle Agent, TSubclassOf<UCrowdMachineState> InStateClass,
+	FGameplayTag Label)
+{
+	int32 StateIndex;
+	int32 LabelIndex;
+	if (!IsAgentValid(Agent) || !ResolveStateLabel(InStateClass, Label, StateIndex, LabelIndex))
+	{
+		return false;
+	}
+
+	RequestTransition({ Agent.Index, StateIndex, LabelIndex, ETransitionType::Push });
+	return true;
+}
+
+bool UCrowdStateMachineSubsystem::PopState(FFSM_CrowdAgentHandle Agent)
+{
+	if (!IsAgentValid(Agent) || ActiveStates[Agent.Index] == INDEX_NONE)
+	{
+		return false;
+	}
+
+	RequestTransition({ Agent.Index, INDEX_NONE, INDEX_NONE, ETransitionType::Pop });
+	return true;
+}
+
+TSubclassOf<UCrowdMachineState> UCrowdStateMachineSubsystem::GetActiveState(FFSM_CrowdAgentHandle Agent) const
+{
+	if (!IsAgentValid(Agent) || ActiveStates[Agent.Index] == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	return States[ActiveStates[Agent.Index]]->GetClass();
+}
+
+FGameplayTag UCrowdStateMachineSubsystem::GetActiveLabel(FFSM_CrowdAgentHandle Agent) const
+{
+	if (!IsAgentValid(Agent) || ActiveStates[Agent.Index] == INDEX_NONE)
+	{
+		return FGameplayTag::EmptyTag;
+	}
+
+	return States[ActiveStates[Agent.Index]]->GetRegisteredLabels()[ActiveLabels[Agent.Index]];
+}
+
+bool UCrowdStateMachineSubsystem::IsInState(FFSM_CrowdAgentHandle Agent, TSubclassOf<UCrowdMachineState> InStateClass,
+	bool bCheckStack) const
+{
+	const int32 StateIndex = FindStateIndex(InStateClass);
+	if (!IsAgentValid(Agent) || StateIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	if (ActiveStates[Agent.Index] == StateIndex)
+	{
+		return true;
+	}
+
+	if (bCheckStack)
+	{
+		// The paused states are the ones below the active one
+		const int32 StackOffset = Agent.Index * MaxStackDepth;
+		for (int32 i = 0; i < StackDepths[Agent.Index] - 1; i++)
+		{
+			if (StackStates[StackOffset + i] == StateIndex)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+int32 UCrowdStateMachineSubsystem::GetStackDepth(FFSM_CrowdAgentHandle Agent) const
+{
+	return IsAgentValid(Agent) ? StackDepths[Agent.Index] : 0;
+}
+
+int32 UCrowdStateMachineSubsystem::GetAgentsNumInState(TSubclassOf<UCrowdMachineState> InStateClass) const
+{
+	const int32 StateIndex = FindStateIndex(InStateClass);
+	return StateIndex != INDEX_NONE ? StateAgentsNums[StateIndex] : 0;
+}
+
+UCrowdMachineState* UCrowdStateMachineSubsystem::GetState(TSubclassOf<UCrowdMachineState> InStateClass) const
+{
+	const int32 StateIndex = FindStateIndex(InStateClass);
+	return StateIndex != INDEX_NONE ? States[StateIndex] : nullptr;
+}
+
+FFSM_CrowdAgentHandle UCrowdStateMachineSubsystem::GetAgentHandle(int32 AgentIndex) const
+{
+	return FFSM_CrowdAgentHandle(AgentIndex, Serials[AgentIndex]);
+}
+
+UCrowdMachineState* UCrowdStateMachineSubsystem::GetStateByIndex(int32 StateIndex) const
+{
+	return States[StateIndex];
+}
+
+bool UCrowdStateMachineSubsystem::GetAgentState(int32 AgentIndex, FAgentState& OutAgent)
+{
+	// The transitions of the agents waiting to be removed are dropped
+	if (!AgentsInUse[AgentIndex] || AgentsPendingRemoval[AgentIndex])
+	{
+		return false;
+	}
+
+	const int32 StackOffset = AgentIndex * MaxStackDepth;
+	OutAgent.ActiveState = &ActiveStates[AgentIndex];
+	OutAgent.ActiveLabel = &ActiveLabels[AgentIndex];
+	OutAgent.StateTime = &StateTimes[AgentIndex];
+	OutAgent.LabelTime = &LabelTimes[AgentIndex];
+	OutAgent.StackDepth = &StackDepths[AgentIndex];
+	OutAgent.StackStates = &StackStates[StackOffset];
+	OutAgent.StackLabels = &StackLabels[StackOffset];
+	return true;
+}
+
+void UCrowdStateMachineSubsystem::OnActiveStateChanged(int32 AgentIndex, int32 PreviousStateIndex,
+	int32 NewStateIndex)
+{
+	if (PreviousStateIndex != INDEX_NONE)
+	{
+		StateAgentsNums[PreviousStateIndex]--;
+	}
+
+	if (NewStateIndex != INDEX_NONE)
+	{
+		StateAgentsNums[NewStateIndex]++;
+	}
+}
+
+int32 UCrowdStateMachineSubsystem::FindOrRegisterState(TSubclassOf<UCrowdMachineState> InStateClass)
+{
+	if (!IsValid(InStateClass) || InStateClass->HasAnyClassFlags(CLASS_Abstract))
+	{
+		FSM_LOG(Warning, "Crowd state class [%s] is invalid.", *GetNameSafe(InStateClass));
+		return INDEX_NONE;
+	}
+
+	if (const int32* FoundIndex = StateIndices.Find(InStateClass))
+	{
+		return *FoundIndex;
+	}
+
+	UCrowdMachineState* State = NewObject<UCrowdMachineState>(this, InStateClass, NAME_None, RF_Transient);
+	const int32 StateIndex = States.Add(State);
+	StateIndices.Add(InStateClass, StateIndex);
+	StateAgentsNums.Add(0);
+
+	FSM_LOG(Verbose, "Crowd state [%s] has been registered.", *InStateClass->GetName());
+
+	return StateIndex;
+}
+
+int32 UCrowdStateMachineSubsystem::FindStateIndex(TSubclassOf<UCrowdMachineState> InStateClass) const
+{
+	const int32* FoundIndex = StateIndices.Find(InStateClass);
+	return FoundIndex ? *FoundIndex : INDEX_NONE;
+}
+
+bool UCrowdStateMachineSubsystem::ResolveStateLabel(TSubclassOf<UCrowdMachineState> InStateClass, FGameplayTag Label,
+	int32& OutStateIndex, int32& OutLabelIndex)
+{
+	OutStateIndex = FindOrRegisterState(InStateClass);
+	if (OutStateIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutLabelIndex = States[OutStateIndex]->FindLabelIndex(Label);
+	if (OutLabelIndex == INDEX_NONE)
+	{
+		FSM_LOG(Warning, "Label [%s] is not present in state [%s].", *Label.ToString(), *InStateClass->GetName());
+		return false;
+	}
+
+	return true;
+}
+
+void UCrowdStateMachineSubsystem::RequestTransition(const FTransitionRequest& Request)
+{
+	TransitionRequests.Add(Request);
+
+	if (!bIsProcessing)
+	{
+		ProcessTransitionRequests();
+	}
+}
+
+void UCrowdStateMachineSubsystem::ProcessTransitionRequests()
+{
+	// Transitions requested by the events are deferred to the next batch instead of being performed right away
+	const bool bWasProcessing = bIsProcessing;
+	bIsProcessing = true;
+
+	ApplyTransitionRequests();
+
+	bIsProcessing = bWasProcessing;
+
+	// Agents removed by the events are removed once the outermost processing finishes, not on the next frame
+	if (!bWasProcessing)
+	{
+		FlushPendingRemovals();
+	}
+}
+
+void UCrowdStateMachineSubsystem::FlushPendingRemovals()
+{
+	for (const int32 AgentIndex : PendingRemovals)
+	{
+		RemoveAgent_Implementation(AgentIndex);
+	}
+
+	PendingRemovals.Reset();
+}
+
+void UCrowdStateMachineSubsystem::SortAgentsByLabel()
+{
+	// Each label of each state has its own bucket
+	StateBucketOffsets.SetNumUninitialized(States.Num());
+	int32 BucketsNum = 0;
+	for (int32 StateIndex = 0; StateIndex < States.Num(); StateIndex++)
+	{
+		StateBucketOffsets[StateIndex] = BucketsNum;
+		BucketsNum += States[StateIndex]->GetRegisteredLabels().Num();
+	}
+
+	// Counting sort; the agents keep their relative order within a bucket
+	BucketOffsets.Reset();
+	BucketOffsets.SetNumZeroed(BucketsNum + 1);
+
+	const int32 SlotsNum = ActiveStates.Num();
+	for (int32 AgentIndex = 0; AgentIndex < SlotsNum; AgentIndex++)
+	{
+		const int32 StateIndex = ActiveStates[AgentIndex];
+		if (StateIndex != INDEX_NONE)
+		{
+			BucketOffsets[StateBucketOffsets[StateIndex] + ActiveLabels[AgentIndex] + 1]++;
+		}
+	}
+
+	for (int32 Bucket = 1; Bucket <= BucketsNum; Bucket++)
+	{
+		BucketOffsets[Bucket] += BucketOffsets[Bucket - 1];
+	}
+
+	BucketCursors = BucketOffsets;
+	SortedAgents.SetNumUninitialized(BucketOffsets[BucketsNum]);
+
+	for (int32 AgentIndex = 0; AgentIndex < SlotsNum; AgentIndex++)
+	{
+		const int32 StateIndex = ActiveStates[AgentIndex];
+		if (StateIndex != INDEX_NONE)
+		{
+			SortedAgents[BucketCursors[StateBucketOffsets[StateIndex] + ActiveLabels[AgentIndex]]++] = AgentIndex;
+		}
+	}
+}
+
+bool UCrowdStateMachineSubsystem::IsAgentIndexValid(int32 AgentIndex) const
+{
+	return AgentsInUse.IsValidIndex(AgentIndex) && AgentsInUse[AgentIndex];
+}
+
+void UCrowdStateMachineSubsystem::RemoveAgent_Implementation(int32 AgentIndex)
+{
+	if (!IsAgentIndexValid(AgentIndex))
+	{
+		return;
+	}
+
+	const int32 ActiveState = ActiveStates[AgentIndex];
+	if (ActiveState != INDEX_NONE)
+	{
+		StateAgentsNums[ActiveState]--;
+	}
+
+	// Invalidate the handles of the agent
+	Serials[AgentIndex]++;
+	AgentsInUse[AgentIndex] = false;
+	AgentsPendingRemoval[AgentIndex] = false;
+	ActiveStates[AgentIndex] = INDEX_NONE;
+	ActiveLabels[AgentIndex] = INDEX_NONE;
+	StackDepths[AgentIndex] = 0;
+	FreeAgentIndices.Add(AgentIndex);
+	AgentsNum--;
+}
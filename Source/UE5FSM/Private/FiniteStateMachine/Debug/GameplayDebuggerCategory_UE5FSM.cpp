@@ -17,6 +17,17 @@ TSharedRef<FGameplayDebuggerCategory> FGameplayDebuggerCategory_UE5FSM::MakeInst
 	return MakeShareable(new FGameplayDebuggerCategory_UE5FSM());
 }
 
+static FSerializedStateData SerializeStateData(const UMachineState* State)
+{
+	FSerializedStateData StateData;
+	StateData.Name = State->GetName();
+	StateData.LastAction = State->GetLastStateAction();
+	StateData.TimeSinceLastStateAction = State->GetTimeSinceLastStateAction();
+	StateData.ExtDebugData = State->GetDebugData();
+
+	return StateData;
+}
+
 static FSerializedFSMData SerializeFSMData(const UFiniteStateMachine* FiniteStateMachine)
 {
 	FSerializedFSMData ReturnValue;
@@ -58,11 +69,22 @@ static FSerializedFSMData SerializeFSMData(const UFiniteStateMachine* FiniteStat
 		const UMachineState* State = FiniteStateMachine->GetState(*It);
 		check(IsValid(State));
 
-		FSerializedStateData& StateData = ReturnValue.StatesStack.AddDefaulted_GetRef();
-		StateData.Name = State->GetName();
-		StateData.LastAction = State->GetLastStateAction();
-		StateData.TimeSinceLastStateAction = State->GetTimeSinceLastStateAction();
-		StateData.ExtDebugData = State->GetDebugData();
+		ReturnValue.StatesStack.Add(SerializeStateData(State));
+	}
+
+	TArray<FGameplayTag> Regions;
+	FiniteStateMachine->GetRegions(Regions);
+	for (const FGameplayTag Region : Regions)
+	{
+		FSerializedRegionData& RegionData = ReturnValue.Regions.AddDefaulted_GetRef();
+		RegionData.Name = Region.ToString();
+
+		// Top-most state first, as for the main stack
+		const TArray<UMachineState*> RegionStack = FiniteStateMachine->GetStatesStackInRegion(Region);
+		for (int32 i = RegionStack.Num() - 1; i >= 0; i--)
+		{
+			RegionData.StatesStack.Add(SerializeStateData(RegionStack[i]));
+		}
 	}
 
 	return ReturnValue;
@@ -117,10 +139,9 @@ static void PrintGlobalState(const FSerializedFSMData& Data, FGameplayDebuggerCa
 	CanvasContext.Printf(TEXT("Global state: %s"), *GetNameSafe(Data.GlobalStateClass));
 }
 
-static void PrintStatesStack(const FSerializedFSMData& Data, FGameplayDebuggerCanvasContext& CanvasContext)
+static void PrintStates(const TArray<FSerializedStateData>& States, FGameplayDebuggerCanvasContext& CanvasContext)
 {
-	CanvasContext.Print(TEXT("\nStates stack:"));
-	for (const FSerializedStateData& StateData : Data.StatesStack)
+	for (const FSerializedStateData& StateData : States)
 	{
 		FString LastActionString = UEnum::GetValueAsString(StateData.LastAction);
 		LastActionString.RemoveFromStart("EStateAction::");
@@ -130,6 +151,21 @@ static void PrintStatesStack(const FSerializedFSMData& Data, FGameplayDebuggerCa
 	}
 }
 
+static void PrintStatesStack(const FSerializedFSMData& Data, FGameplayDebuggerCanvasContext& CanvasContext)
+{
+	CanvasContext.Print(TEXT("\nStates stack:"));
+	PrintStates(Data.StatesStack, CanvasContext);
+}
+
+static void PrintRegions(const FSerializedFSMData& Data, FGameplayDebuggerCanvasContext& CanvasContext)
+{
+	for (const FSerializedRegionData& RegionData : Data.Regions)
+	{
+		CanvasContext.Printf(TEXT("\nRegion %s:"), *RegionData.Name);
+		PrintStates(RegionData.StatesStack, CanvasContext);
+	}
+}
+
 static void PrintRegisteredStates(const FSerializedFSMData& Data, FGameplayDebuggerCanvasContext& CanvasContext)
 {
 	CanvasContext.Print(TEXT("\nRegistered states:"));
@@ -188,6 +224,7 @@ void FGameplayDebuggerCategory_UE5FSM::DrawData(APlayerController* OwnerPC,
 	{
 		PrintGlobalState(Data, CanvasContext);
 		PrintStatesStack(Data, CanvasContext);
+		PrintRegions(Data, CanvasContext);
 		PrintTerminatedStates(Data, CanvasContext);
 		PrintRegisteredStates(Data, CanvasContext);
 		PrintExtDebugData(Data, CanvasContext);
@@ -2,14 +2,69 @@
 
 #include "FiniteStateMachine/FiniteStateMachine.h"
 
+#include "Algo/BinarySearch.h"
+#include "Algo/Sort.h"
+#include "Algo/StableSort.h"
+#include "FiniteStateMachine/FiniteStateMachineArchetype.h"
 #include "FiniteStateMachine/FiniteStateMachineLog.h"
+#include "FiniteStateMachine/FiniteStateMachineSubsystem.h"
 #include "FiniteStateMachine/MachineState.h"
 #include "FiniteStateMachine/MachineStateData.h"
 #include "GameFramework/PlayerState.h"
 #include "Misc/DataValidation.h"
+#include "NativeGameplayTags.h"
+#include "UObject/UObjectArray.h"
 
 using namespace UE5Coro;
 
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_StateMachine_Region, "StateMachine.Region");
+
+/**
+ * Transition failures are rate-limited across all the state machines, as thousands of agents failing the same request
+ * at once would flood the log otherwise. Only accessed from the game thread.
+ */
+static double LastTransitionFailureLogTime = -UE_BIG_NUMBER;
+static int32 SuppressedTransitionFailuresNum = 0;
+
+/**
+ * Marks the lifetime of a transition. Stack changes happening within it don't update the push queue right away; the
+ * queue is drained once the outermost transition completes instead.
+ */
+struct FFSM_TransitionScope
+{
+public:
+	explicit FFSM_TransitionScope(UFiniteStateMachine* Context)
+		: ContextRef(Context)
+	{
+		ContextRef->TransitionDepth++;
+	}
+
+	~FFSM_TransitionScope()
+	{
+		if (!ContextRef.IsValid())
+		{
+			return;
+		}
+
+		UFiniteStateMachine* Context = ContextRef.Get();
+		ensure(Context->TransitionDepth > 0);
+		Context->TransitionDepth--;
+
+		if (Context->TransitionDepth == 0 && Context->bIsPushQueueDirty)
+		{
+			Context->DrainPushQueue();
+		}
+
+		if (Context->TransitionDepth == 0)
+		{
+			Context->PublishPendingStateSnapshot();
+		}
+	}
+
+private:
+	TWeakObjectPtr<UFiniteStateMachine> ContextRef = nullptr;
+};
+
 void FFSM_PushRequestHandle::BindOnResultCallback(const FOnPendingPushRequestSignature::FDelegate&& Callback) const
 {
 	if (StateMachine.IsValid())
@@ -74,7 +129,7 @@ void UFiniteStateMachine::Activate(bool bReset)
 
 		if (IsValid(ActiveState))
 		{
-			ActiveGlobalState->OnStateAction(EStateAction::Resume, nullptr);
+			ActiveState->OnStateAction(EStateAction::Resume, nullptr);
 		}
 	}
 
@@ -83,6 +138,12 @@ void UFiniteStateMachine::Activate(bool bReset)
 		BeginActiveStates();
 	}
 
+	// Commands posted while the state machine was inactive are performed right away rather than on the next tick
+	if (bMyIsActive && HasBeenInitialized() && !TransitionCommands.IsEmpty())
+	{
+		ProcessTransitionCommands();
+	}
+
 	if (!bMyIsActive)
 	{
 		if (IsValid(ActiveGlobalState))
@@ -92,7 +153,7 @@ void UFiniteStateMachine::Activate(bool bReset)
 
 		if (IsValid(ActiveState))
 		{
-			ActiveGlobalState->OnStateAction(EStateAction::Pause, nullptr);
+			ActiveState->OnStateAction(EStateAction::Pause, nullptr);
 		}
 
 		// If state machine was deactivated, we don't want anything to run
@@ -109,19 +170,32 @@ void UFiniteStateMachine::InitializeComponent()
 		return;
 	}
 
-	// Dispatch all the states
-	for (const TSubclassOf<UMachineState> StateClass : InitialStateClassesToRegister)
+	if (UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(this))
+	{
+		Registry = Subsystem;
+		Subsystem->RegisterStateMachine(this);
+	}
+
+	if (IsValid(StateMachineArchetype))
+	{
+		InitializeFromArchetype();
+	}
+	else
 	{
-		if (IsValid(StateClass))
+		// Dispatch all the states
+		for (const TSubclassOf<UMachineState> StateClass : InitialStateClassesToRegister)
 		{
-			if (!ensureMsgf(!StateClass->ImplementsInterface(UGlobalMachineStateInterface::StaticClass()),
-				TEXT("%s"), *GetGlobalStateInInitialRegisteredStatesErrorMessage(StateClass)))
+			if (IsValid(StateClass))
 			{
-				continue;
+				if (!ensureMsgf(!StateClass->ImplementsInterface(UGlobalMachineStateInterface::StaticClass()),
+					TEXT("%s"), *GetGlobalStateInInitialRegisteredStatesErrorMessage(StateClass)))
+				{
+					continue;
+				}
 			}
-		}
 
-		RegisterState(StateClass);
+			RegisterState(StateClass);
+		}
 	}
 
 	// Can remain nullptr
@@ -145,6 +219,24 @@ void UFiniteStateMachine::InitializeComponent()
 		}
 	}
 
+	for (const FFSM_RegionDefinition& Definition : RegionDefinitions)
+	{
+		if (!Definition.RegionTag.MatchesTag(TAG_StateMachine_Region))
+		{
+			FSM_LOG(Warning, "Region [%s] is of wrong tag hierarchy.", *Definition.RegionTag.ToString());
+			continue;
+		}
+
+		if (FindRegionIndex(Definition.RegionTag) != INDEX_NONE)
+		{
+			FSM_LOG(Warning, "Region [%s] is defined more than once.", *Definition.RegionTag.ToString());
+			continue;
+		}
+
+		FRegion& Region = Regions.AddDefaulted_GetRef();
+		Region.Definition = Definition;
+	}
+
 	Super::InitializeComponent();
 
 	bIsInitialized = true;
@@ -153,6 +245,11 @@ void UFiniteStateMachine::InitializeComponent()
 		RegisteredState->PostInitialize();
 	}
 
+	for (TObjectPtr<UMachineState> SubState : RegisteredSubStates)
+	{
+		SubState->PostInitialize();
+	}
+
 	if (IsActive() && !bActiveStatesBegan)
 	{
 		BeginActiveStates();
@@ -169,18 +266,50 @@ void UFiniteStateMachine::UninitializeComponent()
 
 	// Finilize the stack
 	ClearStack();
+	ClearRegions();
 
 	// Sanity check
 	StopEveryLatentExecution();
 	StopEveryRunningLabel();
 
+	// The cluster outlives the states; it must not keep the indices of destroyed objects
+	RemoveStatesFromOwnerCluster();
+
 	for (const TObjectPtr<UMachineState> State : RegisteredStates)
 	{
+		if (Registry.IsValid())
+		{
+			Registry->RemoveFromStateIndex(State);
+		}
+
 		State->bIsDestroyed = true;
 		State->ConditionalBeginDestroy();
 	}
 
+	for (const TObjectPtr<UMachineState> SubState : RegisteredSubStates)
+	{
+		if (Registry.IsValid())
+		{
+			Registry->RemoveFromStateIndex(SubState);
+		}
+
+		SubState->bIsDestroyed = true;
+		SubState->ConditionalBeginDestroy();
+	}
+
 	RegisteredStates.Empty();
+	RegisteredSubStates.Empty();
+	ArchetypeStates.Empty();
+	TransitionCommands.Empty();
+	Regions.Empty();
+	DeferredGotoState = FDeferredGotoState();
+	CoalescedGotoStatesNum = 0;
+
+	if (Registry.IsValid())
+	{
+		Registry->UnregisterStateMachine(this);
+		Registry = nullptr;
+	}
 
 	Super::UninitializeComponent();
 }
@@ -190,14 +319,30 @@ void UFiniteStateMachine::TickComponent(float DeltaTime, ELevelTick LevelTick,
 {
 	Super::TickComponent(DeltaTime, LevelTick, ActorComponentTickFunction);
 
-	if (IsValid(ActiveGlobalState))
+	if (!TransitionCommands.IsEmpty())
 	{
-		ActiveGlobalState->Tick(DeltaTime);
+		ProcessTransitionCommands();
 	}
 
-	if (IsValid(ActiveState))
+	if (IsValid(DeferredGotoState.StateClass))
+	{
+		ResolveDeferredGotoState();
+	}
+
+	if (NextPushRequestExpirationTime >= 0.0 && GetWorld()->GetTimeSeconds() >= NextPushRequestExpirationTime)
 	{
-		ActiveState->Tick(DeltaTime);
+		CancelExpiredPushRequests();
+	}
+
+	if (bTimeSliceStateTicks && RegistryIndex != INDEX_NONE)
+	{
+		// The rest is ticked by the registry once it's their turn
+		TimeSlicedDeltaTime += DeltaTime;
+		TickActiveStates(DeltaTime, EStateTickFilter::Urgent);
+	}
+	else
+	{
+		TickActiveStates(DeltaTime, EStateTickFilter::All);
 	}
 }
 
@@ -206,6 +351,12 @@ EDataValidationResult UFiniteStateMachine::IsDataValid(FDataValidationContext& C
 {
 	EDataValidationResult Result = Super::IsDataValid(Context);
 
+	// The archetype overrides the states, global and initial state of the component, so they're never used
+	if (IsValid(StateMachineArchetype))
+	{
+		return CombineDataValidationResults(Result, StateMachineArchetype->IsDataValid(Context));
+	}
+
 	for (const TSubclassOf<UMachineState> StateClass : InitialStateClassesToRegister)
 	{
 		if (IsValid(StateClass) && StateClass->ImplementsInterface(UGlobalMachineStateInterface::StaticClass()))
@@ -235,6 +386,7 @@ void UFiniteStateMachine::Reset(bool bDeactivate)
 {
 	StopEveryLatentExecution();
 	ClearStack();
+	ClearRegions();
 
 	if (bDeactivate)
 	{
@@ -242,6 +394,87 @@ void UFiniteStateMachine::Reset(bool bDeactivate)
 	}
 }
 
+bool UFiniteStateMachine::SoftReset(bool bBeginInitialStates)
+{
+	if (!HasBeenInitialized())
+	{
+		FSM_LOG(Warning, "Impossible to soft reset before initialization.");
+		return false;
+	}
+
+	if (IsActiveStateDispatchingEvent())
+	{
+		FSM_LOG(Warning, "The active state [%s] is dispatching an event. It's impossible to soft reset.",
+			*ActiveState->GetName());
+		return false;
+	}
+
+	const bool bIsRegionRunningLatentRequest = Regions.ContainsByPredicate([](const FRegion& Region)
+	{
+		return Region.bIsRunningLatentRequest;
+	});
+
+	if (bIsRunningLatentRequest || bIsRegionRunningLatentRequest)
+	{
+		FSM_LOG(Warning, "A latent request is running. It's impossible to soft reset.");
+		return false;
+	}
+
+	// Cancel the pending pushes first, so that they don't get performed while the stack is being cleared
+	CancelEveryPushRequest();
+
+	// The states are torn down in the reverse order they've begun in
+	EndEveryState();
+	if (bActiveStatesBegan && IsValid(ActiveGlobalState))
+	{
+		ActiveGlobalState->OnStateAction(EStateAction::End, nullptr);
+	}
+
+	DeferredGotoState = FDeferredGotoState();
+	CoalescedGotoStatesNum = 0;
+
+	// Sanity check
+	StopEveryLatentExecution();
+	StopEveryRunningLabel();
+
+#ifdef WITH_EDITOR
+	LastStateActionsStack.Reset();
+#endif
+
+	for (const TObjectPtr<UMachineState> State : RegisteredStates)
+	{
+		State->SoftReset();
+	}
+
+	for (const TObjectPtr<UMachineState> SubState : RegisteredSubStates)
+	{
+		SubState->SoftReset();
+	}
+
+	bActiveStatesBegan = false;
+
+	ActiveState = nullptr;
+	if (IsValid(InitialState))
+	{
+		ActiveState = FindState(InitialState);
+		if (IsValid(ActiveState))
+		{
+			ActiveState->SetInitialLabel(InitialStateLabel);
+		}
+	}
+
+	PublishStateSnapshot();
+
+	FSM_LOG(Verbose, "State machine has been soft reset.");
+
+	if (bBeginInitialStates && IsActive())
+	{
+		BeginActiveStates();
+	}
+
+	return true;
+}
+
 bool UFiniteStateMachine::RegisterState(TSubclassOf<UMachineState> InStateClass)
 {
 	if (!IsValid(InStateClass))
@@ -292,6 +525,16 @@ void UFiniteStateMachine::SetInitialState(TSubclassOf<UMachineState> InStateClas
 	InitialStateLabel = Label;
 }
 
+void UFiniteStateMachine::SetStateMachineArchetype(UFiniteStateMachineArchetype* InArchetype)
+{
+	if (!ensure(!HasBeenInitialized()))
+	{
+		return;
+	}
+
+	StateMachineArchetype = InArchetype;
+}
+
 void UFiniteStateMachine::SetGlobalState(TSubclassOf<UMachineState> InStateClass)
 {
 	if (IsValid(GlobalStateClass) || !ensure(!HasBeenInitialized()))
@@ -320,246 +563,388 @@ void UFiniteStateMachine::SetGlobalState(TSubclassOf<UMachineState> InStateClass
 
 bool UFiniteStateMachine::GotoState(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label, bool bForceEvents)
 {
-	if (!ensure(HasBeenInitialized()))
-	{
-		FSM_LOG(Warning, "Impossible to use GotoState on [%s] before initialization.", *GetNameSafe(InStateClass));
-		return false;
-	}
+	const EFSM_TransitionResult Result = TryGotoState(InStateClass, Label, bForceEvents);
+	return IsTransitionAccepted(Result);
+}
 
-	if (!IsValid(InStateClass))
+EFSM_TransitionResult UFiniteStateMachine::TryGotoState(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label,
+	bool bForceEvents)
+{
+	if (bCoalesceGotoState)
 	{
-		FSM_LOG(Warning, "Invalid state class.");
-		return false;
+		const EFSM_TransitionResult Result = RequestGotoState(InStateClass, Label, 0, bForceEvents);
+		return Result;
 	}
 
-	// Disallow going to state when it's on the stack, but it's not the top-most one
-	if (IsInState(InStateClass, true) && ActiveState->GetClass() != InStateClass)
-	{
-		FSM_LOG(Warning, "Impossible to go to state [%s] as it's already present on the states stack.",
-			*GetNameSafe(InStateClass));
-		return false;
-	}
+	const EFSM_TransitionResult Result = GotoState_Immediate(InStateClass, Label, bForceEvents);
+	return Result;
+}
 
-	if (IsTransitionBlockedTo(InStateClass))
+EFSM_TransitionResult UFiniteStateMachine::RequestGotoState(TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label, int32 Priority, bool bForceEvents)
+{
+	// Only reject what can't change until the request is resolved, the rest is checked on resolution
+	EFSM_TransitionResult Result = EFSM_TransitionResult::Deferred;
+	if (!HasBeenInitialized())
 	{
-		FSM_LOG(Warning, "Impossible to go to state [%s] as active state [%s] has disallowed this particular "
-			"transition.", *GetNameSafe(InStateClass), *ActiveState->GetName());
-		return false;
+		Result = EFSM_TransitionResult::NotInitialized;
 	}
-
-	FString Reason;
-	if (!CanActiveStateSafelyDeactivate(Reason))
+	else if (!IsValid(InStateClass))
 	{
-		FSM_LOG(Warning, "Impossible to go to state [%s] as active state [%s] is not safe from being deactivated. "
-			"Reason: [%s]", *GetNameSafe(InStateClass), *ActiveState->GetName(), *Reason);
-		return false;
+		Result = EFSM_TransitionResult::InvalidState;
 	}
-
-	if (!IsStateRegistered(InStateClass))
+	else if (!UMachineState::IsLabelTagCorrect(Label))
 	{
-		FSM_LOG(Warning, "State [%s] is not registered in state machine.", *InStateClass->GetName());
-		return false;
+		Result = EFSM_TransitionResult::InvalidLabel;
 	}
-
-	if (!UMachineState::IsLabelTagCorrect(Label))
+	else if (!IsStateRegistered(InStateClass))
 	{
-		FSM_LOG(Warning, "Label [%s] is of wrong tag hierarchy.", *Label.ToString());
-		return false;
+		Result = EFSM_TransitionResult::NotRegistered;
 	}
 
-	if (bIsRunningLatentRequest)
+	if (Result != EFSM_TransitionResult::Deferred)
 	{
-		FSM_LOG(Warning, "A latent request is already running. Avoid calling multiple of them at once.");
-		return false;
+		LogTransitionFailure(TEXT("RequestGotoState"), Result, InStateClass, Label);
+		return Result;
 	}
 
-	if (!IsActiveStateDispatchingEvent())
-	{
-		GotoState_Implementation(InStateClass, Label, bForceEvents);
-	}
-	else
+	if (IsValid(DeferredGotoState.StateClass))
 	{
-		GotoState_LatentImplementation(InStateClass, Label, bForceEvents);
+		CoalescedGotoStatesNum++;
+
+		// Keep the recorded request if it's more important
+		if (GotoStateCoalescingPolicy == EFSM_GotoStateCoalescingPolicy::HighestPriority &&
+			Priority < DeferredGotoState.Priority)
+		{
+			return Result;
+		}
 	}
 
-	return true;
+	DeferredGotoState.StateClass = InStateClass;
+	DeferredGotoState.Label = Label;
+	DeferredGotoState.Priority = Priority;
+	DeferredGotoState.bForceEvents = bForceEvents;
+
+	return Result;
 }
 
-bool UFiniteStateMachine::EndState()
+bool UFiniteStateMachine::HasDeferredGotoState() const
 {
-	if (!ensure(HasBeenInitialized()))
-	{
-		FSM_LOG(Warning, "Impossible to end a state before initialization.");
-		return false;
-	}
+	return IsValid(DeferredGotoState.StateClass);
+}
 
-	if (!IsValid(ActiveState))
+EFSM_TransitionResult UFiniteStateMachine::ResolveDeferredGotoState()
+{
+	if (!IsValid(DeferredGotoState.StateClass))
 	{
-		FSM_LOG(Warning, "Impossible to end a state as there's nothing to end.");
-		return false;
+		return EFSM_TransitionResult::Success;
 	}
 
-	if (bIsRunningLatentRequest)
-	{
-		FSM_LOG(Warning, "A latent request is already running. Avoid calling multiple of them at once.");
-		return false;
-	}
+	const FDeferredGotoState Request = DeferredGotoState;
+	DeferredGotoState = FDeferredGotoState();
 
-	if (!IsActiveStateDispatchingEvent())
-	{
-		EndState_Implementation();
-	}
-	else
-	{
-		EndState_LatentImplementation();
-	}
+	FSM_LOG(VeryVerbose, "Resolve deferred GotoState. State [%s] Label [%s] Coalesced requests [%d]",
+		*Request.StateClass->GetName(), *Request.Label.ToString(), CoalescedGotoStatesNum);
+	CoalescedGotoStatesNum = 0;
 
-	return true;
+	const EFSM_TransitionResult Result = GotoState_Immediate(Request.StateClass, Request.Label, Request.bForceEvents);
+	return Result;
 }
 
-bool UFiniteStateMachine::GotoLabel(FGameplayTag Label)
+EFSM_TransitionResult UFiniteStateMachine::GotoState_Immediate(TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label, bool bForceEvents)
 {
-	if (!ensure(HasBeenInitialized()))
-	{
-		FSM_LOG(Warning, "Impossible to use GotoLabel before initialization.");
-		return false;
-	}
-
-	if (!IsValid(ActiveState))
+	const EFSM_TransitionResult Result = CanGotoState(InStateClass, Label);
+	if (Result != EFSM_TransitionResult::Success)
 	{
-		FSM_LOG(Warning, "No state is active.");
-		return false;
+		ensure(Result != EFSM_TransitionResult::NotInitialized);
+		LogTransitionFailure(TEXT("GotoState"), Result, InStateClass, Label);
+		return Result;
 	}
 
-	const bool bResult = !ActiveState->GotoLabel(Label);
-	return bResult;
+	return GotoState_Dispatch(InStateClass, Label, bForceEvents);
 }
 
-TCoroutine<> UFiniteStateMachine::PushState(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label,
-	bool* bOutPrematureResult)
+EFSM_TransitionResult UFiniteStateMachine::CanGotoState_Implementation(TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label, int32 ArchetypeToIndex) const
 {
-	if (bOutPrematureResult)
+	if (!HasBeenInitialized())
 	{
-		*bOutPrematureResult = false;
+		return EFSM_TransitionResult::NotInitialized;
 	}
 
-	if (!ensure(HasBeenInitialized()))
+	// Disallow going to state when it's on the stack, but it's not the top-most one
+	if (IsInState(InStateClass, true) && ActiveState->GetClass() != InStateClass)
 	{
-		FSM_LOG(Warning, "Impossible to push state [%s] before initialization.", *GetNameSafe(InStateClass));
-		co_return;
+		return EFSM_TransitionResult::AlreadyOnStack;
 	}
 
-	if (!IsValid(InStateClass))
+	if (IsStateInRegion(InStateClass))
 	{
-		FSM_LOG(Warning, "Invalid state class.");
-		co_return;
+		return EFSM_TransitionResult::AlreadyOnStack;
 	}
 
-	if (IsInState(InStateClass, true))
+	// The archetype has the allowlist, blocklist and registration checks between its states precompiled; they're
+	// performed all the same, just without looking anything up
+	const bool bUseArchetype = ArchetypeToIndex != INDEX_NONE && IsValid(ActiveState) &&
+		ActiveState->ArchetypeIndex != INDEX_NONE;
+
+	const bool bIsBlocked = bUseArchetype
+		? StateMachineArchetype->IsTransitionBlocked(ActiveState->ArchetypeIndex, ArchetypeToIndex)
+		: IsTransitionBlockedTo(InStateClass);
+	if (bIsBlocked)
 	{
-		FSM_LOG(Warning, "Impossible to push state [%s] as it's already present on the states stack.",
-			*GetNameSafe(InStateClass));
-		co_return;
+		return EFSM_TransitionResult::Blocked;
 	}
 
-	if (!IsStateRegistered(InStateClass))
+	const bool bIsRegistered = bUseArchetype
+		? ArchetypeStates.IsValidIndex(ArchetypeToIndex) && IsValid(ArchetypeStates[ArchetypeToIndex])
+		: IsStateRegistered(InStateClass);
+	if (!bIsRegistered)
 	{
-		FSM_LOG(Warning, "State [%s] is not registered in state machine.", *InStateClass->GetName());
-		co_return;
+		return EFSM_TransitionResult::NotRegistered;
 	}
 
 	if (!UMachineState::IsLabelTagCorrect(Label))
 	{
-		FSM_LOG(Warning, "Label [%s] is of wrong tag hierarchy.", *Label.ToString());
-		co_return;
+		return EFSM_TransitionResult::InvalidLabel;
 	}
 
-	if (IsTransitionBlockedTo(InStateClass))
+	FString Reason;
+	if (!CanActiveStateSafelyDeactivate(Reason))
 	{
-		FSM_LOG(Warning, "Impossible to go to state [%s] as active state [%s] has disallowed this "
-			"particular transition", *GetNameSafe(InStateClass), *ActiveState->GetName());
-		co_return;
+		return EFSM_TransitionResult::UnsafeDeactivation;
 	}
 
 	if (bIsRunningLatentRequest)
 	{
-		FSM_LOG(Warning, "A latent request is already running. Avoid calling multiple of them at once.");
-		co_return;
+		return EFSM_TransitionResult::LatentBusy;
 	}
 
-	if (bOutPrematureResult)
+	return EFSM_TransitionResult::Success;
+}
+
+EFSM_TransitionResult UFiniteStateMachine::GotoState_Bulk(TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label, bool bForceEvents)
+{
+	if (bCoalesceGotoState)
 	{
-		*bOutPrematureResult = true;
+		const EFSM_TransitionResult Result = RequestGotoState(InStateClass, Label, 0, bForceEvents);
+		return Result;
 	}
 
-	if (!IsActiveStateDispatchingEvent())
+	return GotoState_Dispatch(InStateClass, Label, bForceEvents);
+}
+
+EFSM_TransitionResult UFiniteStateMachine::GotoState_Dispatch(TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label, bool bForceEvents)
+{
+	// The initial state hasn't begun yet, so it's simply replaced, and the new one begins right after the global one
+	if (bIsBeginningGlobalState)
 	{
-		PushState_Implementation(InStateClass, Label);
+		ActiveState = FindStateChecked(InStateClass);
+		ActiveState->SetInitialLabel(Label);
+		return EFSM_TransitionResult::Success;
 	}
-	else
+
+	if (!IsActiveStateDispatchingEvent())
 	{
-		PushState_LatentImplementation(InStateClass, Label);
+		GotoState_Implementation(InStateClass, Label, bForceEvents);
+		return EFSM_TransitionResult::Success;
 	}
+
+	GotoState_LatentImplementation(InStateClass, Label, bForceEvents);
+	return EFSM_TransitionResult::Deferred;
 }
 
-TCoroutine<> UFiniteStateMachine::PushStateQueued(FFSM_PushRequestHandle& OutHandle,
-	TSubclassOf<UMachineState> InStateClass, FGameplayTag Label)
+EFSM_TransitionResult UFiniteStateMachine::CanGotoState(TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label) const
 {
+	if (!HasBeenInitialized())
+	{
+		return EFSM_TransitionResult::NotInitialized;
+	}
+
 	if (!IsValid(InStateClass))
 	{
-		FSM_LOG(Warning, "Invalid state class.");
-		co_return;
+		return EFSM_TransitionResult::InvalidState;
 	}
 
-	if (!UMachineState::IsLabelTagCorrect(Label))
+	// Precompiled checks are only available between the states of the archetype
+	const bool bCanUseArchetype = !ArchetypeStates.IsEmpty() && IsValid(ActiveState) &&
+		ActiveState->ArchetypeIndex != INDEX_NONE;
+	const int32 ArchetypeToIndex = bCanUseArchetype ? StateMachineArchetype->FindStateIndex(InStateClass) : INDEX_NONE;
+
+	const EFSM_TransitionResult Result = CanGotoState_Implementation(InStateClass, Label, ArchetypeToIndex);
+	return Result;
+}
+
+bool UFiniteStateMachine::EndState()
+{
+	const EFSM_TransitionResult Result = TryEndState();
+	return IsTransitionAccepted(Result);
+}
+
+EFSM_TransitionResult UFiniteStateMachine::TryEndState()
+{
+	const EFSM_TransitionResult Result = CanEndState();
+	if (Result != EFSM_TransitionResult::Success)
 	{
-		FSM_LOG(Warning, "Label [%s] is of wrong tag hierarchy.", *Label.ToString());
-		co_return;
+		ensure(Result != EFSM_TransitionResult::NotInitialized);
+		LogTransitionFailure(TEXT("EndState"), Result);
+		return Result;
+	}
+
+	if (!IsActiveStateDispatchingEvent())
+	{
+		EndState_Implementation();
+		return EFSM_TransitionResult::Success;
 	}
 
+	EndState_LatentImplementation();
+	return EFSM_TransitionResult::Deferred;
+}
+
+EFSM_TransitionResult UFiniteStateMachine::CanEndState() const
+{
 	if (!HasBeenInitialized())
 	{
-		FSM_LOG(Log, "Impossible to immediately push state [%s] before initialization. "
-			"The operation will be queued.", *GetNameSafe(InStateClass));
+		return EFSM_TransitionResult::NotInitialized;
+	}
 
-		co_await AddAndWaitPendingPushRequest(OutHandle, InStateClass, Label);
-		co_return;
+	if (!IsValid(ActiveState))
+	{
+		return EFSM_TransitionResult::NoActiveState;
 	}
 
-	if (IsTransitionBlockedTo(InStateClass))
+	if (bIsRunningLatentRequest)
 	{
-		FSM_LOG(Log, "Impossible to immediately go to state [%s] as active state [%s] has disallowed this "
-			"particular transition. The operation will be queued.",
-			*GetNameSafe(InStateClass), *ActiveState->GetName());
+		return EFSM_TransitionResult::LatentBusy;
+	}
 
-		co_await AddAndWaitPendingPushRequest(OutHandle, InStateClass, Label);
-		co_return;
+	return EFSM_TransitionResult::Success;
+}
+
+bool UFiniteStateMachine::GotoLabel(FGameplayTag Label)
+{
+	if (!ensure(HasBeenInitialized()))
+	{
+		FSM_LOG(Warning, "Impossible to use GotoLabel before initialization.");
+		return false;
 	}
 
-	if (IsInState(InStateClass, true))
+	if (!IsValid(ActiveState))
+	{
+		FSM_LOG(Warning, "No state is active.");
+		return false;
+	}
+
+	const bool bResult = !ActiveState->GotoLabel(Label);
+	return bResult;
+}
+
+TCoroutine<> UFiniteStateMachine::PushState(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label,
+	bool* bOutPrematureResult)
+{
+	EFSM_TransitionResult Result;
+	TCoroutine<> Coroutine = TryPushState(Result, InStateClass, Label);
+
+	if (bOutPrematureResult)
 	{
-		FSM_LOG(Log, "Impossible to immediately push state [%s] as it's already present on the states stack. "
-			"The operation will be queued.", *GetNameSafe(InStateClass));
+		*bOutPrematureResult = IsTransitionAccepted(Result);
+	}
+
+	co_await Coroutine;
+}
 
-		co_await AddAndWaitPendingPushRequest(OutHandle, InStateClass, Label);
+TCoroutine<> UFiniteStateMachine::TryPushState(EFSM_TransitionResult& OutResult,
+	TSubclassOf<UMachineState> InStateClass, FGameplayTag Label)
+{
+	// The result is written before anything suspends, so that the caller can read it right away
+	const EFSM_TransitionResult Result = CanPushState(InStateClass, Label);
+	if (Result != EFSM_TransitionResult::Success)
+	{
+		OutResult = Result;
+		ensure(Result != EFSM_TransitionResult::NotInitialized);
+		LogTransitionFailure(TEXT("PushState"), Result, InStateClass, Label);
 		co_return;
 	}
 
+	if (!IsActiveStateDispatchingEvent())
+	{
+		OutResult = EFSM_TransitionResult::Success;
+		PushState_Implementation(InStateClass, Label);
+	}
+	else
+	{
+		OutResult = EFSM_TransitionResult::Deferred;
+		PushState_LatentImplementation(InStateClass, Label);
+	}
+}
+
+EFSM_TransitionResult UFiniteStateMachine::CanPushState(TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label) const
+{
+	if (!HasBeenInitialized())
+	{
+		return EFSM_TransitionResult::NotInitialized;
+	}
+
+	if (!IsValid(InStateClass))
+	{
+		return EFSM_TransitionResult::InvalidState;
+	}
+
+	if (IsInState(InStateClass, true) || IsStateInRegion(InStateClass))
+	{
+		return EFSM_TransitionResult::AlreadyOnStack;
+	}
+
 	if (!IsStateRegistered(InStateClass))
 	{
-		FSM_LOG(Log, "State [%s] is not registered in state machine. The operation will be queued.",
-			*InStateClass->GetName());
+		return EFSM_TransitionResult::NotRegistered;
+	}
 
-		co_await AddAndWaitPendingPushRequest(OutHandle, InStateClass, Label);
-		co_return;
+	if (!UMachineState::IsLabelTagCorrect(Label))
+	{
+		return EFSM_TransitionResult::InvalidLabel;
+	}
+
+	if (IsTransitionBlockedTo(InStateClass))
+	{
+		return EFSM_TransitionResult::Blocked;
 	}
 
 	if (bIsRunningLatentRequest)
 	{
-		FSM_LOG(Log, "A latent request is already running. Avoid calling multiple of them at once. "
-			"The operation will be queued.");
+		return EFSM_TransitionResult::LatentBusy;
+	}
 
-		co_await AddAndWaitPendingPushRequest(OutHandle, InStateClass, Label);
+	return EFSM_TransitionResult::Success;
+}
+
+TCoroutine<> UFiniteStateMachine::PushStateQueued(FFSM_PushRequestHandle& OutHandle,
+	TSubclassOf<UMachineState> InStateClass, FGameplayTag Label, int32 Priority, float Timeout)
+{
+	if (!IsValid(InStateClass))
+	{
+		FSM_LOG(Warning, "Invalid state class.");
+		co_return;
+	}
+
+	if (!UMachineState::IsLabelTagCorrect(Label))
+	{
+		FSM_LOG(Warning, "Label [%s] is of wrong tag hierarchy.", *Label.ToString());
+		co_return;
+	}
+
+	const EFSM_TransitionResult Result = CanPushState(InStateClass, Label);
+	if (Result != EFSM_TransitionResult::Success)
+	{
+		FSM_LOG(Log, "Impossible to immediately push state [%s]. Result [%s]. The operation will be queued.",
+			*GetNameSafe(InStateClass), *UEnum::GetValueAsString(Result));
+
+		co_await AddAndWaitPendingPushRequest(OutHandle, InStateClass, Label, Priority, Timeout);
 		co_return;
 	}
 
@@ -568,38 +953,183 @@ TCoroutine<> UFiniteStateMachine::PushStateQueued(FFSM_PushRequestHandle& OutHan
 
 bool UFiniteStateMachine::PopState()
 {
-	if (!ensure(HasBeenInitialized()))
+	const EFSM_TransitionResult Result = TryPopState();
+	return IsTransitionAccepted(Result);
+}
+
+EFSM_TransitionResult UFiniteStateMachine::TryPopState()
+{
+	const EFSM_TransitionResult Result = CanPopState();
+	if (Result != EFSM_TransitionResult::Success)
 	{
-		FSM_LOG(Warning, "Impossible to pop a state before initialization.");
-		return false;
+		ensure(Result != EFSM_TransitionResult::NotInitialized);
+		LogTransitionFailure(TEXT("PopState"), Result);
+		return Result;
+	}
+
+	if (!IsActiveStateDispatchingEvent())
+	{
+		PopState_Implementation();
+		return EFSM_TransitionResult::Success;
+	}
+
+	PopState_LatentImplementation();
+	return EFSM_TransitionResult::Deferred;
+}
+
+EFSM_TransitionResult UFiniteStateMachine::CanPopState() const
+{
+	if (!HasBeenInitialized())
+	{
+		return EFSM_TransitionResult::NotInitialized;
 	}
 
 	if (StatesStack.IsEmpty())
 	{
-		FSM_LOG(Warning, "Impossible to pop a state from states stack as it's empty.");
-		return false;
+		return EFSM_TransitionResult::NoActiveState;
 	}
 
 	if (bIsRunningLatentRequest)
 	{
-		FSM_LOG(Warning, "A latent request is already running. Avoid calling multiple of them at once.");
-		return false;
+		return EFSM_TransitionResult::LatentBusy;
 	}
 
-	if (!IsActiveStateDispatchingEvent())
+	return EFSM_TransitionResult::Success;
+}
+
+void UFiniteStateMachine::EnqueueTransitionCommand(const FFSM_TransitionCommand& Command)
+{
+	TransitionCommands.Enqueue(Command);
+}
+
+int32 UFiniteStateMachine::ProcessTransitionCommands()
+{
+	check(IsInGameThread());
+
+	TransitionCommandsBatch.Reset();
+
+	FFSM_TransitionCommand Command;
+	while (TransitionCommands.Dequeue(Command))
 	{
-		PopState_Implementation();
+		TransitionCommandsBatch.Add(Command);
 	}
-	else
+
+	// Posting order of different threads is not deterministic, so it only decides among the commands of the same key
+	Algo::StableSort(TransitionCommandsBatch, [](const FFSM_TransitionCommand& Lhs, const FFSM_TransitionCommand& Rhs)
+	{
+		return Lhs.Priority != Rhs.Priority ? Lhs.Priority > Rhs.Priority : Lhs.SortKey < Rhs.SortKey;
+	});
+
+	auto IsMadeRedundantBy = [](const FFSM_TransitionCommand& Current, const FFSM_TransitionCommand& Previous)
+	{
+		if (Current.Type != Previous.Type)
+		{
+			return false;
+		}
+
+		switch (Current.Type)
+		{
+		case EFSM_TransitionCommandType::GotoState:
+		case EFSM_TransitionCommandType::GotoLabel:
+			return true;
+		case EFSM_TransitionCommandType::PushState:
+			return Current.StateClass == Previous.StateClass && Current.Label == Previous.Label;
+		default:
+			return false;
+		}
+	};
+
+	int32 PerformedCommandsNum = 0;
+	for (int32 i = 0; i < TransitionCommandsBatch.Num(); i++)
 	{
-		PopState_LatentImplementation();
+		// Out of a run of redundant commands, the last one of the highest priority wins, i.e. the one of the highest
+		// sort key, or the last posted one among the same keys
+		int32 WinnerIndex = i;
+		for (; i + 1 < TransitionCommandsBatch.Num() &&
+			IsMadeRedundantBy(TransitionCommandsBatch[i + 1], TransitionCommandsBatch[i]); i++)
+		{
+			if (TransitionCommandsBatch[i + 1].Priority == TransitionCommandsBatch[WinnerIndex].Priority)
+			{
+				WinnerIndex = i + 1;
+			}
+		}
+
+		const FFSM_TransitionCommand& Current = TransitionCommandsBatch[WinnerIndex];
+
+		switch (Current.Type)
+		{
+		case EFSM_TransitionCommandType::GotoState:
+			if (bCoalesceGotoState)
+			{
+				RequestGotoState(Current.StateClass, Current.Label, Current.Priority, Current.bForceEvents);
+			}
+			else
+			{
+				TryGotoState(Current.StateClass, Current.Label, Current.bForceEvents);
+			}
+			break;
+		case EFSM_TransitionCommandType::EndState:
+			TryEndState();
+			break;
+		case EFSM_TransitionCommandType::PushState:
+			PushState(Current.StateClass, Current.Label);
+			break;
+		case EFSM_TransitionCommandType::PopState:
+			TryPopState();
+			break;
+		case EFSM_TransitionCommandType::GotoLabel:
+			GotoLabel(Current.Label);
+			break;
+		}
+
+		PerformedCommandsNum++;
 	}
 
-	return true;
+	FSM_LOG(VeryVerbose, "Performed transition commands [%d] Coalesced [%d]", PerformedCommandsNum,
+		TransitionCommandsBatch.Num() - PerformedCommandsNum);
+
+	TransitionCommandsBatch.Reset();
+	return PerformedCommandsNum;
+}
+
+FFSM_StateSnapshot UFiniteStateMachine::GetStateSnapshot() const
+{
+	uint64 Words[StateSnapshotWordsNum];
+	while (true)
+	{
+		const uint32 SequenceBefore = SnapshotSequence.load(std::memory_order_acquire);
+		if (SequenceBefore & 1)
+		{
+			// The game thread is writing it right now
+			FPlatformProcess::Yield();
+			continue;
+		}
+
+		for (int32 i = 0; i < StateSnapshotWordsNum; i++)
+		{
+			Words[i] = StateSnapshotWords[i].load(std::memory_order_relaxed);
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		// Retry if the game thread has published a new one while we were copying
+		const uint32 SequenceAfter = SnapshotSequence.load(std::memory_order_relaxed);
+		if (SequenceBefore == SequenceAfter)
+		{
+			FFSM_StateSnapshot Result;
+			FMemory::Memcpy(&Result, Words, sizeof(FFSM_StateSnapshot));
+			return Result;
+		}
+	}
+}
+
+bool UFiniteStateMachine::IsTransitionAccepted(EFSM_TransitionResult Result)
+{
+	return Result == EFSM_TransitionResult::Success || Result == EFSM_TransitionResult::Deferred;
 }
 
 TCoroutine<> UFiniteStateMachine::AddAndWaitPendingPushRequest(FFSM_PushRequestHandle& OutHandle,
-	TSubclassOf<UMachineState> InStateClass, FGameplayTag Label)
+	TSubclassOf<UMachineState> InStateClass, FGameplayTag Label, int32 Priority, float Timeout)
 {
 	FFSM_PushRequestHandle Handle;
 	Handle.StateMachine = this;
@@ -608,14 +1138,33 @@ TCoroutine<> UFiniteStateMachine::AddAndWaitPendingPushRequest(FFSM_PushRequestH
 
 	OutHandle = Handle;
 
-	// Push a request to the queue
-	FPendingPushRequest& Request = PendingPushRequests.AddDefaulted_GetRef();
+	FPendingPushRequest Request;
 	Request.StateClass = InStateClass;
 	Request.Label = Label;
 	Request.ID = Handle.ID;
+	Request.Priority = Priority;
 
-	FSM_LOG(VeryVerbose, "Add pending push request. ID [%d] State [%s] Label [%s]",
-		Handle.ID, *InStateClass->GetName(), *Label.ToString());
+	if (Timeout > 0.f)
+	{
+		Request.ExpirationTime = GetWorld()->GetTimeSeconds() + Timeout;
+		if (NextPushRequestExpirationTime < 0.0 || Request.ExpirationTime < NextPushRequestExpirationTime)
+		{
+			NextPushRequestExpirationTime = Request.ExpirationTime;
+		}
+	}
+
+	// Push a request to the queue; keep the queueing order among the requests of the same priority
+	int32 InsertIndex = PendingPushRequests.Num();
+	if (PushQueuePolicy != EFSM_PushQueuePolicy::StrictFIFO)
+	{
+		InsertIndex = Algo::UpperBoundBy(PendingPushRequests, Priority,
+			[](const FPendingPushRequest& Item) { return Item.Priority; }, TGreater<>());
+	}
+
+	PendingPushRequests.Insert(Request, InsertIndex);
+
+	FSM_LOG(VeryVerbose, "Add pending push request. ID [%d] State [%s] Label [%s] Priority [%d] Timeout [%.2f]",
+		Handle.ID, *InStateClass->GetName(), *Label.ToString(), Priority, Timeout);
 
 	// Wait until the request is not handled
 	while (true)
@@ -633,38 +1182,127 @@ TCoroutine<> UFiniteStateMachine::AddAndWaitPendingPushRequest(FFSM_PushRequestH
 
 void UFiniteStateMachine::UpdatePushQueue()
 {
-	if (!PendingPushRequests.IsEmpty())
+	if (PendingPushRequests.IsEmpty())
+	{
+		return;
+	}
+
+	if (PushQueuePolicy != EFSM_PushQueuePolicy::FirstExecutable)
 	{
 		const FPendingPushRequest Request = PendingPushRequests[0];
 		PushState_Pending(Request);
+		return;
+	}
+
+	// Don't let a blocked request stall the ones behind it
+	for (int32 i = 0; i < PendingPushRequests.Num(); i++)
+	{
+		const FPendingPushRequest Request = PendingPushRequests[i];
+		if (PushState_Pending(Request))
+		{
+			return;
+		}
+	}
+}
+
+void UFiniteStateMachine::DrainPushQueue()
+{
+	// Consider the draining a transition on its own, so that the pushes it performs only mark the queue dirty instead of
+	// updating it recursively
+	TransitionDepth++;
+
+	while (bIsPushQueueDirty)
+	{
+		bIsPushQueueDirty = false;
+		UpdatePushQueue();
+	}
+
+	TransitionDepth--;
+
+	if (TransitionDepth == 0)
+	{
+		PublishPendingStateSnapshot();
+	}
+}
+
+void UFiniteStateMachine::CancelExpiredPushRequests()
+{
+	const double CurrentTime = GetWorld()->GetTimeSeconds();
+
+	// Copy the requests, as canceling them might result into pushing new ones
+	const TArray<FPendingPushRequest> Requests = PendingPushRequests;
+
+	NextPushRequestExpirationTime = -1.0;
+	for (const FPendingPushRequest& Request : Requests)
+	{
+		if (Request.ExpirationTime < 0.0)
+		{
+			continue;
+		}
+
+		if (Request.ExpirationTime <= CurrentTime)
+		{
+			FSM_LOG(Verbose, "Pending push request has expired. ID [%d] State [%s]", Request.ID,
+				*Request.StateClass->GetName());
+
+			FFSM_PushRequestHandle Handle;
+			Handle.StateMachine = this;
+			Handle.ID = Request.ID;
+			CancelPushRequest(Handle);
+		}
+		else if (NextPushRequestExpirationTime < 0.0 || Request.ExpirationTime < NextPushRequestExpirationTime)
+		{
+			NextPushRequestExpirationTime = Request.ExpirationTime;
+		}
+	}
+}
+
+void UFiniteStateMachine::CancelPushRequestAt(int32 Index)
+{
+	const FPendingPushRequest PushRequest = PendingPushRequests[Index];
+	PendingPushRequests.RemoveAt(Index);
+
+	FSM_LOG(VeryVerbose, "Cancel pending push request. ID [%d] State [%s] Label [%s]",
+		PushRequest.ID, *PushRequest.StateClass->GetName(), *PushRequest.Label.ToString());
+
+	const FOnPendingPushRequestSignature* FoundDelegate = OnPendingPushRequestResultDelegates.Find(PushRequest.ID);
+	if (FoundDelegate)
+	{
+		FoundDelegate->Broadcast(EFSM_PendingPushRequestResult::Canceled);
+
+		// Remove the delegates as this one will never be fired anymore
+		OnPendingPushRequestResultDelegates.Remove(PushRequest.ID);
 	}
+
+	OnPushRequestResultDelegate.Broadcast(PushRequest.ID, EPushRequestResult::Canceled);
 }
 
-void UFiniteStateMachine::PushState_Pending(FPendingPushRequest Request)
+bool UFiniteStateMachine::PushState_Pending(FPendingPushRequest Request)
 {
 	if (!HasBeenInitialized())
 	{
-		return;
+		return false;
 	}
 
-	if (IsInState(Request.StateClass))
+	// Requests are not necessarily tried in the stack order anymore, hence check the whole stack
+	if (IsInState(Request.StateClass, true) || IsStateInRegion(Request.StateClass))
 	{
-		return;
+		return false;
 	}
 
 	if (IsTransitionBlockedTo(Request.StateClass))
 	{
-		return;
+		return false;
 	}
 
 	if (!IsStateRegistered(Request.StateClass))
 	{
-		return;
+		return false;
 	}
 
 	if (bIsRunningLatentRequest)
 	{
-		return;
+		return false;
 	}
 
 	// Sanity check; Should never happen
@@ -697,6 +1335,7 @@ void UFiniteStateMachine::PushState_Pending(FPendingPushRequest Request)
 
 	// Notify about the action
 	OnPushRequestResultDelegate.Broadcast(Request.ID, EPushRequestResult::Success);
+	return true;
 }
 
 int32 UFiniteStateMachine::ClearStack()
@@ -708,6 +1347,9 @@ int32 UFiniteStateMachine::ClearStack()
 		return 0;
 	}
 
+	// Let the queued push requests be executed only once the stack is cleared
+	FFSM_TransitionScope TransitionScope(this);
+
 	int32 StatesPopped = 0;
 	while (!StatesStack.IsEmpty() && EndState())
 	{
@@ -717,6 +1359,215 @@ int32 UFiniteStateMachine::ClearStack()
 	return StatesPopped;
 }
 
+bool UFiniteStateMachine::AddRegion(const FFSM_RegionDefinition& Definition)
+{
+	if (!Definition.RegionTag.MatchesTag(TAG_StateMachine_Region))
+	{
+		FSM_LOG(Warning, "Region [%s] is of wrong tag hierarchy.", *Definition.RegionTag.ToString());
+		return false;
+	}
+
+	const bool bIsDefined = RegionDefinitions.ContainsByPredicate([&Definition](const FFSM_RegionDefinition& Item)
+	{
+		return Item.RegionTag == Definition.RegionTag;
+	});
+
+	if (bIsDefined || FindRegionIndex(Definition.RegionTag) != INDEX_NONE)
+	{
+		FSM_LOG(Warning, "Region [%s] is already defined.", *Definition.RegionTag.ToString());
+		return false;
+	}
+
+	if (!HasBeenInitialized())
+	{
+		RegionDefinitions.Add(Definition);
+		return true;
+	}
+
+	FRegion& Region = Regions.AddDefaulted_GetRef();
+	Region.Definition = Definition;
+
+	if (bActiveStatesBegan && IsValid(Definition.InitialState))
+	{
+		GotoStateInRegion(Definition.RegionTag, Definition.InitialState, Definition.InitialStateLabel);
+	}
+
+	return true;
+}
+
+bool UFiniteStateMachine::GotoStateInRegion(FGameplayTag Region, TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label, bool bForceEvents)
+{
+	const int32 RegionIndex = FindRegionIndex(Region);
+	const EFSM_TransitionResult Result = CanEnterRegion(RegionIndex, InStateClass, Label, true);
+	if (Result != EFSM_TransitionResult::Success)
+	{
+		LogTransitionFailure(TEXT("GotoStateInRegion"), Result, InStateClass, Label);
+		return false;
+	}
+
+	RunRegionTransition(RegionIndex, [this, RegionIndex, InStateClass, Label]
+	{
+		return CanEnterRegion(RegionIndex, InStateClass, Label, true);
+	},
+	[this, RegionIndex, InStateClass, Label, bForceEvents]
+	{
+		GotoStateInRegion_Implementation(RegionIndex, InStateClass, Label, bForceEvents);
+	});
+
+	return true;
+}
+
+bool UFiniteStateMachine::PushStateInRegion(FGameplayTag Region, TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label)
+{
+	const int32 RegionIndex = FindRegionIndex(Region);
+	const EFSM_TransitionResult Result = CanEnterRegion(RegionIndex, InStateClass, Label, false);
+	if (Result != EFSM_TransitionResult::Success)
+	{
+		LogTransitionFailure(TEXT("PushStateInRegion"), Result, InStateClass, Label);
+		return false;
+	}
+
+	RunRegionTransition(RegionIndex, [this, RegionIndex, InStateClass, Label]
+	{
+		return CanEnterRegion(RegionIndex, InStateClass, Label, false);
+	},
+	[this, RegionIndex, InStateClass, Label]
+	{
+		PushStateInRegion_Implementation(RegionIndex, InStateClass, Label);
+	});
+
+	return true;
+}
+
+bool UFiniteStateMachine::PopStateInRegion(FGameplayTag Region)
+{
+	const int32 RegionIndex = FindRegionIndex(Region);
+	const EFSM_TransitionResult Result = CanLeaveRegion(RegionIndex);
+	if (Result != EFSM_TransitionResult::Success)
+	{
+		LogTransitionFailure(TEXT("PopStateInRegion"), Result);
+		return false;
+	}
+
+	RunRegionTransition(RegionIndex, [this, RegionIndex]
+	{
+		return CanLeaveRegion(RegionIndex);
+	},
+	[this, RegionIndex]
+	{
+		RemoveStateInRegion_Implementation(RegionIndex, EStateAction::Pop);
+	});
+
+	return true;
+}
+
+bool UFiniteStateMachine::EndStateInRegion(FGameplayTag Region)
+{
+	const int32 RegionIndex = FindRegionIndex(Region);
+	const EFSM_TransitionResult Result = CanLeaveRegion(RegionIndex);
+	if (Result != EFSM_TransitionResult::Success)
+	{
+		LogTransitionFailure(TEXT("EndStateInRegion"), Result);
+		return false;
+	}
+
+	RunRegionTransition(RegionIndex, [this, RegionIndex]
+	{
+		return CanLeaveRegion(RegionIndex);
+	},
+	[this, RegionIndex]
+	{
+		RemoveStateInRegion_Implementation(RegionIndex, EStateAction::End);
+	});
+
+	return true;
+}
+
+int32 UFiniteStateMachine::ClearStackInRegion(FGameplayTag Region)
+{
+	const int32 RegionIndex = FindRegionIndex(Region);
+	if (RegionIndex == INDEX_NONE)
+	{
+		FSM_LOG(Warning, "Region [%s] is not defined.", *Region.ToString());
+		return 0;
+	}
+
+	const UMachineState* DispatchingState = FindDispatchingState(Regions[RegionIndex].ActiveState);
+	if (IsValid(DispatchingState))
+	{
+		FSM_LOG(Warning, "State [%s] is dispatching an event. It's impossible to clear the stack of region [%s].",
+			*DispatchingState->GetName(), *Region.ToString());
+		return 0;
+	}
+
+	// Let the queued push requests be executed only once the stack is cleared
+	FFSM_TransitionScope TransitionScope(this);
+
+	int32 StatesEnded = 0;
+	while (!Regions[RegionIndex].StatesStack.IsEmpty() && EndStateInRegion(Region))
+	{
+		StatesEnded++;
+	}
+
+	return StatesEnded;
+}
+
+UMachineState* UFiniteStateMachine::GetActiveStateInRegion(FGameplayTag Region) const
+{
+	const int32 RegionIndex = FindRegionIndex(Region);
+	return RegionIndex != INDEX_NONE ? Regions[RegionIndex].ActiveState.Get() : nullptr;
+}
+
+bool UFiniteStateMachine::IsInStateInRegion(FGameplayTag Region, TSubclassOf<UMachineState> InStateClass,
+	bool bCheckStack) const
+{
+	const int32 RegionIndex = FindRegionIndex(Region);
+	if (RegionIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FRegion& FoundRegion = Regions[RegionIndex];
+	if (!bCheckStack)
+	{
+		return IsValid(FoundRegion.ActiveState) && FoundRegion.ActiveState->GetClass() == InStateClass;
+	}
+
+	for (const TObjectPtr<UMachineState> State : FoundRegion.StatesStack)
+	{
+		if (State->GetClass() == InStateClass)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UFiniteStateMachine::GetRegions(TArray<FGameplayTag>& OutRegions) const
+{
+	OutRegions.Reset(Regions.Num());
+	for (const FRegion& Region : Regions)
+	{
+		OutRegions.Add(Region.Definition.RegionTag);
+	}
+}
+
+TArray<UMachineState*> UFiniteStateMachine::GetStatesStackInRegion(FGameplayTag Region) const
+{
+	TArray<UMachineState*> ReturnValue;
+
+	const int32 RegionIndex = FindRegionIndex(Region);
+	if (RegionIndex != INDEX_NONE)
+	{
+		ReturnValue.Append(Regions[RegionIndex].StatesStack);
+	}
+
+	return ReturnValue;
+}
+
 int32 UFiniteStateMachine::StopEveryLatentExecution()
 {
 	int32 StoppedLatentExecutios = 0;
@@ -725,6 +1576,11 @@ int32 UFiniteStateMachine::StopEveryLatentExecution()
 		StoppedLatentExecutios += State->StopLatentExecution_Implementation();
 	}
 
+	for (const TObjectPtr<UMachineState> SubState : RegisteredSubStates)
+	{
+		StoppedLatentExecutios += SubState->StopLatentExecution_Implementation();
+	}
+
 	if (StoppedLatentExecutios > 0)
 	{
 		FSM_LOG(VeryVerbose, "All [%d] latent executions have been cancelled.", StoppedLatentExecutios);
@@ -741,6 +1597,11 @@ int32 UFiniteStateMachine::StopEveryRunningLabel()
 		StoppedLabels += State->StopRunningLabels();
 	}
 
+	for (const TObjectPtr<UMachineState> SubState : RegisteredSubStates)
+	{
+		StoppedLabels += SubState->StopRunningLabels();
+	}
+
 	if (StoppedLabels > 0)
 	{
 		FSM_LOG(VeryVerbose, "All [%d] running labels have been cancelled.", StoppedLabels);
@@ -749,30 +1610,36 @@ int32 UFiniteStateMachine::StopEveryRunningLabel()
 	return StoppedLabels;
 }
 
-bool UFiniteStateMachine::CancelPushRequest(FFSM_PushRequestHandle Handle)
+int32 UFiniteStateMachine::CancelEveryPushRequest()
 {
-	const int32 FoundIndex = PendingPushRequests.Find(FPendingPushRequest(Handle.ID));
-	if (FoundIndex == INDEX_NONE)
+	// Canceling the requests might result into pushing new ones, which are newer than any request pending now
+	const uint32 FirstNewRequestID = FFSM_PushRequestHandle::s_ID;
+	auto IsOldRequest = [FirstNewRequestID](const FPendingPushRequest& Request)
 	{
-		return false;
-	}
+		return Request.ID < FirstNewRequestID;
+	};
 
-	const FPendingPushRequest PushRequest = PendingPushRequests[FoundIndex];
-	PendingPushRequests.RemoveAt(FoundIndex);
+	// Cancel from the back, so that the remaining requests don't have to be moved
+	int32 CanceledRequests = 0;
+	for (int32 Index = PendingPushRequests.FindLastByPredicate(IsOldRequest); Index != INDEX_NONE;
+		Index = PendingPushRequests.FindLastByPredicate(IsOldRequest))
+	{
+		CancelPushRequestAt(Index);
+		CanceledRequests++;
+	}
 
-	FSM_LOG(VeryVerbose, "Cancel pending push request. ID [%d] State [%s] Label [%s]",
-		PushRequest.ID, *PushRequest.StateClass->GetName(), *PushRequest.Label.ToString());
+	return CanceledRequests;
+}
 
-	const FOnPendingPushRequestSignature* FoundDelegate = OnPendingPushRequestResultDelegates.Find(Handle.ID);
-	if (FoundDelegate)
+bool UFiniteStateMachine::CancelPushRequest(FFSM_PushRequestHandle Handle)
+{
+	const int32 FoundIndex = PendingPushRequests.Find(FPendingPushRequest(Handle.ID));
+	if (FoundIndex == INDEX_NONE)
 	{
-		FoundDelegate->Broadcast(EFSM_PendingPushRequestResult::Canceled);
-
-		// Remove the delegates as this one will never be fired anymore
-		OnPendingPushRequestResultDelegates.Remove(Handle.ID);
+		return false;
 	}
 
-	OnPushRequestResultDelegate.Broadcast(Handle.ID, EPushRequestResult::Canceled);
+	CancelPushRequestAt(FoundIndex);
 	return true;
 }
 
@@ -782,6 +1649,11 @@ bool UFiniteStateMachine::IsPushRequestPending(FFSM_PushRequestHandle Handle) co
 	return bContains;
 }
 
+int32 UFiniteStateMachine::GetPendingPushRequestsNum() const
+{
+	return PendingPushRequests.Num();
+}
+
 FOnPendingPushRequestSignature& UFiniteStateMachine::GetOnPendingPushRequestResultDelegate(
 	FFSM_PushRequestHandle Handle)
 {
@@ -791,6 +1663,12 @@ FOnPendingPushRequestSignature& UFiniteStateMachine::GetOnPendingPushRequestResu
 	return OnPendingPushRequestResultDelegates.FindOrAdd(Handle.ID);
 }
 
+FFSM_StateActionAwaiter UFiniteStateMachine::WaitForStateAction(TSubclassOf<UMachineState> InStateClass,
+	EFSM_StateActionMask Actions) const
+{
+	return FFSM_StateActionAwaiter(FindState(InStateClass), Actions);
+}
+
 bool UFiniteStateMachine::IsInState(TSubclassOf<UMachineState> InStateClass, bool bCheckStack) const
 {
 	if (!IsValid(ActiveState))
@@ -820,6 +1698,17 @@ bool UFiniteStateMachine::IsInState(TSubclassOf<UMachineState> InStateClass, boo
 
 bool UFiniteStateMachine::IsTransitionBlockedTo(TSubclassOf<UMachineState> InStateClass) const
 {
+	// Use the precompiled transitions whenever both the states are a part of the archetype
+	if (IsValid(ActiveState) && ActiveState->ArchetypeIndex != INDEX_NONE)
+	{
+		const int32 ToIndex = StateMachineArchetype->FindStateIndex(InStateClass);
+		if (ToIndex != INDEX_NONE)
+		{
+			const bool bIsBlocked = StateMachineArchetype->IsTransitionBlocked(ActiveState->ArchetypeIndex, ToIndex);
+			return bIsBlocked;
+		}
+	}
+
 	const bool bIsBlocked = IsStateCurrentlyBlocklisted(InStateClass);
 	const bool bIsAllowed = IsStateCurrentlyAllowlisted(InStateClass);
 	return bIsBlocked || !bIsAllowed;
@@ -827,22 +1716,12 @@ bool UFiniteStateMachine::IsTransitionBlockedTo(TSubclassOf<UMachineState> InSta
 
 bool UFiniteStateMachine::IsStateCurrentlyBlocklisted(TSubclassOf<UMachineState> InStateClass) const
 {
-	if (!IsValid(InStateClass))
-	{
-		return false;
-	}
-
-	if (!IsValid(ActiveState) || !ActiveState->bUseBlocklist)
+	if (!IsValid(ActiveState))
 	{
 		return false;
 	}
 
-	const bool bIsBlocked = ActiveState->StatesBlocklist.ContainsByPredicate(
-		[InStateClass](const TSubclassOf<UMachineState> Item)
-		{
-			return InStateClass->IsChildOf(Item);
-		});
-
+	const bool bIsBlocked = ActiveState->IsStateBlocklisted(InStateClass);
 	return bIsBlocked;
 }
 
@@ -853,17 +1732,12 @@ bool UFiniteStateMachine::IsStateCurrentlyAllowlisted(TSubclassOf<UMachineState>
 		return false;
 	}
 
-	if (!IsValid(ActiveState) || !ActiveState->bUseAllowlist)
+	if (!IsValid(ActiveState))
 	{
 		return true;
 	}
 
-	const bool bIsAllowed = ActiveState->StatesAllowlist.ContainsByPredicate(
-		[InStateClass](const TSubclassOf<UMachineState> Item)
-		{
-			return InStateClass->IsChildOf(Item);
-		});
-
+	const bool bIsAllowed = ActiveState->IsStateAllowlisted(InStateClass);
 	return bIsAllowed;
 }
 
@@ -971,6 +1845,81 @@ TSubclassOf<UMachineState> UFiniteStateMachine::GetGlobalStateClass() const
 	return GlobalStateClass;
 }
 
+UFiniteStateMachineArchetype* UFiniteStateMachine::GetStateMachineArchetype() const
+{
+	return StateMachineArchetype;
+}
+
+void UFiniteStateMachine::SetGotoStateCoalescingPolicy(EFSM_GotoStateCoalescingPolicy InPolicy)
+{
+	GotoStateCoalescingPolicy = InPolicy;
+}
+
+EFSM_GotoStateCoalescingPolicy UFiniteStateMachine::GetGotoStateCoalescingPolicy() const
+{
+	return GotoStateCoalescingPolicy;
+}
+
+void UFiniteStateMachine::SetPushQueuePolicy(EFSM_PushQueuePolicy InPolicy)
+{
+	PushQueuePolicy = InPolicy;
+
+	if (PushQueuePolicy != EFSM_PushQueuePolicy::StrictFIFO)
+	{
+		// Keep the queueing order among the requests of the same priority
+		Algo::StableSortBy(PendingPushRequests, [](const FPendingPushRequest& Item) { return Item.Priority; },
+			TGreater<>());
+	}
+	else
+	{
+		// Handle IDs grow monotonically, hence they reflect the queueing order
+		Algo::SortBy(PendingPushRequests, [](const FPendingPushRequest& Item) { return Item.ID; });
+	}
+}
+
+EFSM_PushQueuePolicy UFiniteStateMachine::GetPushQueuePolicy() const
+{
+	return PushQueuePolicy;
+}
+
+void UFiniteStateMachine::SetTimeSliceStateTicks(bool bInTimeSlice)
+{
+	if (bTimeSliceStateTicks == bInTimeSlice)
+	{
+		return;
+	}
+
+	bTimeSliceStateTicks = bInTimeSlice;
+	TimeSlicedDeltaTime = 0.f;
+
+	if (Registry.IsValid() && RegistryIndex != INDEX_NONE)
+	{
+		if (bTimeSliceStateTicks)
+		{
+			Registry->AddTimeSlicedStateMachine(this);
+		}
+		else
+		{
+			Registry->RemoveTimeSlicedStateMachine(this);
+		}
+	}
+}
+
+bool UFiniteStateMachine::IsTimeSlicingStateTicks() const
+{
+	return bTimeSliceStateTicks;
+}
+
+void UFiniteStateMachine::SetAddStatesToOwnerCluster(bool bInAddStatesToOwnerCluster)
+{
+	bAddStatesToOwnerCluster = bInAddStatesToOwnerCluster;
+}
+
+bool UFiniteStateMachine::IsAddingStatesToOwnerCluster() const
+{
+	return bAddStatesToOwnerCluster;
+}
+
 AActor* UFiniteStateMachine::GetAvatar() const
 {
 	AActor* Owner = GetOwner();
@@ -1002,81 +1951,446 @@ TArray<UFiniteStateMachine::FDebugStateAction> UFiniteStateMachine::GetLastState
 {
 	TArray<FDebugStateAction> ReturnValue;
 
-	const int32 Num = LastStateActionsStack.Num();
-	for (int32 i = Num - 1; i >= 0; i--)
+	const int32 Num = LastStateActionsStack.Num();
+	for (int32 i = Num - 1; i >= 0; i--)
+	{
+		ReturnValue.Add(LastStateActionsStack[i]);
+	}
+
+	return ReturnValue;
+}
+#endif
+
+void UFiniteStateMachine::OnStateAction(UMachineState* State, EStateAction StateAction)
+{
+#ifdef WITH_EDITOR
+	FDebugStateAction Action;
+	Action.State = State;
+	Action.Action = StateAction;
+	Action.ActionTime = GetWorld()->GetTimeSeconds();
+
+	// Save the action for debug purposes
+	LastStateActionsStack.Add(Action);
+
+	// Don't store too many entries; a hundred should be more than enough
+	constexpr int32 MaxSize = 100;
+	if (LastStateActionsStack.Num() > MaxSize)
+	{
+		LastStateActionsStack.RemoveAt(0);
+	}
+#endif
+
+	// Sub-states are owned by their parent state rather than by the stack, so they neither change its snapshot nor get
+	// indexed, and GotoSubState must not dispatch pending push requests in the middle of its own transition
+	if (IsValid(State->ParentState))
+	{
+		if (Registry.IsValid())
+		{
+			Registry->UpdateUnindexedRuleStates(this, State, StateAction);
+		}
+
+		return;
+	}
+
+	PublishStateSnapshot(StateAction);
+
+	if (Registry.IsValid())
+	{
+		if (State != ActiveGlobalState)
+		{
+			Registry->UpdateStateIndex(this, State, StateAction);
+		}
+		else
+		{
+			Registry->UpdateUnindexedRuleStates(this, State, StateAction);
+		}
+	}
+
+	// Anytime the stack is changed, update the queue so that any pending request is dispatched. Changes happening during
+	// a transition are batched, and the queue is drained only once it completes
+	bIsPushQueueDirty = true;
+	if (TransitionDepth == 0)
+	{
+		DrainPushQueue();
+	}
+}
+
+void UFiniteStateMachine::NotifyStateActionObservers(UMachineState* State, EStateAction StateAction,
+	TSubclassOf<UMachineState> OtherState)
+{
+	UFiniteStateMachineSubsystem* Subsystem = Registry.Get();
+	if (Subsystem && Subsystem->HasStateActionObservers())
+	{
+		Subsystem->NotifyStateAction(this, State, StateAction, OtherState);
+	}
+}
+
+void UFiniteStateMachine::PublishStateSnapshot(EStateAction StateAction)
+{
+	check(IsInGameThread());
+
+	if (TransitionDepth > 0)
+	{
+		// The stack and the active state might not match yet
+		bIsStateSnapshotPending = true;
+		if (StateAction != EStateAction::None)
+		{
+			PendingSnapshotStateAction = StateAction;
+			StateSnapshot.LastStateActionTime = GetWorld()->GetTimeSeconds();
+		}
+
+		return;
+	}
+
+	const uint32 Sequence = SnapshotSequence.load(std::memory_order_relaxed);
+	StateSnapshot.Version = Sequence / 2 + 1;
+	StateSnapshot.ActiveStateIndex = IsValid(ActiveState) ? RegisteredStates.Find(ActiveState) : INDEX_NONE;
+	StateSnapshot.ActiveStateClass = IsValid(ActiveState) ? ActiveState->GetClass() : nullptr;
+	StateSnapshot.ActiveLabel = IsValid(ActiveState) ? ActiveState->ActiveLabel : FGameplayTag::EmptyTag;
+	StateSnapshot.StackDepth = StatesStack.Num();
+
+	const int32 StackNum = FMath::Min(StatesStack.Num(), FFSM_StateSnapshot::MaxStackDepth);
+	for (int32 i = 0; i < FFSM_StateSnapshot::MaxStackDepth; i++)
+	{
+		StateSnapshot.Stack[i] = i < StackNum ? StatesStack[i].Get() : nullptr;
+	}
+
+	if (StateAction != EStateAction::None)
+	{
+		StateSnapshot.LastStateAction = StateAction;
+		StateSnapshot.LastStateActionTime = GetWorld()->GetTimeSeconds();
+	}
+
+	static_assert(std::is_trivially_copyable_v<FFSM_StateSnapshot>, "State snapshot is copied as raw words.");
+	uint64 Words[StateSnapshotWordsNum] = { };
+	FMemory::Memcpy(Words, &StateSnapshot, sizeof(FFSM_StateSnapshot));
+
+	// Odd sequence tells the readers the snapshot is being written
+	SnapshotSequence.store(Sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for (int32 i = 0; i < StateSnapshotWordsNum; i++)
+	{
+		StateSnapshotWords[i].store(Words[i], std::memory_order_relaxed);
+	}
+
+	SnapshotSequence.store(Sequence + 2, std::memory_order_release);
+}
+
+void UFiniteStateMachine::PublishPendingStateSnapshot()
+{
+	if (!bIsStateSnapshotPending)
+	{
+		return;
+	}
+
+	bIsStateSnapshotPending = false;
+
+	// The time of the action has already been recorded
+	const EStateAction StateAction = PendingSnapshotStateAction;
+	PendingSnapshotStateAction = EStateAction::None;
+	if (StateAction != EStateAction::None)
+	{
+		StateSnapshot.LastStateAction = StateAction;
+	}
+
+	PublishStateSnapshot();
+}
+
+void UFiniteStateMachine::BeginActiveStates()
+{
+	ensure(!bActiveStatesBegan);
+
+	if (IsValid(ActiveGlobalState))
+	{
+		bIsBeginningGlobalState = true;
+		ActiveGlobalState->OnStateAction(EStateAction::Begin, nullptr);
+		bIsBeginningGlobalState = false;
+	}
+
+	if (IsValid(ActiveState))
+	{
+		const TSubclassOf<UMachineState> StateClass = ActiveState->GetClass();
+		StatesStack.Push(StateClass);
+
+		ActiveState->OnStateAction(EStateAction::Begin, nullptr);
+	}
+
+	BeginRegions();
+
+	bActiveStatesBegan = true;
+}
+
+void UFiniteStateMachine::InitializeFromArchetype()
+{
+	check(IsValid(StateMachineArchetype));
+
+	StateMachineArchetype->ConditionalCompile();
+	ensureMsgf(StateMachineArchetype->IsConfigurationValid(), TEXT("Finite state machine archetype [%s] is invalid. "
+		"Invalid entries are skipped. Validate the asset to get more details."), *StateMachineArchetype->GetName());
+
+	GlobalStateClass = StateMachineArchetype->GlobalStateClass;
+	InitialState = StateMachineArchetype->InitialState;
+	InitialStateLabel = StateMachineArchetype->InitialStateLabel;
+
+	// If something has been registered before, the archetype lookups might return a different state than the regular
+	// ones would, so we have to rely on the regular ones
+	const bool bUseArchetypeLookups = RegisteredStates.IsEmpty();
+
+	const TArray<FFSM_CompiledState>& CompiledStates = StateMachineArchetype->GetCompiledStates();
+	RegisteredStates.Reserve(CompiledStates.Num());
+
+	for (int32 i = 0; i < CompiledStates.Num(); i++)
+	{
+		const TSubclassOf<UMachineState> StateClass = CompiledStates[i].StateClass;
+		if (!bUseArchetypeLookups)
+		{
+			RegisterState(StateClass);
+			continue;
+		}
+
+		// The archetype has already validated the states
+		UMachineState* State = RegisterState_Implementation(StateClass);
+		State->ArchetypeIndex = i;
+		ArchetypeStates.Add(State);
+	}
+}
+
+UMachineState* UFiniteStateMachine::RegisterState_Implementation(TSubclassOf<UMachineState> InStateClass)
+{
+	AActor* Owner = GetOwner();
+	auto* State = NewObject<UMachineState>(Owner, InStateClass);
+	check(IsValid(State));
+
+	State->SetStateMachine(this);
+
+	AddStateToOwnerCluster(State);
+
+	if (bIsInitialized)
+	{
+		State->PostInitialize();
+	}
+
+	FSM_LOG(Log, "Machine state [%s] has been registered.", *State->GetName());
+
+	RegisteredStates.Add(State);
+
+	if (!State->SubStateClasses.IsEmpty())
+	{
+		RegisterSubStates(State);
+	}
+
+	return State;
+}
+
+void UFiniteStateMachine::RegisterSubStates(UMachineState* ParentState)
+{
+	AActor* Owner = GetOwner();
+	for (const TSubclassOf<UMachineState> SubStateClass : ParentState->SubStateClasses)
+	{
+		if (!IsValid(SubStateClass) || SubStateClass->HasAnyClassFlags(CLASS_Abstract))
+		{
+			FSM_LOG(Warning, "Sub-state class [%s] of state [%s] is either invalid or abstract.",
+				*GetNameSafe(SubStateClass), *ParentState->GetName());
+			continue;
+		}
+
+		if (IsValid(ParentState->FindSubState(SubStateClass)))
+		{
+			FSM_LOG(Warning, "Sub-state class [%s] of state [%s] is already registered.",
+				*SubStateClass->GetName(), *ParentState->GetName());
+			continue;
+		}
+
+		// A state owning itself, directly or not, would nest forever
+		bool bIsAncestor = false;
+		for (const UMachineState* Ancestor = ParentState; IsValid(Ancestor); Ancestor = Ancestor->ParentState)
+		{
+			bIsAncestor |= Ancestor->IsA(SubStateClass);
+		}
+
+		if (bIsAncestor)
+		{
+			FSM_LOG(Warning, "Sub-state class [%s] of state [%s] is one of its parents.",
+				*SubStateClass->GetName(), *ParentState->GetName());
+			continue;
+		}
+
+		auto* SubState = NewObject<UMachineState>(Owner, SubStateClass);
+		check(IsValid(SubState));
+
+		SubState->ParentState = ParentState;
+		SubState->SetStateMachine(this);
+
+		AddStateToOwnerCluster(SubState);
+
+		if (bIsInitialized)
+		{
+			SubState->PostInitialize();
+		}
+
+		FSM_LOG(Log, "Machine sub-state [%s] of state [%s] has been registered.",
+			*SubState->GetName(), *ParentState->GetName());
+
+		ParentState->SubStates.Add(SubState);
+		RegisteredSubStates.Add(SubState);
+
+		if (!SubState->SubStateClasses.IsEmpty())
+		{
+			RegisterSubStates(SubState);
+		}
+	}
+}
+
+void UFiniteStateMachine::TickActiveStates(float DeltaTime, EStateTickFilter Filter)
+{
+	if (IsValid(ActiveGlobalState))
+	{
+		TickStateChain(ActiveGlobalState, DeltaTime, Filter);
+	}
+
+	if (IsValid(ActiveState))
+	{
+		TickStateChain(ActiveState, DeltaTime, Filter);
+	}
+
+	// Regions might be added while ticking
+	for (int32 i = 0; i < Regions.Num(); i++)
+	{
+		UMachineState* State = Regions[i].ActiveState;
+		if (IsValid(State))
+		{
+			TickStateChain(State, DeltaTime, Filter);
+		}
+	}
+}
+
+void UFiniteStateMachine::TickStateChain(UMachineState* State, float DeltaTime, EStateTickFilter Filter)
+{
+	// Sub-states share the tick of the state machine; each one is ticked right after its parent. The state might be
+	// deactivated while ticking, in which case its sub-states are not running anymore
+	for (UMachineState* It = State; IsValid(It) && (It == State || It->IsStateActive()); It = It->ActiveSubState)
+	{
+		if (Filter == EStateTickFilter::All || It->IsUrgent() == (Filter == EStateTickFilter::Urgent))
+		{
+			It->Tick(DeltaTime);
+		}
+	}
+}
+
+bool UFiniteStateMachine::TickTimeSlicedStates()
+{
+	// Not ticked since the last time, e.g. it's been deactivated
+	if (TimeSlicedDeltaTime <= 0.f)
 	{
-		ReturnValue.Add(LastStateActionsStack[i]);
+		return false;
 	}
 
-	return ReturnValue;
+	const float DeltaTime = TimeSlicedDeltaTime;
+	TimeSlicedDeltaTime = 0.f;
+
+	TickActiveStates(DeltaTime, EStateTickFilter::TimeSliced);
+	return true;
 }
-#endif
 
-void UFiniteStateMachine::OnStateAction(UMachineState* State, EStateAction StateAction)
+void UFiniteStateMachine::AddStateToOwnerCluster(UMachineState* State)
 {
-#ifdef WITH_EDITOR
-	FDebugStateAction Action;
-	Action.State = State;
-	Action.Action = StateAction;
-	Action.ActionTime = GetWorld()->GetTimeSeconds();
+	if (!bAddStatesToOwnerCluster)
+	{
+		return;
+	}
 
-	// Save the action for debug purposes
-	LastStateActionsStack.Add(Action);
+	// The owner is neither a cluster root nor a part of a cluster, e.g. it has been spawned at runtime
+	AActor* Owner = GetOwner();
+	if (!FindOwnerCluster())
+	{
+		return;
+	}
 
-	// Don't store too many entries; a hundred should be more than enough
-	constexpr int32 MaxSize = 100;
-	if (LastStateActionsStack.Num() > MaxSize)
+	// States and their data can reference any object at any time, hence they're added as mutable objects to still get
+	// their references traced as long as the cluster is reachable
+	State->AddToCluster(Owner, true);
+	if (IsValid(State->BaseStateData))
 	{
-		LastStateActionsStack.RemoveAt(0);
+		State->BaseStateData->AddToCluster(Owner, true);
 	}
-#endif
 
-	// Anytime the stack is changed, update the queue so that any pending request is dispatched
-	UpdatePushQueue();
+	bStatesAddedToOwnerCluster = true;
+
+	FSM_LOG(VeryVerbose, "Machine state [%s] has been added to owner [%s] GC cluster.",
+		*State->GetName(), *Owner->GetName());
 }
 
-void UFiniteStateMachine::BeginActiveStates()
+void UFiniteStateMachine::RemoveStatesFromOwnerCluster()
 {
-	ensure(!bActiveStatesBegan);
+	if (!bStatesAddedToOwnerCluster)
+	{
+		return;
+	}
 
-	if (IsValid(ActiveGlobalState))
+	bStatesAddedToOwnerCluster = false;
+
+	// If the cluster has been dissolved in the meantime, its objects have been released along with it
+	FUObjectCluster* Cluster = FindOwnerCluster();
+	if (!Cluster)
 	{
-		ActiveGlobalState->OnStateAction(EStateAction::Begin, nullptr);
+		return;
 	}
 
-	if (IsValid(ActiveState))
+	// Mutable objects are kept sorted by their indices
+	auto RemoveFromCluster = [Cluster] (const UObject* Object)
 	{
-		const TSubclassOf<UMachineState> StateClass = ActiveState->GetClass();
-		StatesStack.Push(StateClass);
+		if (!Object)
+		{
+			return;
+		}
 
-		ActiveState->OnStateAction(EStateAction::Begin, nullptr);
+		const int32 ObjectIndex = Algo::BinarySearch(Cluster->MutableObjects, GUObjectArray.ObjectToIndex(Object));
+		if (ObjectIndex != INDEX_NONE)
+		{
+			Cluster->MutableObjects.RemoveAt(ObjectIndex);
+		}
+	};
+
+	for (const TArray<TObjectPtr<UMachineState>>* States : { &RegisteredStates, &RegisteredSubStates })
+	{
+		for (const TObjectPtr<UMachineState> State : *States)
+		{
+			RemoveFromCluster(State);
+			RemoveFromCluster(State->BaseStateData);
+		}
 	}
 
-	bActiveStatesBegan = true;
+	FSM_LOG(VeryVerbose, "Machine states have been removed from owner [%s] GC cluster.", *GetNameSafe(GetOwner()));
 }
 
-UMachineState* UFiniteStateMachine::RegisterState_Implementation(TSubclassOf<UMachineState> InStateClass)
+FUObjectCluster* UFiniteStateMachine::FindOwnerCluster() const
 {
-	AActor* Owner = GetOwner();
-	auto* State = NewObject<UMachineState>(Owner, InStateClass);
-	check(IsValid(State));
-
-	State->OnStateActionDelegate.AddUObject(this, &ThisClass::OnStateAction);
-	State->SetStateMachine(this);
-
-	if (bIsInitialized)
+	const AActor* Owner = GetOwner();
+	const FUObjectItem* OwnerItem = Owner ? GUObjectArray.ObjectToObjectItem(Owner) : nullptr;
+	if (!OwnerItem || OwnerItem->GetOwnerIndex() == 0)
 	{
-		State->PostInitialize();
+		return nullptr;
 	}
 
-	FSM_LOG(Log, "Machine state [%s] has been registered.", *State->GetName());
-
-	RegisteredStates.Add(State);
-	return State;
+	// Cluster roots store the index of their cluster, while the objects in them store the index of their root
+	const FUObjectItem* RootItem = OwnerItem->HasAnyFlags(EInternalObjectFlags::ClusterRoot)
+		? OwnerItem
+		: GUObjectArray.IndexToObject(OwnerItem->GetOwnerIndex());
+	return RootItem ? &GUObjectClusters[RootItem->GetClusterIndex()] : nullptr;
 }
 
 UMachineState* UFiniteStateMachine::FindState(TSubclassOf<UMachineState> InStateClass) const
 {
+	if (!ArchetypeStates.IsEmpty())
+	{
+		const int32 Index = StateMachineArchetype->FindStateIndex(InStateClass);
+		if (ArchetypeStates.IsValidIndex(Index))
+		{
+			return ArchetypeStates[Index];
+		}
+	}
+
 	for (const TObjectPtr<UMachineState> State : RegisteredStates)
 	{
 		const TSubclassOf<UMachineState> StateClass = State->GetClass();
@@ -1100,6 +2414,7 @@ UMachineState* UFiniteStateMachine::FindStateChecked(TSubclassOf<UMachineState>
 void UFiniteStateMachine::GotoState_Implementation(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label,
 	bool bForceEvents)
 {
+	FFSM_TransitionScope TransitionScope(this);
 	UMachineState* State = FindStateChecked(InStateClass);
 
 	if (IsValid(ActiveState))
@@ -1150,6 +2465,8 @@ TCoroutine<> UFiniteStateMachine::PushState_Implementation(TSubclassOf<UMachineS
 	TSubclassOf<UMachineState> PausedStateClass = nullptr;
 
 	{
+		FFSM_TransitionScope TransitionScope(this);
+
 		if (IsValid(ActiveState))
 		{
 			// The current active is paused while it's not the top-most
@@ -1199,6 +2516,8 @@ TCoroutine<> UFiniteStateMachine::PushState_LatentImplementation(TSubclassOf<UMa
 
 void UFiniteStateMachine::PopState_Implementation()
 {
+	FFSM_TransitionScope TransitionScope(this);
+
 	TSubclassOf<UMachineState> ResumedState = nullptr;
 	const int32 Num = StatesStack.Num();
 	if (Num > 1)
@@ -1215,6 +2534,7 @@ void UFiniteStateMachine::PopState_Implementation()
 	{
 		// Nothing to resume
 		ActiveState = nullptr;
+		PublishStateSnapshot();
 		return;
 	}
 
@@ -1236,6 +2556,8 @@ TCoroutine<> UFiniteStateMachine::PopState_LatentImplementation()
 
 void UFiniteStateMachine::EndState_Implementation()
 {
+	FFSM_TransitionScope TransitionScope(this);
+
 	TSubclassOf<UMachineState> ResumedState = nullptr;
 	const int32 Num = StatesStack.Num();
 	if (Num > 1)
@@ -1252,6 +2574,7 @@ void UFiniteStateMachine::EndState_Implementation()
 	{
 		// Nothing to resume
 		ActiveState = nullptr;
+		PublishStateSnapshot();
 		return;
 	}
 
@@ -1281,14 +2604,7 @@ TCoroutine<> UFiniteStateMachine::WaitUntilStateAction(TSubclassOf<UMachineState
 
 	// Wait until the requested state gets the requested state action
 	UMachineState* State = FindStateChecked(InStateClass);
-	while (true)
-	{
-		const auto [InState, InAction] = co_await State->OnStateActionDelegate;
-		if (InAction == StateAction)
-		{
-			break;
-		}
-	}
+	co_await FFSM_StateActionAwaiter(State, ToStateActionMask(StateAction));
 
 	co_await FinishNowIfCanceled();
 }
@@ -1296,14 +2612,15 @@ TCoroutine<> UFiniteStateMachine::WaitUntilStateAction(TSubclassOf<UMachineState
 TCoroutine<> UFiniteStateMachine::WaitUntilActiveStateEventDispatch()
 {
 	ensure(!bIsRunningLatentRequest);
-	check(IsValid(ActiveState));
 
-	ensure(ActiveState->IsDispatchingEvent());
+	// Either the active state or the global state is dispatching, so there might be no active state
+	UMachineState* DispatchingState = GetActiveDispatchingState();
+	check(IsValid(DispatchingState));
 	bIsRunningLatentRequest = true;
 
-	co_await ActiveState->OnFinishedDispatchingEvent;
+	co_await DispatchingState->OnFinishedDispatchingEvent;
 
-	ensure(!ActiveState->IsDispatchingEvent());
+	ensure(!DispatchingState->IsDispatchingEvent());
 }
 
 void UFiniteStateMachine::ClearStatesInvalidLatentExecutionCancellers()
@@ -1314,6 +2631,11 @@ void UFiniteStateMachine::ClearStatesInvalidLatentExecutionCancellers()
 		RemovedCancellers += State->ClearInvalidLatentExecutionCancellers();
 	}
 
+	for (const TObjectPtr<UMachineState> SubState : RegisteredSubStates)
+	{
+		RemovedCancellers += SubState->ClearInvalidLatentExecutionCancellers();
+	}
+
 	if (RemovedCancellers > 0)
 	{
 		FSM_LOG(VeryVerbose, "All [%d] running invalid latent execution cancellers have been cancelled.",
@@ -1335,7 +2657,372 @@ bool UFiniteStateMachine::CanActiveStateSafelyDeactivate(FString& OutReason) con
 
 bool UFiniteStateMachine::IsActiveStateDispatchingEvent() const
 {
-	return IsValid(ActiveState) && ActiveState->IsDispatchingEvent();
+	return IsValid(GetActiveDispatchingState());
+}
+
+UMachineState* UFiniteStateMachine::GetActiveDispatchingState() const
+{
+	// The global state and its sub-states dispatch events alongside the active state's chain
+	UMachineState* DispatchingState = FindDispatchingState(ActiveState);
+	if (!IsValid(DispatchingState))
+	{
+		DispatchingState = FindDispatchingState(ActiveGlobalState);
+	}
+
+	return DispatchingState;
+}
+
+UMachineState* UFiniteStateMachine::FindDispatchingState(UMachineState* State)
+{
+	for (; IsValid(State); State = State->ActiveSubState)
+	{
+		if (State->IsDispatchingEvent())
+		{
+			return State;
+		}
+	}
+
+	return nullptr;
+}
+
+int32 UFiniteStateMachine::FindRegionIndex(FGameplayTag Region) const
+{
+	return Regions.IndexOfByPredicate([Region](const FRegion& Item)
+	{
+		return Item.Definition.RegionTag == Region;
+	});
+}
+
+bool UFiniteStateMachine::IsStateInRegion(TSubclassOf<UMachineState> InStateClass) const
+{
+	const UMachineState* State = FindState(InStateClass);
+	return IsValid(State) && State->RegionIndex != INDEX_NONE;
+}
+
+void UFiniteStateMachine::BeginRegions()
+{
+	for (int32 i = 0; i < Regions.Num(); i++)
+	{
+		// Starting a state might add more regions
+		const FFSM_RegionDefinition Definition = Regions[i].Definition;
+		if (IsValid(Definition.InitialState) && !IsValid(Regions[i].ActiveState))
+		{
+			GotoStateInRegion(Definition.RegionTag, Definition.InitialState, Definition.InitialStateLabel);
+		}
+	}
+}
+
+void UFiniteStateMachine::ClearRegions()
+{
+	for (int32 i = 0; i < Regions.Num(); i++)
+	{
+		ClearStackInRegion(Regions[i].Definition.RegionTag);
+	}
+}
+
+int32 UFiniteStateMachine::EndEveryState()
+{
+	// Let the queued push requests be executed only once the stacks are cleared
+	FFSM_TransitionScope TransitionScope(this);
+
+	int32 StatesEnded = 0;
+	for (FRegion& Region : Regions)
+	{
+		while (!Region.StatesStack.IsEmpty())
+		{
+			// The state stays active while it's ending, just like when it ends on its own
+			UMachineState* State = Region.StatesStack.Pop();
+			Region.ActiveState = State;
+			State->OnStateAction(EStateAction::End, nullptr);
+			State->RegionIndex = INDEX_NONE;
+			StatesEnded++;
+		}
+
+		Region.ActiveState = nullptr;
+	}
+
+	while (!StatesStack.IsEmpty())
+	{
+		const TSubclassOf<UMachineState> StateClass = StatesStack.Pop();
+		ActiveState = FindStateChecked(StateClass);
+		ActiveState->OnStateAction(EStateAction::End, nullptr);
+		StatesEnded++;
+	}
+
+	ActiveState = nullptr;
+	PublishStateSnapshot();
+
+	return StatesEnded;
+}
+
+EFSM_TransitionResult UFiniteStateMachine::CanEnterRegion(int32 RegionIndex, TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label, bool bReplaceActive) const
+{
+	if (!HasBeenInitialized())
+	{
+		return EFSM_TransitionResult::NotInitialized;
+	}
+
+	if (!Regions.IsValidIndex(RegionIndex))
+	{
+		return EFSM_TransitionResult::InvalidRegion;
+	}
+
+	if (!IsValid(InStateClass))
+	{
+		return EFSM_TransitionResult::InvalidState;
+	}
+
+	if (!UMachineState::IsLabelTagCorrect(Label))
+	{
+		return EFSM_TransitionResult::InvalidLabel;
+	}
+
+	const UMachineState* State = FindState(InStateClass);
+	if (!IsValid(State))
+	{
+		return EFSM_TransitionResult::NotRegistered;
+	}
+
+	// A state can be on a single stack at once; only the active state of the region can be replaced with itself
+	const FRegion& Region = Regions[RegionIndex];
+	const bool bIsReplacingItself = bReplaceActive && Region.ActiveState == State;
+	if (!bIsReplacingItself && (State == ActiveGlobalState || State->RegionIndex != INDEX_NONE ||
+		IsInState(State->GetClass(), true)))
+	{
+		return EFSM_TransitionResult::AlreadyOnStack;
+	}
+
+	if (IsValid(Region.ActiveState))
+	{
+		if (Region.ActiveState->IsStateBlocklisted(InStateClass) || !Region.ActiveState->IsStateAllowlisted(InStateClass))
+		{
+			return EFSM_TransitionResult::Blocked;
+		}
+
+		FString Reason;
+		if (bReplaceActive && !Region.ActiveState->CanSafelyDeactivate(OUT Reason))
+		{
+			return EFSM_TransitionResult::UnsafeDeactivation;
+		}
+	}
+
+	if (Region.bIsRunningLatentRequest)
+	{
+		return EFSM_TransitionResult::LatentBusy;
+	}
+
+	return EFSM_TransitionResult::Success;
+}
+
+EFSM_TransitionResult UFiniteStateMachine::CanLeaveRegion(int32 RegionIndex) const
+{
+	if (!HasBeenInitialized())
+	{
+		return EFSM_TransitionResult::NotInitialized;
+	}
+
+	if (!Regions.IsValidIndex(RegionIndex))
+	{
+		return EFSM_TransitionResult::InvalidRegion;
+	}
+
+	if (Regions[RegionIndex].StatesStack.IsEmpty())
+	{
+		return EFSM_TransitionResult::NoActiveState;
+	}
+
+	if (Regions[RegionIndex].bIsRunningLatentRequest)
+	{
+		return EFSM_TransitionResult::LatentBusy;
+	}
+
+	return EFSM_TransitionResult::Success;
+}
+
+void UFiniteStateMachine::RunRegionTransition(int32 RegionIndex,
+	TUniqueFunction<EFSM_TransitionResult()>&& Validate, TUniqueFunction<void()>&& Transition)
+{
+	UMachineState* DispatchingState = FindDispatchingState(Regions[RegionIndex].ActiveState);
+	if (!IsValid(DispatchingState))
+	{
+		Transition();
+		return;
+	}
+
+	RegionTransition_LatentImplementation(RegionIndex, DispatchingState, MoveTemp(Validate), MoveTemp(Transition));
+}
+
+TCoroutine<> UFiniteStateMachine::RegionTransition_LatentImplementation(int32 RegionIndex,
+	UMachineState* DispatchingState, TUniqueFunction<EFSM_TransitionResult()> Validate,
+	TUniqueFunction<void()> Transition)
+{
+	Regions[RegionIndex].bIsRunningLatentRequest = true;
+
+	co_await DispatchingState->OnFinishedDispatchingEvent;
+
+	// The regions are gone if the state machine has been uninitialized in the meantime
+	if (!Regions.IsValidIndex(RegionIndex))
+	{
+		co_return;
+	}
+
+	Regions[RegionIndex].bIsRunningLatentRequest = false;
+
+	// The stacks might have changed while waiting, e.g. the state could have been added to another one in the meantime
+	const EFSM_TransitionResult Result = Validate();
+	if (Result != EFSM_TransitionResult::Success)
+	{
+		LogTransitionFailure(TEXT("RegionTransition"), Result);
+		co_return;
+	}
+
+	Transition();
+}
+
+void UFiniteStateMachine::GotoStateInRegion_Implementation(int32 RegionIndex, TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label, bool bForceEvents)
+{
+	FFSM_TransitionScope TransitionScope(this);
+	UMachineState* State = FindStateChecked(InStateClass);
+	UMachineState* OldState = Regions[RegionIndex].ActiveState;
+
+	if (OldState == State && !bForceEvents)
+	{
+		State->GotoLabel(Label);
+		return;
+	}
+
+	TSubclassOf<UMachineState> OldStateClass = nullptr;
+	if (IsValid(OldState))
+	{
+		// Pop the active state from the stack without notifying the state, as we're not explicitly pushing/popping
+		Regions[RegionIndex].StatesStack.Pop();
+
+		OldStateClass = OldState->GetClass();
+		OldState->OnStateAction(EStateAction::End, InStateClass);
+		OldState->RegionIndex = INDEX_NONE;
+	}
+
+	Regions[RegionIndex].ActiveState = State;
+	Regions[RegionIndex].StatesStack.Push(State);
+	State->RegionIndex = RegionIndex;
+
+	State->GotoLabel(Label);
+	State->OnStateAction(EStateAction::Begin, OldStateClass);
+}
+
+void UFiniteStateMachine::PushStateInRegion_Implementation(int32 RegionIndex, TSubclassOf<UMachineState> InStateClass,
+	FGameplayTag Label)
+{
+	FFSM_TransitionScope TransitionScope(this);
+	UMachineState* State = FindStateChecked(InStateClass);
+	UMachineState* PausedState = Regions[RegionIndex].ActiveState;
+
+	TSubclassOf<UMachineState> PausedStateClass = nullptr;
+	if (IsValid(PausedState))
+	{
+		// The active state is paused while it's not the top-most
+		PausedStateClass = PausedState->GetClass();
+		PausedState->OnStateAction(EStateAction::Pause, InStateClass);
+	}
+
+	Regions[RegionIndex].ActiveState = State;
+	Regions[RegionIndex].StatesStack.Push(State);
+	State->RegionIndex = RegionIndex;
+
+	State->GotoLabel(Label);
+	State->OnStateAction(EStateAction::Push, PausedStateClass);
+}
+
+void UFiniteStateMachine::RemoveStateInRegion_Implementation(int32 RegionIndex, EStateAction StateAction)
+{
+	check(StateAction == EStateAction::End || StateAction == EStateAction::Pop);
+
+	// The stack might have been cleared while the transition was deferred
+	if (Regions[RegionIndex].StatesStack.IsEmpty())
+	{
+		return;
+	}
+
+	FFSM_TransitionScope TransitionScope(this);
+
+	UMachineState* RemovedState = Regions[RegionIndex].StatesStack.Pop();
+	UMachineState* ResumedState = !Regions[RegionIndex].StatesStack.IsEmpty()
+		? Regions[RegionIndex].StatesStack.Top().Get()
+		: nullptr;
+
+	RemovedState->OnStateAction(StateAction, IsValid(ResumedState) ? ResumedState->GetClass() : nullptr);
+	RemovedState->RegionIndex = INDEX_NONE;
+
+	Regions[RegionIndex].ActiveState = ResumedState;
+	if (IsValid(ResumedState))
+	{
+		ResumedState->OnStateAction(EStateAction::Resume, RemovedState->GetClass());
+	}
+}
+
+void UFiniteStateMachine::LogTransitionFailure(const TCHAR* Transition, EFSM_TransitionResult Result,
+	TSubclassOf<UMachineState> InStateClass, FGameplayTag Label)
+{
+	if (!bLogTransitionFailures || LogFiniteStateMachine.IsSuppressed(ELogVerbosity::Warning))
+	{
+		return;
+	}
+
+	// Callers retrying every tick would flood the log otherwise; only count the failures in between
+	check(IsInGameThread());
+	const double CurrentTime = FPlatformTime::Seconds();
+	if (CurrentTime - LastTransitionFailureLogTime < TransitionFailuresLogInterval)
+	{
+		SuppressedTransitionFailuresNum++;
+		return;
+	}
+
+	FString Details;
+	switch (Result)
+	{
+	case EFSM_TransitionResult::NotInitialized:
+		Details = TEXT("The state machine has not been initialized yet.");
+		break;
+	case EFSM_TransitionResult::InvalidState:
+		Details = TEXT("Invalid state class.");
+		break;
+	case EFSM_TransitionResult::InvalidLabel:
+		Details = TEXT("Label is of wrong tag hierarchy.");
+		break;
+	case EFSM_TransitionResult::NotRegistered:
+		Details = TEXT("State is not registered in state machine.");
+		break;
+	case EFSM_TransitionResult::AlreadyOnStack:
+		Details = TEXT("State is already present on the states stack.");
+		break;
+	case EFSM_TransitionResult::Blocked:
+		Details = TEXT("Active state has disallowed this particular transition.");
+		break;
+	case EFSM_TransitionResult::UnsafeDeactivation:
+		CanActiveStateSafelyDeactivate(Details);
+		Details = FString::Printf(TEXT("Active state is not safe from being deactivated. Reason: [%s]"), *Details);
+		break;
+	case EFSM_TransitionResult::LatentBusy:
+		Details = TEXT("A latent request is already running. Avoid calling multiple of them at once.");
+		break;
+	case EFSM_TransitionResult::NoActiveState:
+		Details = TEXT("There's no active state.");
+		break;
+	case EFSM_TransitionResult::InvalidRegion:
+		Details = TEXT("The region is not defined in the state machine.");
+		break;
+	default:
+		break;
+	}
+
+	FSM_LOG(Warning, "%s failed. Result [%s] State [%s] Label [%s] Active state [%s] Suppressed failures [%d]. %s",
+		Transition, *UEnum::GetValueAsString(Result), *GetNameSafe(InStateClass), *Label.ToString(),
+		*GetNameSafe(ActiveState), SuppressedTransitionFailuresNum, *Details);
+
+	LastTransitionFailureLogTime = CurrentTime;
+	SuppressedTransitionFailuresNum = 0;
 }
 
 FString UFiniteStateMachine::GetGlobalStateInInitialRegisteredStatesErrorMessage(
@@ -0,0 +1,414 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/FiniteStateMachineArchetype.h"
+
+#include "FiniteStateMachine/FiniteStateMachineLog.h"
+#include "Misc/DataValidation.h"
+#include "UObject/ObjectSaveContext.h"
+
+void UFiniteStateMachineArchetype::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITOR
+	// State classes might have changed since the last save; compile on the first use, as the state class defaults might
+	// not be fully loaded yet
+	bIsCompiled = false;
+#else
+	if (bIsCompiled)
+	{
+		BuildStateIndices();
+	}
+#endif
+}
+
+void UFiniteStateMachineArchetype::PreSave(FObjectPreSaveContext SaveContext)
+{
+	Super::PreSave(SaveContext);
+
+	// Save the compiled data, so that cooked builds don't have to compile anything
+	Compile();
+}
+
+#if WITH_EDITOR
+void UFiniteStateMachineArchetype::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	Compile();
+}
+
+EDataValidationResult UFiniteStateMachineArchetype::IsDataValid(FDataValidationContext& Context) const
+{
+	EDataValidationResult Result = Super::IsDataValid(Context);
+
+	// The state classes might have changed since the last compilation. Validation must not alter the asset, so the
+	// current configuration is compiled into a transient archetype instead
+	auto* Compiled = NewObject<ThisClass>(GetTransientPackage(), NAME_None, RF_Transient);
+	Compiled->StateClassesToRegister = StateClassesToRegister;
+	Compiled->GlobalStateClass = GlobalStateClass;
+	Compiled->InitialState = InitialState;
+	Compiled->InitialStateLabel = InitialStateLabel;
+	Compiled->Compile();
+
+	for (const FString& Error : Compiled->ValidationErrors)
+	{
+		Context.AddError(FText::FromString(Error));
+		Result = EDataValidationResult::Invalid;
+	}
+
+	for (const FString& Warning : Compiled->ValidationWarnings)
+	{
+		Context.AddWarning(FText::FromString(Warning));
+	}
+
+	return Result;
+}
+#endif
+
+void UFiniteStateMachineArchetype::Compile()
+{
+	CompiledStates.Empty();
+	ValidationErrors.Empty();
+	ValidationWarnings.Empty();
+
+	for (const TSubclassOf<UMachineState> StateClass : StateClassesToRegister)
+	{
+		if (!IsValid(StateClass))
+		{
+			ValidationErrors.Add(TEXT("StateClassesToRegister contains an invalid state class."));
+			continue;
+		}
+
+		if (StateClass->HasAnyClassFlags(CLASS_Abstract))
+		{
+			ValidationErrors.Add(FString::Printf(TEXT("Machine state class [%s] is abstract."), *StateClass->GetName()));
+			continue;
+		}
+
+		if (StateClass->ImplementsInterface(UGlobalMachineStateInterface::StaticClass()))
+		{
+			ValidationErrors.Add(FString::Printf(
+				TEXT("StateClassesToRegister contains a global machine state [%s]. Remove it out of the array.\n"
+					"GlobalStateClass will be automatically registered in the state machine."), *StateClass->GetName()));
+			continue;
+		}
+
+		// Follow the same rules UFiniteStateMachine::RegisterState() does
+		const bool bIsAlreadyRegistered = CompiledStates.ContainsByPredicate(
+			[StateClass](const FFSM_CompiledState& Item)
+			{
+				return Item.StateClass->IsChildOf(StateClass);
+			});
+
+		if (bIsAlreadyRegistered)
+		{
+			ValidationErrors.Add(FString::Printf(TEXT("State class [%s] is already registered."),
+				*StateClass->GetName()));
+			continue;
+		}
+
+		FFSM_CompiledState& CompiledState = CompiledStates.AddDefaulted_GetRef();
+		CompiledState.StateClass = StateClass;
+		const UMachineState* StateCDO = StateClass->GetDefaultObject<UMachineState>();
+		StateCDO->GetRegisteredLabels(CompiledState.Labels);
+
+		// States that don't use labels can still be gone to with the default one
+		if (!StateCDO->UsesLabels())
+		{
+			CompiledState.Labels.Add(TAG_StateMachine_Label_Default);
+		}
+	}
+
+	if (IsValid(GlobalStateClass) && !GlobalStateClass->ImplementsInterface(UGlobalMachineStateInterface::StaticClass()))
+	{
+		ValidationErrors.Add(FString::Printf(TEXT("Global state [%s] must implement UGlobalMachineStateInterface."),
+			*GlobalStateClass->GetName()));
+	}
+
+	if (IsValid(InitialState))
+	{
+		const FFSM_CompiledState* CompiledInitialState = CompiledStates.FindByPredicate(
+			[this](const FFSM_CompiledState& Item)
+			{
+				return Item.StateClass == InitialState;
+			});
+
+		if (!CompiledInitialState)
+		{
+			ValidationErrors.Add(FString::Printf(
+				TEXT("Specified InitialState [%s] is not present in StateClassesToRegister.\n"
+					"Either change it or add it to StateClassesToRegister."), *InitialState->GetName()));
+		}
+		else if (!CompiledInitialState->Labels.Contains(InitialStateLabel))
+		{
+			ValidationErrors.Add(FString::Printf(TEXT("Initial label [%s] is not present in initial state [%s]."),
+				*InitialStateLabel.ToString(), *InitialState->GetName()));
+		}
+	}
+
+	// Derive the transitions each state allows from its allowlist and blocklist
+	const int32 StatesNum = CompiledStates.Num();
+	const int32 WordsNum = FMath::DivideAndRoundUp(StatesNum, 32);
+	for (FFSM_CompiledState& From : CompiledStates)
+	{
+		const auto* FromDefaults = From.StateClass->GetDefaultObject<UMachineState>();
+
+		From.BlockedTransitionsMask.Init(0, WordsNum);
+		for (int32 ToIndex = 0; ToIndex < StatesNum; ToIndex++)
+		{
+			const TSubclassOf<UMachineState> ToClass = CompiledStates[ToIndex].StateClass;
+			if (FromDefaults->IsStateBlocklisted(ToClass) || !FromDefaults->IsStateAllowlisted(ToClass))
+			{
+				From.BlockedTransitionsMask[ToIndex / 32] |= 1u << (ToIndex % 32);
+			}
+		}
+	}
+
+	AnalyzeTransitionGraph();
+
+	bIsCompiled = true;
+	BuildStateIndices();
+
+	UE_LOG(LogFiniteStateMachine, Verbose, TEXT("Finite state machine archetype [%s] has been compiled. States [%d] "
+		"Errors [%d] Warnings [%d]"), *GetName(), StatesNum, ValidationErrors.Num(), ValidationWarnings.Num());
+}
+
+void UFiniteStateMachineArchetype::ConditionalCompile()
+{
+	if (!bIsCompiled)
+	{
+		Compile();
+	}
+}
+
+bool UFiniteStateMachineArchetype::IsCompiled() const
+{
+	return bIsCompiled;
+}
+
+bool UFiniteStateMachineArchetype::IsConfigurationValid() const
+{
+	return bIsCompiled && ValidationErrors.IsEmpty();
+}
+
+const TArray<FString>& UFiniteStateMachineArchetype::GetValidationErrors() const
+{
+	return ValidationErrors;
+}
+
+const TArray<FString>& UFiniteStateMachineArchetype::GetValidationWarnings() const
+{
+	return ValidationWarnings;
+}
+
+const TArray<FFSM_CompiledState>& UFiniteStateMachineArchetype::GetCompiledStates() const
+{
+	return CompiledStates;
+}
+
+int32 UFiniteStateMachineArchetype::FindStateIndex(TSubclassOf<UMachineState> InStateClass) const
+{
+	const int32* FoundIndex = StateIndices.Find(InStateClass.Get());
+	return FoundIndex ? *FoundIndex : INDEX_NONE;
+}
+
+bool UFiniteStateMachineArchetype::IsTransitionBlocked(int32 FromIndex, int32 ToIndex) const
+{
+	check(CompiledStates.IsValidIndex(FromIndex));
+	check(CompiledStates.IsValidIndex(ToIndex));
+
+	const uint32 Word = CompiledStates[FromIndex].BlockedTransitionsMask[ToIndex / 32];
+	const bool bIsBlocked = !!(Word & (1u << (ToIndex % 32)));
+	return bIsBlocked;
+}
+
+bool UFiniteStateMachineArchetype::ContainsLabel(int32 StateIndex, FGameplayTag Label) const
+{
+	check(CompiledStates.IsValidIndex(StateIndex));
+
+	const bool bContains = CompiledStates[StateIndex].Labels.Contains(Label);
+	return bContains;
+}
+
+void UFiniteStateMachineArchetype::BuildStateIndices()
+{
+	StateIndices.Empty(CompiledStates.Num());
+	for (int32 i = 0; i < CompiledStates.Num(); i++)
+	{
+		StateIndices.Add(CompiledStates[i].StateClass.Get(), i);
+	}
+}
+
+void UFiniteStateMachineArchetype::AnalyzeTransitionGraph()
+{
+	struct FEdge
+	{
+		int32 ToIndex = INDEX_NONE;
+		/** Label the transition starts with. If invalid, the transition may start with any label. */
+		FGameplayTag Label;
+	};
+
+	const int32 StatesNum = CompiledStates.Num();
+
+	// Gather the transitions a state performs. If it doesn't declare any, assume it may go anywhere it's allowed to
+	auto GatherEdges = [this, StatesNum](const UMachineState* FromDefaults, int32 FromIndex, TArray<FEdge>& OutEdges)
+	{
+		TArray<FFSM_TransitionDeclaration> Declarations = FromDefaults->GetDeclaredTransitions();
+		if (Declarations.IsEmpty())
+		{
+			for (int32 ToIndex = 0; ToIndex < StatesNum; ToIndex++)
+			{
+				if (FromIndex == INDEX_NONE || !IsTransitionBlocked(FromIndex, ToIndex))
+				{
+					OutEdges.Add({ ToIndex, FGameplayTag::EmptyTag });
+				}
+			}
+
+			return;
+		}
+
+		// Transitions performed by the transition rules are known as well
+		for (const FFSM_TransitionRule& Rule : FromDefaults->GetTransitionRules())
+		{
+			FFSM_TransitionDeclaration& Declaration = Declarations.AddDefaulted_GetRef();
+			Declaration.StateClass = Rule.StateClass;
+			Declaration.Label = Rule.Label;
+		}
+
+		const FString FromName = FromDefaults->GetClass()->GetName();
+		for (const FFSM_TransitionDeclaration& Declaration : Declarations)
+		{
+			const int32 ToIndex = FindCompiledStateIndex(Declaration.StateClass);
+			if (ToIndex == INDEX_NONE)
+			{
+				ValidationErrors.Add(FString::Printf(TEXT("State [%s] declares a transition to state [%s] which is not "
+					"registered."), *FromName, *GetNameSafe(Declaration.StateClass)));
+				continue;
+			}
+
+			// Label changes within the same state are not subject to the allowlist and blocklist
+			if (FromIndex != INDEX_NONE && FromIndex != ToIndex && IsTransitionBlocked(FromIndex, ToIndex))
+			{
+				ValidationErrors.Add(FString::Printf(TEXT("State [%s] declares a transition to state [%s] which its "
+					"allowlist or blocklist disallows."), *FromName, *Declaration.StateClass->GetName()));
+				continue;
+			}
+
+			if (!ContainsLabel(ToIndex, Declaration.Label))
+			{
+				ValidationErrors.Add(FString::Printf(TEXT("State [%s] declares a transition to label [%s] which is not "
+					"present in state [%s]."), *FromName, *Declaration.Label.ToString(),
+					*CompiledStates[ToIndex].StateClass->GetName()));
+				continue;
+			}
+
+			OutEdges.Add({ ToIndex, Declaration.Label });
+		}
+	};
+
+	TArray<TArray<FEdge>> Edges;
+	Edges.SetNum(StatesNum);
+	for (int32 i = 0; i < StatesNum; i++)
+	{
+		GatherEdges(CompiledStates[i].StateClass->GetDefaultObject<UMachineState>(), i, Edges[i]);
+	}
+
+	// The graph is entered through the initial state, and through the global state that may go anywhere at any time
+	TArray<FEdge> Roots;
+	const int32 InitialIndex = FindCompiledStateIndex(InitialState);
+	if (InitialIndex != INDEX_NONE)
+	{
+		Roots.Add({ InitialIndex, InitialStateLabel });
+	}
+
+	if (IsValid(GlobalStateClass) && GlobalStateClass->ImplementsInterface(UGlobalMachineStateInterface::StaticClass()))
+	{
+		GatherEdges(GlobalStateClass->GetDefaultObject<UMachineState>(), INDEX_NONE, Roots);
+	}
+
+	// Without entry points the states can only be entered from outside, so there's nothing to analyze
+	if (Roots.IsEmpty())
+	{
+		return;
+	}
+
+	TBitArray<> Reached(false, StatesNum);
+	TBitArray<> AnyLabelReached(false, StatesNum);
+	TArray<TSet<FGameplayTag>> ReachedLabels;
+	ReachedLabels.SetNum(StatesNum);
+
+	TArray<int32> PendingStates;
+	auto Visit = [&](const FEdge& Edge)
+	{
+		if (Edge.Label.IsValid())
+		{
+			ReachedLabels[Edge.ToIndex].Add(Edge.Label);
+		}
+		else
+		{
+			AnyLabelReached[Edge.ToIndex] = true;
+		}
+
+		if (!Reached[Edge.ToIndex])
+		{
+			Reached[Edge.ToIndex] = true;
+			PendingStates.Add(Edge.ToIndex);
+		}
+	};
+
+	for (const FEdge& Root : Roots)
+	{
+		Visit(Root);
+	}
+
+	while (!PendingStates.IsEmpty())
+	{
+		const int32 FromIndex = PendingStates.Pop();
+		for (const FEdge& Edge : Edges[FromIndex])
+		{
+			Visit(Edge);
+		}
+	}
+
+	for (int32 i = 0; i < StatesNum; i++)
+	{
+		const FFSM_CompiledState& CompiledState = CompiledStates[i];
+		if (!Reached[i])
+		{
+			ValidationWarnings.Add(FString::Printf(TEXT("State [%s] is unreachable from the initial and global "
+				"states."), *CompiledState.StateClass->GetName()));
+			continue;
+		}
+
+		if (AnyLabelReached[i])
+		{
+			continue;
+		}
+
+		for (const FGameplayTag& Label : CompiledState.Labels)
+		{
+			if (!ReachedLabels[i].Contains(Label))
+			{
+				ValidationWarnings.Add(FString::Printf(TEXT("Label [%s] of state [%s] is never transited to."),
+					*Label.ToString(), *CompiledState.StateClass->GetName()));
+			}
+		}
+	}
+}
+
+int32 UFiniteStateMachineArchetype::FindCompiledStateIndex(TSubclassOf<UMachineState> InStateClass) const
+{
+	if (!IsValid(InStateClass))
+	{
+		return INDEX_NONE;
+	}
+
+	const int32 FoundIndex = CompiledStates.IndexOfByPredicate(
+		[InStateClass](const FFSM_CompiledState& Item)
+		{
+			return Item.StateClass->IsChildOf(InStateClass);
+		});
+
+	return FoundIndex;
+}
@@ -0,0 +1,1002 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/FiniteStateMachineSubsystem.h"
+
+#include "Engine/World.h"
+#include "FiniteStateMachine/FiniteStateMachineArchetype.h"
+#include "FiniteStateMachine/FiniteStateMachineLog.h"
+#include "FiniteStateMachine/MachineStateData.h"
+
+DECLARE_CYCLE_STAT(TEXT("Evaluate transition rules"), STAT_FSM_EvaluateTransitionRules, STATGROUP_FiniteStateMachine);
+DECLARE_CYCLE_STAT(TEXT("Tick time-sliced states"), STAT_FSM_TickTimeSlicedStates, STATGROUP_FiniteStateMachine);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Time-sliced state machines ticked"), STAT_FSM_TimeSlicedStateMachinesTicked,
+	STATGROUP_FiniteStateMachine);
+DECLARE_CYCLE_STAT(TEXT("Resume deferred labels"), STAT_FSM_ResumeDeferredLabels, STATGROUP_FiniteStateMachine);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Deferred label resumptions"), STAT_FSM_DeferredLabelResumptions,
+	STATGROUP_FiniteStateMachine);
+
+void UFiniteStateMachineSubsystem::Deinitialize()
+{
+	// Let the deferred labels carry on rather than leaving them suspended forever, so that they wind down along with
+	// their states. Nothing is deferred anymore, and the ones canceled meanwhile are skipped
+	bBudgetLabelResumptions = false;
+	while (NextDeferredLabelIndex < DeferredLabelResumptions.Num())
+	{
+		FFSM_LabelResumptionAwaiter* Awaiter = DeferredLabelResumptions[NextDeferredLabelIndex++];
+		if (Awaiter)
+		{
+			Awaiter->QueueIndex = INDEX_NONE;
+			Awaiter->Handle.resume();
+		}
+	}
+
+	DeferredLabelResumptions.Empty();
+	NextDeferredLabelIndex = 0;
+	DeferredLabelActivationsNum = 0;
+	LabelContinuationStartCycles = 0;
+
+	for (const TObjectPtr<UFiniteStateMachine> StateMachine : StateMachines)
+	{
+		if (IsValid(StateMachine))
+		{
+			StateMachine->RegistryIndex = INDEX_NONE;
+			StateMachine->TimeSlicedIndex = INDEX_NONE;
+		}
+	}
+
+	StateMachines.Empty();
+	StateIndex.Empty();
+	Observers.Empty();
+	WildcardObservers = FStateActionObservers();
+	ObserversNum = 0;
+	RuleStateClasses.Empty();
+	RuleTransitions.Empty();
+	TimeSlicedStateMachines.Empty();
+	NextTimeSlicedIndex = 0;
+
+	Super::Deinitialize();
+}
+
+void UFiniteStateMachineSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!RuleStateClasses.IsEmpty())
+	{
+		EvaluateTransitionRules();
+	}
+
+	if (!TimeSlicedStateMachines.IsEmpty())
+	{
+		TickTimeSlicedStateMachines();
+	}
+
+	if (NextDeferredLabelIndex < DeferredLabelResumptions.Num())
+	{
+		ResumeDeferredLabels();
+	}
+}
+
+TStatId UFiniteStateMachineSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFiniteStateMachineSubsystem, STATGROUP_Tickables);
+}
+
+UFiniteStateMachineSubsystem* UFiniteStateMachineSubsystem::Get(const UObject* WorldContextObject)
+{
+	const UWorld* World = IsValid(WorldContextObject) ? WorldContextObject->GetWorld() : nullptr;
+	return IsValid(World) ? World->GetSubsystem<UFiniteStateMachineSubsystem>() : nullptr;
+}
+
+void UFiniteStateMachineSubsystem::RegisterStateMachine(UFiniteStateMachine* StateMachine)
+{
+	check(IsValid(StateMachine));
+
+	if (StateMachine->RegistryIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	StateMachine->RegistryIndex = StateMachines.Add(StateMachine);
+
+	if (StateMachine->bTimeSliceStateTicks)
+	{
+		AddTimeSlicedStateMachine(StateMachine);
+	}
+}
+
+void UFiniteStateMachineSubsystem::UnregisterStateMachine(UFiniteStateMachine* StateMachine)
+{
+	check(IsValid(StateMachine));
+
+	const int32 Index = StateMachine->RegistryIndex;
+	if (!StateMachines.IsValidIndex(Index) || StateMachines[Index] != StateMachine)
+	{
+		return;
+	}
+
+	// Swap with the last one to not shift the others
+	StateMachines.RemoveAtSwap(Index);
+	if (StateMachines.IsValidIndex(Index))
+	{
+		StateMachines[Index]->RegistryIndex = Index;
+	}
+
+	StateMachine->RegistryIndex = INDEX_NONE;
+
+	if (StateMachine->bTimeSliceStateTicks)
+	{
+		RemoveTimeSlicedStateMachine(StateMachine);
+	}
+}
+
+const TArray<TObjectPtr<UFiniteStateMachine>>& UFiniteStateMachineSubsystem::GetStateMachines() const
+{
+	return StateMachines;
+}
+
+int32 UFiniteStateMachineSubsystem::GetStateMachinesNumInState(TSubclassOf<UMachineState> StateClass,
+	bool bCheckStack) const
+{
+	return GetStateMachinesInState(StateClass, bCheckStack).Num();
+}
+
+TConstArrayView<UFiniteStateMachine*> UFiniteStateMachineSubsystem::GetStateMachinesInState(
+	TSubclassOf<UMachineState> StateClass, bool bCheckStack) const
+{
+	const FFSM_StateIndexEntry* FoundEntry = StateIndex.Find(StateClass.Get());
+	if (!FoundEntry)
+	{
+		return TConstArrayView<UFiniteStateMachine*>();
+	}
+
+	return ToRawPtrTArrayUnsafe(bCheckStack ? FoundEntry->StackStateMachines : FoundEntry->ActiveStateMachines);
+}
+
+void UFiniteStateMachineSubsystem::UpdateStateIndex(UFiniteStateMachine* StateMachine, UMachineState* State,
+	EStateAction StateAction)
+{
+	FFSM_StateIndexEntry& Entry = FindOrAddStateIndexEntry(State->GetClass());
+	int32& ActiveSlot = State->ActiveIndexSlot;
+	int32& StackSlot = State->StackIndexSlot;
+
+	switch (StateAction)
+	{
+	case EStateAction::Begin:
+	case EStateAction::Push:
+		AddToStateIndexList(Entry.StackStateMachines, Entry.StackStates, StateMachine, State, StackSlot);
+		AddToStateIndexList(Entry.ActiveStateMachines, Entry.ActiveStates, StateMachine, State, ActiveSlot);
+		break;
+
+	case EStateAction::Resume:
+		AddToStateIndexList(Entry.ActiveStateMachines, Entry.ActiveStates, StateMachine, State, ActiveSlot);
+		break;
+
+	case EStateAction::Pause:
+		RemoveFromStateIndexList(Entry.ActiveStateMachines, Entry.ActiveStates, ActiveSlot, false);
+		break;
+
+	case EStateAction::End:
+	case EStateAction::Pop:
+		RemoveFromStateIndexList(Entry.ActiveStateMachines, Entry.ActiveStates, ActiveSlot, false);
+		RemoveFromStateIndexList(Entry.StackStateMachines, Entry.StackStates, StackSlot, true);
+		break;
+
+	default: checkNoEntry();
+	}
+}
+
+void UFiniteStateMachineSubsystem::UpdateUnindexedRuleStates(UFiniteStateMachine* StateMachine, UMachineState* State,
+	EStateAction StateAction)
+{
+	if (State->GetTransitionRules().IsEmpty())
+	{
+		return;
+	}
+
+	FFSM_StateIndexEntry& Entry = FindOrAddStateIndexEntry(State->GetClass());
+	switch (StateAction)
+	{
+	case EStateAction::Begin:
+	case EStateAction::Push:
+	case EStateAction::Resume:
+		AddToStateIndexList(Entry.UnindexedStateMachines, Entry.UnindexedStates, StateMachine, State,
+			State->ActiveIndexSlot);
+		break;
+
+	case EStateAction::End:
+	case EStateAction::Pop:
+	case EStateAction::Pause:
+		RemoveFromStateIndexList(Entry.UnindexedStateMachines, Entry.UnindexedStates, State->ActiveIndexSlot, false);
+		break;
+
+	default: checkNoEntry();
+	}
+}
+
+void UFiniteStateMachineSubsystem::RemoveFromStateIndex(UMachineState* State)
+{
+	if (State->ActiveIndexSlot == INDEX_NONE && State->StackIndexSlot == INDEX_NONE)
+	{
+		return;
+	}
+
+	FFSM_StateIndexEntry* FoundEntry = StateIndex.Find(State->GetClass());
+	if (!ensure(FoundEntry))
+	{
+		return;
+	}
+
+	// Indexed active states are always on the stack as well; an active slot alone belongs to an unindexed state
+	if (State->StackIndexSlot == INDEX_NONE)
+	{
+		RemoveFromStateIndexList(FoundEntry->UnindexedStateMachines, FoundEntry->UnindexedStates,
+			State->ActiveIndexSlot, false);
+	}
+	else
+	{
+		RemoveFromStateIndexList(FoundEntry->ActiveStateMachines, FoundEntry->ActiveStates, State->ActiveIndexSlot,
+			false);
+		RemoveFromStateIndexList(FoundEntry->StackStateMachines, FoundEntry->StackStates, State->StackIndexSlot,
+			true);
+	}
+}
+
+FFSM_StateIndexEntry& UFiniteStateMachineSubsystem::FindOrAddStateIndexEntry(
+	UClass* StateClass)
+{
+	if (FFSM_StateIndexEntry* FoundEntry = StateIndex.Find(StateClass))
+	{
+		return *FoundEntry;
+	}
+
+	// Only the classes having rules are visited on evaluation
+	if (!StateClass->GetDefaultObject<UMachineState>()->GetTransitionRules().IsEmpty())
+	{
+		RuleStateClasses.Add(StateClass);
+	}
+
+	return StateIndex.Add(StateClass);
+}
+
+void UFiniteStateMachineSubsystem::AddToStateIndexList(TArray<TObjectPtr<UFiniteStateMachine>>& StateMachines,
+	TArray<TObjectPtr<UMachineState>>& States, UFiniteStateMachine* StateMachine, UMachineState* State, int32& Slot)
+{
+	if (Slot != INDEX_NONE)
+	{
+		return;
+	}
+
+	Slot = StateMachines.Add(StateMachine);
+	States.Add(State);
+}
+
+void UFiniteStateMachineSubsystem::RemoveFromStateIndexList(TArray<TObjectPtr<UFiniteStateMachine>>& StateMachines,
+	TArray<TObjectPtr<UMachineState>>& States, int32& Slot, bool bIsStackList)
+{
+	if (Slot == INDEX_NONE)
+	{
+		return;
+	}
+
+	const int32 Index = Slot;
+	Slot = INDEX_NONE;
+
+	// Swap with the last one to not shift the others, and tell it its new slot
+	StateMachines.RemoveAtSwap(Index);
+	States.RemoveAtSwap(Index);
+	if (States.IsValidIndex(Index))
+	{
+		UMachineState* MovedState = States[Index];
+		(bIsStackList ? MovedState->StackIndexSlot : MovedState->ActiveIndexSlot) = Index;
+	}
+}
+
+int32 UFiniteStateMachineSubsystem::GotoStateBulk(TConstArrayView<UFiniteStateMachine*> InStateMachines,
+	TSubclassOf<UMachineState> StateClass, FGameplayTag Label, TArray<EFSM_TransitionResult>& OutResults,
+	bool bForceEvents)
+{
+	const int32 Num = InStateMachines.Num();
+	OutResults.SetNumUninitialized(Num);
+
+	// Validate the parts all the state machines share only once
+	EFSM_TransitionResult SharedResult = EFSM_TransitionResult::Success;
+	if (!IsValid(StateClass))
+	{
+		SharedResult = EFSM_TransitionResult::InvalidState;
+	}
+	else if (!UMachineState::IsLabelTagCorrect(Label))
+	{
+		SharedResult = EFSM_TransitionResult::InvalidLabel;
+	}
+
+	if (SharedResult != EFSM_TransitionResult::Success)
+	{
+		FSM_LOG(Warning, "Bulk GotoState has failed for [%d] state machines. Reason [%s]", Num,
+			*UEnum::GetValueAsString(SharedResult));
+
+		for (EFSM_TransitionResult& Result : OutResults)
+		{
+			Result = SharedResult;
+		}
+
+		return 0;
+	}
+
+	// Squads usually share the archetype; look the target state up only when it changes
+	const UFiniteStateMachineArchetype* CachedArchetype = nullptr;
+	int32 CachedToIndex = INDEX_NONE;
+
+	int32 AcceptedNum = 0;
+	int32 RejectedNum = 0;
+	for (int32 i = 0; i < Num; i++)
+	{
+		UFiniteStateMachine* StateMachine = InStateMachines[i];
+		if (!IsValid(StateMachine))
+		{
+			OutResults[i] = EFSM_TransitionResult::NotInitialized;
+			RejectedNum++;
+			continue;
+		}
+
+		int32 ToIndex = INDEX_NONE;
+		if (!StateMachine->ArchetypeStates.IsEmpty())
+		{
+			const UFiniteStateMachineArchetype* Archetype = StateMachine->StateMachineArchetype;
+			if (Archetype != CachedArchetype)
+			{
+				CachedArchetype = Archetype;
+				CachedToIndex = Archetype->FindStateIndex(StateClass);
+			}
+
+			ToIndex = CachedToIndex;
+		}
+
+		// Validate right before the transition, as the events of the previous transitions might have changed anything
+		OutResults[i] = StateMachine->CanGotoState_Implementation(StateClass, Label, ToIndex);
+		if (OutResults[i] != EFSM_TransitionResult::Success)
+		{
+			RejectedNum++;
+			continue;
+		}
+
+		OutResults[i] = StateMachine->GotoState_Bulk(StateClass, Label, bForceEvents);
+		AcceptedNum += UFiniteStateMachine::IsTransitionAccepted(OutResults[i]) ? 1 : 0;
+	}
+
+	if (RejectedNum > 0)
+	{
+		FSM_LOG(Verbose, "Bulk GotoState to [%s] has been rejected by [%d] state machines out of [%d].",
+			*StateClass->GetName(), RejectedNum, Num);
+	}
+
+	return AcceptedNum;
+}
+
+int32 UFiniteStateMachineSubsystem::EvaluateTransitionRules()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSM_EvaluateTransitionRules);
+
+	RuleTransitions.Reset();
+
+	for (const TSubclassOf<UMachineState> StateClass : RuleStateClasses)
+	{
+		const FFSM_StateIndexEntry& Entry = StateIndex.FindChecked(StateClass.Get());
+		const TArray<FFSM_TransitionRule>& Rules = StateClass->GetDefaultObject<UMachineState>()->GetTransitionRules();
+		GatherRuleTransitions(Rules, ToRawPtrTArrayUnsafe(Entry.ActiveStateMachines),
+			ToRawPtrTArrayUnsafe(Entry.ActiveStates));
+		GatherRuleTransitions(Rules, ToRawPtrTArrayUnsafe(Entry.UnindexedStateMachines),
+			ToRawPtrTArrayUnsafe(Entry.UnindexedStates));
+	}
+
+	// The transitions alter the state index, hence they're performed only once everything has been evaluated
+	int32 PerformedNum = 0;
+	for (const FRuleTransition& Transition : RuleTransitions)
+	{
+		PerformedNum += PerformRuleTransition(Transition) ? 1 : 0;
+	}
+
+	RuleTransitions.Reset();
+	return PerformedNum;
+}
+
+void UFiniteStateMachineSubsystem::GatherRuleTransitions(TConstArrayView<FFSM_TransitionRule> Rules,
+	TConstArrayView<UFiniteStateMachine*> InStateMachines, TConstArrayView<UMachineState*> States)
+{
+	if (States.IsEmpty())
+	{
+		return;
+	}
+
+	EvaluateTransitionRules_Batch(Rules, States);
+
+	for (int32 i = 0; i < States.Num(); i++)
+	{
+		if (MetRuleIndices[i] != INDEX_NONE)
+		{
+			FRuleTransition& Transition = RuleTransitions.AddDefaulted_GetRef();
+			Transition.StateMachine = InStateMachines[i];
+			Transition.State = States[i];
+			Transition.Rule = &Rules[MetRuleIndices[i]];
+		}
+	}
+}
+
+void UFiniteStateMachineSubsystem::EvaluateTransitionRules_Batch(TConstArrayView<FFSM_TransitionRule> Rules,
+	TConstArrayView<UMachineState*> States)
+{
+	const int32 Num = States.Num();
+	MetRuleIndices.Init(INDEX_NONE, Num);
+	ConditionValues.SetNumUninitialized(Num);
+	ConditionResults.SetNumUninitialized(Num);
+
+	// All the states are of the same class
+	const UClass* StateClass = States[0]->GetClass();
+
+	int32 PendingNum = Num;
+	for (int32 RuleIndex = 0; RuleIndex < Rules.Num() && PendingNum > 0; RuleIndex++)
+	{
+		const FFSM_TransitionRule& Rule = Rules[RuleIndex];
+
+		// The states are already active, the rule would only restart them
+		if (Rule.StateClass == StateClass)
+		{
+			continue;
+		}
+
+		FMemory::Memset(ConditionResults.GetData(), 1, Num);
+
+		for (const FFSM_TransitionCondition& Condition : Rule.Conditions)
+		{
+			GatherConditionValues(Condition, States, ConditionValues, ConditionResults);
+
+			if (Condition.Type == EFSM_TransitionConditionType::StateDataTag)
+			{
+				CompareConditionValues(EFSM_ComparisonOperator::Equal, Condition.bInverse ? 0.f : 1.f,
+					ConditionValues, ConditionResults);
+			}
+			else
+			{
+				CompareConditionValues(Condition.Operator, Condition.Value, ConditionValues, ConditionResults);
+			}
+		}
+
+		// Earlier rules take precedence
+		for (int32 i = 0; i < Num; i++)
+		{
+			if (ConditionResults[i] && MetRuleIndices[i] == INDEX_NONE)
+			{
+				MetRuleIndices[i] = RuleIndex;
+				PendingNum--;
+			}
+		}
+	}
+}
+
+void UFiniteStateMachineSubsystem::GatherConditionValues(const FFSM_TransitionCondition& Condition,
+	TConstArrayView<UMachineState*> States, TArrayView<float> OutValues, TArrayView<uint8> OutResults)
+{
+	const int32 Num = States.Num();
+	if (Condition.Type == EFSM_TransitionConditionType::TimeSinceLastStateAction)
+	{
+		for (int32 i = 0; i < Num; i++)
+		{
+			OutValues[i] = States[i]->GetTimeSinceLastStateAction();
+		}
+
+		return;
+	}
+
+	// States of the same class usually use the same data class; resolve the property only when it changes
+	const UClass* CachedDataClass = nullptr;
+	const FProperty* Property = nullptr;
+
+	const bool bIsTagCondition = Condition.Type == EFSM_TransitionConditionType::StateDataTag;
+	for (int32 i = 0; i < Num; i++)
+	{
+		const UMachineStateData* StateData = States[i]->BaseStateData.Get();
+		if (!IsValid(StateData))
+		{
+			OutResults[i] = 0;
+			continue;
+		}
+
+		if (StateData->GetClass() != CachedDataClass)
+		{
+			CachedDataClass = StateData->GetClass();
+			Property = FindFProperty<FProperty>(CachedDataClass, Condition.PropertyName);
+			if (!Property)
+			{
+				FSM_LOG(Verbose, "Transition condition property [%s] doesn't exist in state data [%s].",
+					*Condition.PropertyName.ToString(), *CachedDataClass->GetName());
+			}
+		}
+
+		if (!Property)
+		{
+			OutResults[i] = 0;
+			continue;
+		}
+
+		const void* ValuePtr = Property->ContainerPtrToValuePtr<void>(StateData);
+		if (bIsTagCondition)
+		{
+			bool bHasTag = false;
+			if (const auto* StructProperty = CastField<FStructProperty>(Property))
+			{
+				if (StructProperty->Struct == FGameplayTag::StaticStruct())
+				{
+					bHasTag = static_cast<const FGameplayTag*>(ValuePtr)->MatchesTag(Condition.Tag);
+				}
+				else if (StructProperty->Struct == FGameplayTagContainer::StaticStruct())
+				{
+					bHasTag = static_cast<const FGameplayTagContainer*>(ValuePtr)->HasTag(Condition.Tag);
+				}
+			}
+
+			OutValues[i] = bHasTag ? 1.f : 0.f;
+		}
+		else if (const auto* FloatProperty = CastField<FFloatProperty>(Property))
+		{
+			OutValues[i] = FloatProperty->GetPropertyValue(ValuePtr);
+		}
+		else if (const auto* DoubleProperty = CastField<FDoubleProperty>(Property))
+		{
+			OutValues[i] = static_cast<float>(DoubleProperty->GetPropertyValue(ValuePtr));
+		}
+		else if (const auto* NumericProperty = CastField<FNumericProperty>(Property);
+			NumericProperty && NumericProperty->IsInteger())
+		{
+			OutValues[i] = static_cast<float>(NumericProperty->GetSignedIntPropertyValue(ValuePtr));
+		}
+		else if (const auto* BoolProperty = CastField<FBoolProperty>(Property))
+		{
+			OutValues[i] = BoolProperty->GetPropertyValue(ValuePtr) ? 1.f : 0.f;
+		}
+		else
+		{
+			OutResults[i] = 0;
+		}
+	}
+}
+
+void UFiniteStateMachineSubsystem::CompareConditionValues(EFSM_ComparisonOperator Operator, float Value,
+	TConstArrayView<float> Values, TArrayView<uint8> InOutResults)
+{
+	const int32 Num = Values.Num();
+	const float* RESTRICT ValuesData = Values.GetData();
+	uint8* RESTRICT ResultsData = InOutResults.GetData();
+
+	// The operator is picked once per column, leaving tight branchless loops the compiler vectorizes
+	switch (Operator)
+	{
+	case EFSM_ComparisonOperator::Less:
+		for (int32 i = 0; i < Num; i++) { ResultsData[i] &= static_cast<uint8>(ValuesData[i] < Value); }
+		break;
+	case EFSM_ComparisonOperator::LessOrEqual:
+		for (int32 i = 0; i < Num; i++) { ResultsData[i] &= static_cast<uint8>(ValuesData[i] <= Value); }
+		break;
+	case EFSM_ComparisonOperator::Greater:
+		for (int32 i = 0; i < Num; i++) { ResultsData[i] &= static_cast<uint8>(ValuesData[i] > Value); }
+		break;
+	case EFSM_ComparisonOperator::GreaterOrEqual:
+		for (int32 i = 0; i < Num; i++) { ResultsData[i] &= static_cast<uint8>(ValuesData[i] >= Value); }
+		break;
+	case EFSM_ComparisonOperator::Equal:
+		for (int32 i = 0; i < Num; i++) { ResultsData[i] &= static_cast<uint8>(ValuesData[i] == Value); }
+		break;
+	case EFSM_ComparisonOperator::NotEqual:
+		for (int32 i = 0; i < Num; i++) { ResultsData[i] &= static_cast<uint8>(ValuesData[i] != Value); }
+		break;
+	default: checkNoEntry();
+	}
+}
+
+bool UFiniteStateMachineSubsystem::PerformRuleTransition(const FRuleTransition& Transition)
+{
+	UFiniteStateMachine* StateMachine = Transition.StateMachine;
+	UMachineState* State = Transition.State;
+	const FFSM_TransitionRule& Rule = *Transition.Rule;
+
+	// A transition performed earlier might have deactivated the state
+	if (!IsValid(StateMachine) || !IsValid(State) ||
+		!(State->IsStateActive() || State == StateMachine->ActiveGlobalState))
+	{
+		return false;
+	}
+
+	if (UMachineState* ParentState = State->GetParentState())
+	{
+		return ParentState->GotoSubState(Rule.StateClass, Rule.Label);
+	}
+
+	// Rules stay met for as long as the transition is rejected; check first to not report it every frame
+	if (State->RegionIndex != INDEX_NONE)
+	{
+		if (StateMachine->CanEnterRegion(State->RegionIndex, Rule.StateClass, Rule.Label, true) !=
+			EFSM_TransitionResult::Success)
+		{
+			return false;
+		}
+
+		return StateMachine->GotoStateInRegion(State->GetRegion(), Rule.StateClass, Rule.Label);
+	}
+
+	// The rules of the global state target the active state, which might already be the one to go to
+	if (StateMachine->IsInState(Rule.StateClass))
+	{
+		return false;
+	}
+
+	if (StateMachine->CanGotoState(Rule.StateClass, Rule.Label) != EFSM_TransitionResult::Success)
+	{
+		return false;
+	}
+
+	return StateMachine->GotoState(Rule.StateClass, Rule.Label);
+}
+
+void UFiniteStateMachineSubsystem::AddTimeSlicedStateMachine(UFiniteStateMachine* StateMachine)
+{
+	check(IsValid(StateMachine));
+
+	if (StateMachine->TimeSlicedIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	// Appended ones wait for a whole round, like the rest
+	StateMachine->TimeSlicedIndex = TimeSlicedStateMachines.Add(StateMachine);
+}
+
+void UFiniteStateMachineSubsystem::RemoveTimeSlicedStateMachine(UFiniteStateMachine* StateMachine)
+{
+	int32 Index = StateMachine->TimeSlicedIndex;
+	if (!TimeSlicedStateMachines.IsValidIndex(Index) || TimeSlicedStateMachines[Index] != StateMachine)
+	{
+		return;
+	}
+
+	StateMachine->TimeSlicedIndex = INDEX_NONE;
+
+	// The ones before NextTimeSlicedIndex have already ticked in this round. Move the hole to the end of them first,
+	// so that the one swapped into it hasn't ticked yet either, and nobody skips or repeats their turn
+	if (Index < NextTimeSlicedIndex)
+	{
+		NextTimeSlicedIndex--;
+		if (Index != NextTimeSlicedIndex)
+		{
+			UFiniteStateMachine* TickedStateMachine = TimeSlicedStateMachines[NextTimeSlicedIndex];
+			TimeSlicedStateMachines[Index] = TickedStateMachine;
+			TickedStateMachine->TimeSlicedIndex = Index;
+			Index = NextTimeSlicedIndex;
+		}
+	}
+
+	TimeSlicedStateMachines.RemoveAtSwap(Index);
+	if (TimeSlicedStateMachines.IsValidIndex(Index))
+	{
+		TimeSlicedStateMachines[Index]->TimeSlicedIndex = Index;
+	}
+}
+
+void UFiniteStateMachineSubsystem::SetStateTicksBudget(float InBudget)
+{
+	StateTicksBudget = FMath::Max(InBudget, 0.f);
+}
+
+float UFiniteStateMachineSubsystem::GetStateTicksBudget() const
+{
+	return StateTicksBudget;
+}
+
+void UFiniteStateMachineSubsystem::SetMaxStateTickDelay(int32 InMaxDelay)
+{
+	MaxStateTickDelay = FMath::Max(InMaxDelay, 1);
+}
+
+int32 UFiniteStateMachineSubsystem::GetMaxStateTickDelay() const
+{
+	return MaxStateTickDelay;
+}
+
+int32 UFiniteStateMachineSubsystem::TickTimeSlicedStateMachines()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSM_TickTimeSlicedStates);
+
+	// Starvation protection: visit enough of them to get through all of them within the maximum delay
+	const int32 MinVisitsNum = FMath::DivideAndRoundUp(TimeSlicedStateMachines.Num(), FMath::Max(MaxStateTickDelay, 1));
+	const uint64 BudgetCycles = static_cast<uint64>(StateTicksBudget / (FPlatformTime::GetSecondsPerCycle64() * 1e6));
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	int32 TickedNum = 0;
+
+	// State machines might be added or removed while ticking
+	for (int32 VisitsNum = 0; VisitsNum < TimeSlicedStateMachines.Num(); VisitsNum++)
+	{
+		if (VisitsNum >= MinVisitsNum && FPlatformTime::Cycles64() - StartCycles >= BudgetCycles)
+		{
+			break;
+		}
+
+		if (!TimeSlicedStateMachines.IsValidIndex(NextTimeSlicedIndex))
+		{
+			NextTimeSlicedIndex = 0;
+		}
+
+		UFiniteStateMachine* StateMachine = TimeSlicedStateMachines[NextTimeSlicedIndex++];
+		if (StateMachine->TickTimeSlicedStates())
+		{
+			TickedNum++;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_FSM_TimeSlicedStateMachinesTicked, TickedNum);
+	return TickedNum;
+}
+
+UFiniteStateMachineSubsystem::FLabelResumptionScope::FLabelResumptionScope(UFiniteStateMachineSubsystem* InSubsystem)
+	: Subsystem(InSubsystem)
+	, StartCycles(FPlatformTime::Cycles64())
+{
+	// Resumptions never run within a label carrying on; if one is still being charged, it has finished already
+	if (Subsystem->LabelResumptionDepth == 0)
+	{
+		Subsystem->LabelContinuationStartCycles = 0;
+	}
+
+	Subsystem->LabelResumptionDepth++;
+}
+
+UFiniteStateMachineSubsystem::FLabelResumptionScope::~FLabelResumptionScope()
+{
+	Subsystem->LabelResumptionDepth--;
+
+	// Nested resumptions are a part of the outer one
+	if (Subsystem->LabelResumptionDepth == 0)
+	{
+		Subsystem->LabelResumptionCycles = Subsystem->GetLabelResumptionCycles() +
+			(FPlatformTime::Cycles64() - StartCycles);
+		Subsystem->LabelResumptionFrame = GFrameCounter;
+	}
+}
+
+bool UFiniteStateMachineSubsystem::ShouldBudgetLabelResumption(const UMachineState* State) const
+{
+	return bBudgetLabelResumptions && LabelResumptionDepth == 0 && IsValid(State) && !State->IsUrgent();
+}
+
+bool UFiniteStateMachineSubsystem::HasLabelResumptionBudget() const
+{
+	// The first resumption of each frame is always allowed, so that nothing waits forever regardless of the budget
+	const uint64 SpentCycles = GetLabelResumptionCycles();
+	const uint64 BudgetCycles = static_cast<uint64>(LabelResumptionsBudget /
+		(FPlatformTime::GetSecondsPerCycle64() * 1e6));
+	return SpentCycles == 0 || SpentCycles < BudgetCycles;
+}
+
+void UFiniteStateMachineSubsystem::ResumeLabel(std::coroutine_handle<> Handle)
+{
+	FLabelResumptionScope Scope(this);
+	Handle.resume();
+}
+
+void UFiniteStateMachineSubsystem::BeginLabelContinuation()
+{
+	// A label that hasn't reached a latent execution since then has finished, or has been stopped; it's not charged
+	LabelContinuationStartCycles = FPlatformTime::Cycles64();
+	LabelContinuationFrame = GFrameCounter;
+}
+
+void UFiniteStateMachineSubsystem::EndLabelContinuation()
+{
+	if (LabelContinuationStartCycles == 0)
+	{
+		return;
+	}
+
+	// Time spent in another frame is not a part of the budget of this one
+	if (LabelContinuationFrame == GFrameCounter)
+	{
+		LabelResumptionCycles = GetLabelResumptionCycles() + (FPlatformTime::Cycles64() - LabelContinuationStartCycles);
+		LabelResumptionFrame = GFrameCounter;
+	}
+
+	LabelContinuationStartCycles = 0;
+}
+
+void UFiniteStateMachineSubsystem::DeferLabelResumption(FFSM_LabelResumptionAwaiter* Awaiter)
+{
+	check(Awaiter);
+
+	Awaiter->QueueIndex = DeferredLabelResumptions.Add(Awaiter);
+	INC_DWORD_STAT(STAT_FSM_DeferredLabelResumptions);
+}
+
+void UFiniteStateMachineSubsystem::CancelLabelResumption(FFSM_LabelResumptionAwaiter* Awaiter)
+{
+	const int32 Index = Awaiter->QueueIndex;
+	if (DeferredLabelResumptions.IsValidIndex(Index) && DeferredLabelResumptions[Index] == Awaiter)
+	{
+		// Keep the order of the others; the slot is skipped when it's its turn
+		DeferredLabelResumptions[Index] = nullptr;
+	}
+
+	Awaiter->QueueIndex = INDEX_NONE;
+}
+
+void UFiniteStateMachineSubsystem::AddDeferredLabelActivation()
+{
+	DeferredLabelActivationsNum++;
+	INC_DWORD_STAT(STAT_FSM_DeferredLabelResumptions);
+}
+
+void UFiniteStateMachineSubsystem::RemoveDeferredLabelActivation()
+{
+	DeferredLabelActivationsNum = FMath::Max(DeferredLabelActivationsNum - 1, 0);
+}
+
+int32 UFiniteStateMachineSubsystem::GetDeferredLabelResumptionsNum() const
+{
+	int32 Num = DeferredLabelActivationsNum;
+	for (int32 i = NextDeferredLabelIndex; i < DeferredLabelResumptions.Num(); i++)
+	{
+		if (DeferredLabelResumptions[i])
+		{
+			Num++;
+		}
+	}
+
+	return Num;
+}
+
+void UFiniteStateMachineSubsystem::SetBudgetLabelResumptions(bool bInBudget)
+{
+	bBudgetLabelResumptions = bInBudget;
+}
+
+void UFiniteStateMachineSubsystem::SetLabelResumptionsBudget(float InBudget)
+{
+	LabelResumptionsBudget = FMath::Max(InBudget, 0.f);
+}
+
+float UFiniteStateMachineSubsystem::GetLabelResumptionsBudget() const
+{
+	return LabelResumptionsBudget;
+}
+
+int32 UFiniteStateMachineSubsystem::ResumeDeferredLabels()
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSM_ResumeDeferredLabels);
+
+	int32 ResumedNum = 0;
+
+	// Resumed labels might defer again, in which case they're appended
+	while (NextDeferredLabelIndex < DeferredLabelResumptions.Num())
+	{
+		// Starvation protection: the queue moves forward every frame regardless of the budget
+		if (ResumedNum > 0 && !HasLabelResumptionBudget())
+		{
+			break;
+		}
+
+		FFSM_LabelResumptionAwaiter* Awaiter = DeferredLabelResumptions[NextDeferredLabelIndex++];
+		if (!Awaiter)
+		{
+			continue;
+		}
+
+		Awaiter->QueueIndex = INDEX_NONE;
+		ResumeLabel(Awaiter->Handle);
+		ResumedNum++;
+	}
+
+	// Drop the resumed ones once they take most of the queue
+	if (NextDeferredLabelIndex * 2 >= DeferredLabelResumptions.Num())
+	{
+		DeferredLabelResumptions.RemoveAt(0, NextDeferredLabelIndex);
+
+		// The rest is at most as long as the dropped part
+		for (FFSM_LabelResumptionAwaiter* Awaiter : DeferredLabelResumptions)
+		{
+			if (Awaiter)
+			{
+				Awaiter->QueueIndex -= NextDeferredLabelIndex;
+			}
+		}
+
+		NextDeferredLabelIndex = 0;
+	}
+
+	return ResumedNum;
+}
+
+uint64 UFiniteStateMachineSubsystem::GetLabelResumptionCycles() const
+{
+	return LabelResumptionFrame == GFrameCounter ? LabelResumptionCycles : 0;
+}
+
+FDelegateHandle UFiniteStateMachineSubsystem::AddStateActionObserver(TSubclassOf<UMachineState> StateClass,
+	EFSM_StateActionMask Actions, FOnGlobalStateActionSignature&& Delegate)
+{
+	if (Actions == EFSM_StateActionMask::None || !Delegate.IsBound())
+	{
+		return FDelegateHandle();
+	}
+
+	const FDelegateHandle Handle = Delegate.GetHandle();
+
+	FStateActionObservers* ClassObservers = &WildcardObservers;
+	if (StateClass)
+	{
+		TUniquePtr<FStateActionObservers>& FoundObservers = Observers.FindOrAdd(StateClass.Get());
+		if (!FoundObservers.IsValid())
+		{
+			FoundObservers = MakeUnique<FStateActionObservers>();
+		}
+
+		ClassObservers = FoundObservers.Get();
+	}
+
+	FStateActionObserver Observer;
+	Observer.Delegate = MoveTemp(Delegate);
+	Observer.Actions = Actions;
+	ClassObservers->Add(MoveTemp(Observer));
+
+	ObserversNum++;
+
+	return Handle;
+}
+
+bool UFiniteStateMachineSubsystem::RemoveStateActionObserver(FDelegateHandle Handle)
+{
+	bool bRemoved = WildcardObservers.Remove(Handle);
+	for (auto It = Observers.CreateIterator(); It && !bRemoved; ++It)
+	{
+		bRemoved = It.Value()->Remove(Handle);
+
+		// Observers being notified are removed once the notification ends
+		if (bRemoved && It.Value()->IsEmpty() && !It.Value()->IsBroadcasting())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (bRemoved)
+	{
+		ObserversNum--;
+	}
+
+	return bRemoved;
+}
+
+bool UFiniteStateMachineSubsystem::HasStateActionObservers() const
+{
+	return ObserversNum > 0;
+}
+
+void UFiniteStateMachineSubsystem::NotifyStateAction(UFiniteStateMachine* StateMachine, UMachineState* State,
+	EStateAction StateAction, TSubclassOf<UMachineState> OtherState)
+{
+	if (ObserversNum == 0)
+	{
+		return;
+	}
+
+	const auto NotifyAll = [](const FStateActionObserver&) { return true; };
+	WildcardObservers.Broadcast(StateAction, NotifyAll, StateMachine, State, StateAction, OtherState);
+
+	const TObjectKey<UClass> StateClass = State->GetClass();
+	if (const TUniquePtr<FStateActionObservers>* FoundObservers = Observers.Find(StateClass))
+	{
+		// The map might be altered by the observers
+		FStateActionObservers* ClassObservers = FoundObservers->Get();
+		ClassObservers->Broadcast(StateAction, NotifyAll, StateMachine, State, StateAction, OtherState);
+
+		// The last observers might have removed themselves while being notified
+		if (ClassObservers->IsEmpty() && !ClassObservers->IsBroadcasting())
+		{
+			Observers.Remove(StateClass);
+		}
+	}
+}
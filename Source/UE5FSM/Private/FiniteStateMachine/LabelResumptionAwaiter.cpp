@@ -0,0 +1,53 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/LabelResumptionAwaiter.h"
+
+#include "FiniteStateMachine/FiniteStateMachineSubsystem.h"
+
+FFSM_LabelResumptionAwaiter::FFSM_LabelResumptionAwaiter(const UMachineState* InState)
+{
+	UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(InState);
+	if (IsValid(Subsystem) && Subsystem->ShouldBudgetLabelResumption(InState))
+	{
+		Scheduler = Subsystem;
+	}
+}
+
+FFSM_LabelResumptionAwaiter::~FFSM_LabelResumptionAwaiter()
+{
+	// The coroutine might be destroyed while waiting
+	if (QueueIndex != INDEX_NONE && Scheduler.IsValid())
+	{
+		Scheduler->CancelLabelResumption(this);
+	}
+}
+
+bool FFSM_LabelResumptionAwaiter::await_ready()
+{
+	UFiniteStateMachineSubsystem* Subsystem = Scheduler.Get();
+	if (!IsValid(Subsystem))
+	{
+		return true;
+	}
+
+	if (Subsystem->HasLabelResumptionBudget())
+	{
+		// Carry on without suspending; the label is charged once it reaches its next latent execution
+		Subsystem->BeginLabelContinuation();
+		return true;
+	}
+
+	return false;
+}
+
+void FFSM_LabelResumptionAwaiter::await_suspend(std::coroutine_handle<> InHandle)
+{
+	UFiniteStateMachineSubsystem* Subsystem = Scheduler.Get();
+	Handle = InHandle;
+	Subsystem->DeferLabelResumption(this);
+}
+
+void FFSM_LabelResumptionAwaiter::await_resume() const
+{
+	// Empty
+}
@@ -4,8 +4,11 @@
 
 #include "FiniteStateMachine/FiniteStateMachine.h"
 #include "FiniteStateMachine/FiniteStateMachineLog.h"
+#include "FiniteStateMachine/FiniteStateMachineSubsystem.h"
 #include "FiniteStateMachine/MachineStateData.h"
+#include "FiniteStateMachine/StateActionAwaiter.h"
 #include "NativeGameplayTags.h"
+#include "UObject/ObjectKey.h"
 
 using namespace UE5Coro;
 
@@ -56,6 +59,18 @@ UMachineState::~UMachineState()
 {
 	StopRunningLabels();
 	StopLatentExecution_Implementation();
+	DetachActionAwaiters();
+}
+
+void UMachineState::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	// The default label is registered before the subclasses get to clear the flag
+	if (!bUsesLabels)
+	{
+		RegisteredLabels.Empty();
+	}
 }
 
 UWorld* UMachineState::GetWorld() const
@@ -95,6 +110,82 @@ float UMachineState::GetTimeSinceLastStateAction() const
 	return TimeSinceLastStateAction;
 }
 
+FDelegateHandle UMachineState::SubscribeToStateActions(EFSM_StateActionMask Actions,
+	FOnFilteredStateActionSignature&& Delegate, TSubclassOf<UMachineState> OtherStateFilter)
+{
+	if (Actions == EFSM_StateActionMask::None || !Delegate.IsBound())
+	{
+		return FDelegateHandle();
+	}
+
+	const FDelegateHandle Handle = Delegate.GetHandle();
+
+	FStateActionSubscription Subscription;
+	Subscription.Delegate = MoveTemp(Delegate);
+	Subscription.OtherStateFilter = OtherStateFilter;
+	Subscription.Actions = Actions;
+	StateActionSubscriptions.Add(MoveTemp(Subscription));
+
+	return Handle;
+}
+
+bool UMachineState::UnsubscribeFromStateActions(FDelegateHandle Handle)
+{
+	const bool bRemoved = StateActionSubscriptions.Remove(Handle);
+	return bRemoved;
+}
+
+uint16 UMachineState::GetImplementedK2Events(const UClass* InClass)
+{
+	check(IsInGameThread());
+
+	static TMap<TObjectKey<UClass>, uint16> Cache;
+
+#if WITH_EDITOR
+	// Recompiled blueprint classes are the same objects with different functions, hence forget about everything
+	static const FDelegateHandle ObjectsReplacedHandle = FCoreUObjectDelegates::OnObjectsReplaced.AddLambda(
+		[](const TMap<UObject*, UObject*>&)
+		{
+			Cache.Empty();
+		});
+#endif
+
+	if (const uint16* FoundEvents = Cache.Find(InClass))
+	{
+		return *FoundEvents;
+	}
+
+	const FName EventNames[] =
+	{
+		GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnBegan),
+		GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnEnded),
+		GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnPushed),
+		GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnPopped),
+		GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnResumed),
+		GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnPaused),
+		GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnActivated),
+		GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnDeactivated),
+		GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnAddedToStack),
+	};
+
+	uint16 ImplementedEvents = 0;
+	for (int32 i = 0; i < UE_ARRAY_COUNT(EventNames); i++)
+	{
+		if (InClass->IsFunctionImplementedInScript(EventNames[i]))
+		{
+			ImplementedEvents |= 1 << i;
+		}
+	}
+
+	Cache.Add(InClass, ImplementedEvents);
+	return ImplementedEvents;
+}
+
+bool UMachineState::IsK2EventImplemented(EK2Event Event) const
+{
+	return (ImplementedK2Events & (1 << static_cast<uint8>(Event))) != 0;
+}
+
 FString UMachineState::GetDebugData() const
 {
 	return "";
@@ -104,7 +195,10 @@ void UMachineState::OnBegan(TSubclassOf<UMachineState> OldState)
 {
 	OnAddedToStack(EStateAction::Begin, OldState);
 	OnActivated(EStateAction::Begin, OldState);
-	K2_OnBegan(OldState);
+	if (IsK2EventImplemented(EK2Event::OnBegan))
+	{
+		K2_OnBegan(OldState);
+	}
 }
 
 void UMachineState::OnEnded(TSubclassOf<UMachineState> NewState)
@@ -117,48 +211,72 @@ void UMachineState::OnEnded(TSubclassOf<UMachineState> NewState)
 	}
 
 	OnRemovedFromStack(EStateAction::End, NewState);
-	K2_OnEnded(NewState);
+	if (IsK2EventImplemented(EK2Event::OnEnded))
+	{
+		K2_OnEnded(NewState);
+	}
 }
 
 void UMachineState::OnPushed(TSubclassOf<UMachineState> OldState)
 {
 	OnAddedToStack(EStateAction::Push, OldState);
 	OnActivated(EStateAction::Push, OldState);
-	K2_OnPushed(OldState);
+	if (IsK2EventImplemented(EK2Event::OnPushed))
+	{
+		K2_OnPushed(OldState);
+	}
 }
 
 void UMachineState::OnPopped(TSubclassOf<UMachineState> NewState)
 {
 	OnDeactivated(EStateAction::Pop, NewState);
 	OnRemovedFromStack(EStateAction::Pop, NewState);
-	K2_OnPopped(NewState);
+	if (IsK2EventImplemented(EK2Event::OnPopped))
+	{
+		K2_OnPopped(NewState);
+	}
 }
 
 void UMachineState::OnResumed(TSubclassOf<UMachineState> OldState)
 {
 	OnActivated(EStateAction::Resume, OldState);
-	K2_OnResumed(OldState);
+	if (IsK2EventImplemented(EK2Event::OnResumed))
+	{
+		K2_OnResumed(OldState);
+	}
 }
 
 void UMachineState::OnPaused(TSubclassOf<UMachineState> NewState)
 {
 	OnDeactivated(EStateAction::Pause, NewState);
-	K2_OnPaused(NewState);
+	if (IsK2EventImplemented(EK2Event::OnPaused))
+	{
+		K2_OnPaused(NewState);
+	}
 }
 
 void UMachineState::OnActivated(EStateAction StateAction, TSubclassOf<UMachineState> OldState)
 {
-	K2_OnActivated(StateAction, OldState);
+	if (IsK2EventImplemented(EK2Event::OnActivated))
+	{
+		K2_OnActivated(StateAction, OldState);
+	}
 }
 
 void UMachineState::OnDeactivated(EStateAction StateAction, TSubclassOf<UMachineState> NewState)
 {
-	K2_OnDeactivated(StateAction, NewState);
+	if (IsK2EventImplemented(EK2Event::OnDeactivated))
+	{
+		K2_OnDeactivated(StateAction, NewState);
+	}
 }
 
 void UMachineState::OnAddedToStack(EStateAction StateAction, TSubclassOf<UMachineState> OldState)
 {
-	K2_OnAddedToStack(StateAction, OldState);
+	if (IsK2EventImplemented(EK2Event::OnAddedToStack))
+	{
+		K2_OnAddedToStack(StateAction, OldState);
+	}
 }
 
 void UMachineState::OnRemovedFromStack(EStateAction StateAction, TSubclassOf<UMachineState> NewState)
@@ -170,6 +288,13 @@ void UMachineState::OnRemovedFromStack(EStateAction StateAction, TSubclassOf<UMa
 
 bool UMachineState::RegisterLabel(FGameplayTag Label, const FLabelSignature& Callback)
 {
+	if (!bUsesLabels)
+	{
+		FSM_LOG(Warning, "Label [%s] can't be registered; state [%s] doesn't use labels.", *Label.ToString(),
+			*GetName());
+		return false;
+	}
+
 	if (!IsLabelTagCorrect(Label))
 	{
 		FSM_LOG(Warning, "Label [%s] is of wrong tag hierarchy.", *Label.ToString());
@@ -195,6 +320,12 @@ bool UMachineState::RegisterLabel(FGameplayTag Label, const FLabelSignature& Cal
 
 int32 UMachineState::StopRunningLabels()
 {
+	if (!bUsesLabels)
+	{
+		// No label has ever been activated
+		return 0;
+	}
+
 	int32 StoppedCoroutines = 0;
 	for (auto& [Coroutine, DebugData] : RunningLabels)
 	{
@@ -295,16 +426,50 @@ int32 UMachineState::StopLatentExecution_Implementation()
 
 bool UMachineState::IsStateActive() const
 {
+	if (IsValid(ParentState))
+	{
+		// Sub-states are not known to the state machine; they're active while running within their parent
+		return ParentState->ActiveSubState == this && IsRunning();
+	}
+
+	if (RegionIndex != INDEX_NONE)
+	{
+		return StateMachine.IsValid() && StateMachine->Regions[RegionIndex].ActiveState == this;
+	}
+
 	return StateMachine.IsValid() && StateMachine->IsInState(GetClass());
 }
 
 void UMachineState::Tick(float DeltaSeconds)
 {
-	if (!bLabelActivated)
+	if (bUsesLabels && !bLabelActivated)
 	{
+		UFiniteStateMachineSubsystem* Subsystem = StateMachine.IsValid() ? StateMachine->Registry.Get() : nullptr;
+		const bool bBudgetLabel = IsValid(Subsystem) && Subsystem->ShouldBudgetLabelResumption(this);
+		if (bBudgetLabel && !Subsystem->HasLabelResumptionBudget())
+		{
+			// Try again on the next tick
+			if (!bIsLabelActivationDeferred)
+			{
+				bIsLabelActivationDeferred = true;
+				Subsystem->AddDeferredLabelActivation();
+			}
+
+			return;
+		}
+
+		ClearDeferredLabelActivation();
+
 		const FLabelSignature& LabelFunction = RegisteredLabels.FindChecked(ActiveLabel);
 		if (ensureMsgf(LabelFunction.IsBound(), TEXT("Function for label [%s] is not bound"), *ActiveLabel.ToString()))
 		{
+			// Charge the label code running until its first suspension to the budget
+			TOptional<UFiniteStateMachineSubsystem::FLabelResumptionScope> ResumptionScope;
+			if (bBudgetLabel)
+			{
+				ResumptionScope.Emplace(Subsystem);
+			}
+
 			bLabelActivated = true;
 
 			// Disallow editing the active label
@@ -344,12 +509,33 @@ UMachineStateData* UMachineState::CreateStateData()
 	return BaseStateData;
 }
 
+void UMachineState::SoftReset()
+{
+	StopRunningLabels();
+	StopLatentExecution_Implementation();
+
+	ClearDeferredLabelActivation();
+
+	ActiveLabel = TAG_StateMachine_Label_Default;
+	bLabelActivated = false;
+	bIsActivatingLabel = false;
+	ActiveSubState = nullptr;
+	LastStateAction = EStateAction::None;
+	LastStateActionTime = 0.f;
+
+	if (IsValid(BaseStateData))
+	{
+		BaseStateData->ResetData();
+	}
+}
+
 void UMachineState::SetStateMachine(UFiniteStateMachine* InStateMachine)
 {
 	check(StateMachine.IsExplicitlyNull());
 	check(IsValid(InStateMachine));
 
 	StateMachine = InStateMachine;
+	ImplementedK2Events = GetImplementedK2Events(GetClass());
 
 	Initialize();
 }
@@ -362,6 +548,20 @@ void UMachineState::SetInitialLabel(FGameplayTag Label)
 
 void UMachineState::OnStateAction(EStateAction StateAction, TSubclassOf<UMachineState> StateClass)
 {
+	// The active sub-state is deactivated before its parent, and activated after it
+	const bool bIsDeactivation = StateAction == EStateAction::End || StateAction == EStateAction::Pop ||
+		StateAction == EStateAction::Pause;
+	if (bIsDeactivation && !SubStates.IsEmpty())
+	{
+		UpdateSubStates(StateAction, StateClass);
+	}
+
+	// A removed state doesn't wait to activate its label anymore
+	if (StateAction == EStateAction::End || StateAction == EStateAction::Pop)
+	{
+		ClearDeferredLabelActivation();
+	}
+
 	{
 		FMS_IsDispatchingEventManager Guard(this);
 
@@ -405,8 +605,153 @@ void UMachineState::OnStateAction(EStateAction StateAction, TSubclassOf<UMachine
 		LastStateActionTime = GetTime();
 	}
 
+	// Let the state machine handle the action before anyone else
+	if (StateMachine.IsValid())
+	{
+		StateMachine->OnStateAction(this, StateAction);
+	}
+
 	// Notify about a state action
 	OnStateActionDelegate.Broadcast(this, StateAction);
+	StateActionSubscriptions.Broadcast(StateAction, [StateClass](const FStateActionSubscription& Subscription)
+	{
+		return !Subscription.OtherStateFilter || (StateClass && StateClass->IsChildOf(Subscription.OtherStateFilter));
+	}, this, StateAction, StateClass);
+
+	if (StateMachine.IsValid())
+	{
+		StateMachine->NotifyStateActionObservers(this, StateAction, StateClass);
+	}
+
+	if (ActionWaitNodesHead)
+	{
+		ResumeActionAwaiters(StateAction);
+	}
+
+	// Don't activate the sub-state if the state has already been deactivated in the meantime
+	if (!bIsDeactivation && !SubStates.IsEmpty() && LastStateAction == StateAction)
+	{
+		UpdateSubStates(StateAction, StateClass);
+	}
+}
+
+void UMachineState::ClearDeferredLabelActivation()
+{
+	if (!bIsLabelActivationDeferred)
+	{
+		return;
+	}
+
+	bIsLabelActivationDeferred = false;
+
+	UFiniteStateMachineSubsystem* Subsystem = StateMachine.IsValid() ? StateMachine->Registry.Get() : nullptr;
+	if (IsValid(Subsystem))
+	{
+		Subsystem->RemoveDeferredLabelActivation();
+	}
+}
+
+void UMachineState::EndLabelContinuation() const
+{
+	UFiniteStateMachineSubsystem* Subsystem = StateMachine.IsValid() ? StateMachine->Registry.Get() : nullptr;
+	if (IsValid(Subsystem))
+	{
+		Subsystem->EndLabelContinuation();
+	}
+}
+
+void UMachineState::ResumeActionAwaiters(EStateAction StateAction)
+{
+	const EFSM_StateActionMask ActionMask = ToStateActionMask(StateAction);
+
+	// Awaiters linked while resuming the others have to wait for the next action
+	const uint32 LastSerial = ActionWaitNodesSerial;
+
+	bool bResumedAny = true;
+	while (bResumedAny)
+	{
+		bResumedAny = false;
+		for (FFSM_StateActionWaitNode* Node = ActionWaitNodesHead; Node; Node = Node->Next)
+		{
+			if (Node->Serial <= LastSerial && EnumHasAnyFlags(Node->Actions, ActionMask))
+			{
+				// Resuming a coroutine can alter the list in any way; start over
+				Node->Awaiter->OnNodeTriggered(*Node, StateAction);
+				bResumedAny = true;
+				break;
+			}
+		}
+	}
+}
+
+void UMachineState::DetachActionAwaiters()
+{
+	while (ActionWaitNodesHead)
+	{
+		FFSM_StateActionAwaiter::UnlinkNode(*ActionWaitNodesHead);
+	}
+}
+
+void UMachineState::UpdateSubStates(EStateAction StateAction, TSubclassOf<UMachineState> OtherState)
+{
+	switch (StateAction)
+	{
+	case EStateAction::Begin:
+	case EStateAction::Push:
+		if (!IsValid(ActiveSubState))
+		{
+			ActiveSubState = FindSubState(InitialSubState);
+			if (IsValid(ActiveSubState))
+			{
+				ActiveSubState->SetInitialLabel(InitialSubStateLabel);
+			}
+		}
+
+		// Sub-states begin regardless of whether the parent began or got pushed
+		if (IsValid(ActiveSubState) && !ActiveSubState->IsOnStack())
+		{
+			ActiveSubState->OnStateAction(EStateAction::Begin, OtherState);
+		}
+		break;
+
+	case EStateAction::Resume:
+		if (IsValid(ActiveSubState) && ActiveSubState->IsOnStack() && !ActiveSubState->IsRunning())
+		{
+			ActiveSubState->OnStateAction(EStateAction::Resume, OtherState);
+		}
+		break;
+
+	case EStateAction::Pause:
+		if (IsValid(ActiveSubState) && ActiveSubState->IsRunning())
+		{
+			ActiveSubState->OnStateAction(EStateAction::Pause, OtherState);
+		}
+		break;
+
+	case EStateAction::End:
+	case EStateAction::Pop:
+		if (IsValid(ActiveSubState) && ActiveSubState->IsOnStack())
+		{
+			ActiveSubState->OnStateAction(EStateAction::End, OtherState);
+		}
+
+		// Start over from the initial sub-state the next time
+		ActiveSubState = nullptr;
+		break;
+
+	default: checkNoEntry();
+	}
+}
+
+bool UMachineState::IsOnStack() const
+{
+	return LastStateAction != EStateAction::None && LastStateAction != EStateAction::End &&
+		LastStateAction != EStateAction::Pop;
+}
+
+bool UMachineState::IsRunning() const
+{
+	return IsOnStack() && LastStateAction != EStateAction::Pause;
 }
 
 bool UMachineState::CanSafelyDeactivate(FString& OutReason) const
@@ -433,17 +778,37 @@ FString UMachineState::GetDebugString(const FString& RunLatentExecutionExt) cons
 
 bool UMachineState::GotoState(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label, bool bForceEvents)
 {
+	if (RegionIndex != INDEX_NONE)
+	{
+		return StateMachine->GotoStateInRegion(GetRegion(), InStateClass, Label, bForceEvents);
+	}
+
 	return StateMachine->GotoState(InStateClass, Label, bForceEvents);
 }
 
 bool UMachineState::EndState()
 {
+	if (RegionIndex != INDEX_NONE)
+	{
+		return StateMachine->EndStateInRegion(GetRegion());
+	}
+
 	return StateMachine->EndState();
 }
 
 bool UMachineState::GotoLabel(FGameplayTag Label)
 {
-	if (Label.IsValid())
+	if (!bUsesLabels)
+	{
+		// Transitions to the default label are fine, there's just nothing to activate
+		if (Label.IsValid() && Label != TAG_StateMachine_Label_Default)
+		{
+			FSM_LOG(Warning, "Label [%s] can't be activated; state [%s] doesn't use labels.", *Label.ToString(),
+				*GetName());
+			return false;
+		}
+	}
+	else if (Label.IsValid())
 	{
 		if (!IsLabelTagCorrect(Label))
 		{
@@ -466,28 +831,62 @@ bool UMachineState::GotoLabel(FGameplayTag Label)
 	StopLatentExecution_Implementation();
 	StopRunningLabels();
 
+	if (StateMachine.IsValid() && StateMachine->ActiveState == this)
+	{
+		StateMachine->PublishStateSnapshot();
+	}
+
 	return true;
 }
 
 TCoroutine<> UMachineState::PushState(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label,
 	bool* bOutPrematureResult)
 {
-	co_await StateMachine->PushState(InStateClass, Label, bOutPrematureResult);
+	if (RegionIndex == INDEX_NONE)
+	{
+		co_await StateMachine->PushState(InStateClass, Label, bOutPrematureResult);
+		co_return;
+	}
+
+	const int32 MyRegionIndex = RegionIndex;
+	const bool bResult = StateMachine->PushStateInRegion(GetRegion(), InStateClass, Label);
+	if (bOutPrematureResult)
+	{
+		*bOutPrematureResult = bResult;
+	}
+
+	// The pushed state might have already been removed, resuming this one
+	const bool bIsDeferred = StateMachine->Regions[MyRegionIndex].bIsRunningLatentRequest;
+	if (bResult && (bIsDeferred || LastStateAction == EStateAction::Pause))
+	{
+		// Return code execution only after this state gets resumed
+		co_await FFSM_StateActionAwaiter(this, EFSM_StateActionMask::Resume);
+	}
 }
 
 TCoroutine<> UMachineState::PushStateQueued(FFSM_PushRequestHandle& OutHandle,
-	TSubclassOf<UMachineState> InStateClass, FGameplayTag Label)
+	TSubclassOf<UMachineState> InStateClass, FGameplayTag Label, int32 Priority, float Timeout)
 {
-	co_await StateMachine->PushStateQueued(OutHandle, InStateClass, Label);
+	co_await StateMachine->PushStateQueued(OutHandle, InStateClass, Label, Priority, Timeout);
 }
 
 bool UMachineState::PopState()
 {
+	if (RegionIndex != INDEX_NONE)
+	{
+		return StateMachine->PopStateInRegion(GetRegion());
+	}
+
 	return StateMachine->PopState();
 }
 
 int32 UMachineState::ClearStack()
 {
+	if (RegionIndex != INDEX_NONE)
+	{
+		return StateMachine->ClearStackInRegion(GetRegion());
+	}
+
 	return StateMachine->ClearStack();
 }
 
@@ -497,11 +896,227 @@ bool UMachineState::ContainsLabel(FGameplayTag Label) const
 	return !!LabelFunction;
 }
 
+void UMachineState::GetRegisteredLabels(TArray<FGameplayTag>& OutLabels) const
+{
+	RegisteredLabels.GenerateKeyArray(OutLabels);
+}
+
 bool UMachineState::IsLabelTagCorrect(FGameplayTag Tag)
 {
 	return Tag.MatchesTag(TAG_StateMachine_Label);
 }
 
+bool UMachineState::IsStateBlocklisted(TSubclassOf<UMachineState> InStateClass) const
+{
+	if (!IsValid(InStateClass) || !bUseBlocklist)
+	{
+		return false;
+	}
+
+	const bool bIsBlocked = StatesBlocklist.ContainsByPredicate(
+		[InStateClass](const TSubclassOf<UMachineState> Item)
+		{
+			return InStateClass->IsChildOf(Item);
+		});
+
+	return bIsBlocked;
+}
+
+bool UMachineState::IsStateAllowlisted(TSubclassOf<UMachineState> InStateClass) const
+{
+	if (!IsValid(InStateClass))
+	{
+		return false;
+	}
+
+	if (!bUseAllowlist)
+	{
+		return true;
+	}
+
+	const bool bIsAllowed = StatesAllowlist.ContainsByPredicate(
+		[InStateClass](const TSubclassOf<UMachineState> Item)
+		{
+			return InStateClass->IsChildOf(Item);
+		});
+
+	return bIsAllowed;
+}
+
+const TArray<FFSM_TransitionDeclaration>& UMachineState::GetDeclaredTransitions() const
+{
+	return DeclaredTransitions;
+}
+
+const TArray<FFSM_TransitionRule>& UMachineState::GetTransitionRules() const
+{
+	return TransitionRules;
+}
+
+bool UMachineState::IsUrgent() const
+{
+	return bIsUrgent;
+}
+
+bool UMachineState::UsesLabels() const
+{
+	return bUsesLabels;
+}
+
+bool UMachineState::GotoSubState(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label, bool bForceEvents)
+{
+	UMachineState* NewSubState = FindSubState(InStateClass);
+	if (!IsValid(NewSubState))
+	{
+		FSM_LOG(Warning, "Sub-state [%s] is not present in state [%s].", *GetNameSafe(InStateClass), *GetName());
+		return false;
+	}
+
+	if (!IsLabelTagCorrect(Label))
+	{
+		FSM_LOG(Warning, "Label [%s] is of wrong tag hierarchy.", *Label.ToString());
+		return false;
+	}
+
+	// States that don't use labels accept only the default one, which they don't activate
+	const bool bContainsLabel = NewSubState->UsesLabels() ? NewSubState->ContainsLabel(Label) :
+		Label == TAG_StateMachine_Label_Default;
+	if (!bContainsLabel)
+	{
+		FSM_LOG(Warning, "Label [%s] is not present in sub-state [%s].", *Label.ToString(), *NewSubState->GetName());
+		return false;
+	}
+
+	// Only choose the sub-state to start with when this state is added to the stack
+	if (!IsOnStack())
+	{
+		ActiveSubState = NewSubState;
+		NewSubState->SetInitialLabel(Label);
+		return true;
+	}
+
+	if (!IsRunning())
+	{
+		FSM_LOG(Warning, "State [%s] is paused. It's impossible to go to sub-state [%s].",
+			*GetName(), *NewSubState->GetName());
+		return false;
+	}
+
+	UMachineState* OldSubState = ActiveSubState;
+	const bool bIsOldSubStateOnStack = IsValid(OldSubState) && OldSubState->IsOnStack();
+	if (bIsOldSubStateOnStack)
+	{
+		if (OldSubState->IsDispatchingEvent())
+		{
+			FSM_LOG(Warning, "Sub-state [%s] is dispatching an event. It's impossible to go to sub-state [%s].",
+				*OldSubState->GetName(), *NewSubState->GetName());
+			return false;
+		}
+
+		FString Reason;
+		if (!OldSubState->CanSafelyDeactivate(OUT Reason))
+		{
+			FSM_LOG(Warning, "Sub-state [%s] cannot be deactivated. Reason: %s", *OldSubState->GetName(), *Reason);
+			return false;
+		}
+
+		if (OldSubState->IsStateBlocklisted(InStateClass) || !OldSubState->IsStateAllowlisted(InStateClass))
+		{
+			FSM_LOG(Warning, "Sub-state [%s] doesn't allow to go to sub-state [%s].",
+				*OldSubState->GetName(), *NewSubState->GetName());
+			return false;
+		}
+
+		if (OldSubState == NewSubState && !bForceEvents)
+		{
+			return NewSubState->GotoLabel(Label);
+		}
+
+		OldSubState->OnStateAction(EStateAction::End, InStateClass);
+
+		// Ending the sub-state might have caused a transition removing this state from the stack
+		if (!IsRunning())
+		{
+			return false;
+		}
+	}
+
+	ActiveSubState = NewSubState;
+	NewSubState->SetInitialLabel(Label);
+	NewSubState->OnStateAction(EStateAction::Begin, IsValid(OldSubState) ? OldSubState->GetClass() : nullptr);
+
+	return true;
+}
+
+bool UMachineState::EndSubState()
+{
+	UMachineState* OldSubState = ActiveSubState;
+	if (!IsValid(OldSubState) || !OldSubState->IsOnStack())
+	{
+		return false;
+	}
+
+	if (OldSubState->IsDispatchingEvent())
+	{
+		FSM_LOG(Warning, "Sub-state [%s] is dispatching an event. It's impossible to end it.",
+			*OldSubState->GetName());
+		return false;
+	}
+
+	FString Reason;
+	if (!OldSubState->CanSafelyDeactivate(OUT Reason))
+	{
+		FSM_LOG(Warning, "Sub-state [%s] cannot be deactivated. Reason: %s", *OldSubState->GetName(), *Reason);
+		return false;
+	}
+
+	OldSubState->OnStateAction(EStateAction::End, nullptr);
+	if (ActiveSubState == OldSubState)
+	{
+		ActiveSubState = nullptr;
+	}
+
+	return true;
+}
+
+UMachineState* UMachineState::GetActiveSubState() const
+{
+	return IsValid(ActiveSubState) && ActiveSubState->IsOnStack() ? ActiveSubState.Get() : nullptr;
+}
+
+UMachineState* UMachineState::FindSubState(TSubclassOf<UMachineState> InStateClass) const
+{
+	if (!IsValid(InStateClass))
+	{
+		return nullptr;
+	}
+
+	for (const TObjectPtr<UMachineState> SubState : SubStates)
+	{
+		if (SubState->GetClass()->IsChildOf(InStateClass))
+		{
+			return SubState;
+		}
+	}
+
+	return nullptr;
+}
+
+UMachineState* UMachineState::GetParentState() const
+{
+	return ParentState;
+}
+
+FGameplayTag UMachineState::GetRegion() const
+{
+	if (RegionIndex == INDEX_NONE || !StateMachine.IsValid())
+	{
+		return FGameplayTag::EmptyTag;
+	}
+
+	return StateMachine->Regions[RegionIndex].Definition.RegionTag;
+}
+
 AActor* UMachineState::GetOwner() const
 {
 	return GetOwner<AActor>();
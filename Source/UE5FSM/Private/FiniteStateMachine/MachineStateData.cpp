@@ -1,3 +1,63 @@
 // Author: Antonio Sidenko (Tonetfal). All rights reserved.
 
 #include "FiniteStateMachine/MachineStateData.h"
+
+/**
+ * Copy every property of an archetype to an object without sharing the instanced objects of the archetype with it.
+ * @param	Object object to reset.
+ * @param	Archetype object to copy the properties from.
+ */
+static void ResetToArchetype(UObject* Object, const UObject* Archetype)
+{
+	for (TFieldIterator<FProperty> It(Object->GetClass()); It; ++It)
+	{
+		FProperty* Property = *It;
+		if (!Property->ContainsInstancedObjectProperty())
+		{
+			Property->CopyCompleteValue_InContainer(Object, Archetype);
+			continue;
+		}
+
+		// The instanced objects owned by the object are kept, so that nothing referencing them gets invalidated
+		const auto* ObjectProperty = CastField<FObjectProperty>(Property);
+		if (ObjectProperty)
+		{
+			for (int32 i = 0; i < ObjectProperty->ArrayDim; i++)
+			{
+				UObject* Subobject = ObjectProperty->GetObjectPropertyValue_InContainer(Object, i);
+				const UObject* Template = ObjectProperty->GetObjectPropertyValue_InContainer(Archetype, i);
+				if (!IsValid(Template))
+				{
+					ObjectProperty->SetObjectPropertyValue_InContainer(Object, nullptr, i);
+				}
+				else if (IsValid(Subobject) && Subobject != Template && Subobject->IsIn(Object) &&
+					Subobject->GetClass() == Template->GetClass())
+				{
+					ResetToArchetype(Subobject, Template);
+				}
+				else
+				{
+					UObject* NewSubobject = DuplicateObject<UObject>(Template, Object);
+					ObjectProperty->SetObjectPropertyValue_InContainer(Object, NewSubobject, i);
+				}
+			}
+
+			continue;
+		}
+
+		// Containers and structs get new instances out of the archetype ones
+		Property->CopyCompleteValue_InContainer(Object, Archetype);
+
+		FObjectInstancingGraph InstancingGraph(Object);
+		Property->InstanceSubobjects(Property->ContainerPtrToValuePtr<void>(Object),
+			Property->ContainerPtrToValuePtr<void>(Archetype), Object, &InstancingGraph);
+	}
+}
+
+void UMachineStateData::ResetData()
+{
+	const UObject* Archetype = GetArchetype();
+	check(IsValid(Archetype));
+
+	ResetToArchetype(this, Archetype);
+}
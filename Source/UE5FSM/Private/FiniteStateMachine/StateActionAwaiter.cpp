@@ -0,0 +1,155 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/StateActionAwaiter.h"
+
+FFSM_StateActionAwaiter::FFSM_StateActionAwaiter(UMachineState* InState, EFSM_StateActionMask InActions)
+{
+	AddNode(InState, InActions);
+}
+
+FFSM_StateActionAwaiter::FFSM_StateActionAwaiter(TConstArrayView<FFSM_StateActionTarget> Targets, bool bInWaitAll)
+	: bWaitAll(bInWaitAll)
+{
+	Nodes.Reserve(Targets.Num());
+	for (const FFSM_StateActionTarget& Target : Targets)
+	{
+		AddNode(Target.State, Target.Actions);
+	}
+}
+
+FFSM_StateActionAwaiter::FFSM_StateActionAwaiter(FFSM_StateActionAwaiter&& Other)
+	: Nodes(MoveTemp(Other.Nodes))
+	, Result(Other.Result)
+	, bWaitAll(Other.bWaitAll)
+{
+	// Nodes are linked only on suspension, their addresses must not change afterwards
+	check(!Other.Handle);
+}
+
+FFSM_StateActionAwaiter::~FFSM_StateActionAwaiter()
+{
+	// The coroutine might be destroyed while waiting
+	UnlinkNodes();
+}
+
+FFSM_StateActionAwaiter FFSM_StateActionAwaiter::WhenAny(TConstArrayView<FFSM_StateActionTarget> Targets)
+{
+	return FFSM_StateActionAwaiter(Targets, false);
+}
+
+FFSM_StateActionAwaiter FFSM_StateActionAwaiter::WhenAll(TConstArrayView<FFSM_StateActionTarget> Targets)
+{
+	return FFSM_StateActionAwaiter(Targets, true);
+}
+
+bool FFSM_StateActionAwaiter::await_ready() const
+{
+	return Nodes.IsEmpty();
+}
+
+void FFSM_StateActionAwaiter::await_suspend(std::coroutine_handle<> InHandle)
+{
+	Handle = InHandle;
+
+	for (FFSM_StateActionWaitNode& Node : Nodes)
+	{
+		LinkNode(Node);
+	}
+}
+
+FFSM_StateActionWaitResult FFSM_StateActionAwaiter::await_resume() const
+{
+	return Result;
+}
+
+void FFSM_StateActionAwaiter::OnNodeTriggered(FFSM_StateActionWaitNode& Node, EStateAction StateAction)
+{
+	UnlinkNode(Node);
+	TriggeredNodesNum++;
+
+	Result.TargetIndex = static_cast<int32>(&Node - Nodes.GetData());
+	Result.StateAction = StateAction;
+
+	if (bWaitAll && TriggeredNodesNum < Nodes.Num())
+	{
+		return;
+	}
+
+	UnlinkNodes();
+
+	// The awaiter might not exist anymore after this point
+	Handle.resume();
+}
+
+void FFSM_StateActionAwaiter::AddNode(UMachineState* InState, EFSM_StateActionMask InActions)
+{
+	// Waiting for a state that doesn't exist, or for no action, would never end
+	if (IsValid(InState) && InActions != EFSM_StateActionMask::None)
+	{
+		FFSM_StateActionWaitNode& Node = Nodes.AddDefaulted_GetRef();
+		Node.State = InState;
+		Node.Actions = InActions;
+	}
+}
+
+void FFSM_StateActionAwaiter::LinkNode(FFSM_StateActionWaitNode& Node)
+{
+	check(!Node.bIsLinked);
+
+	UMachineState* State = Node.State;
+	Node.Awaiter = this;
+	Node.Serial = ++State->ActionWaitNodesSerial;
+	Node.Prev = State->ActionWaitNodesTail;
+	Node.Next = nullptr;
+	Node.bIsLinked = true;
+
+	if (State->ActionWaitNodesTail)
+	{
+		State->ActionWaitNodesTail->Next = &Node;
+	}
+	else
+	{
+		State->ActionWaitNodesHead = &Node;
+	}
+
+	State->ActionWaitNodesTail = &Node;
+}
+
+void FFSM_StateActionAwaiter::UnlinkNode(FFSM_StateActionWaitNode& Node)
+{
+	if (!Node.bIsLinked)
+	{
+		return;
+	}
+
+	UMachineState* State = Node.State;
+	if (Node.Prev)
+	{
+		Node.Prev->Next = Node.Next;
+	}
+	else
+	{
+		State->ActionWaitNodesHead = Node.Next;
+	}
+
+	if (Node.Next)
+	{
+		Node.Next->Prev = Node.Prev;
+	}
+	else
+	{
+		State->ActionWaitNodesTail = Node.Prev;
+	}
+
+	Node.Prev = nullptr;
+	Node.Next = nullptr;
+	Node.bIsLinked = false;
+}
+
+void FFSM_StateActionAwaiter::UnlinkNodes()
+{
+	for (FFSM_StateActionWaitNode& Node : Nodes)
+	{
+		UnlinkNode(Node);
+	}
+}
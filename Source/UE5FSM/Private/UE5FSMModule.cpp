@@ -8,6 +8,7 @@
 #define LOCTEXT_NAMESPACE "FUE5FSMModule"
 
 UE_DEFINE_GAMEPLAY_TAG(TAG_StateMachine_Label_Test, "StateMachine.Label.Test");
+UE_DEFINE_GAMEPLAY_TAG(TAG_StateMachine_Region_Test, "StateMachine.Region.Test");
 
 const static FName DebuggerCategoryName = "UE5FSM";
 
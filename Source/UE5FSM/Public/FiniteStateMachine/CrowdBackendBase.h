@@ -0,0 +1,146 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/CrowdMachineState.h"
+
+/**
+ * Crowd backend performing the transitions of its agents, regardless of where it stores their runtime data.
+ *
+ * Requested transitions are performed in order, and the events they cause are dispatched in chunks grouped by state
+ * and action once the whole batch has been performed. Transitions requested by the events are performed in the next
+ * batch, up to MaxTransitionIterations times.
+ *
+ * Backends expose the runtime data of their agents through GetAgentState().
+ */
+class UE5FSM_API FFSM_CrowdBackendBase
+	: public ICrowdStateMachineBackend
+{
+public:
+	/** Maximum amount of states on the stack of an agent, including the active one. */
+	static constexpr int32 MaxStackDepth = 4;
+
+	/** Maximum amount of agents a single chunk holds. */
+	static constexpr int32 ChunkSize = 1024;
+
+	/** Amount of times the events may request new transitions within a single processing. */
+	static constexpr int32 MaxTransitionIterations = 16;
+
+	/** Kind of a transition request. */
+	enum class ETransitionType : uint8
+	{
+		Goto,
+		GotoLabel,
+		Push,
+		Pop
+	};
+
+	/** Transition requested for a single agent. */
+	struct FTransitionRequest
+	{
+	public:
+		int32 AgentIndex = INDEX_NONE;
+		int32 StateIndex = INDEX_NONE;
+		int32 LabelIndex = INDEX_NONE;
+		ETransitionType Type = ETransitionType::Goto;
+	};
+
+public:
+	/**
+	 * Get the shared instance of a registered state out of its index.
+	 * @param	StateIndex index of the state.
+	 * @return	State.
+	 */
+	virtual UCrowdMachineState* GetStateByIndex(int32 StateIndex) const = 0;
+
+protected:
+	/** Runtime data of a single agent. Points into the storage of the backend. */
+	struct FAgentState
+	{
+	public:
+		int32* ActiveState = nullptr;
+		int32* ActiveLabel = nullptr;
+		float* StateTime = nullptr;
+		float* LabelTime = nullptr;
+
+		/** Amount of states on the stack, including the active one. The agent has no active state if it's 0. */
+		uint8* StackDepth = nullptr;
+
+		/** MaxStackDepth states on the stack from the bottom one. */
+		int32* StackStates = nullptr;
+
+		/** MaxStackDepth labels of the states on the stack. */
+		int32* StackLabels = nullptr;
+	};
+
+	/**
+	 * Get the runtime data of an agent a transition is to be performed for.
+	 * @param	AgentIndex index of the agent.
+	 * @param	OutAgent output parameter. Runtime data of the agent.
+	 * @return	If true, the agent exists, false otherwise.
+	 */
+	virtual bool GetAgentState(int32 AgentIndex, FAgentState& OutAgent) = 0;
+
+	/**
+	 * Called when a transition has changed the active state of an agent.
+	 * @param	AgentIndex index of the agent.
+	 * @param	PreviousStateIndex state that was active. INDEX_NONE if there was none.
+	 * @param	NewStateIndex state that is active now. INDEX_NONE if there's none.
+	 */
+	virtual void OnActiveStateChanged(int32 AgentIndex, int32 PreviousStateIndex, int32 NewStateIndex);
+
+	/**
+	 * Perform the requested transitions in order, and dispatch the events they've caused.
+	 */
+	void ApplyTransitionRequests();
+
+	/**
+	 * Call a function for each chunk of a list of agents.
+	 * @param	Agents indices of the agents.
+	 * @param	DeltaTime time since the previous processing.
+	 * @param	Function function to call with each chunk.
+	 */
+	void ForEachChunk(TConstArrayView<int32> Agents, float DeltaTime,
+		TFunctionRef<void(const FFSM_CrowdChunk& Chunk)> Function);
+
+	/**
+	 * Drop the requested transitions and the pending events, and free their memory.
+	 */
+	void EmptyTransitionRequests();
+
+private:
+	/** Event to dispatch to a state for a single agent. */
+	struct FPendingEvent
+	{
+	public:
+		int32 AgentIndex = INDEX_NONE;
+		int32 StateIndex = INDEX_NONE;
+		EStateAction Action = EStateAction::None;
+	};
+
+	/**
+	 * Perform a single transition request.
+	 * @param	Request request to perform.
+	 * @param	Agent runtime data of the agent.
+	 */
+	void ApplyTransitionRequest(const FTransitionRequest& Request, const FAgentState& Agent);
+
+	/**
+	 * Dispatch the pending events grouped by state and action.
+	 */
+	void DispatchPendingEvents();
+
+protected:
+	/** Transitions to perform. */
+	TArray<FTransitionRequest> TransitionRequests;
+
+private:
+	/** Transitions being performed. Swapped with TransitionRequests to let the events request new ones. */
+	TArray<FTransitionRequest> TransitionRequestsBatch;
+
+	/** Events caused by the performed transitions waiting to be dispatched. */
+	TArray<FPendingEvent> PendingEvents;
+
+	/** Scratch buffer of the agents of a single event dispatch. */
+	TArray<int32> EventAgents;
+};
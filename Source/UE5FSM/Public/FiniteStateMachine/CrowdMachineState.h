@@ -0,0 +1,236 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/CrowdStateMachineBackend.h"
+#include "FiniteStateMachine/MachineState.h"
+
+#include "CrowdMachineState.generated.h"
+
+class UCrowdMachineState;
+
+/**
+ * Handle of an agent of the crowd state machine backend.
+ */
+USTRUCT(BlueprintType)
+struct UE5FSM_API FFSM_CrowdAgentHandle
+{
+	GENERATED_BODY()
+
+public:
+	FFSM_CrowdAgentHandle() = default;
+	FFSM_CrowdAgentHandle(int32 InIndex, uint32 InSerial)
+		: Index(InIndex)
+		, Serial(InSerial)
+	{
+	}
+
+	bool operator==(const FFSM_CrowdAgentHandle& Rhs) const
+	{
+		return Index == Rhs.Index && Serial == Rhs.Serial;
+	}
+
+	bool operator!=(const FFSM_CrowdAgentHandle& Rhs) const
+	{
+		return !(*this == Rhs);
+	}
+
+	/**
+	 * Check whether the handle has ever been assigned. It might refer to a removed agent nevertheless.
+	 * @return	If true, the handle has been assigned, false otherwise.
+	 */
+	bool IsSet() const
+	{
+		return Index != INDEX_NONE;
+	}
+
+public:
+	/** Index of the agent in the arrays of the subsystem. Stable for the whole lifetime of the agent. */
+	int32 Index = INDEX_NONE;
+
+	/** Serial number telling apart the agents that have been using the same index. */
+	uint32 Serial = 0;
+};
+
+/**
+ * Agents of the crowd that are in the same state at the same label, processed together by a label function.
+ */
+struct UE5FSM_API FFSM_CrowdChunk
+{
+public:
+	/**
+	 * Get the amount of agents in the chunk.
+	 * @return	Amount of agents.
+	 */
+	int32 Num() const;
+
+	/**
+	 * Get the index of an agent in the backend. Meant to index the data kept alongside the agents.
+	 * @param	i index of the agent in the chunk.
+	 * @return	Agent index.
+	 */
+	int32 GetAgentIndex(int32 i) const;
+
+	/**
+	 * Get the time since an agent has entered the state.
+	 * @param	i index of the agent in the chunk.
+	 * @return	Time in seconds.
+	 */
+	float GetStateTime(int32 i) const;
+
+	/**
+	 * Get the time since an agent has entered the label.
+	 * @param	i index of the agent in the chunk.
+	 * @return	Time in seconds.
+	 */
+	float GetLabelTime(int32 i) const;
+
+	/**
+	 * Request an agent to go to a state. Performed once the chunks of the frame have been processed.
+	 * @see		ICrowdStateMachineBackend::RequestGotoState()
+	 */
+	void GotoState(int32 i, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default) const;
+
+	/**
+	 * Request an agent to go to a label of its active state. Performed once the chunks of the frame have been
+	 * processed.
+	 * @see		ICrowdStateMachineBackend::RequestGotoLabel()
+	 */
+	void GotoLabel(int32 i, FGameplayTag Label) const;
+
+	/**
+	 * Request an agent to push a state. Performed once the chunks of the frame have been processed.
+	 * @see		ICrowdStateMachineBackend::RequestPushState()
+	 */
+	void PushState(int32 i, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default) const;
+
+	/**
+	 * Request an agent to pop its active state. Performed once the chunks of the frame have been processed.
+	 * @see		ICrowdStateMachineBackend::RequestPopState()
+	 */
+	void PopState(int32 i) const;
+
+public:
+	/** Backend the agents belong to. */
+	ICrowdStateMachineBackend* Backend = nullptr;
+
+	/** Indices of the agents in the backend. */
+	TConstArrayView<int32> Agents;
+
+	/** Time since the previous tick. */
+	float DeltaTime = 0.f;
+};
+
+/**
+ * State of the crowd state machine backends. Unlike UMachineState, a single instance of it is shared by all the agents
+ * in it, and it doesn't keep any per-agent data; a backend, e.g. UCrowdStateMachineSubsystem, owns the state machines
+ * of the agents.
+ *
+ * # Labels
+ * - Labels are registered using REGISTER_LABEL(), just like in UMachineState, and use the same label tags.
+ * - A label is a function called each frame with chunks of the agents that are at it. Instead of awaiting latent
+ * actions, it compares the timers of the agents, e.g. FFSM_CrowdChunk::GetLabelTime().
+ * - GOTO_STATE() and the like co_return from coroutines, hence they can't be used. Request the transitions through the
+ * chunk instead. They're performed once all the chunks of the frame have been processed.
+ *
+ * # Events
+ * - OnBegan(), OnEnded(), OnPaused() and OnResumed() are called with chunks of the agents that have performed the
+ * action during the frame.
+ */
+UCLASS(Abstract, ClassGroup=("Finite State Machine"))
+class UE5FSM_API UCrowdMachineState
+	: public UObject
+{
+	GENERATED_BODY()
+
+public:
+	DECLARE_DELEGATE_OneParam(
+		FLabelSignature,
+		const FFSM_CrowdChunk& Chunk);
+
+public:
+	UCrowdMachineState();
+
+	/**
+	 * Check whether the state contains a given label.
+	 * @param	Label label to check the presence of.
+	 * @return	If true, the state contains the label, false otherwise.
+	 */
+	bool ContainsLabel(FGameplayTag Label) const;
+
+	/**
+	 * Get the labels the state registers in registration order.
+	 * @return	Registered labels.
+	 */
+	const TArray<FGameplayTag>& GetRegisteredLabels() const;
+
+	/**
+	 * Find the index of a registered label. Backends store it instead of the label.
+	 * @param	Label label to search for.
+	 * @return	Label index. INDEX_NONE if the label is not registered.
+	 */
+	int32 FindLabelIndex(FGameplayTag Label) const;
+
+	/**
+	 * Call a label function with a chunk of agents.
+	 * @param	LabelIndex index of the label.
+	 * @param	Chunk agents at the label.
+	 */
+	void ExecuteLabel(int32 LabelIndex, const FFSM_CrowdChunk& Chunk);
+
+	/**
+	 * Call an event with a chunk of agents.
+	 * @param	Action action the agents have performed. Begin, End, Pause or Resume.
+	 * @param	Chunk agents that have performed the action.
+	 */
+	void DispatchEvent(EStateAction Action, const FFSM_CrowdChunk& Chunk);
+
+protected:
+	/**
+	 * Register a new label this state contains.
+	 * @param	Label gameplay tag associated with the label.
+	 * @param	Callback function to call with the chunks of the agents at the label.
+	 * @return	If true, the label has been registered, false otherwise.
+	 * @see		REGISTER_LABEL()
+	 */
+	bool RegisterLabel(FGameplayTag Label, const FLabelSignature& Callback);
+
+	/**
+	 * Default label the agents start with, if not told otherwise.
+	 * @param	Chunk agents at the label.
+	 */
+	virtual void Label_Default(const FFSM_CrowdChunk& Chunk);
+
+	/**
+	 * Called with the agents that have entered the state.
+	 * @param	Chunk agents that have entered the state.
+	 */
+	virtual void OnBegan(const FFSM_CrowdChunk& Chunk);
+
+	/**
+	 * Called with the agents that have left the state.
+	 * @param	Chunk agents that have left the state.
+	 */
+	virtual void OnEnded(const FFSM_CrowdChunk& Chunk);
+
+	/**
+	 * Called with the agents that have pushed another state on top of this one.
+	 * @param	Chunk agents that have paused the state.
+	 */
+	virtual void OnPaused(const FFSM_CrowdChunk& Chunk);
+
+	/**
+	 * Called with the agents that have popped the state on top of this one.
+	 * @param	Chunk agents that have resumed the state.
+	 */
+	virtual void OnResumed(const FFSM_CrowdChunk& Chunk);
+
+private:
+	/** Registered labels. The index of each label is the one the agents store. */
+	TArray<FGameplayTag> RegisteredLabels;
+
+	/** Functions of the registered labels in the same order. */
+	TArray<FLabelSignature> LabelFunctions;
+};
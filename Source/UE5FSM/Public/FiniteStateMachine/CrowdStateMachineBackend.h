@@ -0,0 +1,73 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "GameplayTagContainer.h"
+#include "Templates/SubclassOf.h"
+
+class UCrowdMachineState;
+
+/**
+ * Storage of the runtime data of crowd agents (active state, label, timers and stack) that runs the crowd states.
+ * Chunks forward the queries and the transition requests of the labels to it.
+ *
+ * Agents are identified by an index whose meaning is up to the backend, e.g. an index in its arrays.
+ *
+ * @see		UCrowdStateMachineSubsystem
+ */
+class UE5FSM_API ICrowdStateMachineBackend
+{
+public:
+	virtual ~ICrowdStateMachineBackend() = default;
+
+	/**
+	 * Get the name telling apart the backends, so that states can access backend-specific data.
+	 * @return	Backend name.
+	 */
+	virtual FName GetBackendName() const = 0;
+
+	/**
+	 * Get the time since an agent has entered its active state.
+	 * @param	AgentIndex index of the agent.
+	 * @return	Time in seconds.
+	 */
+	virtual float GetStateTime(int32 AgentIndex) const = 0;
+
+	/**
+	 * Get the time since an agent has entered its active label.
+	 * @param	AgentIndex index of the agent.
+	 * @return	Time in seconds.
+	 */
+	virtual float GetLabelTime(int32 AgentIndex) const = 0;
+
+	/**
+	 * Request an agent to go to a state.
+	 * @param	AgentIndex index of the agent.
+	 * @param	InStateClass state to go to.
+	 * @param	Label label to start the state with.
+	 */
+	virtual void RequestGotoState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label) = 0;
+
+	/**
+	 * Request an agent to go to a label of its active state.
+	 * @param	AgentIndex index of the agent.
+	 * @param	Label label to go to.
+	 */
+	virtual void RequestGotoLabel(int32 AgentIndex, FGameplayTag Label) = 0;
+
+	/**
+	 * Request an agent to push a state.
+	 * @param	AgentIndex index of the agent.
+	 * @param	InStateClass state to push.
+	 * @param	Label label to start the state with.
+	 */
+	virtual void RequestPushState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label) = 0;
+
+	/**
+	 * Request an agent to pop its active state.
+	 * @param	AgentIndex index of the agent.
+	 */
+	virtual void RequestPopState(int32 AgentIndex) = 0;
+};
@@ -0,0 +1,331 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/CrowdBackendBase.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "CrowdStateMachineSubsystem.generated.h"
+
+/**
+ * Data-oriented backend running lightweight state machines for crowds of agents without any component or per-agent
+ * object.
+ *
+ * # Data layout
+ * - The runtime data of the agents (active state, label, timers and stack) is kept in contiguous arrays, one per
+ * field, indexed by the agent index. Removed agents leave their slots to the next added ones.
+ * - Each state class is instantiated only once per subsystem, and is shared by all the agents in it. See
+ * UCrowdMachineState.
+ *
+ * # Processing
+ * - Each frame, the agents are sorted by their state and label, and each label function is called with chunks of the
+ * agents at it.
+ * - Transitions requested while processing are performed once all the chunks have been processed, and then the
+ * events are dispatched in chunks as well. Transitions requested outside the processing are performed right away.
+ * - Timers are advanced in a single pass over the arrays at the end of the frame.
+ *
+ * # Stack
+ * - Each agent has a stack of up to MaxStackDepth states. Paused states are not processed.
+ */
+UCLASS()
+class UE5FSM_API UCrowdStateMachineSubsystem
+	: public UTickableWorldSubsystem
+	, public FFSM_CrowdBackendBase
+{
+	GENERATED_BODY()
+
+public:
+	/** Name of the backend. */
+	static const FName BackendName;
+
+public:
+	//~USubsystem Interface
+	virtual void Deinitialize() override;
+	//~End of USubsystem Interface
+
+	//~FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End of FTickableGameObject Interface
+
+	//~ICrowdStateMachineBackend Interface
+	virtual FName GetBackendName() const override;
+	virtual float GetStateTime(int32 AgentIndex) const override;
+	virtual float GetLabelTime(int32 AgentIndex) const override;
+	virtual void RequestGotoState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label) override;
+	virtual void RequestGotoLabel(int32 AgentIndex, FGameplayTag Label) override;
+	virtual void RequestPushState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label) override;
+	virtual void RequestPopState(int32 AgentIndex) override;
+	//~End of ICrowdStateMachineBackend Interface
+
+	//~FFSM_CrowdBackendBase Interface
+	virtual UCrowdMachineState* GetStateByIndex(int32 StateIndex) const override;
+	//~End of FFSM_CrowdBackendBase Interface
+
+	/**
+	 * Get the subsystem of the world a given object is in.
+	 * @param	WorldContextObject object to get the world from.
+	 * @return	Subsystem. May be nullptr.
+	 */
+	static UCrowdStateMachineSubsystem* Get(const UObject* WorldContextObject);
+
+	/**
+	 * Create the shared instance of a state class. States are registered on their first use otherwise.
+	 * @param	InStateClass state class to register.
+	 * @return	If true, the state is registered, false otherwise.
+	 */
+	bool RegisterState(TSubclassOf<UCrowdMachineState> InStateClass);
+
+	/**
+	 * Add an agent.
+	 * @param	InitialState state the agent starts with. If not specified, it won't have any.
+	 * @param	Label label the initial state starts with.
+	 * @return	Agent handle. Unset if the initial state or label are invalid.
+	 */
+	FFSM_CrowdAgentHandle AddAgent(TSubclassOf<UCrowdMachineState> InitialState = nullptr,
+		FGameplayTag Label = TAG_StateMachine_Label_Default);
+
+	/**
+	 * Remove an agent. Its states are ended without dispatching the events. Agents removed while processing are removed
+	 * once the processing finishes, and are invalid in the meantime.
+	 * @param	Agent agent to remove.
+	 * @return	If true, the agent has been removed, false otherwise.
+	 */
+	bool RemoveAgent(FFSM_CrowdAgentHandle Agent);
+
+	/**
+	 * Check whether a handle refers to an existing agent.
+	 * @param	Agent agent to check.
+	 * @return	If true, the agent exists, false otherwise.
+	 */
+	bool IsAgentValid(FFSM_CrowdAgentHandle Agent) const;
+
+	/**
+	 * Get the amount of existing agents.
+	 * @return	Amount of agents.
+	 */
+	int32 GetAgentsNum() const;
+
+	/**
+	 * Activate a state at a specified label. The active state ends.
+	 * @param	Agent agent to perform the transition for.
+	 * @param	InStateClass state to go to.
+	 * @param	Label label to start the state with.
+	 * @return	If true, the transition has been accepted, false otherwise.
+	 */
+	bool GotoState(FFSM_CrowdAgentHandle Agent, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default);
+
+	/**
+	 * Go to a label of the active state.
+	 * @param	Agent agent to perform the transition for.
+	 * @param	Label label to go to.
+	 * @return	If true, the transition has been accepted, false otherwise.
+	 */
+	bool GotoLabel(FFSM_CrowdAgentHandle Agent, FGameplayTag Label);
+
+	/**
+	 * Push a state at a specified label on top of the stack. The active state gets paused.
+	 * @param	Agent agent to perform the transition for.
+	 * @param	InStateClass state to push.
+	 * @param	Label label to start the state with.
+	 * @return	If true, the transition has been accepted, false otherwise.
+	 */
+	bool PushState(FFSM_CrowdAgentHandle Agent, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default);
+
+	/**
+	 * Pop the active state. The state below it, if any, gets resumed.
+	 * @param	Agent agent to perform the transition for.
+	 * @return	If true, the transition has been accepted, false otherwise.
+	 */
+	bool PopState(FFSM_CrowdAgentHandle Agent);
+
+	/**
+	 * Get the active state of an agent.
+	 * @param	Agent agent to get the state of.
+	 * @return	Active state class. nullptr if there's none.
+	 */
+	TSubclassOf<UCrowdMachineState> GetActiveState(FFSM_CrowdAgentHandle Agent) const;
+
+	/**
+	 * Get the label the active state of an agent is at.
+	 * @param	Agent agent to get the label of.
+	 * @return	Active label. Empty if there's no active state.
+	 */
+	FGameplayTag GetActiveLabel(FFSM_CrowdAgentHandle Agent) const;
+
+	/**
+	 * Check whether an agent is in a given state.
+	 * @param	Agent agent to check.
+	 * @param	InStateClass state to check. Its subclasses are not taken in account.
+	 * @param	bCheckStack if true, paused states are taken in account as well, otherwise only the active one is.
+	 * @return	If true, the agent is in the state, false otherwise.
+	 */
+	bool IsInState(FFSM_CrowdAgentHandle Agent, TSubclassOf<UCrowdMachineState> InStateClass,
+		bool bCheckStack = false) const;
+
+	/**
+	 * Get the amount of states on the stack of an agent.
+	 * @param	Agent agent to check.
+	 * @return	Stack depth.
+	 */
+	int32 GetStackDepth(FFSM_CrowdAgentHandle Agent) const;
+
+	/**
+	 * Get the amount of agents having a given state active. Only the agents added to the subsystem are counted;
+	 * entities processed by external backends, such as the Mass one, keep their states on their own.
+	 * @param	InStateClass state to check. Its subclasses are not taken in account.
+	 * @return	Amount of agents.
+	 */
+	int32 GetAgentsNumInState(TSubclassOf<UCrowdMachineState> InStateClass) const;
+
+	/**
+	 * Get the shared instance of a registered state.
+	 * @param	InStateClass state class.
+	 * @return	State. nullptr if the state is not registered.
+	 */
+	UCrowdMachineState* GetState(TSubclassOf<UCrowdMachineState> InStateClass) const;
+
+	/**
+	 * Get the handle of an agent out of its index.
+	 * @param	AgentIndex index of the agent.
+	 * @return	Agent handle.
+	 */
+	FFSM_CrowdAgentHandle GetAgentHandle(int32 AgentIndex) const;
+
+	/**
+	 * Find the index of a state class, registering it if needed. The indices are shared by the backends running in the
+	 * world.
+	 * @param	InStateClass state class.
+	 * @return	State index. INDEX_NONE if the class is invalid.
+	 */
+	int32 FindOrRegisterState(TSubclassOf<UCrowdMachineState> InStateClass);
+
+	/**
+	 * Resolve the indices of a state and its label for a transition, registering the state if needed.
+	 * @param	InStateClass state class.
+	 * @param	Label label of the state.
+	 * @param	OutStateIndex output parameter. State index.
+	 * @param	OutLabelIndex output parameter. Label index.
+	 * @return	If true, both are valid, false otherwise.
+	 */
+	bool ResolveStateLabel(TSubclassOf<UCrowdMachineState> InStateClass, FGameplayTag Label, int32& OutStateIndex,
+		int32& OutLabelIndex);
+
+protected:
+	//~FFSM_CrowdBackendBase Interface
+	virtual bool GetAgentState(int32 AgentIndex, FAgentState& OutAgent) override;
+	virtual void OnActiveStateChanged(int32 AgentIndex, int32 PreviousStateIndex, int32 NewStateIndex) override;
+	//~End of FFSM_CrowdBackendBase Interface
+
+private:
+	/**
+	 * Find the index of a registered state class.
+	 * @param	InStateClass state class.
+	 * @return	State index. INDEX_NONE if the class is not registered.
+	 */
+	int32 FindStateIndex(TSubclassOf<UCrowdMachineState> InStateClass) const;
+
+	/**
+	 * Add a transition request, and perform it right away unless the chunks are being processed.
+	 * @param	Request request to add.
+	 */
+	void RequestTransition(const FTransitionRequest& Request);
+
+	/**
+	 * Perform the requested transitions in order, and dispatch the events they've caused. Unless it's called while
+	 * processing, the agents removed in the meantime are removed afterward.
+	 */
+	void ProcessTransitionRequests();
+
+	/**
+	 * Remove the agents that have been removed while processing.
+	 */
+	void FlushPendingRemovals();
+
+	/**
+	 * Sort the agents having an active state by their state and label into the label buckets.
+	 */
+	void SortAgentsByLabel();
+
+	/**
+	 * Check whether an agent index refers to an existing agent.
+	 * @param	AgentIndex index to check.
+	 * @return	If true, the agent exists, false otherwise.
+	 */
+	bool IsAgentIndexValid(int32 AgentIndex) const;
+
+	/**
+	 * Release the slot of an agent.
+	 * @param	AgentIndex index of the agent.
+	 */
+	void RemoveAgent_Implementation(int32 AgentIndex);
+
+private:
+	/** Shared instances of the registered states. The index of each state is the one the agents store. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UCrowdMachineState>> States;
+
+	/** State class to state index. */
+	TMap<const UClass*, int32> StateIndices;
+
+	/** Index of the first label bucket of each state. */
+	TArray<int32> StateBucketOffsets;
+
+	/** Amount of agents having each state active. */
+	TArray<int32> StateAgentsNums;
+
+	/** Serial number of the agent using each slot. */
+	TArray<uint32> Serials;
+
+	/** Whether each slot is used by an agent. */
+	TArray<bool> AgentsInUse;
+
+	/** Whether the agent of each slot has been removed while processing, and waits to be removed. */
+	TArray<bool> AgentsPendingRemoval;
+
+	/** Index of the active state of each agent. INDEX_NONE if there's none. */
+	TArray<int32> ActiveStates;
+
+	/** Index of the active label of each agent within its active state. */
+	TArray<int32> ActiveLabels;
+
+	/** Time since each agent has entered its active state. */
+	TArray<float> StateTimes;
+
+	/** Time since each agent has entered its active label. */
+	TArray<float> LabelTimes;
+
+	/** Amount of states on the stack of each agent, including the active one. */
+	TArray<uint8> StackDepths;
+
+	/** States on the stack of each agent from the bottom one, MaxStackDepth per agent. */
+	TArray<int32> StackStates;
+
+	/** Labels of the states on the stack of each agent, MaxStackDepth per agent. */
+	TArray<int32> StackLabels;
+
+	/** Slots released by the removed agents. */
+	TArray<int32> FreeAgentIndices;
+
+	/** Agents sorted by their label bucket. Rebuilt each frame. */
+	TArray<int32> SortedAgents;
+
+	/** Index of the first agent of each label bucket in SortedAgents, plus the end. Rebuilt each frame. */
+	TArray<int32> BucketOffsets;
+
+	/** Next free slot of each label bucket while sorting. */
+	TArray<int32> BucketCursors;
+
+	/** Agents removed while processing. */
+	TArray<int32> PendingRemovals;
+
+	/** Amount of existing agents. */
+	int32 AgentsNum = 0;
+
+	/** If true, the chunks are being processed, and the transitions are deferred, false otherwise. */
+	bool bIsProcessing = false;
+};
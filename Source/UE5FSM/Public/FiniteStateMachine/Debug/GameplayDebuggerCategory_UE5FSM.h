@@ -23,12 +23,20 @@ public:
 	FString ExtDebugData = "";
 };
 
+struct FSerializedRegionData
+{
+public:
+	FString Name = "None";
+	TArray<FSerializedStateData> StatesStack;
+};
+
 struct FSerializedFSMData
 {
 public:
 	TSubclassOf<UMachineState> GlobalStateClass = nullptr;
 	TArray<TSubclassOf<UMachineState>> RegisteredStateClasses;
 	TArray<FSerializedStateData> StatesStack;
+	TArray<FSerializedRegionData> Regions;
 	TArray<UFiniteStateMachine::FDebugStateAction> LastTerminatedStates;
 	FString ExtGlobalDebugData = "";
 };
@@ -2,13 +2,21 @@
 
 #pragma once
 
+#include <atomic>
 #include "Components/ActorComponent.h"
+#include "Containers/Queue.h"
 #include "FiniteStateMachine/MachineState.h"
+#include "FiniteStateMachine/StateActionAwaiter.h"
 
 #include "FiniteStateMachine.generated.h"
 
 UE5FSM_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_StateMachine_Label_Default);
 
+class UFiniteStateMachineArchetype;
+class UFiniteStateMachineSubsystem;
+struct FFSM_TransitionScope;
+struct FUObjectCluster;
+
 UENUM()
 enum class EFSM_PendingPushRequestResult : uint8
 {
@@ -16,6 +24,52 @@ enum class EFSM_PendingPushRequestResult : uint8
 	Canceled
 };
 
+/**
+ * Result of a transition request. Anything but Success and Deferred means that the request has been rejected.
+ */
+UENUM(BlueprintType)
+enum class EFSM_TransitionResult : uint8
+{
+	/** The transition has been performed. */
+	Success,
+	/** The active state is dispatching an event. The transition will be performed as soon as it finishes. */
+	Deferred,
+	/** The state machine has not been initialized yet. */
+	NotInitialized,
+	/** The state class is invalid. */
+	InvalidState,
+	/** The label is of wrong tag hierarchy. */
+	InvalidLabel,
+	/** The state is not registered in the state machine. */
+	NotRegistered,
+	/** The state is already present on the states stack. */
+	AlreadyOnStack,
+	/** The active state has disallowed the transition. */
+	Blocked,
+	/** The active state is not safe from being deactivated. */
+	UnsafeDeactivation,
+	/** Another latent request is already running. */
+	LatentBusy,
+	/** There's no active state to end or pop. */
+	NoActiveState,
+	/** The region is not defined in the state machine. */
+	InvalidRegion
+};
+
+/**
+ * Policy deciding which of the queued push requests is executed when the push queue is updated.
+ */
+UENUM()
+enum class EFSM_PushQueuePolicy : uint8
+{
+	/** Requests are executed in order they have been queued. Only the first one is tried, blocking the others. */
+	StrictFIFO,
+	/** Requests are ordered by priority, then by the queueing order. Only the first one is tried, blocking the others. */
+	Priority,
+	/** Requests are ordered by priority, then by the queueing order. The first one that can be executed wins. */
+	FirstExecutable
+};
+
 UE5FSM_API DECLARE_MULTICAST_DELEGATE_OneParam(FOnPendingPushRequestSignature, EFSM_PendingPushRequestResult Result);
 
 /**
@@ -50,6 +104,117 @@ private:
 	TWeakObjectPtr<UFiniteStateMachine> StateMachine = nullptr;
 };
 
+/**
+ * Policy deciding which of the GotoState requests made within the same frame survives when they're coalesced.
+ */
+UENUM()
+enum class EFSM_GotoStateCoalescingPolicy : uint8
+{
+	/** The last request wins. */
+	LastWins,
+	/** The request of the highest priority wins. Among the ones of the same priority, the last one wins. */
+	HighestPriority
+};
+
+/**
+ * Available transitions that can be requested using a transition command.
+ */
+UENUM()
+enum class EFSM_TransitionCommandType : uint8
+{
+	GotoState,
+	EndState,
+	PushState,
+	PopState,
+	GotoLabel
+};
+
+/**
+ * Transition request that can be posted from any thread, and is performed by the state machine on the game thread.
+ */
+struct UE5FSM_API FFSM_TransitionCommand
+{
+public:
+	/** Transition to perform. */
+	EFSM_TransitionCommandType Type = EFSM_TransitionCommandType::GotoState;
+
+	/** State to go to or to push. Unused by EndState, PopState, and GotoLabel. */
+	TSubclassOf<UMachineState> StateClass = nullptr;
+
+	/** Label to start the state at, or to go to. Unused by EndState and PopState. */
+	FGameplayTag Label = TAG_StateMachine_Label_Default;
+
+	/** Commands of higher priority are performed first. */
+	int32 Priority = 0;
+
+	/**
+	 * Caller defined key ordering commands of the same priority in ascending order, e.g. ID of the system posting them.
+	 * Commands of the same priority and key are performed in the order they have been posted in, which depends on the
+	 * thread scheduling. Out of coalesced commands of the same priority, the last performed one wins.
+	 */
+	uint32 SortKey = 0;
+
+	/** GotoState only. In case of switching to the same state we're in: If true, fire end & begin events. */
+	bool bForceEvents = true;
+};
+
+/**
+ * Region of a state machine, i.e. a states stack running concurrently with the main one and the other regions.
+ */
+USTRUCT(BlueprintType)
+struct UE5FSM_API FFSM_RegionDefinition
+{
+	GENERATED_BODY()
+
+public:
+	/** Tag identifying the region. */
+	UPROPERTY(EditDefaultsOnly, Category="Region", meta=(Categories="StateMachine.Region"))
+	FGameplayTag RegionTag;
+
+	/** State the region starts with. If not specified, it won't have any unless GotoStateInRegion() is used. */
+	UPROPERTY(EditDefaultsOnly, Category="Region", meta=(AllowAbstract="False"))
+	TSubclassOf<UMachineState> InitialState = nullptr;
+
+	/** Label the initial state starts with. */
+	UPROPERTY(EditDefaultsOnly, Category="Region", meta=(Categories="StateMachine.Label"))
+	FGameplayTag InitialStateLabel = TAG_StateMachine_Label_Default;
+};
+
+/**
+ * Read-only copy of the state machine state that any thread can read without touching UObjects.
+ */
+struct UE5FSM_API FFSM_StateSnapshot
+{
+public:
+	/** Maximum amount of stack entries the snapshot holds. */
+	static constexpr int32 MaxStackDepth = 16;
+
+public:
+	/** Incremented each time a snapshot is published. 0 if nothing has been published yet. */
+	uint32 Version = 0;
+
+	/** Index of the active state in UFiniteStateMachine::GetRegisteredStateClasses(). INDEX_NONE if there's none. */
+	int32 ActiveStateIndex = INDEX_NONE;
+
+	/** Class of the active state. Meant to be compared against only. */
+	const UClass* ActiveStateClass = nullptr;
+
+	/** Label the active state is at. */
+	FGameplayTag ActiveLabel;
+
+	/** Amount of states on the stack. It might exceed MaxStackDepth. */
+	int32 StackDepth = 0;
+
+	/** Classes of the states on the stack from the bottom one. Meant to be compared against only. */
+	const UClass* Stack[MaxStackDepth] = { };
+
+	/** Last action a state has performed. */
+	EStateAction LastStateAction = EStateAction::None;
+
+	/** World time in seconds the last action has been performed at. */
+	double LastStateActionTime = 0.0;
+};
+
 /**
  * Component to manage Machine States defining behavior of a stateful object in an easy way.
  *
@@ -73,6 +238,21 @@ private:
  *   can be set during initialization only, while normal states can be switched at any time after initialization.
  * - To switch behaviors use GotoState(), PushState(), PopState(), PauseState(), ResumeState(), and GotoLabel().
  * - To access data state use GetStateData().
+ *
+ * # Regions:
+ * - Besides the main stack, the state machine can have regions, each with its own states stack running concurrently,
+ * e.g. locomotion, combat and dialogue layers. They share the registered states, the tick, the state index and the
+ * debug history of the state machine.
+ * - A state can be on a single stack at a time. States on the stack of a region transit within it when they use
+ * GotoState(), PushState(), PopState(), EndState() or ClearStack().
+ * - To manipulate a region from outside use GotoStateInRegion(), PushStateInRegion(), PopStateInRegion(),
+ * EndStateInRegion() and ClearStackInRegion().
+ *
+ * # Time slicing:
+ * - When bTimeSliceStateTicks is set, the state machine ticks only its urgent states (see UMachineState::IsUrgent()).
+ * The other ones are ticked by UFiniteStateMachineSubsystem, which round-robins them across frames within a time
+ * budget, passing them the time elapsed since their previous tick. Their labels start on their first tick as usual.
+ * - Transition commands, coalesced GotoState requests and push requests are still processed every frame.
  */
 UCLASS(Config="Engine", DefaultConfig, ClassGroup=("Finite State Machine"), meta=(BlueprintSpawnableComponent))
 class UE5FSM_API UFiniteStateMachine
@@ -80,6 +260,16 @@ class UE5FSM_API UFiniteStateMachine
 {
 	GENERATED_BODY()
 
+public:
+	/** Publishes the state snapshot whenever the active label changes. */
+	friend UMachineState;
+
+	/** Defers the push queue update until the outermost transition completes. */
+	friend FFSM_TransitionScope;
+
+	/** Keeps track of the index of the state machine in its registry. */
+	friend UFiniteStateMachineSubsystem;
+
 public:
 	enum class EPushRequestResult : uint8
 	{
@@ -110,6 +300,9 @@ private:
 		uint32 ID = 0;
 		TSubclassOf<UMachineState> StateClass = nullptr;
 		FGameplayTag Label = FGameplayTag::EmptyTag;
+		int32 Priority = 0;
+		/** World time in seconds the request is canceled at. Negative if it never expires. */
+		double ExpirationTime = -1.0;
 	};
 
 public:
@@ -146,6 +339,20 @@ public:
 	 */
 	void Reset(bool bDeactivate);
 
+	/**
+	 * Bring the state machine back to its initial configuration without destroying any state or state data, making it
+	 * reusable at no allocation cost, for instance, when the owner is returned to a pool.
+	 *
+	 * Every state on the stacks is ended from the top-most one without resuming the paused ones, the global state is
+	 * ended last, pending push requests are canceled, running labels and latent executions are stopped, debug history
+	 * is cleared, every state returns to its initial label and resets its data.
+	 *
+	 * @param	bBeginInitialStates if true, global and initial states will begin right away if the state machine is
+	 * active, otherwise they will begin on the next activation.
+	 * @return	If true, the state machine has been reset, false otherwise.
+	 */
+	bool SoftReset(bool bBeginInitialStates = true);
+
 	/**
 	 * Register a given state.
 	 * @param	InStateClass state to register.
@@ -167,6 +374,13 @@ public:
 	 */
 	void SetGlobalState(TSubclassOf<UMachineState> InStateClass);
 
+	/**
+	 * Set archetype the state machine is configured with.
+	 * @param	InArchetype archetype to use. If nullptr, the configuration of the component is used.
+	 * @note	Only callable before the initialization terminates.
+	 */
+	void SetStateMachineArchetype(UFiniteStateMachineArchetype* InArchetype);
+
 	/**
      * Activate a state at a specified label. If there's any active state, it'll deactivated.
 	 * @param	InStateClass state to go to.
@@ -180,6 +394,53 @@ public:
 	bool GotoState(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label = TAG_StateMachine_Label_Default,
 		bool bForceEvents = true);
 
+	/**
+	 * Activate a state at a specified label. If there's any active state, it'll deactivated.
+	 * @param	InStateClass state to go to.
+	 * @param	Label label to start the state at.
+	 * @param	bForceEvents in case of switching to the same state we're in: If true, fire end & begin events,
+	 * otherwise do not.
+	 * @return	Result of the request. Use it to back off based on the reason of a rejection.
+	 * @see		GotoState()
+	 */
+	EFSM_TransitionResult TryGotoState(TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default, bool bForceEvents = true);
+
+	/**
+	 * Request to activate a state at a specified label at the beginning of the next tick. Out of all the requests made
+	 * until then only one survives following GotoStateCoalescingPolicy, and only it pays the transition cost.
+	 * @param	InStateClass state to go to.
+	 * @param	Label label to start the state at.
+	 * @param	Priority priority of the request used by the HighestPriority policy.
+	 * @param	bForceEvents in case of switching to the same state we're in: If true, fire end & begin events,
+	 * otherwise do not.
+	 * @return	Deferred if the request has been recorded, otherwise the reason of the rejection. The transition itself
+	 * might still fail when resolved.
+	 */
+	EFSM_TransitionResult RequestGotoState(TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default, int32 Priority = 0, bool bForceEvents = true);
+
+	/**
+	 * Perform the surviving GotoState request right away, if any. Game thread only.
+	 * @return	Result of the performed transition. Success if there was nothing to perform.
+	 */
+	EFSM_TransitionResult ResolveDeferredGotoState();
+
+	/**
+	 * Check whether a GotoState request is waiting to be resolved.
+	 * @return	If true, there's a deferred GotoState request, false otherwise.
+	 */
+	bool HasDeferredGotoState() const;
+
+	/**
+	 * Check whether GotoState would succeed without performing it or logging anything.
+	 * @param	InStateClass state to go to.
+	 * @param	Label label to start the state at.
+	 * @return	Result GotoState would return. Success stands for both Success and Deferred.
+	 */
+	EFSM_TransitionResult CanGotoState(TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default) const;
+
 	/**
 	 * End the active state. If there's any state below this in the stack, it'll resume its execution.
 	 * @return	If true, a state has ended, false otherwise.
@@ -188,6 +449,19 @@ public:
 	 */
 	bool EndState();
 
+	/**
+	 * End the active state. If there's any state below this in the stack, it'll resume its execution.
+	 * @return	Result of the request. Use it to back off based on the reason of a rejection.
+	 * @see		EndState()
+	 */
+	EFSM_TransitionResult TryEndState();
+
+	/**
+	 * Check whether EndState would succeed without performing it or logging anything.
+	 * @return	Result EndState would return. Success stands for both Success and Deferred.
+	 */
+	EFSM_TransitionResult CanEndState() const;
+
 	/**
 	 * Go to a label using the active state.
 	 * @param	Label label to go to.
@@ -207,6 +481,27 @@ public:
 	UE5Coro::TCoroutine<> PushState(TSubclassOf<UMachineState> InStateClass,
 		FGameplayTag Label = TAG_StateMachine_Label_Default, bool* bOutPrematureResult = nullptr);
 
+	/**
+	 * Push a state at a specified label on top of the stack. If there's any active state, it'll be paused upon
+	 * successful push.
+	 * @param	OutResult output parameter. Result of the request. It's written before the function returns code
+	 * execution.
+	 * @param	InStateClass state to push.
+	 * @param	Label label to start the state at.
+	 * @see		PushState()
+	 */
+	UE5Coro::TCoroutine<> TryPushState(EFSM_TransitionResult& OutResult, TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default);
+
+	/**
+	 * Check whether PushState would succeed without performing it or logging anything.
+	 * @param	InStateClass state to push.
+	 * @param	Label label to start the state at.
+	 * @return	Result PushState would return. Success stands for both Success and Deferred.
+	 */
+	EFSM_TransitionResult CanPushState(TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default) const;
+
 	/**
 	 * Push a state at a specified label on top of the stack. If the operation is not possible to execute for
 	 * any reason that might change in the future, it'll queued, and apply it as soon as it becomes possible following
@@ -214,9 +509,12 @@ public:
 	 * @param	OutHandle output parameter. Push request handle used to interact with the request.
 	 * @param	InStateClass state to push.
 	 * @param	Label label to start the state at.
+	 * @param	Priority priority of the request in the queue. Ignored by the StrictFIFO policy.
+	 * @param	Timeout time in seconds after which the queued request is canceled. Zero or less to never cancel it.
+	 * @see		PushQueuePolicy
 	 */
 	UE5Coro::TCoroutine<> PushStateQueued(FFSM_PushRequestHandle& OutHandle, TSubclassOf<UMachineState> InStateClass,
-		FGameplayTag Label = TAG_StateMachine_Label_Default);
+		FGameplayTag Label = TAG_StateMachine_Label_Default, int32 Priority = 0, float Timeout = 0.f);
 
 	/**
 	 * Pop the top-most state from stack. If there's any state below this in the stack, it'll resume its execution.
@@ -226,12 +524,140 @@ public:
 	 */
 	bool PopState();
 
+	/**
+	 * Pop the top-most state from stack. If there's any state below this in the stack, it'll resume its execution.
+	 * @return	Result of the request. Use it to back off based on the reason of a rejection.
+	 * @see		PopState()
+	 */
+	EFSM_TransitionResult TryPopState();
+
+	/**
+	 * Check whether PopState would succeed without performing it or logging anything.
+	 * @return	Result PopState would return. Success stands for both Success and Deferred.
+	 */
+	EFSM_TransitionResult CanPopState() const;
+
+	/**
+	 * Post a transition command to perform at the beginning of the next tick, or on activation if the state machine is
+	 * inactive. It's safe to call from any thread, as long as the state machine is guaranteed to be alive.
+	 *
+	 * Commands posted between two ticks are performed in a single batch sorted by their priority and sort key.
+	 * Redundant commands are coalesced: out of consecutive GotoState or GotoLabel commands only the last one of the
+	 * highest priority, i.e. the one of the highest sort key among them, is performed, and consecutive identical
+	 * PushState commands are performed once.
+	 * @param	Command command to perform.
+	 */
+	void EnqueueTransitionCommand(const FFSM_TransitionCommand& Command);
+
+	/**
+	 * Perform all the posted transition commands right away. Game thread only.
+	 * @return	Amount of performed commands, excluding the coalesced ones.
+	 */
+	int32 ProcessTransitionCommands();
+
+	/**
+	 * Get the latest state snapshot. It's safe to call from any thread, and it never blocks the game thread. The
+	 * snapshot is published whenever a state performs an action or the active label changes.
+	 * @return	Consistent copy of the latest state snapshot.
+	 */
+	FFSM_StateSnapshot GetStateSnapshot() const;
+
+	/**
+	 * Check whether a transition request has been accepted, i.e. it has been either performed or deferred.
+	 * @param	Result result of the request.
+	 * @return	If true, the request has been accepted, false otherwise.
+	 */
+	static bool IsTransitionAccepted(EFSM_TransitionResult Result);
+
 	/**
 	 * Clear all states from the stack leaving it empty.
 	 * @return	Amount of ended states.
 	 */
 	int32 ClearStack();
 
+	/**
+	 * Add a region to the state machine. If the state machine has already activated its states, the region starts
+	 * right away.
+	 * @param	Definition region to add.
+	 * @return	If true, the region has been added, false otherwise.
+	 */
+	bool AddRegion(const FFSM_RegionDefinition& Definition);
+
+	/**
+	 * Activate a state at a specified label in a region. If there's any active state in the region, it'll be
+	 * deactivated. The main stack and the other regions are not affected.
+	 * @param	Region region to transit in.
+	 * @param	InStateClass state to go to.
+	 * @param	Label label to start the state with.
+	 * @param	bForceEvents in case of switching to the same state we're in: If true, fire end & begin events,
+	 * otherwise do not.
+	 * @return	If true, the transition has been either performed or deferred, false otherwise.
+	 */
+	bool GotoStateInRegion(FGameplayTag Region, TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default, bool bForceEvents = true);
+
+	/**
+	 * Push a state at a specified label on top of the stack of a region. If there's any active state in the region,
+	 * it'll be paused.
+	 * @param	Region region to transit in.
+	 * @param	InStateClass state to push.
+	 * @param	Label label to start the state with.
+	 * @return	If true, the transition has been either performed or deferred, false otherwise.
+	 */
+	bool PushStateInRegion(FGameplayTag Region, TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default);
+
+	/**
+	 * Pop the top-most state from the stack of a region. If there's any state below it, it'll resume its execution.
+	 * @param	Region region to transit in.
+	 * @return	If true, the transition has been either performed or deferred, false otherwise.
+	 */
+	bool PopStateInRegion(FGameplayTag Region);
+
+	/**
+	 * End the active state of a region. If there's any state below it, it'll resume its execution.
+	 * @param	Region region to transit in.
+	 * @return	If true, the transition has been either performed or deferred, false otherwise.
+	 */
+	bool EndStateInRegion(FGameplayTag Region);
+
+	/**
+	 * Clear all states from the stack of a region leaving it empty.
+	 * @param	Region region to clear.
+	 * @return	Amount of ended states.
+	 */
+	int32 ClearStackInRegion(FGameplayTag Region);
+
+	/**
+	 * Get the active state of a region.
+	 * @param	Region region to get the active state of.
+	 * @return	Active state. Nullptr if there's none, or the region doesn't exist.
+	 */
+	UMachineState* GetActiveStateInRegion(FGameplayTag Region) const;
+
+	/**
+	 * Check whether a given state is active in a region.
+	 * @param	Region region to check.
+	 * @param	InStateClass state to check against.
+	 * @param	bCheckStack if true, whole stack of the region will be used, otherwise only its active state.
+	 * @return	If true, the state is active, or present when checking the stack, false otherwise.
+	 */
+	bool IsInStateInRegion(FGameplayTag Region, TSubclassOf<UMachineState> InStateClass,
+		bool bCheckStack = false) const;
+
+	/**
+	 * Get the tags of all the regions of the state machine.
+	 * @param	OutRegions output parameter. Region tags.
+	 */
+	void GetRegions(TArray<FGameplayTag>& OutRegions) const;
+
+	/**
+	 * Get the states stack of a region.
+	 * @param	Region region to get the stack of.
+	 * @return	States from the bottom one. Empty if the region doesn't exist.
+	 */
+	TArray<UMachineState*> GetStatesStackInRegion(FGameplayTag Region) const;
+
 	/**
 	 * Stop any latent execution of EVERY state known to this state machine. Doesn't interrupt label execution.
 	 * @return	Amount of latent executions stopped.
@@ -248,6 +674,12 @@ public:
 	 */
 	int32 StopEveryRunningLabel();
 
+	/**
+	 * Cancel all the pending push requests.
+	 * @return	Amount of canceled push requests.
+	 */
+	int32 CancelEveryPushRequest();
+
 	/**
 	 * Remove the specified request from the pending push list.
 	 * @param	Handle request to cancel.
@@ -262,6 +694,12 @@ public:
 	 */
 	bool IsPushRequestPending(FFSM_PushRequestHandle Handle) const;
 
+	/**
+	 * Get the amount of pending push requests.
+	 * @return	Amount of pending push requests.
+	 */
+	int32 GetPendingPushRequestsNum() const;
+
 	/**
 	 * Get multicast delegate that is fired when the specified push request handle is finished. If the handle is not
 	 * associated with an active pending request, the returned delegate will never fire.
@@ -270,6 +708,17 @@ public:
 	 */
 	FOnPendingPushRequestSignature& GetOnPendingPushRequestResultDelegate(FFSM_PushRequestHandle Handle);
 
+	/**
+	 * Wait until a registered state performs any of the given actions. The awaiter can be combined with the ones of
+	 * other state machines through FFSM_StateActionAwaiter::WhenAny() and FFSM_StateActionAwaiter::WhenAll().
+	 * @param	InStateClass state to wait the actions of.
+	 * @param	Actions actions to wait for.
+	 * @return	Awaiter resuming only once one of the actions takes place. Resumes right away if the state is not
+	 * registered.
+	 */
+	FFSM_StateActionAwaiter WaitForStateAction(TSubclassOf<UMachineState> InStateClass,
+		EFSM_StateActionMask Actions) const;
+
 	/**
 	 * Check whether a given state is active.
 	 * @param	InStateClass state to check against.
@@ -381,6 +830,64 @@ public:
 	 */
 	TSubclassOf<UMachineState> GetGlobalStateClass() const;
 
+	/**
+	 * Get archetype the state machine is configured with.
+	 * @return	State machine archetype. May be nullptr.
+	 */
+	UFiniteStateMachineArchetype* GetStateMachineArchetype() const;
+
+	/**
+	 * Set policy deciding which of the GotoState requests made within the same frame survives when they're coalesced.
+	 * The request that has already been recorded is kept, and has to win over the next ones following the new policy.
+	 * @param	InPolicy policy to use.
+	 */
+	void SetGotoStateCoalescingPolicy(EFSM_GotoStateCoalescingPolicy InPolicy);
+
+	/**
+	 * Get policy deciding which of the GotoState requests made within the same frame survives when they're coalesced.
+	 * @return	GotoState coalescing policy.
+	 */
+	EFSM_GotoStateCoalescingPolicy GetGotoStateCoalescingPolicy() const;
+
+	/**
+	 * Set policy deciding which of the queued push requests is executed when the push queue is updated. The requests
+	 * that are already queued are reordered to follow the new policy.
+	 * @param	InPolicy policy to use.
+	 */
+	void SetPushQueuePolicy(EFSM_PushQueuePolicy InPolicy);
+
+	/**
+	 * Get policy deciding which of the queued push requests is executed when the push queue is updated.
+	 * @return	Push queue policy.
+	 */
+	EFSM_PushQueuePolicy GetPushQueuePolicy() const;
+
+	/**
+	 * Set whether the states that are not urgent are ticked by the subsystem within its time budget instead of every
+	 * frame.
+	 * @param	bInTimeSlice if true, the ticks of the states are time-sliced, false otherwise.
+	 */
+	void SetTimeSliceStateTicks(bool bInTimeSlice);
+
+	/**
+	 * Check whether the states that are not urgent are ticked by the subsystem within its time budget.
+	 * @return	If true, the ticks of the states are time-sliced, false otherwise.
+	 */
+	bool IsTimeSlicingStateTicks() const;
+
+	/**
+	 * Set whether the states registered from now on are added to the GC cluster of the owning actor when it's in one.
+	 * @param	bInAddStatesToOwnerCluster if true, states are added to the owner cluster, false otherwise.
+	 * @see		UFiniteStateMachine::bAddStatesToOwnerCluster
+	 */
+	void SetAddStatesToOwnerCluster(bool bInAddStatesToOwnerCluster);
+
+	/**
+	 * Check whether the registered states are added to the GC cluster of the owning actor when it's in one.
+	 * @return	If true, states are added to the owner cluster, false otherwise.
+	 */
+	bool IsAddingStatesToOwnerCluster() const;
+
 	/**
 	 * Get physical actor of the state machine.
 	 * @return	Physical actor. If failed to find the avatar, owner will be returned instead.
@@ -425,12 +932,71 @@ protected:
 	 */
 	virtual void OnStateAction(UMachineState* State, EStateAction StateAction);
 
+	/**
+	 * Notify the world-wide observers about an action of our state.
+	 * @param	State state that performed an action.
+	 * @param	StateAction the performed action.
+	 * @param	OtherState other state taking part in the transition.
+	 */
+	void NotifyStateActionObservers(UMachineState* State, EStateAction StateAction,
+		TSubclassOf<UMachineState> OtherState);
+
 private:
 	/**
 	 * Activate initial states.
 	 */
 	void BeginActiveStates();
 
+	/**
+	 * Activate a state at a specified label right away regardless of the coalescing.
+	 * @see		TryGotoState()
+	 */
+	EFSM_TransitionResult GotoState_Immediate(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label,
+		bool bForceEvents);
+
+	/**
+	 * Check whether GotoState can be performed, given that the state class is valid.
+	 * @param	InStateClass valid state to activate.
+	 * @param	Label label to start the state at.
+	 * @param	ArchetypeToIndex archetype index of the state to activate. INDEX_NONE if unknown.
+	 * @return	Result of the checks.
+	 * @see		CanGotoState(), UFiniteStateMachineSubsystem::GotoStateBulk()
+	 */
+	EFSM_TransitionResult CanGotoState_Implementation(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label,
+		int32 ArchetypeToIndex) const;
+
+	/**
+	 * Activate a state at a specified label that has passed the bulk checks.
+	 * @see		UFiniteStateMachineSubsystem::GotoStateBulk()
+	 */
+	EFSM_TransitionResult GotoState_Bulk(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label,
+		bool bForceEvents);
+
+	/**
+	 * Activate a state at a specified label that has passed the checks. The transition is deferred if the active state
+	 * is dispatching an event. While the global state is beginning, the initial state is replaced instead.
+	 * @return	Success if the transition has been performed, Deferred otherwise.
+	 */
+	EFSM_TransitionResult GotoState_Dispatch(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label,
+		bool bForceEvents);
+
+	/**
+	 * Publish the current state for the other threads. Game thread only. During a transition, the publication is
+	 * postponed until the transition completes, so that the readers never see a half-performed one.
+	 * @param	StateAction action that has triggered the publication. None if it's not caused by a state action.
+	 */
+	void PublishStateSnapshot(EStateAction StateAction = EStateAction::None);
+
+	/**
+	 * Publish the snapshot postponed during the transition that has just completed, if any.
+	 */
+	void PublishPendingStateSnapshot();
+
+	/**
+	 * Take the configuration from the archetype and register its states.
+	 */
+	void InitializeFromArchetype();
+
 	/**
 	 * Register a given state. Doesn't perform any check.
 	 * @param	InStateClass state to register.
@@ -438,6 +1004,62 @@ private:
 	 */
 	UMachineState* RegisterState_Implementation(TSubclassOf<UMachineState> InStateClass);
 
+	/**
+	 * Create the sub-states a given state owns, and the ones they own in turn.
+	 * @param	ParentState state to create the sub-states of.
+	 */
+	void RegisterSubStates(UMachineState* ParentState);
+
+	/** Active states to tick. */
+	enum class EStateTickFilter : uint8
+	{
+		All,
+		/** Only the states that are urgent. */
+		Urgent,
+		/** Only the states that are not urgent. */
+		TimeSliced
+	};
+
+	/**
+	 * Tick the active states, the active states of the regions, and their sub-states.
+	 * @param	DeltaTime time since last tick.
+	 * @param	Filter states to tick.
+	 */
+	void TickActiveStates(float DeltaTime, EStateTickFilter Filter);
+
+	/**
+	 * Tick a state and the chain of its active sub-states.
+	 * @param	State state to tick.
+	 * @param	DeltaTime time since last tick.
+	 * @param	Filter states to tick.
+	 */
+	void TickStateChain(UMachineState* State, float DeltaTime, EStateTickFilter Filter);
+
+	/**
+	 * Tick the states that are not urgent with the time accumulated since their previous tick. Called by the subsystem
+	 * when the ticks of the states are time-sliced.
+	 * @return	If true, the states have been ticked, false if they haven't been due for a tick.
+	 */
+	bool TickTimeSlicedStates();
+
+	/**
+	 * Add a given state and its data to the GC cluster the owner is in, if any.
+	 * @param	State state to add to the cluster.
+	 */
+	void AddStateToOwnerCluster(UMachineState* State);
+
+	/**
+	 * Remove the registered states and their data from the GC cluster the owner is in. The cluster keeps its mutable
+	 * objects by their indices, hence they have to be removed before the states get destroyed.
+	 */
+	void RemoveStatesFromOwnerCluster();
+
+	/**
+	 * Find the GC cluster the owner is in.
+	 * @return	Cluster. nullptr if the owner is not in any.
+	 */
+	FUObjectCluster* FindOwnerCluster() const;
+
 	/**
 	 * Find a given state.
 	 * @param	InStateClass state to search for.
@@ -493,7 +1115,8 @@ private:
 	UE5Coro::TCoroutine<> WaitUntilStateAction(TSubclassOf<UMachineState> InStateClass, EStateAction StateAction) const;
 
 	/**
-	 * Wait until the active state dispatches an event that it is *currently* dispatching.
+	 * Wait until the active state, or one of its active sub-states, dispatches an event that it is *currently*
+	 * dispatching.
 	 */
 	UE5Coro::TCoroutine<> WaitUntilActiveStateEventDispatch();
 
@@ -502,20 +1125,40 @@ private:
 	 * @param	OutHandle output parameter. Push request handle used to interact with the request.
 	 * @param	InStateClass state to push.
 	 * @param	Label label to start the state at.
+	 * @param	Priority priority of the request in the queue.
+	 * @param	Timeout time in seconds after which the request is canceled. Zero or less to never cancel it.
 	 */
 	UE5Coro::TCoroutine<> AddAndWaitPendingPushRequest(FFSM_PushRequestHandle& OutHandle,
-		TSubclassOf<UMachineState> InStateClass, FGameplayTag Label);
+		TSubclassOf<UMachineState> InStateClass, FGameplayTag Label, int32 Priority, float Timeout);
 
 	/**
-	 * Try to push the first element in the queue.
+	 * Try to push the queued requests following the push queue policy.
 	 */
 	void UpdatePushQueue();
 
+	/**
+	 * Execute every queued push request that can be executed. Pushes performed in the meantime don't update the queue
+	 * on their own, but make it be updated once more.
+	 */
+	void DrainPushQueue();
+
+	/**
+	 * Cancel the pending push requests whose timeout has expired.
+	 */
+	void CancelExpiredPushRequests();
+
+	/**
+	 * Remove a pending push request, and notify about its cancellation.
+	 * @param	Index index of the request in the pending push requests.
+	 */
+	void CancelPushRequestAt(int32 Index);
+
 	/**
 	 * Try to execute a pending push request.
 	 * @param	Request request to try to execute.
+	 * @return	If true, the request has been executed, false otherwise.
 	 */
-	void PushState_Pending(FPendingPushRequest Request);
+	bool PushState_Pending(FPendingPushRequest Request);
 
 	/**
 	 * Remove all latent execution cancel delegates that are no longer bound because the latent execution the delegate
@@ -537,6 +1180,102 @@ private:
 	 */
 	bool IsActiveStateDispatchingEvent() const;
 
+	/**
+	 * Find the state dispatching an event among the active state, the global state, and their active sub-states.
+	 * @return	Dispatching state. Nullptr if none of them is dispatching an event.
+	 */
+	UMachineState* GetActiveDispatchingState() const;
+
+	/**
+	 * Find the state dispatching an event among a given state and its active sub-states.
+	 * @param	State state to start the search from.
+	 * @return	Dispatching state. Nullptr if none of them is dispatching an event.
+	 */
+	static UMachineState* FindDispatchingState(UMachineState* State);
+
+	/**
+	 * Find the index of a region.
+	 * @param	Region region to search for.
+	 * @return	Region index. INDEX_NONE if there's no such region.
+	 */
+	int32 FindRegionIndex(FGameplayTag Region) const;
+
+	/**
+	 * Check whether a given state is on the stack of any region.
+	 * @param	InStateClass state to check.
+	 * @return	If true, the state is in a region, false otherwise.
+	 */
+	bool IsStateInRegion(TSubclassOf<UMachineState> InStateClass) const;
+
+	/**
+	 * Start the regions with their initial states.
+	 */
+	void BeginRegions();
+
+	/**
+	 * End all the states of all the regions.
+	 */
+	void ClearRegions();
+
+	/**
+	 * End every state of the regions and of the stack from the top-most one without resuming the ones below it, as
+	 * they're about to be ended as well.
+	 * @return	Amount of ended states.
+	 */
+	int32 EndEveryState();
+
+	/**
+	 * Check whether a state can be added to the stack of a region.
+	 * @param	RegionIndex region to add the state to.
+	 * @param	InStateClass state to add.
+	 * @param	Label label to start the state with.
+	 * @param	bReplaceActive if true, the state replaces the active one of the region, otherwise it's pushed on top.
+	 * @return	Result the transition would have.
+	 */
+	EFSM_TransitionResult CanEnterRegion(int32 RegionIndex, TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label, bool bReplaceActive) const;
+
+	/**
+	 * Check whether the active state of a region can be removed from its stack.
+	 * @param	RegionIndex region to check.
+	 * @return	Result the transition would have.
+	 */
+	EFSM_TransitionResult CanLeaveRegion(int32 RegionIndex) const;
+
+	/**
+	 * Perform a transition in a region right away, or once the state dispatching an event in it finishes.
+	 * @param	RegionIndex region to transit in.
+	 * @param	Validate check to run again before a deferred transition, as the stacks might have changed meanwhile.
+	 * @param	Transition transition to perform.
+	 */
+	void RunRegionTransition(int32 RegionIndex, TUniqueFunction<EFSM_TransitionResult()>&& Validate,
+		TUniqueFunction<void()>&& Transition);
+	UE5Coro::TCoroutine<> RegionTransition_LatentImplementation(int32 RegionIndex, UMachineState* DispatchingState,
+		TUniqueFunction<EFSM_TransitionResult()> Validate, TUniqueFunction<void()> Transition);
+
+	void GotoStateInRegion_Implementation(int32 RegionIndex, TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label, bool bForceEvents);
+	void PushStateInRegion_Implementation(int32 RegionIndex, TSubclassOf<UMachineState> InStateClass,
+		FGameplayTag Label);
+
+	/**
+	 * Remove the active state from the stack of a region, and resume the one below it, if any.
+	 * @param	RegionIndex region to transit in.
+	 * @param	StateAction either End or Pop.
+	 */
+	void RemoveStateInRegion_Implementation(int32 RegionIndex, EStateAction StateAction);
+
+	/**
+	 * Log a rejected transition request, unless it's disabled or another one has been logged recently by any state
+	 * machine.
+	 * @param	Transition name of the requested transition.
+	 * @param	Result reason of the rejection.
+	 * @param	InStateClass state the transition was requested for.
+	 * @param	Label label the transition was requested for.
+	 */
+	void LogTransitionFailure(const TCHAR* Transition, EFSM_TransitionResult Result,
+		TSubclassOf<UMachineState> InStateClass = nullptr, FGameplayTag Label = FGameplayTag::EmptyTag);
+
 	FString GetGlobalStateInInitialRegisteredStatesErrorMessage(TSubclassOf<UMachineState> StateClass) const;
 	FString GetActiveStateNotRegisteredErrorMessage() const;
 
@@ -554,6 +1293,10 @@ protected:
 	UPROPERTY(Transient, VisibleInstanceOnly, Category="State Machine|Debug")
 	TArray<TObjectPtr<UMachineState>> RegisteredStates;
 
+	/** Sub-states of all the registered states, nested ones included. They're not reachable through FindState(). */
+	UPROPERTY(Transient, VisibleInstanceOnly, Category="State Machine|Debug")
+	TArray<TObjectPtr<UMachineState>> RegisteredSubStates;
+
 	/** Active global state. */
 	UPROPERTY(Transient, VisibleInstanceOnly, Category="State Machine|Debug")
 	TObjectPtr<UMachineState> ActiveGlobalState = nullptr;
@@ -584,21 +1327,139 @@ private:
 	UPROPERTY(EditDefaultsOnly, Category="State Machine", meta=(Categories="StateMachine.Label"))
 	FGameplayTag InitialStateLabel = TAG_StateMachine_Label_Default;
 
+	/**
+	 * Precompiled configuration shared by all the state machines using it. If specified, its states to register, global
+	 * state, initial state and its label are used instead of the ones specified in this component.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine")
+	TObjectPtr<UFiniteStateMachineArchetype> StateMachineArchetype = nullptr;
+
+	/** Policy deciding which of the queued push requests is executed when the push queue is updated. */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine")
+	EFSM_PushQueuePolicy PushQueuePolicy = EFSM_PushQueuePolicy::StrictFIFO;
+
+	/** Regions running concurrently with the main stack. Their initial states have to be registered. */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine|Regions")
+	TArray<FFSM_RegionDefinition> RegionDefinitions;
+
+	/**
+	 * If true, GotoState requests are recorded and resolved once per frame at the beginning of the tick, letting only
+	 * one of them survive, false otherwise.
+	 * @note	When enabled, GOTO_STATE doesn't change the state right away, but still interrupts the label it's used in
+	 * once the request is accepted. The current state stays idle until the request is resolved.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine|Coalescing")
+	bool bCoalesceGotoState = false;
+
+	/** Policy deciding which of the coalesced GotoState requests survives. */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine|Coalescing", meta=(EditCondition="bCoalesceGotoState"))
+	EFSM_GotoStateCoalescingPolicy GotoStateCoalescingPolicy = EFSM_GotoStateCoalescingPolicy::LastWins;
+
+	/**
+	 * If true, only the urgent states are ticked every frame, while the other ones are ticked by the subsystem within
+	 * its time budget, false otherwise.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine|Time Slicing")
+	bool bTimeSliceStateTicks = false;
+
+	/**
+	 * States registered out of the archetype indexed by their archetype index. Empty if the lookups can't rely on the
+	 * archetype, i.e. some states have been registered before the archetype ones.
+	 */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UMachineState>> ArchetypeStates;
+
 	/** If true, initial states have been activated, false otherwise. */
 	bool bActiveStatesBegan = false;
 
+	/**
+	 * If true, the global state is beginning ahead of the initial state, false otherwise. GotoState replaces the initial
+	 * state meanwhile, as there's no active state to end yet.
+	 */
+	bool bIsBeginningGlobalState = false;
+
 	/** Time in seconds it takes to start clearing state execution cancellers. */
 	UPROPERTY(Config)
 	float StateExecutionCancellersClearingInterval = 60.f;
 
+	/**
+	 * If true, registered states and their data are added to the GC cluster of the owning actor when it's in one, making
+	 * the garbage collector treat them as a part of the owner instead of tracking each one of them separately.
+	 * @note	Only actors that have been clustered on load (i.e. placed in a level) have a cluster. The engine never
+	 * clusters spawned actors, pooled ones included, so this does nothing for them unless the owner creates a cluster
+	 * on its own, e.g. by calling CreateCluster() on itself before any state is registered.
+	 */
+	UPROPERTY(Config)
+	bool bAddStatesToOwnerCluster = true;
+
+	/** If true, any state has been added to the GC cluster of the owner, false otherwise. */
+	bool bStatesAddedToOwnerCluster = false;
+
+	/** If true, rejected transition requests are logged, false otherwise. */
+	UPROPERTY(Config)
+	bool bLogTransitionFailures = true;
+
+	/**
+	 * Minimum time in seconds between two logged transition failures of any state machine. The ones in between are
+	 * only counted.
+	 */
+	UPROPERTY(Config)
+	float TransitionFailuresLogInterval = 1.f;
+
+	/** GotoState request waiting to be resolved. Only used when GotoState requests are coalesced. */
+	struct FDeferredGotoState
+	{
+	public:
+		TSubclassOf<UMachineState> StateClass = nullptr;
+		FGameplayTag Label = FGameplayTag::EmptyTag;
+		int32 Priority = 0;
+		bool bForceEvents = true;
+	};
+
+	/** The surviving GotoState request. Its state class is nullptr if there's none. */
+	FDeferredGotoState DeferredGotoState;
+
+	/** Amount of requests the deferred GotoState has replaced since the last resolution. */
+	int32 CoalescedGotoStatesNum = 0;
+
+	/** Transition commands posted from any thread waiting to be performed on the game thread. */
+	TQueue<FFSM_TransitionCommand, EQueueMode::Mpsc> TransitionCommands;
+
+	/** Scratch buffer the transition commands are sorted in. It's kept around to avoid allocating on each batch. */
+	TArray<FFSM_TransitionCommand> TransitionCommandsBatch;
+
+	/** Amount of words the state snapshot is stored in. */
+	static constexpr int32 StateSnapshotWordsNum = (sizeof(FFSM_StateSnapshot) + sizeof(uint64) - 1) / sizeof(uint64);
+
+	/** Latest snapshot. Game thread only; the other threads read the published words. */
+	FFSM_StateSnapshot StateSnapshot;
+
+	/**
+	 * Snapshot published for the other threads. It's guarded by SnapshotSequence in a seqlock fashion, and stored in
+	 * atomic words, so that a reader copying it while it's being written doesn't race the writer.
+	 */
+	std::atomic<uint64> StateSnapshotWords[StateSnapshotWordsNum] = { };
+
+	/** Sequence number of the state snapshot. It's odd while the snapshot is being written. */
+	std::atomic<uint32> SnapshotSequence = 0;
+
+	/** If true, a snapshot has been requested during the current transition, and has to be published once it ends. */
+	bool bIsStateSnapshotPending = false;
+
+	/** Last action a state has performed during the current transition. */
+	EStateAction PendingSnapshotStateAction = EStateAction::None;
+
 #ifdef WITH_EDITOR
 	/** Container of all states that performed an action. It exists for debug purposes only. */
 	TArray<FDebugStateAction> LastStateActionsStack;
 #endif
 
-	/** Queue for the pending push requests that failed to happen. Only the very first entry is tried to be pushed. */
+	/** Queue for the pending push requests that failed to happen. It's kept sorted following the push queue policy. */
 	TArray<FPendingPushRequest> PendingPushRequests;
 
+	/** World time in seconds the earliest pending push request expires at. Negative if none of them expires. */
+	double NextPushRequestExpirationTime = -1.0;
+
 	/** Delegates to pending push request ID. Users can listen for these using ID to register their callbacks. */
 	TMap<uint32, FOnPendingPushRequestSignature> OnPendingPushRequestResultDelegates;
 
@@ -611,6 +1472,43 @@ private:
 	 */
 	bool bIsRunningLatentRequest = false;
 
+	/** Amount of transitions (GotoState, EndState, PushState, or PopState) being currently performed. */
+	int32 TransitionDepth = 0;
+
+	/** If true, the stack has changed during the current transition, and the push queue has to be updated. */
+	bool bIsPushQueueDirty = false;
+
+	/** Runtime data of a region. */
+	struct FRegion
+	{
+	public:
+		FFSM_RegionDefinition Definition;
+
+		/** Active state of the region. The states are kept alive by the registered states. */
+		TObjectPtr<UMachineState> ActiveState = nullptr;
+
+		/** States stack of the region. The top-most is the active one, while all the others are paused. */
+		TArray<TObjectPtr<UMachineState>> StatesStack;
+
+		/** If true, a transition is waiting for a state of the region to finish dispatching an event. */
+		bool bIsRunningLatentRequest = false;
+	};
+
+	/** Regions created out of the region definitions. */
+	TArray<FRegion> Regions;
+
+	/** World-wide registry the state machine is in. */
+	TWeakObjectPtr<UFiniteStateMachineSubsystem> Registry = nullptr;
+
+	/** Index of the state machine in the registry. */
+	int32 RegistryIndex = INDEX_NONE;
+
+	/** Index of the state machine among the time-sliced ones of the registry. INDEX_NONE if it's not one of them. */
+	int32 TimeSlicedIndex = INDEX_NONE;
+
+	/** Time in seconds elapsed since the time-sliced states have been ticked last time. */
+	float TimeSlicedDeltaTime = 0.f;
+
 	bool bIsInitialized = false;
 };
 
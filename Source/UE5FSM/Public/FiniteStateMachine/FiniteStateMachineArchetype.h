@@ -0,0 +1,193 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "Engine/DataAsset.h"
+#include "FiniteStateMachine/MachineState.h"
+
+#include "FiniteStateMachineArchetype.generated.h"
+
+/**
+ * Information about a single state of a finite state machine archetype derived from the state class defaults.
+ */
+USTRUCT()
+struct UE5FSM_API FFSM_CompiledState
+{
+	GENERATED_BODY()
+
+public:
+	/** State class the information is about. */
+	UPROPERTY(VisibleAnywhere, Category="Compiled State")
+	TSubclassOf<UMachineState> StateClass = nullptr;
+
+	/** Labels the state registers. States that don't use labels only accept the default one. */
+	UPROPERTY(VisibleAnywhere, Category="Compiled State")
+	TArray<FGameplayTag> Labels;
+
+	/**
+	 * Bit mask where each bit tells whether transition from this state to the state of the same index is blocked.
+	 * Derived from the allowlist and blocklist.
+	 */
+	UPROPERTY()
+	TArray<uint32> BlockedTransitionsMask;
+};
+
+/**
+ * Precompiled configuration of a finite state machine shared by all the instances using it.
+ *
+ * Every state machine that is configured in the same way derives the same information over and over again on
+ * initialization and on each transition. The archetype computes it only once, either when it's saved (hence at cook), or
+ * on its first use, and then all the state machines reference it read-only.
+ *
+ * # What it contains:
+ * - States to register, global state, initial state and its label. When a state machine uses an archetype, these
+ * override the ones specified on the component.
+ * - Index of each state, which makes registration and lookups not depend on the amount of states.
+ * - Transition masks derived from the allowlists and blocklists of the states, making transition checks constant time.
+ * - Labels each state registers.
+ * - Validation results.
+ * - Static analysis of the transition graph built from the allowlists, blocklists and transitions the states declare.
+ * It reports declared transitions that can never succeed as errors, and unreachable states and dead labels as warnings.
+ *
+ * @note	The compiled data reflects the class defaults. If a state alters its allowlist or blocklist at runtime, it has
+ * to be registered without an archetype.
+ */
+UCLASS(BlueprintType, ClassGroup=("Finite State Machine"))
+class UE5FSM_API UFiniteStateMachineArchetype
+	: public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	//~UObject Interface
+	virtual void PostLoad() override;
+	virtual void PreSave(FObjectPreSaveContext SaveContext) override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual EDataValidationResult IsDataValid(FDataValidationContext& Context) const override;
+#endif
+	//~End of UObject Interface
+
+	/**
+	 * Derive all the information from the current configuration. Any previously compiled data is thrown away.
+	 */
+	void Compile();
+
+	/**
+	 * Compile the archetype if it hasn't been compiled yet.
+	 */
+	void ConditionalCompile();
+
+	/**
+	 * Check whether the archetype has been compiled.
+	 * @return	If true, the archetype has been compiled, false otherwise.
+	 */
+	bool IsCompiled() const;
+
+	/**
+	 * Check whether the compiled configuration is valid.
+	 * @return	If true, the configuration is valid, false otherwise.
+	 */
+	bool IsConfigurationValid() const;
+
+	/**
+	 * Get the errors found during the compilation.
+	 * @return	Validation errors.
+	 */
+	const TArray<FString>& GetValidationErrors() const;
+
+	/**
+	 * Get the issues found by the transition graph analysis that don't prevent the archetype from being used.
+	 * @return	Validation warnings.
+	 */
+	const TArray<FString>& GetValidationWarnings() const;
+
+	/**
+	 * Get the compiled states. The index of each state is its archetype index.
+	 * @return	Compiled states.
+	 */
+	const TArray<FFSM_CompiledState>& GetCompiledStates() const;
+
+	/**
+	 * Find the archetype index of a given state class.
+	 * @param	InStateClass state class to search for. Its parent classes are not taken in account.
+	 * @return	Archetype index. INDEX_NONE if the state is not a part of the archetype.
+	 */
+	int32 FindStateIndex(TSubclassOf<UMachineState> InStateClass) const;
+
+	/**
+	 * Check whether transition between two states is blocked.
+	 * @param	FromIndex archetype index of the active state.
+	 * @param	ToIndex archetype index of the state to transit to.
+	 * @return	If true, the transition is blocked, false otherwise.
+	 */
+	bool IsTransitionBlocked(int32 FromIndex, int32 ToIndex) const;
+
+	/**
+	 * Check whether a state contains a given label.
+	 * @param	StateIndex archetype index of the state.
+	 * @param	Label label to check the presence of.
+	 * @return	If true, the state contains the label, false otherwise.
+	 */
+	bool ContainsLabel(int32 StateIndex, FGameplayTag Label) const;
+
+private:
+	/**
+	 * Rebuild the transient lookup tables out of the compiled data.
+	 */
+	void BuildStateIndices();
+
+	/**
+	 * Build the transition graph out of the compiled states, and report unreachable states, dead labels, and declared
+	 * transitions that can never succeed.
+	 */
+	void AnalyzeTransitionGraph();
+
+	/**
+	 * Find the compiled state the state machine would pick for a given class, following UFiniteStateMachine::FindState().
+	 * @param	InStateClass state class to search for. Its subclasses are taken in account.
+	 * @return	Archetype index. INDEX_NONE if there's no such state.
+	 */
+	int32 FindCompiledStateIndex(TSubclassOf<UMachineState> InStateClass) const;
+
+public:
+	/** All the machine states that will be automatically registered on initialization. */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine", meta=(AllowAbstract="False"))
+	TArray<TSubclassOf<UMachineState>> StateClassesToRegister;
+
+	/** Global state the state machine is in. If not specified, it won't have any. */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine",
+		meta=(MustImplement="/Script/UE5FSM.GlobalMachineStateInterface", AllowAbstract="False"))
+	TSubclassOf<UMachineState> GlobalStateClass = nullptr;
+
+	/**
+	 * Initial state the state machine starts with. If not specified, it won't have any unless GotoState() is used after
+	 * initialization.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine", meta=(AllowAbstract="False"))
+	TSubclassOf<UMachineState> InitialState = nullptr;
+
+	/** Label the initial state starts with. If not specified, Default label will be used. */
+	UPROPERTY(EditDefaultsOnly, Category="State Machine", meta=(Categories="StateMachine.Label"))
+	FGameplayTag InitialStateLabel = TAG_StateMachine_Label_Default;
+
+private:
+	/** States that passed the validation in registration order. */
+	UPROPERTY(VisibleAnywhere, Category="Compiled")
+	TArray<FFSM_CompiledState> CompiledStates;
+
+	/** Errors found during the compilation. */
+	UPROPERTY(VisibleAnywhere, Category="Compiled")
+	TArray<FString> ValidationErrors;
+
+	/** Issues found by the transition graph analysis. */
+	UPROPERTY(VisibleAnywhere, Category="Compiled")
+	TArray<FString> ValidationWarnings;
+
+	/** If true, the compiled data is up to date, false otherwise. */
+	UPROPERTY()
+	bool bIsCompiled = false;
+
+	/** State class to archetype index. */
+	TMap<const UClass*, int32> StateIndices;
+};
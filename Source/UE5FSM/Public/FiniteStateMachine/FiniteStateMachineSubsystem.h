@@ -0,0 +1,558 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/FiniteStateMachine.h"
+#include "FiniteStateMachine/LabelResumptionAwaiter.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+#include "FiniteStateMachineSubsystem.generated.h"
+
+/**
+ * State machines a single state class is in, kept by the state index of UFiniteStateMachineSubsystem. Each list of
+ * state machines is paired with the list of their instances of the state.
+ */
+USTRUCT()
+struct FFSM_StateIndexEntry
+{
+	GENERATED_BODY()
+
+public:
+	/** State machines having the state active. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UFiniteStateMachine>> ActiveStateMachines;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UMachineState>> ActiveStates;
+
+	/** State machines having the state on the stack, whether it's active or paused. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UFiniteStateMachine>> StackStateMachines;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UMachineState>> StackStates;
+
+	/**
+	 * Active global states and sub-states having transition rules. They're not indexed, and are listed only to
+	 * evaluate their rules. They use the active slot, as they're never in the other lists.
+	 */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UFiniteStateMachine>> UnindexedStateMachines;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UMachineState>> UnindexedStates;
+};
+
+/**
+ * World-wide registry of the finite state machines. It lets observe the state actions of every state machine in the
+ * world without binding to the states one by one.
+ *
+ * # Observers
+ * - Observers are registered for a state class and a mask of actions. Each state action performs a single lookup in the
+ * table of the observed state classes, and calls only the observers interested in that action.
+ * - State classes are matched exactly; use nullptr to observe all the states.
+ *
+ * # State index
+ * - The subsystem keeps track of the state machines each state class is active in, or is on the stack of. It's updated
+ * incrementally on each state action, making queries like "how many agents are attacking" constant time, and the
+ * iteration over them cache-friendly.
+ * - State classes are matched exactly, and global states are not indexed.
+ *
+ * # Bulk transitions
+ * - Transitions requested for many state machines at once validate the parts they share only once. Each state machine
+ * is then validated right before its own transition, as the events of the previous transitions might affect it.
+ *
+ * # Transition rules
+ * - Once per frame, the subsystem evaluates the transition rules of the active states using the state index. All the
+ * active states of a class are checked at once: each condition reads one value per state into a contiguous column, and
+ * compares the whole column in a single branchless loop. The resulting transitions are performed once every rule has
+ * been evaluated.
+ * - Rules are taken from the class defaults of the states.
+ * - The rules of the global states and of the sub-states are evaluated as well. These states are not indexed, and are
+ * tracked only while they're active and have rules.
+ *
+ * # Time slicing
+ * - State machines that time-slice the ticks of their states are ticked in round-robin order, resuming from where the
+ * previous frame has stopped, until the time budget is exhausted.
+ * - To not starve any of them, at least as many are ticked each frame as it takes to visit all of them within the
+ * maximum tick delay, regardless of the budget.
+ * - Urgent states are ticked every frame by their state machines, and are not a part of the budget.
+ * - The subsystem is a tickable object, so it ticks once per frame after all the tick groups of the world. Time-sliced
+ * states therefore tick after every actor and component, whatever tick group their state machine is in, and they see
+ * the results of the physics and of the post-update work of that frame.
+ *
+ * # Label resumptions
+ * - When enabled, the labels of the states that are not urgent start, and carry on after their latent executions, only
+ * while the label resumption budget of the frame lasts. The rest is deferred, and resumed on the next frames in the
+ * order of deferral. See FFSM_LabelResumptionAwaiter.
+ */
+UCLASS(Config="Engine", DefaultConfig)
+class UE5FSM_API UFiniteStateMachineSubsystem
+	: public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	DECLARE_DELEGATE_FourParams(
+		FOnGlobalStateActionSignature,
+		UFiniteStateMachine* StateMachine,
+		UMachineState* State,
+		EStateAction StateAction,
+		TSubclassOf<UMachineState> OtherState);
+
+public:
+	//~USubsystem Interface
+	virtual void Deinitialize() override;
+	//~End of USubsystem Interface
+
+	//~FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End of FTickableGameObject Interface
+
+	/**
+	 * Get the subsystem of the world a given object is in.
+	 * @param	WorldContextObject object to get the world from.
+	 * @return	Subsystem. May be nullptr.
+	 */
+	static UFiniteStateMachineSubsystem* Get(const UObject* WorldContextObject);
+
+	/**
+	 * Add a state machine to the registry. Called by the state machines on initialization.
+	 * @param	StateMachine state machine to add.
+	 */
+	void RegisterStateMachine(UFiniteStateMachine* StateMachine);
+
+	/**
+	 * Remove a state machine from the registry. Called by the state machines on uninitialization.
+	 * @param	StateMachine state machine to remove.
+	 */
+	void UnregisterStateMachine(UFiniteStateMachine* StateMachine);
+
+	/**
+	 * Get all the registered state machines. The order is not stable.
+	 * @return	Registered state machines.
+	 */
+	const TArray<TObjectPtr<UFiniteStateMachine>>& GetStateMachines() const;
+
+	/**
+	 * Get the amount of state machines a given state is in.
+	 * @param	StateClass state class to check. Its subclasses are not taken in account.
+	 * @param	bCheckStack if true, paused states are taken in account as well, otherwise only the active ones are.
+	 * @return	Amount of state machines.
+	 */
+	int32 GetStateMachinesNumInState(TSubclassOf<UMachineState> StateClass, bool bCheckStack = false) const;
+
+	/**
+	 * Get the state machines a given state is in. The order is not stable.
+	 * @param	StateClass state class to check. Its subclasses are not taken in account.
+	 * @param	bCheckStack if true, paused states are taken in account as well, otherwise only the active ones are.
+	 * @return	State machines. The view is invalidated by any following state action.
+	 */
+	TConstArrayView<UFiniteStateMachine*> GetStateMachinesInState(TSubclassOf<UMachineState> StateClass,
+		bool bCheckStack = false) const;
+
+	/**
+	 * Update the state index after an action of a state. Called by the state machines.
+	 * @param	StateMachine state machine the state belongs to.
+	 * @param	State state that performed the action.
+	 * @param	StateAction action that took place.
+	 */
+	void UpdateStateIndex(UFiniteStateMachine* StateMachine, UMachineState* State, EStateAction StateAction);
+
+	/**
+	 * Keep track of a global state or a sub-state having transition rules while it's active. Such states are not
+	 * indexed, but their rules are evaluated along with the others. Called by the state machines.
+	 * @param	StateMachine state machine the state belongs to.
+	 * @param	State state that performed the action.
+	 * @param	StateAction action that took place.
+	 */
+	void UpdateUnindexedRuleStates(UFiniteStateMachine* StateMachine, UMachineState* State, EStateAction StateAction);
+
+	/**
+	 * Remove a state from the state index. Called by the state machines before destroying their states.
+	 * @param	State state to remove.
+	 */
+	void RemoveFromStateIndex(UMachineState* State);
+
+	/**
+	 * Activate a state at a specified label in several state machines at once. The validation shared by all of them,
+	 * and the lookups in their archetypes, are performed only once. The rest is validated per state machine right
+	 * before its transition.
+	 * @param	InStateMachines state machines to perform the transition in.
+	 * @param	StateClass state to activate.
+	 * @param	Label label to start the state at.
+	 * @param	OutResults output parameter. Result for each state machine, in the same order.
+	 * @param	bForceEvents if true, in case of transition to the same state, state change events will be fired.
+	 * @return	Amount of state machines that have accepted the transition.
+	 * @see		UFiniteStateMachine::TryGotoState()
+	 */
+	int32 GotoStateBulk(TConstArrayView<UFiniteStateMachine*> InStateMachines, TSubclassOf<UMachineState> StateClass,
+		FGameplayTag Label, TArray<EFSM_TransitionResult>& OutResults, bool bForceEvents = true);
+
+	/**
+	 * Evaluate the transition rules of all the active states, and perform the transitions of the rules that have been
+	 * met. Called every frame.
+	 * @return	Amount of performed transitions.
+	 */
+	int32 EvaluateTransitionRules();
+
+	/**
+	 * Add a state machine to the ones whose states are ticked within the time budget. Called by the state machines.
+	 * @param	StateMachine state machine to add.
+	 */
+	void AddTimeSlicedStateMachine(UFiniteStateMachine* StateMachine);
+
+	/**
+	 * Remove a state machine from the ones whose states are ticked within the time budget. Called by the state machines.
+	 * @param	StateMachine state machine to remove.
+	 */
+	void RemoveTimeSlicedStateMachine(UFiniteStateMachine* StateMachine);
+
+	/**
+	 * Set the time the time-sliced state ticks may take each frame.
+	 * @param	InBudget budget in microseconds.
+	 */
+	void SetStateTicksBudget(float InBudget);
+
+	/**
+	 * Get the time the time-sliced state ticks may take each frame.
+	 * @return	Budget in microseconds.
+	 */
+	float GetStateTicksBudget() const;
+
+	/**
+	 * Set the maximum amount of frames a time-sliced state machine may go without ticking its states.
+	 * @param	InMaxDelay maximum delay in frames. Clamped to 1.
+	 */
+	void SetMaxStateTickDelay(int32 InMaxDelay);
+
+	/**
+	 * Get the maximum amount of frames a time-sliced state machine may go without ticking its states.
+	 * @return	Maximum delay in frames.
+	 */
+	int32 GetMaxStateTickDelay() const;
+
+	/** Charges the time spent within its lifetime to the label resumption budget of the frame. */
+	struct UE5FSM_API FLabelResumptionScope
+	{
+	public:
+		explicit FLabelResumptionScope(UFiniteStateMachineSubsystem* InSubsystem);
+		~FLabelResumptionScope();
+
+	private:
+		UFiniteStateMachineSubsystem* Subsystem = nullptr;
+		uint64 StartCycles = 0;
+	};
+
+	/**
+	 * Check whether the label resumptions of a given state are subject to the budget.
+	 * @param	State state to check.
+	 * @return	If true, the resumptions are budgeted, false otherwise.
+	 */
+	bool ShouldBudgetLabelResumption(const UMachineState* State) const;
+
+	/**
+	 * Check whether the label resumption budget of the current frame hasn't been exhausted yet.
+	 * @return	If true, a label can be resumed right away, false otherwise.
+	 */
+	bool HasLabelResumptionBudget() const;
+
+	/**
+	 * Resume a deferred label, charging the time it takes to the label resumption budget of the frame.
+	 * @param	Handle coroutine to resume.
+	 */
+	void ResumeLabel(std::coroutine_handle<> Handle);
+
+	/**
+	 * Start charging a label that carries on right away to the label resumption budget of the frame. It's charged until
+	 * it reaches its next latent execution, see EndLabelContinuation(). If it never does within the frame, nothing is
+	 * charged.
+	 */
+	void BeginLabelContinuation();
+
+	/**
+	 * Charge the label that has carried on right away to the label resumption budget of the frame, if there's any.
+	 * Called by the states whenever they start a latent execution.
+	 */
+	void EndLabelContinuation();
+
+	/**
+	 * Queue a label resumption until there's budget for it.
+	 * @param	Awaiter awaiter to resume.
+	 */
+	void DeferLabelResumption(FFSM_LabelResumptionAwaiter* Awaiter);
+
+	/**
+	 * Remove a deferred label resumption from the queue.
+	 * @param	Awaiter awaiter to remove.
+	 */
+	void CancelLabelResumption(FFSM_LabelResumptionAwaiter* Awaiter);
+
+	/**
+	 * Record that a state has postponed the activation of its label due to the exhausted budget. Called once per
+	 * deferral, no matter how many frames the activation is retried for.
+	 */
+	void AddDeferredLabelActivation();
+
+	/**
+	 * Record that a state has stopped waiting to activate its label, whether it has activated it or not.
+	 */
+	void RemoveDeferredLabelActivation();
+
+	/**
+	 * Get the amount of label resumptions and activations waiting for budget.
+	 * @return	Amount of deferred label resumptions and activations.
+	 */
+	int32 GetDeferredLabelResumptionsNum() const;
+
+	/**
+	 * Set whether the label resumptions of the states that are not urgent are budgeted.
+	 * @param	bInBudget if true, label resumptions are budgeted, false otherwise.
+	 */
+	void SetBudgetLabelResumptions(bool bInBudget);
+
+	/**
+	 * Set the time the label resumptions may take each frame before the rest is deferred.
+	 * @param	InBudget budget in microseconds.
+	 */
+	void SetLabelResumptionsBudget(float InBudget);
+
+	/**
+	 * Get the time the label resumptions may take each frame before the rest is deferred.
+	 * @return	Budget in microseconds.
+	 */
+	float GetLabelResumptionsBudget() const;
+
+	/**
+	 * Observe the actions of a given state class in every state machine of the world.
+	 * @param	StateClass state class to observe. Its subclasses are not observed. If nullptr, every state is observed.
+	 * @param	Actions actions to observe.
+	 * @param	Delegate delegate to call when one of the actions takes place.
+	 * @return	Handle used to remove the observer.
+	 */
+	FDelegateHandle AddStateActionObserver(TSubclassOf<UMachineState> StateClass, EFSM_StateActionMask Actions,
+		FOnGlobalStateActionSignature&& Delegate);
+
+	/**
+	 * Remove an observer added via AddStateActionObserver().
+	 * @param	Handle handle returned on addition.
+	 * @return	If true, the observer has been removed, false otherwise.
+	 */
+	bool RemoveStateActionObserver(FDelegateHandle Handle);
+
+	/**
+	 * Check whether there's any observer.
+	 * @return	If true, at least one observer is registered, false otherwise.
+	 */
+	bool HasStateActionObservers() const;
+
+	/**
+	 * Call the observers interested in a given state action.
+	 * @param	StateMachine state machine the state belongs to.
+	 * @param	State state that performed the action.
+	 * @param	StateAction action that took place.
+	 * @param	OtherState other state taking part in the transition.
+	 */
+	void NotifyStateAction(UFiniteStateMachine* StateMachine, UMachineState* State, EStateAction StateAction,
+		TSubclassOf<UMachineState> OtherState);
+
+private:
+	/**
+	 * Queue the transitions of the first transition rule each state meets.
+	 * @param	Rules transition rules of the states.
+	 * @param	InStateMachines state machines the states belong to.
+	 * @param	States active states of the same class.
+	 */
+	void GatherRuleTransitions(TConstArrayView<FFSM_TransitionRule> Rules,
+		TConstArrayView<UFiniteStateMachine*> InStateMachines, TConstArrayView<UMachineState*> States);
+
+	/**
+	 * Find the first transition rule each state meets.
+	 * @param	Rules transition rules of the states.
+	 * @param	States active states of the same class.
+	 */
+	void EvaluateTransitionRules_Batch(TConstArrayView<FFSM_TransitionRule> Rules,
+		TConstArrayView<UMachineState*> States);
+
+	/**
+	 * Write the value each state checks by a condition in a column. The states whose value can't be read fail the
+	 * condition.
+	 * @param	Condition condition to read the values of.
+	 * @param	States states to read the values of.
+	 * @param	OutValues output parameter. Value of each state.
+	 * @param	OutResults output parameter. Reset for the states that fail the condition.
+	 */
+	static void GatherConditionValues(const FFSM_TransitionCondition& Condition, TConstArrayView<UMachineState*> States,
+		TArrayView<float> OutValues, TArrayView<uint8> OutResults);
+
+	/**
+	 * Compare a column of values with a single value, keeping the result of the previous conditions.
+	 * @param	Operator operator to compare with.
+	 * @param	Value value to compare with.
+	 * @param	Values values to compare.
+	 * @param	InOutResults in-out parameter. Whether each state has met the conditions so far.
+	 */
+	static void CompareConditionValues(EFSM_ComparisonOperator Operator, float Value, TConstArrayView<float> Values,
+		TArrayView<uint8> InOutResults);
+
+	/** Transition of a met transition rule waiting to be performed. */
+	struct FRuleTransition
+	{
+	public:
+		UFiniteStateMachine* StateMachine = nullptr;
+		UMachineState* State = nullptr;
+		const FFSM_TransitionRule* Rule = nullptr;
+	};
+
+	/**
+	 * Perform the transition of a met transition rule, unless it's not possible anymore.
+	 * @param	Transition transition to perform.
+	 * @return	If true, the transition has been accepted, false otherwise.
+	 */
+	static bool PerformRuleTransition(const FRuleTransition& Transition);
+
+	/**
+	 * Tick the states of the time-sliced state machines in round-robin order until the time budget is exhausted.
+	 * @return	Amount of state machines that have ticked their states.
+	 */
+	int32 TickTimeSlicedStateMachines();
+
+	/**
+	 * Resume the deferred label resumptions in the order of deferral until the budget is exhausted. At least one is
+	 * resumed each frame.
+	 * @return	Amount of resumed labels.
+	 */
+	int32 ResumeDeferredLabels();
+
+	/**
+	 * Get the time spent on the label resumptions in the current frame.
+	 * @return	Spent time in cycles.
+	 */
+	uint64 GetLabelResumptionCycles() const;
+
+private:
+	/** State machines a single state class is in. */
+	/**
+	 * Find the index entry of a state class, adding it if there's none yet.
+	 * @param	StateClass state class to find the entry of.
+	 * @return	Index entry.
+	 */
+	FFSM_StateIndexEntry& FindOrAddStateIndexEntry(UClass* StateClass);
+
+	/**
+	 * Add a state to one of the lists of its index entry.
+	 * @param	StateMachines state machines of the list.
+	 * @param	States states of the list.
+	 * @param	StateMachine state machine to add.
+	 * @param	State state to add.
+	 * @param	Slot slot the state keeps its index in the list in.
+	 */
+	static void AddToStateIndexList(TArray<TObjectPtr<UFiniteStateMachine>>& StateMachines,
+		TArray<TObjectPtr<UMachineState>>& States, UFiniteStateMachine* StateMachine, UMachineState* State, int32& Slot);
+
+	/**
+	 * Remove a state from one of the lists of its index entry.
+	 * @param	StateMachines state machines of the list.
+	 * @param	States states of the list.
+	 * @param	Slot slot the state keeps its index in the list in.
+	 * @param	bIsStackList if true, the list is the stack one, false otherwise.
+	 */
+	static void RemoveFromStateIndexList(TArray<TObjectPtr<UFiniteStateMachine>>& StateMachines,
+		TArray<TObjectPtr<UMachineState>>& States, int32& Slot, bool bIsStackList);
+
+	struct FStateActionObserver
+	{
+	public:
+		FOnGlobalStateActionSignature Delegate;
+		EFSM_StateActionMask Actions = EFSM_StateActionMask::None;
+		bool bIsRemoved = false;
+	};
+
+	/** Observers of a single state class grouped by the action they observe. */
+	using FStateActionObservers = TFSM_StateActionListeners<FStateActionObserver>;
+
+	/** Registered state machines. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UFiniteStateMachine>> StateMachines;
+
+	/** State class to the state machines it's in. */
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<UClass>, FFSM_StateIndexEntry> StateIndex;
+
+	/**
+	 * Observers of each observed state class. They're kept by pointer, as a new state class can be observed while the
+	 * observers of another one are being notified. Classes are removed once their last observer is.
+	 */
+	TMap<TObjectKey<UClass>, TUniquePtr<FStateActionObservers>> Observers;
+
+	/** Observers of all the states. */
+	FStateActionObservers WildcardObservers;
+
+	/** Total amount of observers. */
+	int32 ObserversNum = 0;
+
+	/** Indexed state classes having transition rules. */
+	UPROPERTY(Transient)
+	TArray<TSubclassOf<UMachineState>> RuleStateClasses;
+
+	/** Value each state checked by the current condition. Reused between evaluations. */
+	TArray<float> ConditionValues;
+
+	/** Whether each state has met all the conditions of the current rule so far. Reused between evaluations. */
+	TArray<uint8> ConditionResults;
+
+	/** Index of the first rule each state has met. Reused between evaluations. */
+	TArray<int32> MetRuleIndices;
+
+	/** Transitions of the met rules waiting to be performed. Reused between evaluations. */
+	TArray<FRuleTransition> RuleTransitions;
+
+	/** State machines whose states are ticked within the time budget in round-robin order. */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UFiniteStateMachine>> TimeSlicedStateMachines;
+
+	/** Index of the time-sliced state machine to tick first on the next frame. */
+	int32 NextTimeSlicedIndex = 0;
+
+	/** Time in microseconds the time-sliced state ticks may take each frame. */
+	UPROPERTY(Config)
+	float StateTicksBudget = 1000.f;
+
+	/** Maximum amount of frames a time-sliced state machine may go without ticking its states. */
+	UPROPERTY(Config)
+	int32 MaxStateTickDelay = 8;
+
+	/** Deferred label resumptions in the order of deferral. Canceled ones are nullptr. */
+	TArray<FFSM_LabelResumptionAwaiter*> DeferredLabelResumptions;
+
+	/** Index of the deferred label resumption to resume first. The ones before it have been resumed already. */
+	int32 NextDeferredLabelIndex = 0;
+
+	/** Amount of states waiting for budget to activate their label. */
+	int32 DeferredLabelActivationsNum = 0;
+
+	/** Time the label that has carried on right away has started in. 0 if there's none. */
+	uint64 LabelContinuationStartCycles = 0;
+
+	/** Frame the label that has carried on right away has started in. */
+	uint64 LabelContinuationFrame = 0;
+
+	/** Time spent on the label resumptions in LabelResumptionFrame. */
+	uint64 LabelResumptionCycles = 0;
+
+	/** Frame LabelResumptionCycles has been accumulated in. */
+	uint64 LabelResumptionFrame = 0;
+
+	/** Amount of label resumptions being currently performed. Nested ones are a part of the outer one. */
+	int32 LabelResumptionDepth = 0;
+
+	/** If true, the label resumptions of the states that are not urgent are budgeted, false otherwise. */
+	UPROPERTY(Config)
+	bool bBudgetLabelResumptions = false;
+
+	/** Time in microseconds the label resumptions may take each frame before the rest is deferred. */
+	UPROPERTY(Config)
+	float LabelResumptionsBudget = 500.f;
+};
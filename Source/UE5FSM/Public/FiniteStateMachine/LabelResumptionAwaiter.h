@@ -0,0 +1,58 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include <coroutine>
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class UFiniteStateMachineSubsystem;
+class UMachineState;
+
+/**
+ * Awaiter letting UFiniteStateMachineSubsystem decide when a label of a state carries on.
+ *
+ * If the label resumption budget of the frame hasn't been exhausted yet, the coroutine carries on right away without
+ * suspending, and the time it takes until it reaches its next latent execution is charged to the budget. Otherwise,
+ * the resumption is deferred, and the subsystem resumes it on one of the next frames in the order of deferral.
+ *
+ * The coroutine always carries on right away when budgeting is disabled, when the state is urgent, or when it's
+ * already a part of a budgeted resumption.
+ *
+ * Example:
+ * - co_await FFSM_LabelResumptionAwaiter(this);
+ *
+ * @note	UMachineState::RunLatentExecution() awaits it on its own once the latent execution finishes.
+ */
+class UE5FSM_API FFSM_LabelResumptionAwaiter
+{
+public:
+	/** Resumes the deferred awaiters. */
+	friend UFiniteStateMachineSubsystem;
+
+public:
+	/**
+	 * Budget the resumption of a label of a given state.
+	 * @param	InState state the label belongs to.
+	 */
+	explicit FFSM_LabelResumptionAwaiter(const UMachineState* InState);
+
+	FFSM_LabelResumptionAwaiter(const FFSM_LabelResumptionAwaiter&) = delete;
+	FFSM_LabelResumptionAwaiter& operator=(const FFSM_LabelResumptionAwaiter&) = delete;
+	~FFSM_LabelResumptionAwaiter();
+
+	//~Awaiter Interface
+	bool await_ready();
+	void await_suspend(std::coroutine_handle<> InHandle);
+	void await_resume() const;
+	//~End of Awaiter Interface
+
+private:
+	/** Subsystem budgeting the resumption. nullptr if the resumption is not budgeted. */
+	TWeakObjectPtr<UFiniteStateMachineSubsystem> Scheduler = nullptr;
+
+	/** Coroutine to resume. */
+	std::coroutine_handle<> Handle;
+
+	/** Index of the awaiter in the queue of the subsystem. INDEX_NONE if it's not waiting in it. */
+	int32 QueueIndex = INDEX_NONE;
+};
@@ -4,6 +4,7 @@
 
 #include "FiniteStateMachine/FiniteStateMachineTypes.h"
 #include "FiniteStateMachine/GlobalMachineStateInterface.h"
+#include "FiniteStateMachine/LabelResumptionAwaiter.h"
 #include "GameplayTagContainer.h"
 #include "NativeGameplayTags.h"
 #include "UE5Coro.h"
@@ -11,9 +12,14 @@
 
 #include "MachineState.generated.h"
 
+class FFiniteStateMachineK2EventsCacheTest;
 class UFiniteStateMachine;
+class UFiniteStateMachineSubsystem;
+class UMachineState;
 class UMachineStateData;
+class FFSM_StateActionAwaiter;
 struct FFSM_PushRequestHandle;
+struct FFSM_StateActionWaitNode;
 struct FMS_IsDispatchingEventManager;
 
 /** Label tag associated with the default label the states start with if not told otherwise. */
@@ -116,6 +122,324 @@ enum class EStateAction : uint8
 	Pause
 };
 
+/**
+ * Mask of state actions used to wait for any of several actions at once.
+ */
+UENUM(meta=(Bitflags, UseEnumValuesAsMaskValuesInEditor="true"))
+enum class EFSM_StateActionMask : uint8
+{
+	None = 0 UMETA(Hidden),
+	Begin = 1 << 0,
+	End = 1 << 1,
+	Push = 1 << 2,
+	Pop = 1 << 3,
+	Resume = 1 << 4,
+	Pause = 1 << 5
+};
+ENUM_CLASS_FLAGS(EFSM_StateActionMask);
+
+/**
+ * Convert a state action to its mask bit.
+ * @param	StateAction state action to convert.
+ * @return	Mask containing only the given action. Empty for EStateAction::None.
+ */
+constexpr EFSM_StateActionMask ToStateActionMask(EStateAction StateAction)
+{
+	return StateAction == EStateAction::None
+		? EFSM_StateActionMask::None
+		: static_cast<EFSM_StateActionMask>(1 << (static_cast<uint8>(StateAction) - 1));
+}
+
+/**
+ * Listeners of state actions grouped by the action they listen to, so that each action only calls the listeners
+ * interested in it. Listeners of several actions are in several buckets.
+ *
+ * Listeners can be added and removed while they're being called. The added ones are called starting from the next
+ * broadcast. The removed ones are only marked as such, and are destroyed once the broadcast ends, as the listener that
+ * is being called might be the one removing itself.
+ * @tparam	ListenerType listener type. It must have Delegate, Actions, and bIsRemoved members.
+ */
+template<typename ListenerType>
+class TFSM_StateActionListeners
+{
+public:
+	/**
+	 * Add a listener.
+	 * @param	Listener listener to add.
+	 */
+	void Add(ListenerType&& Listener)
+	{
+		PendingListeners.Add(MoveTemp(Listener));
+
+		// Buckets must not change while they're being iterated
+		if (BroadcastDepth == 0)
+		{
+			Flush();
+		}
+	}
+
+	/**
+	 * Remove a listener.
+	 * @param	Handle handle of the listener's delegate.
+	 * @return	If true, the listener has been removed, false otherwise.
+	 */
+	bool Remove(FDelegateHandle Handle)
+	{
+		if (!Handle.IsValid())
+		{
+			return false;
+		}
+
+		// Pending listeners are never being called, they can be destroyed right away
+		const int32 RemovedPending = PendingListeners.RemoveAll([Handle](const ListenerType& Listener)
+		{
+			return Listener.Delegate.GetHandle() == Handle;
+		});
+
+		bool bRemoved = RemovedPending > 0;
+		for (TArray<ListenerType>& Bucket : Buckets)
+		{
+			for (ListenerType& Listener : Bucket)
+			{
+				if (!Listener.bIsRemoved && Listener.Delegate.GetHandle() == Handle)
+				{
+					// Don't touch the delegate, as it might be the one being executed
+					Listener.bIsRemoved = true;
+					bHasRemovedListeners = true;
+					bRemoved = true;
+				}
+			}
+		}
+
+		if (BroadcastDepth == 0)
+		{
+			Flush();
+		}
+
+		return bRemoved;
+	}
+
+	/**
+	 * Call the listeners interested in a given action.
+	 * @param	StateAction action that took place.
+	 * @param	Filter predicate telling whether a listener has to be called.
+	 * @param	Args arguments to execute the delegates with.
+	 */
+	template<typename FilterType, typename... ArgTypes>
+	void Broadcast(EStateAction StateAction, const FilterType& Filter, ArgTypes... Args)
+	{
+		const int32 BucketIndex = static_cast<int32>(StateAction) - 1;
+		check(BucketIndex >= 0 && BucketIndex < StateActionsNum);
+
+		const TArray<ListenerType>& Bucket = Buckets[BucketIndex];
+		if (Bucket.IsEmpty())
+		{
+			return;
+		}
+
+		BroadcastDepth++;
+
+		for (const ListenerType& Listener : Bucket)
+		{
+			if (!Listener.bIsRemoved && Filter(Listener))
+			{
+				Listener.Delegate.ExecuteIfBound(Args...);
+			}
+		}
+
+		BroadcastDepth--;
+
+		if (BroadcastDepth == 0)
+		{
+			Flush();
+		}
+	}
+
+	/**
+	 * Check whether there are no listeners. The ones removed while broadcasting are counted until the broadcast ends.
+	 * @return	If true, there are no listeners, false otherwise.
+	 */
+	bool IsEmpty() const
+	{
+		if (!PendingListeners.IsEmpty())
+		{
+			return false;
+		}
+
+		for (const TArray<ListenerType>& Bucket : Buckets)
+		{
+			if (!Bucket.IsEmpty())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Check whether the listeners are being called.
+	 * @return	If true, a broadcast is being performed, false otherwise.
+	 */
+	bool IsBroadcasting() const
+	{
+		return BroadcastDepth > 0;
+	}
+
+private:
+	/**
+	 * Add the listeners added while broadcasting, and destroy the ones removed in the meantime.
+	 */
+	void Flush()
+	{
+		if (bHasRemovedListeners)
+		{
+			bHasRemovedListeners = false;
+			for (TArray<ListenerType>& Bucket : Buckets)
+			{
+				Bucket.RemoveAll([](const ListenerType& Listener)
+				{
+					return Listener.bIsRemoved;
+				});
+			}
+		}
+
+		for (const ListenerType& Listener : PendingListeners)
+		{
+			for (int32 i = 0; i < StateActionsNum; i++)
+			{
+				if (EnumHasAnyFlags(Listener.Actions, ToStateActionMask(static_cast<EStateAction>(i + 1))))
+				{
+					Buckets[i].Add(Listener);
+				}
+			}
+		}
+
+		PendingListeners.Empty();
+	}
+
+private:
+	/** Amount of state actions, one bucket per each. */
+	static constexpr int32 StateActionsNum = static_cast<int32>(EStateAction::Pause);
+
+	/** Listeners grouped by the action they listen to. */
+	TArray<ListenerType> Buckets[StateActionsNum];
+
+	/** Listeners added while broadcasting. They're added to the buckets once the broadcast ends. */
+	TArray<ListenerType> PendingListeners;
+
+	/** Amount of broadcasts being currently performed. Buckets are not altered while broadcasting. */
+	int32 BroadcastDepth = 0;
+
+	/** If true, some listeners have been removed while broadcasting, false otherwise. */
+	bool bHasRemovedListeners = false;
+};
+
+/**
+ * Transition a state declares to perform. It's only used by the static analysis of finite state machine archetypes.
+ */
+USTRUCT(BlueprintType)
+struct UE5FSM_API FFSM_TransitionDeclaration
+{
+	GENERATED_BODY()
+
+public:
+	/** State the transition goes to. Use the declaring state itself to describe label changes within it. */
+	UPROPERTY(EditDefaultsOnly, Category="Transition", meta=(AllowAbstract="False"))
+	TSubclassOf<UMachineState> StateClass = nullptr;
+
+	/** Label the state starts with. */
+	UPROPERTY(EditDefaultsOnly, Category="Transition", meta=(Categories="StateMachine.Label"))
+	FGameplayTag Label = TAG_StateMachine_Label_Default;
+};
+
+UENUM(BlueprintType)
+enum class EFSM_TransitionConditionType : uint8
+{
+	/** Compare a numeric property of the state data with a value. */
+	StateDataNumber,
+	/** Check whether a gameplay tag, or a gameplay tag container, property of the state data has a tag. */
+	StateDataTag,
+	/** Compare the time since the last state action with a value. */
+	TimeSinceLastStateAction,
+};
+
+UENUM(BlueprintType)
+enum class EFSM_ComparisonOperator : uint8
+{
+	Less,
+	LessOrEqual,
+	Greater,
+	GreaterOrEqual,
+	Equal,
+	NotEqual,
+};
+
+/**
+ * Single check of a transition rule.
+ */
+USTRUCT(BlueprintType)
+struct UE5FSM_API FFSM_TransitionCondition
+{
+	GENERATED_BODY()
+
+public:
+	/** What the condition checks. */
+	UPROPERTY(EditDefaultsOnly, Category="Condition")
+	EFSM_TransitionConditionType Type = EFSM_TransitionConditionType::StateDataNumber;
+
+	/** Name of the state data property to check. */
+	UPROPERTY(EditDefaultsOnly, Category="Condition",
+		meta=(EditCondition="Type != EFSM_TransitionConditionType::TimeSinceLastStateAction", EditConditionHides))
+	FName PropertyName = NAME_None;
+
+	/** Operator to compare the checked value with Value. */
+	UPROPERTY(EditDefaultsOnly, Category="Condition",
+		meta=(EditCondition="Type != EFSM_TransitionConditionType::StateDataTag", EditConditionHides))
+	EFSM_ComparisonOperator Operator = EFSM_ComparisonOperator::Greater;
+
+	/** Value the checked one is compared with. */
+	UPROPERTY(EditDefaultsOnly, Category="Condition",
+		meta=(EditCondition="Type != EFSM_TransitionConditionType::StateDataTag", EditConditionHides))
+	float Value = 0.f;
+
+	/** Tag the property has to have. */
+	UPROPERTY(EditDefaultsOnly, Category="Condition",
+		meta=(EditCondition="Type == EFSM_TransitionConditionType::StateDataTag", EditConditionHides))
+	FGameplayTag Tag;
+
+	/** If true, the property must not have the tag instead. */
+	UPROPERTY(EditDefaultsOnly, Category="Condition",
+		meta=(EditCondition="Type == EFSM_TransitionConditionType::StateDataTag", EditConditionHides))
+	bool bInverse = false;
+};
+
+/**
+ * Transition a state performs on its own as soon as all the conditions are met. Evaluated by
+ * UFiniteStateMachineSubsystem.
+ */
+USTRUCT(BlueprintType)
+struct UE5FSM_API FFSM_TransitionRule
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * State to go to. Sub-states go to one of the sub-states of their parent. The rule is skipped while the state is
+	 * already active.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Transition", meta=(AllowAbstract="False"))
+	TSubclassOf<UMachineState> StateClass = nullptr;
+
+	/** Label the state starts with. */
+	UPROPERTY(EditDefaultsOnly, Category="Transition", meta=(Categories="StateMachine.Label"))
+	FGameplayTag Label = TAG_StateMachine_Label_Default;
+
+	/** Conditions that all have to be met. If empty, the transition is performed right away. */
+	UPROPERTY(EditDefaultsOnly, Category="Transition")
+	TArray<FFSM_TransitionCondition> Conditions;
+};
+
 /**
  * Finite machine's state defining behavior of an object. <br> <br>
  *
@@ -139,6 +463,36 @@ enum class EStateAction : uint8
  * information to this state.
  * - The object is created once on state registration, and destroys at the end of the state lifecycle.
  * - To define the subclass of the data object you want to use for a particular state use UMachineState::StateDataClass.
+ *
+ * # Sub-states
+ * - A state can own sub-states listed in UMachineState::SubStateClasses. They're created along with it, and one of them
+ * at a time runs within it, forming a nested state machine without any extra component or tick function.
+ * - The owning state machine ticks the active sub-state and activates its labels right after its parent, in the same
+ * tick.
+ * - The active sub-state follows the lifecycle of its parent: it begins when the parent is added to the stack, gets
+ * paused and resumed along with it, and ends when the parent is removed from the stack.
+ * - Use GotoSubState() to switch between sub-states. GotoState(), PushState() and the like still change the states of
+ * the owning state machine, even when called from a sub-state.
+ *
+ * # Regions
+ * - A state on the stack of a region of the state machine transits within that region when it uses GotoState(),
+ * EndState(), PushState(), PopState() and ClearStack(). PushStateQueued() always uses the main stack.
+ *
+ * # Transition rules
+ * - Transitions depending only on the state data and timers can be described in UMachineState::TransitionRules instead
+ * of being checked in Tick() or in labels. UFiniteStateMachineSubsystem evaluates them once per frame for all the
+ * active states of the same class at once.
+ *
+ * # Time slicing
+ * - When the state machine time-slices the ticks of its states, Tick() might not be called every frame, and its delta
+ * time covers all the frames since the previous one. States that have to react right away should set
+ * UMachineState::bIsUrgent.
+ * - When the subsystem budgets label resumptions, labels of states that are not urgent might start, and carry on after
+ * RunLatentExecution(), a few frames late.
+ *
+ * # Tick-only states
+ * - States driven only by Tick() and the events can clear UMachineState::bUsesLabels. They never activate a label, so
+ * no coroutine is created for them, and nothing has to be stopped when they're removed from the stack.
  */
 UCLASS(Abstract, Blueprintable, BlueprintType, ClassGroup=("Finite State Machine"))
 class UE5FSM_API UMachineState
@@ -153,6 +507,15 @@ public:
 	/** It queues certain users calls (GotoState, PushState, PopState) while dispatching event. */
 	friend FMS_IsDispatchingEventManager;
 
+	/** Links itself to the states it waits the actions of. */
+	friend FFSM_StateActionAwaiter;
+
+	/** Keeps track of the position of the state in the world-wide state index. */
+	friend UFiniteStateMachineSubsystem;
+
+	/** Checks the cache of the implemented blueprint events. */
+	friend FFiniteStateMachineK2EventsCacheTest;
+
 public:
 	DECLARE_DELEGATE_RetVal(
 		UE5Coro::TCoroutine<>, FLabelSignature);
@@ -162,11 +525,18 @@ public:
 		UMachineState* State,
 		EStateAction StateAction);
 
+	DECLARE_DELEGATE_ThreeParams(
+		FOnFilteredStateActionSignature,
+		UMachineState* State,
+		EStateAction StateAction,
+		TSubclassOf<UMachineState> OtherState);
+
 public:
 	UMachineState();
 	virtual ~UMachineState() override;
 
 	//~UObject Interface
+	virtual void PostInitProperties() override;
 	virtual UWorld* GetWorld() const override;
 	//~End of UObject Interface
 
@@ -200,6 +570,26 @@ public:
 	 */
 	float GetTimeSinceLastStateAction() const;
 
+	/**
+	 * Subscribe to a subset of the actions of this state. Unlike OnStateActionDelegate, the listener is only called for
+	 * the actions it's interested in.
+	 * @param	Actions actions to listen to.
+	 * @param	Delegate delegate to call when one of the actions takes place.
+	 * @param	OtherStateFilter if specified, the listener is only called when the other state taking part in the
+	 * transition is of this class. The other state is the previous one for Begin, Push, and Resume, and the next one
+	 * for End, Pop, and Pause, hence it allows filtering by the (from, to) pair.
+	 * @return	Handle used to unsubscribe.
+	 */
+	FDelegateHandle SubscribeToStateActions(EFSM_StateActionMask Actions, FOnFilteredStateActionSignature&& Delegate,
+		TSubclassOf<UMachineState> OtherStateFilter = nullptr);
+
+	/**
+	 * Remove a subscription made via SubscribeToStateActions().
+	 * @param	Handle handle returned on subscription.
+	 * @return	If true, the subscription has been removed, false otherwise.
+	 */
+	bool UnsubscribeFromStateActions(FDelegateHandle Handle);
+
 	/**
 	 * Get debug string. It will be used by the gameplay debugger category for UE5FSM.
 	 *
@@ -440,6 +830,13 @@ protected:
 	 */
 	virtual UMachineStateData* CreateStateData();
 
+	/**
+	 * Bring the state back to its initial configuration without destroying it. Called when the owning state machine is
+	 * soft reset. Override it to reset any custom runtime field.
+	 * @see		UFiniteStateMachine::SoftReset()
+	 */
+	virtual void SoftReset();
+
 private:
 	/**
 	 * Set state machine that manages this state.
@@ -458,6 +855,47 @@ private:
 	 */
 	void OnStateAction(EStateAction StateAction, TSubclassOf<UMachineState> StateClass);
 
+	/**
+	 * Stop counting the activation of the active label as deferred, if it was.
+	 */
+	void ClearDeferredLabelActivation();
+
+	/**
+	 * Charge the label that has carried on right away without waiting for the budget, as it has reached its next
+	 * latent execution.
+	 */
+	void EndLabelContinuation() const;
+
+	/**
+	 * Resume the awaiters waiting for a given action of this state.
+	 * @param	StateAction action that took place.
+	 */
+	void ResumeActionAwaiters(EStateAction StateAction);
+
+	/**
+	 * Detach all the awaiters waiting for an action of this state. They'll never be resumed.
+	 */
+	void DetachActionAwaiters();
+
+	/**
+	 * Make the active sub-state follow an action of this state.
+	 * @param	StateAction action this state went through.
+	 * @param	OtherState other state taking part in the transition.
+	 */
+	void UpdateSubStates(EStateAction StateAction, TSubclassOf<UMachineState> OtherState);
+
+	/**
+	 * Check whether the state is on the stack according to the last action it went through.
+	 * @return	If true, the state is on the stack, false otherwise.
+	 */
+	bool IsOnStack() const;
+
+	/**
+	 * Check whether the state is on the stack and not paused according to the last action it went through.
+	 * @return	If true, the state is running, false otherwise.
+	 */
+	bool IsRunning() const;
+
 	/**
 	 * Check whether this state can safely be deactivated.
 	 * @return	True if it can, false otherwise.
@@ -548,9 +986,12 @@ public:
 	 * @param	OutHandle output parameter. Push request handle used to interact with the request.
 	 * @param	InStateClass state to push.
 	 * @param	Label label to start the state at.
+	 * @param	Priority priority of the request in the queue.
+	 * @param	Timeout time in seconds after which the queued request is canceled. Zero or less to never cancel it.
 	 */
 	UE5Coro::TCoroutine<> PushStateQueued(FFSM_PushRequestHandle& OutHandle,
-		TSubclassOf<UMachineState> InStateClass, FGameplayTag Label = TAG_StateMachine_Label_Default);
+		TSubclassOf<UMachineState> InStateClass, FGameplayTag Label = TAG_StateMachine_Label_Default,
+		int32 Priority = 0, float Timeout = 0.f);
 
 	/**
 	 * Pop the top-most state from stack. If there's any state below this in the stack, it'll resume its execution.
@@ -574,6 +1015,12 @@ public:
 	 */
 	bool ContainsLabel(FGameplayTag Label) const;
 
+	/**
+	 * Get all the labels registered in this state.
+	 * @param	OutLabels output parameter. Registered labels.
+	 */
+	void GetRegisteredLabels(TArray<FGameplayTag>& OutLabels) const;
+
 	/**
 	 * Check whether a given tag is valid for a label.
 	 * @param	Tag tag to check for validness.
@@ -581,6 +1028,87 @@ public:
 	 */
 	static bool IsLabelTagCorrect(FGameplayTag Tag);
 
+	/**
+	 * Check whether the blocklist of this state blocks a given state.
+	 * @param	InStateClass state to check.
+	 * @return	If true, the state is blocked, false otherwise.
+	 */
+	bool IsStateBlocklisted(TSubclassOf<UMachineState> InStateClass) const;
+
+	/**
+	 * Check whether the allowlist of this state allows a given state.
+	 * @param	InStateClass state to check.
+	 * @return	If true, the state is allowed, false otherwise.
+	 */
+	bool IsStateAllowlisted(TSubclassOf<UMachineState> InStateClass) const;
+
+	/**
+	 * Get the transitions this state declares to perform.
+	 * @return	Declared transitions. If empty, the state may perform any transition it's allowed to.
+	 */
+	const TArray<FFSM_TransitionDeclaration>& GetDeclaredTransitions() const;
+
+	/**
+	 * Get the transitions this state performs on its own once their conditions are met.
+	 * @return	Transition rules in order of priority.
+	 */
+	const TArray<FFSM_TransitionRule>& GetTransitionRules() const;
+
+	/**
+	 * Check whether this state has to be ticked every frame even when the ticks of the state machine are time-sliced.
+	 * @return	If true, the state is urgent, false otherwise.
+	 */
+	bool IsUrgent() const;
+
+	/**
+	 * Check whether this state activates labels.
+	 * @return	If true, the state activates labels, false if it's driven only by its tick and events.
+	 */
+	bool UsesLabels() const;
+
+	/**
+	 * Activate a sub-state at a specified label. If there's any active sub-state, it'll be ended. If this state is not
+	 * on the stack, the sub-state is only chosen to start with once it's added to it.
+	 * @param	InStateClass sub-state to go to.
+	 * @param	Label label to start the sub-state with.
+	 * @param	bForceEvents in case of switching to the same sub-state we're in: If true, fire end & begin events,
+	 * otherwise do not.
+	 * @return	If true, sub-state has been successfully switched, false otherwise.
+	 */
+	bool GotoSubState(TSubclassOf<UMachineState> InStateClass, FGameplayTag Label = TAG_StateMachine_Label_Default,
+		bool bForceEvents = true);
+
+	/**
+	 * End the active sub-state, leaving this state without any.
+	 * @return	If true, a sub-state has ended, false otherwise.
+	 */
+	bool EndSubState();
+
+	/**
+	 * Get the sub-state running within this state.
+	 * @return	Active sub-state. Nullptr if there's none.
+	 */
+	UMachineState* GetActiveSubState() const;
+
+	/**
+	 * Find a sub-state of this state.
+	 * @param	InStateClass sub-state class to search for. Its subclasses are taken in account.
+	 * @return	Sub-state. Nullptr if there's no such sub-state.
+	 */
+	UMachineState* FindSubState(TSubclassOf<UMachineState> InStateClass) const;
+
+	/**
+	 * Get the state owning this one.
+	 * @return	Parent state. Nullptr if this state is registered directly in the state machine.
+	 */
+	UMachineState* GetParentState() const;
+
+	/**
+	 * Get the region of the state machine this state is on the stack of.
+	 * @return	Region tag. Empty if the state is not in any region.
+	 */
+	FGameplayTag GetRegion() const;
+
 #pragma region Utilities
 
 public:
@@ -634,7 +1162,44 @@ private:
 	/** Delegate to execute when an event has dispatched. It's intended to be used only by the FSM. */
 	FSimpleDelegate OnFinishedDispatchingEvent;
 
-private:
+	/** Blueprint events that can be skipped when they're not implemented by the class of the state. */
+	enum class EK2Event : uint8
+	{
+		OnBegan,
+		OnEnded,
+		OnPushed,
+		OnPopped,
+		OnResumed,
+		OnPaused,
+		OnActivated,
+		OnDeactivated,
+		OnAddedToStack
+	};
+
+	/**
+	 * Find out which blueprint events a class implements. The result is cached per class. In editor, the cache is
+	 * cleared whenever objects are reinstanced, as blueprint classes keep their identity when they're recompiled.
+	 * @param	InClass class to check.
+	 * @return	Mask where each bit tells whether the event of the same index is implemented.
+	 */
+	static uint16 GetImplementedK2Events(const UClass* InClass);
+
+	/**
+	 * Check whether the class of this state implements a given blueprint event.
+	 * @param	Event event to check.
+	 * @return	If true, the event has to be called, false otherwise.
+	 */
+	bool IsK2EventImplemented(EK2Event Event) const;
+
+	struct FStateActionSubscription
+	{
+	public:
+		FOnFilteredStateActionSignature Delegate;
+		TSubclassOf<UMachineState> OtherStateFilter = nullptr;
+		EFSM_StateActionMask Actions = EFSM_StateActionMask::None;
+		bool bIsRemoved = false;
+	};
+
 	struct FLatentExecution
 	{
 	public:
@@ -663,6 +1228,54 @@ protected:
 	UPROPERTY(EditDefaultsOnly, Category="State Transition", meta=(AllowAbstract="False", EditCondition="bUseBlockList"))
 	TArray<TSubclassOf<UMachineState>> StatesBlocklist;
 
+	/**
+	 * Transitions this state performs, i.e. GOTO_STATE, PUSH_STATE and GOTO_LABEL usages. It's used only by the static
+	 * analysis of the archetypes the state is in, and doesn't restrict anything at runtime. If empty, the state is
+	 * assumed to be able to perform any transition it's allowed to.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="State Transition")
+	TArray<FFSM_TransitionDeclaration> DeclaredTransitions;
+
+	/**
+	 * Transitions this state performs on its own while it's active, once all the conditions of one of them are met. The
+	 * first rule in order whose conditions are met wins. They're evaluated once per frame for all the active states of
+	 * the same class at once, which is cheaper than checking the same conditions in the tick of each state.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="State Transition")
+	TArray<FFSM_TransitionRule> TransitionRules;
+
+	/**
+	 * If true, this state is ticked every frame even when the state machine time-slices the ticks of its states, e.g.
+	 * combat states that have to react right away, false otherwise.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Tick")
+	bool bIsUrgent = false;
+
+	/**
+	 * If true, this state activates its labels, false if it's driven only by its tick and events. Labels can't be
+	 * registered nor gone to when it's false, and the state doesn't create nor keep track of any coroutine for them.
+	 * The default label is not registered either; it's still accepted by the transitions, there's just nothing to
+	 * activate.
+	 * @note	Has to be set in the constructor before registering labels, if any.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Labels")
+	bool bUsesLabels = true;
+
+	/** States this state owns. One of them at a time runs within this state while it's active. */
+	UPROPERTY(EditDefaultsOnly, Category="Sub States", meta=(AllowAbstract="False"))
+	TArray<TSubclassOf<UMachineState>> SubStateClasses;
+
+	/**
+	 * Sub-state to start with when this state is added to the stack. If not specified, it won't have any unless
+	 * GotoSubState() is used.
+	 */
+	UPROPERTY(EditDefaultsOnly, Category="Sub States", meta=(AllowAbstract="False"))
+	TSubclassOf<UMachineState> InitialSubState = nullptr;
+
+	/** Label the initial sub-state starts with. */
+	UPROPERTY(EditDefaultsOnly, Category="Sub States", meta=(Categories="StateMachine.Label"))
+	FGameplayTag InitialSubStateLabel = TAG_StateMachine_Label_Default;
+
 	/** Reference to the base state data object. It's intended to be downcasted to get the subclasses version. */
 	UPROPERTY()
 	TObjectPtr<UMachineStateData> BaseStateData = nullptr;
@@ -681,6 +1294,9 @@ private:
 	/** If true, UMachineState::ActiveLabel has been activated, false otherwise. */
 	bool bLabelActivated = false;
 
+	/** If true, the activation of UMachineState::ActiveLabel waits for the label resumption budget, false otherwise. */
+	bool bIsLabelActivationDeferred = false;
+
 	/** Handles associated with the coroutines used by this state. */
 	TArray<TPair<UE5Coro::TCoroutine<>, FString>> RunningLabels;
 
@@ -704,6 +1320,45 @@ private:
 
 	/** If true, an event is currently dispatching, false otherwise. */
 	bool bIsDispatchingEvent = false;
+
+	/** Index of this state in the archetype of the owning state machine. INDEX_NONE if it's not a part of it. */
+	int32 ArchetypeIndex = INDEX_NONE;
+
+	/** Index of the state machine region this state is on the stack of. */
+	int32 RegionIndex = INDEX_NONE;
+
+	/** Sub-states created out of SubStateClasses by the owning state machine. */
+	UPROPERTY()
+	TArray<TObjectPtr<UMachineState>> SubStates;
+
+	/** Sub-state running within this state, or the one to start with if this state is not on the stack. */
+	UPROPERTY()
+	TObjectPtr<UMachineState> ActiveSubState = nullptr;
+
+	/** State owning this one. Nullptr if this state is registered directly in the state machine. */
+	UPROPERTY()
+	TObjectPtr<UMachineState> ParentState = nullptr;
+
+	/**
+	 * Blueprint events implemented by the class of this state. Calls to the other ones are skipped, as they'd go through
+	 * ProcessEvent for nothing. All of them are called until the state is registered.
+	 */
+	uint16 ImplementedK2Events = MAX_uint16;
+
+	/** Index of this state in the list of active states of the world-wide state index. */
+	int32 ActiveIndexSlot = INDEX_NONE;
+
+	/** Index of this state in the list of states on the stack of the world-wide state index. */
+	int32 StackIndexSlot = INDEX_NONE;
+
+	/** Intrusive list of the awaiters waiting for an action of this state. They live in the awaiting coroutines. */
+	FFSM_StateActionWaitNode* ActionWaitNodesHead = nullptr;
+	FFSM_StateActionWaitNode* ActionWaitNodesTail = nullptr;
+
+	/** Serial given to the last linked wait node. Used to not resume the nodes linked while an action is handled. */
+	uint32 ActionWaitNodesSerial = 0;
+	/** Subscriptions made via SubscribeToStateActions(). */
+	TFSM_StateActionListeners<FStateActionSubscription> StateActionSubscriptions;
 };
 
 template<typename TFunction, typename... TArgs>
@@ -734,6 +1389,9 @@ UE5Coro::TCoroutine<> UMachineState::RunLatentExecutionExt(TFunction Function, F
 	// Save debug data
 	LatentExecutionWrapper->DebugData = DebugInfo;
 
+	// A label that has carried on right away ends its budgeted part here
+	EndLabelContinuation();
+
 #ifdef FSM_EXTREME_VERBOSITY
 	UE_LOG(LogFiniteStateMachine, VeryVerbose, TEXT("%s"), *GetDebugString(LatentExecutionWrapper.DebugData));
 #endif
@@ -751,6 +1409,9 @@ UE5Coro::TCoroutine<> UMachineState::RunLatentExecutionExt(TFunction Function, F
 	// Wait until either the latent execution terminates or we're explicitly cancelled
 	co_await Race(LatentExecution, RunLatentExecution_ExternalCancellation(LatentExecutionWrapper->CancelDelegate));
 
+	// Carry on only if there's budget for it this frame
+	co_await FFSM_LabelResumptionAwaiter(this);
+
 	// Wait until the state becomes active (if not already) or invalid
 	co_await UE5Coro::Latent::Until([this]
 	{
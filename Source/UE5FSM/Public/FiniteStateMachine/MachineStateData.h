@@ -17,5 +17,12 @@ class UE5FSM_API UMachineStateData
 	GENERATED_BODY()
 
 public:
-	// Empty
+	/**
+	 * Bring the data back to its initial values. Called when the owning state is soft reset.
+	 *
+	 * By default, every property is copied from the archetype. Instanced objects are never shared with the archetype;
+	 * the ones owned by the data are reset the same way instead, while the others are duplicated out of the archetype
+	 * ones. Override it if the data contains anything else that must not be shallow copied.
+	 */
+	virtual void ResetData();
 };
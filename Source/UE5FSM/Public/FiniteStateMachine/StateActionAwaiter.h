@@ -0,0 +1,140 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include <coroutine>
+#include "FiniteStateMachine/MachineState.h"
+
+class FFSM_StateActionAwaiter;
+
+/**
+ * State and the actions of it to wait for.
+ */
+struct UE5FSM_API FFSM_StateActionTarget
+{
+public:
+	FFSM_StateActionTarget() = default;
+	FFSM_StateActionTarget(UMachineState* InState, EFSM_StateActionMask InActions)
+		: State(InState)
+		, Actions(InActions)
+	{
+	}
+
+public:
+	UMachineState* State = nullptr;
+	EFSM_StateActionMask Actions = EFSM_StateActionMask::None;
+};
+
+/**
+ * Result of waiting for state actions.
+ */
+struct UE5FSM_API FFSM_StateActionWaitResult
+{
+public:
+	/** Index of the target whose action has resumed the awaiter. INDEX_NONE if there was nothing to wait for. */
+	int32 TargetIndex = INDEX_NONE;
+
+	/** Action that has resumed the awaiter. */
+	EStateAction StateAction = EStateAction::None;
+};
+
+/**
+ * Node of the intrusive list of awaiters each machine state keeps. It's stored inside the awaiter.
+ */
+struct UE5FSM_API FFSM_StateActionWaitNode
+{
+public:
+	UMachineState* State = nullptr;
+	EFSM_StateActionMask Actions = EFSM_StateActionMask::None;
+	FFSM_StateActionAwaiter* Awaiter = nullptr;
+	FFSM_StateActionWaitNode* Prev = nullptr;
+	FFSM_StateActionWaitNode* Next = nullptr;
+	uint32 Serial = 0;
+	bool bIsLinked = false;
+};
+
+/**
+ * Awaiter resuming the coroutine only once a state performs one of the requested actions.
+ *
+ * Unlike awaiting UMachineState::OnStateActionDelegate in a loop, the coroutine isn't woken up by the actions it's not
+ * interested in. The awaiter doesn't allocate as long as it waits for up to 4 states: it links itself to the states it
+ * waits for, and the states resume it directly.
+ *
+ * Examples:
+ * - const FFSM_StateActionWaitResult Result = co_await FFSM_StateActionAwaiter(State, EFSM_StateActionMask::Pop |
+ * EFSM_StateActionMask::End);
+ * - co_await FFSM_StateActionAwaiter::WhenAll({ { LeaderState, EFSM_StateActionMask::End },
+ * { FollowerState, EFSM_StateActionMask::End } });
+ *
+ * @note	The coroutine is not resumed if the waited state gets destroyed before performing the action.
+ */
+class UE5FSM_API FFSM_StateActionAwaiter
+{
+public:
+	/** Resumes the awaiter when one of its states performs an action. */
+	friend UMachineState;
+
+public:
+	/**
+	 * Wait for any of the actions of a single state.
+	 * @param	InState state to wait the actions of.
+	 * @param	InActions actions to wait for.
+	 */
+	FFSM_StateActionAwaiter(UMachineState* InState, EFSM_StateActionMask InActions);
+
+	FFSM_StateActionAwaiter(FFSM_StateActionAwaiter&& Other);
+	FFSM_StateActionAwaiter(const FFSM_StateActionAwaiter&) = delete;
+	FFSM_StateActionAwaiter& operator=(const FFSM_StateActionAwaiter&) = delete;
+	FFSM_StateActionAwaiter& operator=(FFSM_StateActionAwaiter&&) = delete;
+	~FFSM_StateActionAwaiter();
+
+	/**
+	 * Wait until any of the targets performs any of its actions.
+	 * @param	Targets states, possibly owned by different state machines, and the actions to wait for.
+	 * @return	Awaiter. The result tells the target that has resumed it.
+	 */
+	static FFSM_StateActionAwaiter WhenAny(TConstArrayView<FFSM_StateActionTarget> Targets);
+
+	/**
+	 * Wait until each target performs any of its actions.
+	 * @param	Targets states, possibly owned by different state machines, and the actions to wait for.
+	 * @return	Awaiter. The result tells the last target that has performed its action.
+	 */
+	static FFSM_StateActionAwaiter WhenAll(TConstArrayView<FFSM_StateActionTarget> Targets);
+
+	//~Awaiter Interface
+	bool await_ready() const;
+	void await_suspend(std::coroutine_handle<> InHandle);
+	FFSM_StateActionWaitResult await_resume() const;
+	//~End of Awaiter Interface
+
+private:
+	FFSM_StateActionAwaiter(TConstArrayView<FFSM_StateActionTarget> Targets, bool bInWaitAll);
+
+	/**
+	 * Called by the state a node is linked to when it performs one of the node's actions.
+	 * @param	Node node whose action took place.
+	 * @param	StateAction action that took place.
+	 */
+	void OnNodeTriggered(FFSM_StateActionWaitNode& Node, EStateAction StateAction);
+
+	void AddNode(UMachineState* InState, EFSM_StateActionMask InActions);
+	void LinkNode(FFSM_StateActionWaitNode& Node);
+	static void UnlinkNode(FFSM_StateActionWaitNode& Node);
+	void UnlinkNodes();
+
+private:
+	/** One node per waited state. */
+	TArray<FFSM_StateActionWaitNode, TInlineAllocator<4>> Nodes;
+
+	/** Coroutine to resume. */
+	std::coroutine_handle<> Handle;
+
+	FFSM_StateActionWaitResult Result;
+
+	/** Amount of nodes whose action has taken place. */
+	int32 TriggeredNodesNum = 0;
+
+	/** If true, the awaiter waits for every node, false otherwise. */
+	bool bWaitAll = false;
+};
@@ -0,0 +1,422 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include <type_traits>
+#include "Containers/Array.h"
+#include "Templates/Tuple.h"
+#include "Templates/IntegerSequence.h"
+
+/**
+ * Base of the states of TStateMachine. The events are not virtual; a state hides the ones it's interested in by
+ * declaring them with the same signature, and the machine calls them statically.
+ *
+ * State indices passed to the events are INDEX_NONE if there's no such state.
+ * @see		TStateMachine::GetStateIndex()
+ */
+template <typename MachineType>
+struct TMachineState
+{
+public:
+	/**
+	 * Called when state starts the execution.
+	 */
+	void OnBegan(MachineType& Machine, int32 OldStateIndex)
+	{
+	}
+
+	/**
+	 * Called when state terminates the execution.
+	 */
+	void OnEnded(MachineType& Machine, int32 NewStateIndex)
+	{
+	}
+
+	/**
+	 * Called when state gets pushed to the state stack.
+	 * @note	When state is pushed, Begin is not called.
+	 */
+	void OnPushed(MachineType& Machine, int32 OldStateIndex)
+	{
+	}
+
+	/**
+	 * Called when state gets popped from the state stack.
+	 * @note	When state is popped, End is not called.
+	 */
+	void OnPopped(MachineType& Machine, int32 NewStateIndex)
+	{
+	}
+
+	/**
+	 * Called when another state got popped from the stack, leaving us be the top-most one.
+	 */
+	void OnResumed(MachineType& Machine, int32 OldStateIndex)
+	{
+	}
+
+	/**
+	 * Called when another state got pushed when we were the top-most one.
+	 */
+	void OnPaused(MachineType& Machine, int32 NewStateIndex)
+	{
+	}
+
+	/**
+	 * Called each time the machine is ticked while the state is the active one.
+	 */
+	void Tick(MachineType& Machine, float DeltaTime)
+	{
+	}
+};
+
+namespace UE5FSM::Private
+{
+	/** Amount of times a state type is listed among the state types of a machine. */
+	template <typename StateType, typename... StateTypes>
+	inline constexpr int32 TStateTypeNum = (0 + ... + (std::is_same_v<StateType, StateTypes> ? 1 : 0));
+}
+
+/**
+ * Finite state machine whose states are known at compile time, meant for hot systems, e.g. weapons or movement modes,
+ * that don't need the reflection, labels and latent execution of UFiniteStateMachine.
+ *
+ * # States
+ * - Each state type is instantiated once inside the machine, just like UFiniteStateMachine instantiates each registered
+ * state once, and keeps its data between activations.
+ * - Events have the same semantics as the ones of UMachineState, and are dispatched statically.
+ *
+ * # Memory
+ * - The states, the stack and the pending transitions are stored inline; the machine never allocates.
+ *
+ * # Transitions
+ * - Transitions requested from the events are performed once the current one has been performed, in order. Up to
+ * MaxPendingTransitions of them can follow a single transition requested from outside.
+ *
+ * @code
+ * struct FWeaponState_Idle;
+ * struct FWeaponState_Firing;
+ * using FWeaponStateMachine = TStateMachine<FWeaponState_Idle, FWeaponState_Firing>;
+ *
+ * struct FWeaponState_Firing : public TMachineState<FWeaponStateMachine>
+ * {
+ *     void Tick(FWeaponStateMachine& Machine, float DeltaTime);
+ * };
+ * @endcode
+ */
+template <typename... StateTypes>
+class TStateMachine
+{
+public:
+	/** Amount of states the machine contains. */
+	static constexpr int32 StatesNum = sizeof...(StateTypes);
+
+	/** Maximum amount of transitions requested from the events that can be pending at once. */
+	static constexpr int32 MaxPendingTransitions = 8;
+
+	static_assert(StatesNum > 0, "State machine has to contain at least a single state.");
+	static_assert(StatesNum <= MAX_int8, "State machine contains too many states.");
+	static_assert(((UE5FSM::Private::TStateTypeNum<StateTypes, StateTypes...> == 1) && ...),
+		"State machine contains the same state type more than once.");
+
+public:
+	TStateMachine() = default;
+
+	// States may refer to the machine, hence it can't be moved around
+	TStateMachine(const TStateMachine&) = delete;
+	TStateMachine& operator=(const TStateMachine&) = delete;
+
+	/**
+	 * Get the index of a state type.
+	 * @return	State index.
+	 */
+	template <typename StateType>
+	static constexpr int32 GetStateIndex()
+	{
+		constexpr bool Matches[] = { std::is_same_v<StateType, StateTypes>... };
+		for (int32 i = 0; i < StatesNum; i++)
+		{
+			if (Matches[i])
+			{
+				return i;
+			}
+		}
+
+		return INDEX_NONE;
+	}
+
+	/**
+	 * Get the instance of a state.
+	 * @return	State.
+	 */
+	template <typename StateType>
+	StateType& GetState()
+	{
+		constexpr int32 StateIndex = GetStateIndex<StateType>();
+		static_assert(StateIndex != INDEX_NONE, "State is not contained by the state machine.");
+		return States.template Get<StateIndex>();
+	}
+
+	/**
+	 * Activate a state. The active state ends, and the new one takes its place on the stack. Going to the active state
+	 * does nothing.
+	 * @return	If true, the transition has been performed or queued, false otherwise.
+	 */
+	template <typename StateType>
+	bool GotoState()
+	{
+		constexpr int32 StateIndex = GetStateIndex<StateType>();
+		static_assert(StateIndex != INDEX_NONE, "State is not contained by the state machine.");
+		return RequestTransition(ETransitionType::Goto, StateIndex);
+	}
+
+	/**
+	 * Push a state on top of the stack. The active state gets paused.
+	 * @return	If true, the transition has been performed or queued, false otherwise.
+	 */
+	template <typename StateType>
+	bool PushState()
+	{
+		constexpr int32 StateIndex = GetStateIndex<StateType>();
+		static_assert(StateIndex != INDEX_NONE, "State is not contained by the state machine.");
+		return RequestTransition(ETransitionType::Push, StateIndex);
+	}
+
+	/**
+	 * Pop the active state. The state below it, if any, gets resumed.
+	 * @return	If true, the transition has been performed or queued, false otherwise.
+	 */
+	bool PopState()
+	{
+		return RequestTransition(ETransitionType::Pop, INDEX_NONE);
+	}
+
+	/**
+	 * Tick the active state.
+	 * @param	DeltaTime time since the previous tick.
+	 */
+	void Tick(float DeltaTime)
+	{
+		if (StackDepth > 0)
+		{
+			VisitState(GetActiveStateIndex(), [this, DeltaTime] (auto& State)
+			{
+				State.Tick(*this, DeltaTime);
+			});
+		}
+	}
+
+	/**
+	 * Get the index of the active state.
+	 * @return	State index. INDEX_NONE if there's no active state.
+	 */
+	int32 GetActiveStateIndex() const
+	{
+		return StackDepth > 0 ? Stack[StackDepth - 1] : INDEX_NONE;
+	}
+
+	/**
+	 * Check whether a given state is active.
+	 * @param	bCheckStack if true, paused states are taken in account as well, otherwise only the active one is.
+	 * @return	If true, the state machine is in the state, false otherwise.
+	 */
+	template <typename StateType>
+	bool IsInState(bool bCheckStack = false) const
+	{
+		constexpr int32 StateIndex = GetStateIndex<StateType>();
+		static_assert(StateIndex != INDEX_NONE, "State is not contained by the state machine.");
+		return bCheckStack ? IsOnStack(StateIndex) : GetActiveStateIndex() == StateIndex;
+	}
+
+	/**
+	 * Get the amount of states on the stack.
+	 * @return	Stack depth.
+	 */
+	int32 GetStackDepth() const
+	{
+		return StackDepth;
+	}
+
+private:
+	/** Kind of a transition request. */
+	enum class ETransitionType : uint8
+	{
+		Goto,
+		Push,
+		Pop
+	};
+
+	/** Transition requested from an event. */
+	struct FTransitionRequest
+	{
+	public:
+		ETransitionType Type = ETransitionType::Goto;
+		int32 StateIndex = INDEX_NONE;
+	};
+
+	/**
+	 * Perform a transition, or queue it if another one is being performed.
+	 * @param	Type kind of the transition.
+	 * @param	StateIndex state to go to or push.
+	 * @return	If true, the transition has been performed or queued, false otherwise.
+	 */
+	bool RequestTransition(ETransitionType Type, int32 StateIndex)
+	{
+		if (bIsTransitioning)
+		{
+			if (!ensureMsgf(PendingTransitions.Num() < MaxPendingTransitions,
+				TEXT("Too many transitions have been requested from the events.")))
+			{
+				return false;
+			}
+
+			PendingTransitions.Add({ Type, StateIndex });
+			return true;
+		}
+
+		bIsTransitioning = true;
+		const bool bResult = ApplyTransition(Type, StateIndex);
+
+		// Transitions requested from the events might request more of them
+		for (int32 i = 0; i < PendingTransitions.Num(); i++)
+		{
+			ApplyTransition(PendingTransitions[i].Type, PendingTransitions[i].StateIndex);
+		}
+
+		PendingTransitions.Reset();
+		bIsTransitioning = false;
+
+		return bResult;
+	}
+
+	/**
+	 * Perform a transition and dispatch its events.
+	 * @param	Type kind of the transition.
+	 * @param	StateIndex state to go to or push.
+	 * @return	If true, the transition has been performed, false otherwise.
+	 */
+	bool ApplyTransition(ETransitionType Type, int32 StateIndex)
+	{
+		const int32 OldStateIndex = GetActiveStateIndex();
+
+		switch (Type)
+		{
+		case ETransitionType::Goto:
+			if (OldStateIndex == StateIndex)
+			{
+				return true;
+			}
+
+			// Each state has a single instance
+			if (IsOnStack(StateIndex))
+			{
+				return false;
+			}
+
+			if (OldStateIndex != INDEX_NONE)
+			{
+				VisitState(OldStateIndex, [this, StateIndex] (auto& State) { State.OnEnded(*this, StateIndex); });
+				Stack[StackDepth - 1] = static_cast<int8>(StateIndex);
+			}
+			else
+			{
+				Stack[StackDepth++] = static_cast<int8>(StateIndex);
+			}
+
+			VisitState(StateIndex, [this, OldStateIndex] (auto& State) { State.OnBegan(*this, OldStateIndex); });
+			return true;
+
+		case ETransitionType::Push:
+			if (IsOnStack(StateIndex))
+			{
+				return false;
+			}
+
+			if (OldStateIndex != INDEX_NONE)
+			{
+				VisitState(OldStateIndex, [this, StateIndex] (auto& State) { State.OnPaused(*this, StateIndex); });
+			}
+
+			Stack[StackDepth++] = static_cast<int8>(StateIndex);
+			VisitState(StateIndex, [this, OldStateIndex] (auto& State) { State.OnPushed(*this, OldStateIndex); });
+			return true;
+
+		case ETransitionType::Pop:
+			if (OldStateIndex == INDEX_NONE)
+			{
+				return false;
+			}
+
+			StackDepth--;
+			const int32 ResumedStateIndex = GetActiveStateIndex();
+
+			VisitState(OldStateIndex, [this, ResumedStateIndex] (auto& State)
+			{
+				State.OnPopped(*this, ResumedStateIndex);
+			});
+
+			if (ResumedStateIndex != INDEX_NONE)
+			{
+				VisitState(ResumedStateIndex, [this, OldStateIndex] (auto& State)
+				{
+					State.OnResumed(*this, OldStateIndex);
+				});
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	/**
+	 * Check whether a state is on the stack.
+	 * @param	StateIndex state to check.
+	 * @return	If true, the state is either active or paused, false otherwise.
+	 */
+	bool IsOnStack(int32 StateIndex) const
+	{
+		for (int32 i = 0; i < StackDepth; i++)
+		{
+			if (Stack[i] == StateIndex)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * Call a function with the instance of a state. The state type is resolved without any virtual call.
+	 * @param	StateIndex state to call the function with.
+	 * @param	Function generic function taking the state.
+	 */
+	template <typename FunctionType>
+	void VisitState(int32 StateIndex, FunctionType&& Function)
+	{
+		VisitState_Implementation(StateIndex, Function, TMakeIntegerSequence<int32, StatesNum>());
+	}
+
+	template <typename FunctionType, int32... Indices>
+	void VisitState_Implementation(int32 StateIndex, FunctionType& Function, TIntegerSequence<int32, Indices...>)
+	{
+		((StateIndex == Indices ? (Function(States.template Get<Indices>()), true) : false) || ...);
+	}
+
+private:
+	/** Instances of the states in the same order as the state types. */
+	TTuple<StateTypes...> States;
+
+	/** Indices of the states on the stack. The last one is the active state. */
+	int8 Stack[StatesNum] = {};
+
+	/** Amount of states on the stack. */
+	int32 StackDepth = 0;
+
+	/** Transitions requested from the events while performing another one. */
+	TArray<FTransitionRequest, TFixedAllocator<MaxPendingTransitions>> PendingTransitions;
+
+	/** Whether a transition is being performed. */
+	bool bIsTransitioning = false;
+};
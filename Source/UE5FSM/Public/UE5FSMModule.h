@@ -7,6 +7,7 @@
 #include "NativeGameplayTags.h"
 
 UE5FSM_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_StateMachine_Label_Test);
+UE5FSM_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_StateMachine_Region_Test);
 
 class FUE5FSMModule
     : public IModuleInterface
@@ -0,0 +1,77 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/FiniteStateMachineAnalysisCommandlet.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "FiniteStateMachine/FiniteStateMachineArchetype.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogFiniteStateMachineAnalysis, Log, All);
+
+UFiniteStateMachineAnalysisCommandlet::UFiniteStateMachineAnalysisCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UFiniteStateMachineAnalysisCommandlet::Main(const FString& Params)
+{
+	const bool bWarningsAsErrors = FParse::Param(*Params, TEXT("WarningsAsErrors"));
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssetsByClass(UFiniteStateMachineArchetype::StaticClass()->GetClassPathName(), Assets, true);
+
+	bool bFailedToLoad = false;
+	TArray<UFiniteStateMachineArchetype*> Archetypes;
+	Archetypes.Reserve(Assets.Num());
+	for (const FAssetData& AssetData : Assets)
+	{
+		auto* Archetype = Cast<UFiniteStateMachineArchetype>(AssetData.GetAsset());
+		if (!IsValid(Archetype))
+		{
+			UE_LOG(LogFiniteStateMachineAnalysis, Error, TEXT("Failed to load finite state machine archetype [%s]."),
+				*AssetData.GetObjectPathString());
+			bFailedToLoad = true;
+			continue;
+		}
+
+		Archetypes.Add(Archetype);
+	}
+
+	const int32 Result = AnalyzeArchetypes(Archetypes, bWarningsAsErrors);
+	return bFailedToLoad ? 1 : Result;
+}
+
+int32 UFiniteStateMachineAnalysisCommandlet::AnalyzeArchetypes(
+	TConstArrayView<UFiniteStateMachineArchetype*> Archetypes, bool bWarningsAsErrors)
+{
+	int32 ErrorsNum = 0;
+	int32 WarningsNum = 0;
+	for (UFiniteStateMachineArchetype* Archetype : Archetypes)
+	{
+		Archetype->Compile();
+
+		for (const FString& Error : Archetype->GetValidationErrors())
+		{
+			UE_LOG(LogFiniteStateMachineAnalysis, Error, TEXT("[%s] %s"), *Archetype->GetPathName(), *Error);
+		}
+
+		for (const FString& Warning : Archetype->GetValidationWarnings())
+		{
+			UE_LOG(LogFiniteStateMachineAnalysis, Warning, TEXT("[%s] %s"), *Archetype->GetPathName(), *Warning);
+		}
+
+		ErrorsNum += Archetype->GetValidationErrors().Num();
+		WarningsNum += Archetype->GetValidationWarnings().Num();
+	}
+
+	UE_LOG(LogFiniteStateMachineAnalysis, Display, TEXT("Analyzed finite state machine archetypes [%d] Errors [%d] "
+		"Warnings [%d]"), Archetypes.Num(), ErrorsNum, WarningsNum);
+
+	const bool bFailed = ErrorsNum > 0 || (bWarningsAsErrors && WarningsNum > 0);
+	return bFailed ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+﻿// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "UE5FSMEditor.h"
+
+#define LOCTEXT_NAMESPACE "FUE5FSMEditorModule"
+
+void FUE5FSMEditorModule::StartupModule()
+{
+}
+
+void FUE5FSMEditorModule::ShutdownModule()
+{
+}
+
+#undef LOCTEXT_NAMESPACE
+
+IMPLEMENT_MODULE(FUE5FSMEditorModule, UE5FSMEditor)
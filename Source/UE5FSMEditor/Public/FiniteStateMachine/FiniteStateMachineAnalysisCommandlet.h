@@ -0,0 +1,41 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+
+#include "FiniteStateMachineAnalysisCommandlet.generated.h"
+
+class UFiniteStateMachineArchetype;
+
+/**
+ * Compile every finite state machine archetype in the project and report the issues found by the transition graph
+ * analysis. Meant to be run as a part of the cook or CI pipeline.
+ *
+ * # Usage
+ * - UnrealEditor-Cmd.exe Project.uproject -run=FiniteStateMachineAnalysis [-WarningsAsErrors]
+ *
+ * # Return value
+ * - 0 if no errors have been found, 1 otherwise. If -WarningsAsErrors is specified, warnings are treated as errors.
+ */
+UCLASS()
+class UE5FSMEDITOR_API UFiniteStateMachineAnalysisCommandlet
+	: public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UFiniteStateMachineAnalysisCommandlet();
+
+	//~UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~End of UCommandlet Interface
+
+	/**
+	 * Compile given archetypes and log the issues found in them.
+	 * @param	Archetypes archetypes to analyze.
+	 * @param	bWarningsAsErrors if true, warnings are treated as errors, false otherwise.
+	 * @return	0 if no errors have been found, 1 otherwise.
+	 */
+	static int32 AnalyzeArchetypes(TConstArrayView<UFiniteStateMachineArchetype*> Archetypes, bool bWarningsAsErrors);
+};
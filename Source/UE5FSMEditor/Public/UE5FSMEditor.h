@@ -0,0 +1,16 @@
+﻿// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+
+class FUE5FSMEditorModule
+    : public IModuleInterface
+{
+public:
+    //~IModuleInterface Interface
+    virtual void StartupModule() override;
+    virtual void ShutdownModule() override;
+    //~End of IModuleInterface Interface
+};
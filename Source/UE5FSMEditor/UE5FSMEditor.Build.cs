@@ -0,0 +1,28 @@
+﻿// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+using UnrealBuildTool;
+
+public class UE5FSMEditor : ModuleRules
+{
+    public UE5FSMEditor(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "CoreUObject",
+                "Engine",
+                "UE5FSM",
+            }
+        );
+
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "AssetRegistry",
+            }
+        );
+    }
+}
@@ -3,8 +3,27 @@
 #include "FiniteStateMachineTestObject.h"
 
 #include "FiniteStateMachine/FiniteStateMachine.h"
+#include "UObject/UObjectArray.h"
 
 AFiniteStateMachineTestActor::AFiniteStateMachineTestActor()
 {
 	StateMachine = CreateDefaultSubobject<UFiniteStateMachine>("FiniteStateMachine");
 }
+
+bool AFiniteStateMachineClusterTestActor::CanBeClusterRoot() const
+{
+	return true;
+}
+
+bool AFiniteStateMachineClusterTestActor::IsInCluster(const UObject* Object) const
+{
+	const FUObjectItem* RootItem = GUObjectArray.ObjectToObjectItem(this);
+	if (!Object || !RootItem || !RootItem->HasAnyFlags(EInternalObjectFlags::ClusterRoot))
+	{
+		return false;
+	}
+
+	const FUObjectCluster& Cluster = GUObjectClusters[RootItem->GetClusterIndex()];
+	const int32 ObjectIndex = GUObjectArray.ObjectToIndex(Object);
+	return Cluster.Objects.Contains(ObjectIndex) || Cluster.MutableObjects.Contains(ObjectIndex);
+}
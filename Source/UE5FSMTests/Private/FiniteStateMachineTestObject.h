@@ -21,3 +21,26 @@ public:
 	UPROPERTY()
 	TObjectPtr<UFiniteStateMachine> StateMachine = nullptr;
 };
+
+/**
+ * Test actor that can be the root of a GC cluster even though it's spawned at runtime, just like the actors placed in a
+ * level are when they're loaded.
+ */
+UCLASS(MinimalAPI, Hidden)
+class AFiniteStateMachineClusterTestActor
+	: public AFiniteStateMachineTestActor
+{
+	GENERATED_BODY()
+
+public:
+	//~UObject Interface
+	virtual bool CanBeClusterRoot() const override;
+	//~End of UObject Interface
+
+	/**
+	 * Check whether an object is in the GC cluster of this actor, either as a regular or as a mutable object.
+	 * @param	Object object to check.
+	 * @return	If true, the object is in the cluster, false otherwise.
+	 */
+	bool IsInCluster(const UObject* Object) const;
+};
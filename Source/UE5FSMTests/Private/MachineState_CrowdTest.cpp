@@ -0,0 +1,81 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "MachineState_CrowdTest.h"
+
+#include "UE5FSMModule.h"
+
+int32 UCrowdMachineState_Test::GetBeganNum() const
+{
+	return BeganNum;
+}
+
+int32 UCrowdMachineState_Test::GetEndedNum() const
+{
+	return EndedNum;
+}
+
+int32 UCrowdMachineState_Test::GetPausedNum() const
+{
+	return PausedNum;
+}
+
+int32 UCrowdMachineState_Test::GetResumedNum() const
+{
+	return ResumedNum;
+}
+
+void UCrowdMachineState_Test::OnBegan(const FFSM_CrowdChunk& Chunk)
+{
+	Super::OnBegan(Chunk);
+	BeganNum += Chunk.Num();
+}
+
+void UCrowdMachineState_Test::OnEnded(const FFSM_CrowdChunk& Chunk)
+{
+	Super::OnEnded(Chunk);
+	EndedNum += Chunk.Num();
+}
+
+void UCrowdMachineState_Test::OnPaused(const FFSM_CrowdChunk& Chunk)
+{
+	Super::OnPaused(Chunk);
+	PausedNum += Chunk.Num();
+}
+
+void UCrowdMachineState_Test::OnResumed(const FFSM_CrowdChunk& Chunk)
+{
+	Super::OnResumed(Chunk);
+	ResumedNum += Chunk.Num();
+}
+
+UCrowdMachineState_Test1::UCrowdMachineState_Test1()
+{
+	REGISTER_LABEL(Test);
+}
+
+void UCrowdMachineState_Test1::Label_Default(const FFSM_CrowdChunk& Chunk)
+{
+	for (int32 i = 0; i < Chunk.Num(); i++)
+	{
+		Chunk.GotoState(i, UCrowdMachineState_Test2::StaticClass());
+	}
+}
+
+void UCrowdMachineState_Test1::Label_Test(const FFSM_CrowdChunk& Chunk)
+{
+	for (int32 i = 0; i < Chunk.Num(); i++)
+	{
+		Chunk.PopState(i);
+	}
+}
+
+void UCrowdMachineState_Test2::Label_Default(const FFSM_CrowdChunk& Chunk)
+{
+	for (int32 i = 0; i < Chunk.Num(); i++)
+	{
+		if (Chunk.GetLabelTime(i) >= PushDelay)
+		{
+			Chunk.PushState(i, UCrowdMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Test);
+		}
+	}
+}
@@ -0,0 +1,65 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/CrowdMachineState.h"
+
+#include "MachineState_CrowdTest.generated.h"
+
+UCLASS(Abstract, Hidden)
+class UCrowdMachineState_Test
+	: public UCrowdMachineState
+{
+	GENERATED_BODY()
+
+public:
+	int32 GetBeganNum() const;
+	int32 GetEndedNum() const;
+	int32 GetPausedNum() const;
+	int32 GetResumedNum() const;
+
+protected:
+	//~UCrowdMachineState Interface
+	virtual void OnBegan(const FFSM_CrowdChunk& Chunk) override;
+	virtual void OnEnded(const FFSM_CrowdChunk& Chunk) override;
+	virtual void OnPaused(const FFSM_CrowdChunk& Chunk) override;
+	virtual void OnResumed(const FFSM_CrowdChunk& Chunk) override;
+	//~End of UCrowdMachineState Interface
+
+private:
+	int32 BeganNum = 0;
+	int32 EndedNum = 0;
+	int32 PausedNum = 0;
+	int32 ResumedNum = 0;
+};
+
+UCLASS(Hidden)
+class UCrowdMachineState_Test1
+	: public UCrowdMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	UCrowdMachineState_Test1();
+
+protected:
+	//~Labels
+	virtual void Label_Default(const FFSM_CrowdChunk& Chunk) override;
+	void Label_Test(const FFSM_CrowdChunk& Chunk);
+	//~End of Labels
+};
+
+UCLASS(Hidden)
+class UCrowdMachineState_Test2
+	: public UCrowdMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr float PushDelay = 0.5f;
+
+protected:
+	//~Labels
+	virtual void Label_Default(const FFSM_CrowdChunk& Chunk) override;
+	//~End of Labels
+};
@@ -0,0 +1,12 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "MachineState_GlobalStateTest.h"
+
+void UMachineState_GlobalStateTest::OnBegan(TSubclassOf<UMachineState> OldState)
+{
+	Super::OnBegan(OldState);
+
+	// The initial state hasn't begun yet
+	const bool bSuccess = GotoState(UMachineState_Test2::StaticClass());
+	BROADCAST_TEST_MESSAGE("GotoState", bSuccess);
+}
@@ -0,0 +1,23 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "MachineState_Test.h"
+
+#include "MachineState_GlobalStateTest.generated.h"
+
+/**
+ * Global state that leaves the initial state before it has begun.
+ */
+UCLASS(Hidden)
+class UMachineState_GlobalStateTest
+	: public UMachineState_Test
+	, public IGlobalMachineStateInterface
+{
+	GENERATED_BODY()
+
+protected:
+	//~UMachineState_Test Interface
+	virtual void OnBegan(TSubclassOf<UMachineState> OldState) override;
+	//~End of UMachineState_Test Interface
+};
@@ -0,0 +1,29 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "MachineState_LabelResumptionTest.h"
+
+int32 UMachineState_LabelResumptionTest::GetResumptionsNum() const
+{
+	return ResumptionsNum;
+}
+
+uint64 UMachineState_LabelResumptionTest::GetFinishFrame() const
+{
+	return FinishFrame;
+}
+
+TCoroutine<> UMachineState_LabelResumptionTest::Label_Default()
+{
+	for (int32 i = 0; i < ExpectedResumptionsNum; i++)
+	{
+		RUN_LATENT_EXECUTION(Latent::NextTick);
+		ResumptionsNum++;
+	}
+
+	FinishFrame = GFrameCounter;
+}
+
+UMachineState_UrgentLabelResumptionTest::UMachineState_UrgentLabelResumptionTest()
+{
+	bIsUrgent = true;
+}
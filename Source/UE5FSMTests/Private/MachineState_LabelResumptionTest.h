@@ -0,0 +1,40 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "MachineState_Test.h"
+
+#include "MachineState_LabelResumptionTest.generated.h"
+
+UCLASS(Hidden)
+class UMachineState_LabelResumptionTest
+	: public UMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr int32 ExpectedResumptionsNum = 3;
+
+public:
+	int32 GetResumptionsNum() const;
+	uint64 GetFinishFrame() const;
+
+protected:
+	//~Labels
+	virtual TCoroutine<> Label_Default() override;
+	//~End of Labels
+
+private:
+	int32 ResumptionsNum = 0;
+	uint64 FinishFrame = 0;
+};
+
+UCLASS(Hidden)
+class UMachineState_UrgentLabelResumptionTest
+	: public UMachineState_LabelResumptionTest
+{
+	GENERATED_BODY()
+
+public:
+	UMachineState_UrgentLabelResumptionTest();
+};
@@ -0,0 +1,5 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "MachineState_StaticTest.h"
+
+TArray<FString> StaticTestMessages;
@@ -0,0 +1,75 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/StaticStateMachine.h"
+
+template <int32 Id>
+struct TStaticMachineState_Test;
+
+using FStaticTestStateMachine = TStateMachine<TStaticMachineState_Test<1>, TStaticMachineState_Test<2>,
+	TStaticMachineState_Test<3>>;
+
+// Defined inside MachineState_StaticTest.cpp
+extern TArray<FString> StaticTestMessages;
+
+/**
+ * Records its events. The third state goes to the first one as soon as it begins.
+ */
+template <int32 Id>
+struct TStaticMachineState_Test
+	: public TMachineState<FStaticTestStateMachine>
+{
+public:
+	void OnBegan(FStaticTestStateMachine& Machine, int32 OldStateIndex);
+
+	void OnEnded(FStaticTestStateMachine& Machine, int32 NewStateIndex)
+	{
+		AddMessage(TEXT("End"), NewStateIndex);
+	}
+
+	void OnPushed(FStaticTestStateMachine& Machine, int32 OldStateIndex)
+	{
+		AddMessage(TEXT("Pushed"), OldStateIndex);
+	}
+
+	void OnPopped(FStaticTestStateMachine& Machine, int32 NewStateIndex)
+	{
+		AddMessage(TEXT("Popped"), NewStateIndex);
+	}
+
+	void OnResumed(FStaticTestStateMachine& Machine, int32 OldStateIndex)
+	{
+		AddMessage(TEXT("Resumed"), OldStateIndex);
+	}
+
+	void OnPaused(FStaticTestStateMachine& Machine, int32 NewStateIndex)
+	{
+		AddMessage(TEXT("Paused"), NewStateIndex);
+	}
+
+	void Tick(FStaticTestStateMachine& Machine, float DeltaTime)
+	{
+		TicksNum++;
+	}
+
+private:
+	void AddMessage(const TCHAR* Event, int32 OtherStateIndex)
+	{
+		StaticTestMessages.Add(FString::Printf(TEXT("Test%d %s %d"), Id, Event, OtherStateIndex));
+	}
+
+public:
+	int32 TicksNum = 0;
+};
+
+// Defined after the state, as it needs the state machine to be complete
+template <int32 Id>
+void TStaticMachineState_Test<Id>::OnBegan(FStaticTestStateMachine& Machine, int32 OldStateIndex)
+{
+	AddMessage(TEXT("Begin"), OldStateIndex);
+	if constexpr (Id == 3)
+	{
+		Machine.GotoState<TStaticMachineState_Test<1>>();
+	}
+}
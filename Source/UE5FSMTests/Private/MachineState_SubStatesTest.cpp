@@ -0,0 +1,20 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "MachineState_SubStatesTest.h"
+
+int32 UMachineState_SubStateTest::GetTicksNum() const
+{
+	return TicksNum;
+}
+
+void UMachineState_SubStateTest::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+	TicksNum++;
+}
+
+UMachineState_SubStatesTest::UMachineState_SubStatesTest()
+{
+	SubStateClasses = { UMachineState_SubStateTest1::StaticClass(), UMachineState_SubStateTest2::StaticClass() };
+	InitialSubState = UMachineState_SubStateTest1::StaticClass();
+}
@@ -0,0 +1,49 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "MachineState_Test.h"
+
+#include "MachineState_SubStatesTest.generated.h"
+
+UCLASS(Abstract, Hidden)
+class UMachineState_SubStateTest
+	: public UMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	int32 GetTicksNum() const;
+
+protected:
+	//~UMachineState_Test Interface
+	virtual void Tick(float DeltaSeconds) override;
+	//~End of UMachineState_Test Interface
+
+private:
+	int32 TicksNum = 0;
+};
+
+UCLASS(Hidden)
+class UMachineState_SubStateTest1
+	: public UMachineState_SubStateTest
+{
+	GENERATED_BODY()
+};
+
+UCLASS(Hidden)
+class UMachineState_SubStateTest2
+	: public UMachineState_SubStateTest
+{
+	GENERATED_BODY()
+};
+
+UCLASS(Hidden)
+class UMachineState_SubStatesTest
+	: public UMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	UMachineState_SubStatesTest();
+};
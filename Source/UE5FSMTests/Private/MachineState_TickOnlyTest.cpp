@@ -0,0 +1,43 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "MachineState_TickOnlyTest.h"
+
+UMachineState_TickOnlyTest::UMachineState_TickOnlyTest()
+{
+	bUsesLabels = false;
+}
+
+int32 UMachineState_TickOnlyTest::GetTicksNum() const
+{
+	return TicksNum;
+}
+
+int32 UMachineState_TickOnlyTest::GetRunningLabelsNum() const
+{
+	return RunningLabels.Num();
+}
+
+bool UMachineState_TickOnlyTest::RegisterTestLabel()
+{
+	return REGISTER_LABEL(Test);
+}
+
+void UMachineState_TickOnlyTest::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+	TicksNum++;
+}
+
+TCoroutine<> UMachineState_TickOnlyTest::Label_Default()
+{
+	// Labels are never activated for this state
+	BROADCAST_TEST_MESSAGE("Label", false);
+	co_return;
+}
+
+TCoroutine<> UMachineState_TickOnlyTest::Label_Test()
+{
+	// Labels can't be registered for this state
+	BROADCAST_TEST_MESSAGE("Label", false);
+	co_return;
+}
@@ -0,0 +1,34 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "MachineState_Test.h"
+
+#include "MachineState_TickOnlyTest.generated.h"
+
+UCLASS(Hidden)
+class UMachineState_TickOnlyTest
+	: public UMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	UMachineState_TickOnlyTest();
+
+	int32 GetTicksNum() const;
+	int32 GetRunningLabelsNum() const;
+	bool RegisterTestLabel();
+
+protected:
+	//~UMachineState_Test Interface
+	virtual void Tick(float DeltaSeconds) override;
+	virtual TCoroutine<> Label_Default() override;
+	//~End of UMachineState_Test Interface
+
+	//~Labels
+	TCoroutine<> Label_Test();
+	//~End of Labels
+
+private:
+	int32 TicksNum = 0;
+};
@@ -0,0 +1,31 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "MachineState_TimeSlicingTest.h"
+
+int32 UMachineState_TimeSlicingTest::GetTicksNum() const
+{
+	return TicksNum;
+}
+
+float UMachineState_TimeSlicingTest::GetTickedTime() const
+{
+	return TickedTime;
+}
+
+float UMachineState_TimeSlicingTest::GetMaxDeltaSeconds() const
+{
+	return MaxDeltaSeconds;
+}
+
+void UMachineState_TimeSlicingTest::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+	TicksNum++;
+	TickedTime += DeltaSeconds;
+	MaxDeltaSeconds = FMath::Max(MaxDeltaSeconds, DeltaSeconds);
+}
+
+UMachineState_UrgentTest::UMachineState_UrgentTest()
+{
+	bIsUrgent = true;
+}
@@ -0,0 +1,46 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "MachineState_Test.h"
+
+#include "MachineState_TimeSlicingTest.generated.h"
+
+UCLASS(Abstract, Hidden)
+class UMachineState_TimeSlicingTest
+	: public UMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	int32 GetTicksNum() const;
+	float GetTickedTime() const;
+	float GetMaxDeltaSeconds() const;
+
+protected:
+	//~UMachineState_Test Interface
+	virtual void Tick(float DeltaSeconds) override;
+	//~End of UMachineState_Test Interface
+
+private:
+	int32 TicksNum = 0;
+	float TickedTime = 0.f;
+	float MaxDeltaSeconds = 0.f;
+};
+
+UCLASS(Hidden)
+class UMachineState_TimeSlicedTest
+	: public UMachineState_TimeSlicingTest
+{
+	GENERATED_BODY()
+};
+
+UCLASS(Hidden)
+class UMachineState_UrgentTest
+	: public UMachineState_TimeSlicingTest
+{
+	GENERATED_BODY()
+
+public:
+	UMachineState_UrgentTest();
+};
@@ -0,0 +1,35 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "MachineState_TransitionGraphTest.h"
+
+#include "UE5FSMModule.h"
+
+UMachineState_TransitionGraphTest1::UMachineState_TransitionGraphTest1()
+{
+	RegisterLabel(TAG_StateMachine_Label_Test, FLabelSignature::CreateUObject(this, &ThisClass::Label_Test));
+
+	FFSM_TransitionDeclaration& Declaration = DeclaredTransitions.AddDefaulted_GetRef();
+	Declaration.StateClass = UMachineState_TransitionGraphTest2::StaticClass();
+}
+
+TCoroutine<> UMachineState_TransitionGraphTest1::Label_Test()
+{
+	co_return;
+}
+
+UMachineState_TransitionGraphTest2::UMachineState_TransitionGraphTest2()
+{
+	StatesBlocklist.Add(UMachineState_TransitionGraphTest3::StaticClass());
+
+	FFSM_TransitionDeclaration& BackDeclaration = DeclaredTransitions.AddDefaulted_GetRef();
+	BackDeclaration.StateClass = UMachineState_TransitionGraphTest1::StaticClass();
+
+	FFSM_TransitionDeclaration& BlockedDeclaration = DeclaredTransitions.AddDefaulted_GetRef();
+	BlockedDeclaration.StateClass = UMachineState_TransitionGraphTest3::StaticClass();
+}
+
+UMachineState_TransitionGraphTest3::UMachineState_TransitionGraphTest3()
+{
+	FFSM_TransitionDeclaration& Declaration = DeclaredTransitions.AddDefaulted_GetRef();
+	Declaration.StateClass = UMachineState_TransitionGraphTest1::StaticClass();
+}
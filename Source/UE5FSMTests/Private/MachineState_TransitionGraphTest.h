@@ -0,0 +1,51 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "MachineState_Test.h"
+
+#include "MachineState_TransitionGraphTest.generated.h"
+
+/**
+ * Declares a transition to the second state only. Its test label is never transited to.
+ */
+UCLASS(Hidden)
+class UMachineState_TransitionGraphTest1
+	: public UMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	UMachineState_TransitionGraphTest1();
+
+protected:
+	//~Labels
+	TCoroutine<> Label_Test();
+	//~End of Labels
+};
+
+/**
+ * Declares transitions back to the first state, and to the third state which its blocklist disallows.
+ */
+UCLASS(Hidden)
+class UMachineState_TransitionGraphTest2
+	: public UMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	UMachineState_TransitionGraphTest2();
+};
+
+/**
+ * Not reachable from any other state.
+ */
+UCLASS(Hidden)
+class UMachineState_TransitionGraphTest3
+	: public UMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	UMachineState_TransitionGraphTest3();
+};
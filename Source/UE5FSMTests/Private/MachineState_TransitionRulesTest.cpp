@@ -0,0 +1,38 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "MachineState_TransitionRulesTest.h"
+
+#include "UE5FSMModule.h"
+
+UMachineState_TransitionRulesTest::UMachineState_TransitionRulesTest()
+{
+	StateDataClass = UMachineStateData_TransitionRulesTest::StaticClass();
+
+	// Always met, but the state is already active; it must neither restart the state nor shadow the other rules
+	FFSM_TransitionRule& SelfRule = TransitionRules.AddDefaulted_GetRef();
+	SelfRule.StateClass = StaticClass();
+
+	// Go to Test2 when the health is low
+	FFSM_TransitionRule& HealthRule = TransitionRules.AddDefaulted_GetRef();
+	HealthRule.StateClass = UMachineState_Test2::StaticClass();
+
+	FFSM_TransitionCondition& HealthCondition = HealthRule.Conditions.AddDefaulted_GetRef();
+	HealthCondition.Type = EFSM_TransitionConditionType::StateDataNumber;
+	HealthCondition.PropertyName = GET_MEMBER_NAME_CHECKED(UMachineStateData_TransitionRulesTest, Health);
+	HealthCondition.Operator = EFSM_ComparisonOperator::Less;
+	HealthCondition.Value = 50.f;
+
+	// Go to Test3 when tagged, once the state has been active for a while
+	FFSM_TransitionRule& TagRule = TransitionRules.AddDefaulted_GetRef();
+	TagRule.StateClass = UMachineState_Test3::StaticClass();
+
+	FFSM_TransitionCondition& TagCondition = TagRule.Conditions.AddDefaulted_GetRef();
+	TagCondition.Type = EFSM_TransitionConditionType::StateDataTag;
+	TagCondition.PropertyName = GET_MEMBER_NAME_CHECKED(UMachineStateData_TransitionRulesTest, Tags);
+	TagCondition.Tag = TAG_StateMachine_Label_Test;
+
+	FFSM_TransitionCondition& TimeCondition = TagRule.Conditions.AddDefaulted_GetRef();
+	TimeCondition.Type = EFSM_TransitionConditionType::TimeSinceLastStateAction;
+	TimeCondition.Operator = EFSM_ComparisonOperator::GreaterOrEqual;
+	TimeCondition.Value = 0.f;
+}
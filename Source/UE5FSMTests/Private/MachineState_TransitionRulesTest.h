@@ -0,0 +1,32 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/MachineStateData.h"
+#include "MachineState_Test.h"
+
+#include "MachineState_TransitionRulesTest.generated.h"
+
+UCLASS(Hidden)
+class UMachineStateData_TransitionRulesTest
+	: public UMachineStateData
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY()
+	float Health = 100.f;
+
+	UPROPERTY()
+	FGameplayTagContainer Tags;
+};
+
+UCLASS(Hidden)
+class UMachineState_TransitionRulesTest
+	: public UMachineState_Test
+{
+	GENERATED_BODY()
+
+public:
+	UMachineState_TransitionRulesTest();
+};
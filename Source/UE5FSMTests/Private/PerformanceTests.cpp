@@ -0,0 +1,379 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#if WITH_EDITOR
+
+#include "FiniteStateMachine/CrowdStateMachineSubsystem.h"
+#include "FiniteStateMachine/FiniteStateMachine.h"
+#include "FiniteStateMachine/MachineStateData.h"
+#include "FiniteStateMachine/StaticStateMachine.h"
+#include "FiniteStateMachineTestObject.h"
+#include "MachineState_CrowdTest.h"
+#include "MachineState_Test.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "Tests/AutomationEditorCommon.h"
+#include "UObject/UObjectArray.h"
+
+/**
+ * Performance tests are not meant to validate the behavior, but to output the timings to compare them between changes.
+ * Results are added as info messages to the automation test report.
+ */
+
+static UWorld* GetPerformanceTestWorld()
+{
+	const FWorldContext* WorldContext = GEditor->GetPIEWorldContext();
+	return WorldContext ? WorldContext->World() : nullptr;
+}
+
+/**
+ * Spawn agents having a few states each.
+ * @param	World world to spawn the agents in.
+ * @param	AgentsNum amount of agents to spawn.
+ * @param	bClusterAgents if true, agents are made GC cluster roots before registering their states, just like the ones
+ * placed in a level are, false otherwise.
+ * @param	bAddStatesToCluster if true, the states of clustered agents are added to their clusters, false otherwise.
+ * @return	Spawned agents.
+ */
+static TArray<AFiniteStateMachineTestActor*> SpawnPerformanceTestAgents(UWorld* World, int32 AgentsNum,
+	bool bClusterAgents = false, bool bAddStatesToCluster = true)
+{
+	TArray<AFiniteStateMachineTestActor*> Agents;
+	Agents.Reserve(AgentsNum);
+
+	for (int32 i = 0; i < AgentsNum; i++)
+	{
+		AFiniteStateMachineTestActor* Agent = bClusterAgents
+			? World->SpawnActor<AFiniteStateMachineClusterTestActor>()
+			: World->SpawnActor<AFiniteStateMachineTestActor>();
+		if (!IsValid(Agent))
+		{
+			continue;
+		}
+
+		if (bClusterAgents)
+		{
+			Agent->CreateCluster();
+		}
+
+		UFiniteStateMachine* StateMachine = Agent->StateMachine;
+		StateMachine->SetAddStatesToOwnerCluster(bAddStatesToCluster);
+		StateMachine->RegisterState(UMachineState_Test1::StaticClass());
+		StateMachine->RegisterState(UMachineState_Test2::StaticClass());
+		StateMachine->RegisterState(UMachineState_Test3::StaticClass());
+		StateMachine->GotoState(UMachineState_Test1::StaticClass());
+
+		Agents.Add(Agent);
+	}
+
+	return Agents;
+}
+
+static void DestroyPerformanceTestAgents(TArray<AFiniteStateMachineTestActor*>& Agents)
+{
+	for (AFiniteStateMachineTestActor* Agent : Agents)
+	{
+		if (IsValid(Agent))
+		{
+			Agent->Destroy();
+		}
+	}
+
+	Agents.Empty();
+}
+
+/**
+ * Measure the average time a full garbage collection takes.
+ * @param	Iterations amount of garbage collections to average.
+ * @return	Average time in seconds.
+ */
+static double MeasureGarbageCollection(int32 Iterations)
+{
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+	const double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+	}
+
+	return (FPlatformTime::Seconds() - StartTime) / Iterations;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FMeasureGarbageCollection,
+	FAutomationTestBase*, Test, int32, AgentsNum, int32, Iterations);
+bool FMeasureGarbageCollection::Update()
+{
+	UWorld* World = GetPerformanceTestWorld();
+	if (!Test->TestNotNull("PIE world", World))
+	{
+		return true;
+	}
+
+	// Take the base line without any agent
+	const double BaseLineTime = MeasureGarbageCollection(Iterations);
+
+	// Spawned actors are never clustered by the engine, hence the agents create their clusters just like the ones
+	// placed in a level would have, otherwise the states would never be added to any cluster
+	double AgentsTimes[2] = {};
+	for (const bool bAddStatesToCluster : { false, true })
+	{
+		TArray<AFiniteStateMachineTestActor*> Agents =
+			SpawnPerformanceTestAgents(World, AgentsNum, true, bAddStatesToCluster);
+		Test->TestEqual("All agents have been spawned", Agents.Num(), AgentsNum);
+
+		int32 FSMObjectsNum = 0;
+		int32 ClusteredFSMObjectsNum = 0;
+		for (TObjectIterator<UObject> It; It; ++It)
+		{
+			if (It->IsA<UMachineState>() || It->IsA<UMachineStateData>())
+			{
+				FSMObjectsNum++;
+
+				// States are added as mutable objects, which don't store the index of the cluster they are in
+				const auto* Agent = Cast<AFiniteStateMachineClusterTestActor>(It->GetTypedOuter<AActor>());
+				if (Agent && Agent->IsInCluster(*It))
+				{
+					ClusteredFSMObjectsNum++;
+				}
+			}
+		}
+
+		if (bAddStatesToCluster)
+		{
+			Test->TestTrue("States have been added to the clusters of their owners", ClusteredFSMObjectsNum > 0);
+		}
+		else
+		{
+			Test->TestEqual("States have not been added to any cluster", ClusteredFSMObjectsNum, 0);
+		}
+
+		// States must stay reachable whether they're in the cluster or not
+		const TWeakObjectPtr<UMachineState> State = Agents.IsEmpty()
+			? nullptr : Agents[0]->StateMachine->GetState<UMachineState_Test1>();
+
+		const double AgentsTime = MeasureGarbageCollection(Iterations);
+		AgentsTimes[bAddStatesToCluster] = AgentsTime;
+
+		Test->TestTrue("States have not been garbage collected", Agents.IsEmpty() || State.IsValid());
+
+		Test->AddInfo(FString::Printf(TEXT("Clustered states [%s] Agents [%d] FSM objects [%d] clustered FSM "
+			"objects [%d] GC base line [%.3fms] GC with agents [%.3fms] FSM agents cost [%.3fms]"),
+			bAddStatesToCluster ? TEXT("on") : TEXT("off"), Agents.Num(), FSMObjectsNum, ClusteredFSMObjectsNum,
+			BaseLineTime * 1000.0, AgentsTime * 1000.0, (AgentsTime - BaseLineTime) * 1000.0));
+
+		DestroyPerformanceTestAgents(Agents);
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+	}
+
+	Test->AddInfo(FString::Printf(TEXT("Clustering states saves [%.3fms] per GC"),
+		(AgentsTimes[false] - AgentsTimes[true]) * 1000.0));
+
+	return true;
+}
+
+struct FStaticPerformanceState1;
+struct FStaticPerformanceState2;
+using FStaticPerformanceStateMachine = TStateMachine<FStaticPerformanceState1, FStaticPerformanceState2>;
+
+struct FStaticPerformanceState1
+	: public TMachineState<FStaticPerformanceStateMachine>
+{
+public:
+	void OnBegan(FStaticPerformanceStateMachine& Machine, int32 OldStateIndex)
+	{
+		BeganNum++;
+	}
+
+public:
+	int32 BeganNum = 0;
+};
+
+struct FStaticPerformanceState2
+	: public TMachineState<FStaticPerformanceStateMachine>
+{
+public:
+	void OnBegan(FStaticPerformanceStateMachine& Machine, int32 OldStateIndex)
+	{
+		BeganNum++;
+	}
+
+public:
+	int32 BeganNum = 0;
+};
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FMeasureStaticStateMachine,
+	FAutomationTestBase*, Test, int32, Iterations);
+bool FMeasureStaticStateMachine::Update()
+{
+	UWorld* World = GetPerformanceTestWorld();
+	if (!Test->TestNotNull("PIE world", World))
+	{
+		return true;
+	}
+
+	// Test states broadcast their events; nobody has to listen to them
+	OnMessageDelegate.Clear();
+
+	TArray<AFiniteStateMachineTestActor*> Agents = SpawnPerformanceTestAgents(World, 1);
+	if (!Test->TestEqual("Agent has been spawned", Agents.Num(), 1))
+	{
+		return true;
+	}
+
+	UFiniteStateMachine* StateMachine = Agents[0]->StateMachine;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		StateMachine->GotoState(i % 2 == 0 ? UMachineState_Test2::StaticClass() : UMachineState_Test1::StaticClass());
+	}
+	const double ObjectTime = FPlatformTime::Seconds() - StartTime;
+
+	FStaticPerformanceStateMachine StaticStateMachine;
+	StaticStateMachine.GotoState<FStaticPerformanceState1>();
+
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		if (i % 2 == 0)
+		{
+			StaticStateMachine.GotoState<FStaticPerformanceState2>();
+		}
+		else
+		{
+			StaticStateMachine.GotoState<FStaticPerformanceState1>();
+		}
+	}
+	const double StaticTime = FPlatformTime::Seconds() - StartTime;
+
+	// Keep the loop from being optimized away
+	Test->TestEqual("Static states have began", StaticStateMachine.GetState<FStaticPerformanceState1>().BeganNum +
+		StaticStateMachine.GetState<FStaticPerformanceState2>().BeganNum, Iterations + 1);
+
+	Test->AddInfo(FString::Printf(TEXT("Transitions [%d] UObject FSM [%.1fns] static FSM [%.1fns] per transition, "
+		"static FSM size [%d bytes]"), Iterations, ObjectTime * 1e9 / Iterations, StaticTime * 1e9 / Iterations,
+		static_cast<int32>(sizeof(FStaticPerformanceStateMachine))));
+
+	DestroyPerformanceTestAgents(Agents);
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FMeasureCrowd,
+	FAutomationTestBase*, Test, int32, AgentsNum, int32, Iterations);
+bool FMeasureCrowd::Update()
+{
+	UWorld* World = GetPerformanceTestWorld();
+	if (!Test->TestNotNull("PIE world", World))
+	{
+		return true;
+	}
+
+	UCrowdStateMachineSubsystem* Subsystem = UCrowdStateMachineSubsystem::Get(World);
+	if (!Test->TestNotNull("Crowd subsystem", Subsystem))
+	{
+		return true;
+	}
+
+	double StartTime = FPlatformTime::Seconds();
+	TArray<FFSM_CrowdAgentHandle> Agents;
+	Agents.Reserve(AgentsNum);
+	for (int32 i = 0; i < AgentsNum; i++)
+	{
+		Agents.Add(Subsystem->AddAgent(UCrowdMachineState_Test1::StaticClass()));
+	}
+	const double AddTime = FPlatformTime::Seconds() - StartTime;
+
+	Test->TestEqual("All agents have been added", Subsystem->GetAgentsNum(), AgentsNum);
+
+	// Long enough for the agents to go through every state and label of the test states
+	constexpr float DeltaTime = 1.f / 60.f;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		Subsystem->Tick(DeltaTime);
+	}
+	const double TickTime = (FPlatformTime::Seconds() - StartTime) / Iterations;
+
+	StartTime = FPlatformTime::Seconds();
+	for (const FFSM_CrowdAgentHandle Agent : Agents)
+	{
+		Subsystem->RemoveAgent(Agent);
+	}
+	const double RemoveTime = FPlatformTime::Seconds() - StartTime;
+
+	Test->TestEqual("All agents have been removed", Subsystem->GetAgentsNum(), 0);
+
+	Test->AddInfo(FString::Printf(TEXT("Crowd agents [%d] add [%.3fms] tick [%.3fms] per frame [%.1fns] per agent, "
+		"remove [%.3fms]"), AgentsNum, AddTime * 1000.0, TickTime * 1000.0, TickTime * 1e9 / AgentsNum,
+		RemoveTime * 1000.0));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineGarbageCollectionPerformanceTest,
+	"UE5FSM.Performance.GarbageCollection",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::PerfFilter);
+
+bool FFiniteStateMachineGarbageCollectionPerformanceTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 AgentsNum = 10000;
+	constexpr int32 Iterations = 10;
+
+	// Setup environment
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FMeasureGarbageCollection(this, AgentsNum, Iterations));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStaticStateMachinePerformanceTest,
+	"UE5FSM.Performance.StaticStateMachine",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::PerfFilter);
+
+bool FFiniteStateMachineStaticStateMachinePerformanceTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 Iterations = 100000;
+
+	// Setup environment
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FMeasureStaticStateMachine(this, Iterations));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineCrowdPerformanceTest,
+	"UE5FSM.Performance.Crowd",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::PerfFilter);
+
+bool FFiniteStateMachineCrowdPerformanceTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 AgentsNum = 100000;
+	constexpr int32 Iterations = 120;
+
+	// Setup environment
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FMeasureCrowd(this, AgentsNum, Iterations));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+#endif
@@ -2,17 +2,42 @@
 
 #if WITH_EDITOR
 
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Blueprint.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "FiniteStateMachine/CrowdStateMachineSubsystem.h"
 #include "FiniteStateMachine/FiniteStateMachine.h"
+#include "FiniteStateMachine/FiniteStateMachineAnalysisCommandlet.h"
+#include "FiniteStateMachine/FiniteStateMachineArchetype.h"
+#include "FiniteStateMachine/FiniteStateMachineSubsystem.h"
+#include "FiniteStateMachine/MassCrowdBackend.h"
+#include "FiniteStateMachine/MassStateMachineProcessor.h"
 #include "FiniteStateMachineTestObject.h"
+#include "K2Node_Event.h"
+#include "Kismet2/BlueprintEditorUtils.h"
+#include "Kismet2/KismetEditorUtilities.h"
 #include "MachineState_BlockedPushTest.h"
+#include "MachineState_CrowdTest.h"
 #include "MachineState_ExternalPushPopTest.h"
 #include "MachineState_ExternalPushTest.h"
+#include "MachineState_GlobalStateTest.h"
+#include "MachineState_LabelResumptionTest.h"
 #include "MachineState_LatentActions.h"
 #include "MachineState_LatentTest.h"
 #include "MachineState_PushPopTest.h"
 #include "MachineState_StartWithNotDefaultLabel.h"
+#include "MachineState_StaticTest.h"
 #include "MachineState_StatesBlocklistTest.h"
+#include "MachineState_SubStatesTest.h"
+#include "MachineState_TickOnlyTest.h"
+#include "MachineState_TimeSlicingTest.h"
+#include "MachineState_TransitionGraphTest.h"
+#include "MachineState_TransitionRulesTest.h"
+#include "MassEntityManager.h"
+#include "MassExecutor.h"
 #include "Misc/AutomationTest.h"
+#include "Misc/DataValidation.h"
 #include "Tests/AutomationCommon.h"
 #include "Tests/AutomationEditorCommon.h"
 #include "UE5FSMModule.h"
@@ -292,128 +317,2258 @@ bool FPopState_Fail::Update()
 	return true;
 }
 
-DEFINE_LATENT_AUTOMATION_COMMAND_FOUR_PARAMETER(FWaitPushPopMessage, FAutomationTestBase*, Test, FString, Message,
-	float, MaxDuration, bool, bFirstIteration);
-bool FWaitPushPopMessage::Update()
+DEFINE_LATENT_AUTOMATION_COMMAND_FOUR_PARAMETER(FTryGotoState,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor, TSubclassOf<UMachineState>, StateClass,
+	EFSM_TransitionResult, ExpectedResult);
+bool FTryGotoState::Update()
 {
-	// This command supports only one execution at a time
-	// This is a little hack as it would take a bit more time to make it work properly :(
-	constexpr float InvalidTime = -1.f;
-	static float BeginTime = InvalidTime;
-	static bool bGotMessage = false;
+	LATENT_TEST_BEGIN();
+	Test->TestTrue("Can go to state", StateMachine->CanGotoState(StateClass) == ExpectedResult);
+	Test->TestTrue("Try go to state", StateMachine->TryGotoState(StateClass) == ExpectedResult);
+	return true;
+}
 
-	if (bGotMessage)
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FTryPopState,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor, EFSM_TransitionResult, ExpectedResult);
+bool FTryPopState::Update()
+{
+	LATENT_TEST_BEGIN();
+	Test->TestTrue("Can pop state", StateMachine->CanPopState() == ExpectedResult);
+	Test->TestTrue("Try pop state", StateMachine->TryPopState() == ExpectedResult);
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FPostTransitionCommands,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FPostTransitionCommands::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	// Post the commands in random order from worker threads; the sort key must make the result deterministic
+	constexpr int32 CommandsNum = 64;
+	ParallelFor(CommandsNum, [StateMachine] (int32 Index)
 	{
-		bGotMessage = false;
-		BeginTime = InvalidTime;
-		return true;
+		FFSM_TransitionCommand Command;
+		Command.Type = EFSM_TransitionCommandType::GotoState;
+		Command.StateClass = Index % 2 == 0 ? UMachineState_Test2::StaticClass() : UMachineState_Test3::StaticClass();
+		Command.SortKey = Index;
+		StateMachine->EnqueueTransitionCommand(Command);
+	});
+
+	LATENT_TEST_TRUE("Go to states are coalesced", StateMachine->ProcessTransitionCommands() == 1);
+	LATENT_TEST_TRUE("The command of the highest sort key wins",
+		StateMachine->IsInState(UMachineState_Test3::StaticClass()));
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FPostPrioritizedTransitionCommands,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FPostPrioritizedTransitionCommands::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	// The high priority command is posted last and has a higher sort key, still it must win
+	FFSM_TransitionCommand LowPriorityCommand;
+	LowPriorityCommand.Type = EFSM_TransitionCommandType::GotoState;
+	LowPriorityCommand.StateClass = UMachineState_Test1::StaticClass();
+	LowPriorityCommand.SortKey = 0;
+	StateMachine->EnqueueTransitionCommand(LowPriorityCommand);
+
+	FFSM_TransitionCommand HighPriorityCommand;
+	HighPriorityCommand.Type = EFSM_TransitionCommandType::GotoState;
+	HighPriorityCommand.StateClass = UMachineState_Test3::StaticClass();
+	HighPriorityCommand.Priority = 10;
+	HighPriorityCommand.SortKey = 1;
+	StateMachine->EnqueueTransitionCommand(HighPriorityCommand);
+
+	LATENT_TEST_TRUE("Go to states are coalesced", StateMachine->ProcessTransitionCommands() == 1);
+	LATENT_TEST_TRUE("The high priority command wins", StateMachine->IsInState(UMachineState_Test3::StaticClass()));
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FPostTransitionCommandsWhileInactive,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FPostTransitionCommandsWhileInactive::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	StateMachine->Deactivate();
+	LATENT_TEST_FALSE("State machine is inactive", StateMachine->IsActive());
+
+	FFSM_TransitionCommand Command;
+	Command.Type = EFSM_TransitionCommandType::GotoState;
+	Command.StateClass = UMachineState_Test2::StaticClass();
+	StateMachine->EnqueueTransitionCommand(Command);
+
+	// The command must not wait for the next tick
+	StateMachine->Activate(false);
+	LATENT_TEST_TRUE("State machine is active", StateMachine->IsActive());
+	LATENT_TEST_TRUE("The command is performed on activation",
+		StateMachine->IsInState(UMachineState_Test2::StaticClass()));
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCheckStateSnapshot,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCheckStateSnapshot::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	// Read it the same way a worker thread would
+	const FFSM_StateSnapshot Snapshot = Async(EAsyncExecution::ThreadPool, [StateMachine]
+	{
+		return StateMachine->GetStateSnapshot();
+	}).Get();
+
+	const TArray<TSubclassOf<UMachineState>> RegisteredStates = StateMachine->GetRegisteredStateClasses();
+	const TArray<TSubclassOf<UMachineState>>& StatesStack = StateMachine->GetStatesStack();
+
+	LATENT_TEST_TRUE("Snapshot has been published", Snapshot.Version > 0);
+	LATENT_TEST_TRUE("Active state class", Snapshot.ActiveStateClass == StateMachine->GetActiveStateClass());
+	LATENT_TEST_TRUE("Active state index", RegisteredStates.IsValidIndex(Snapshot.ActiveStateIndex) &&
+		RegisteredStates[Snapshot.ActiveStateIndex] == StateMachine->GetActiveStateClass());
+	LATENT_TEST_TRUE("Stack depth", Snapshot.StackDepth == StatesStack.Num());
+
+	for (int32 i = 0; i < StatesStack.Num(); i++)
+	{
+		LATENT_TEST_TRUE("Stack entry", Snapshot.Stack[i] == StatesStack[i]);
+	}
+
+	LATENT_TEST_TRUE("Last state action", Snapshot.LastStateAction == EStateAction::Push);
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCoalesceGotoStates,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCoalesceGotoStates::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	// Only the last one must pay the transition cost
+	LATENT_TEST_TRUE("Request Test2", StateMachine->RequestGotoState(UMachineState_Test2::StaticClass()) ==
+		EFSM_TransitionResult::Deferred);
+	LATENT_TEST_TRUE("Request Test3", StateMachine->RequestGotoState(UMachineState_Test3::StaticClass()) ==
+		EFSM_TransitionResult::Deferred);
+	LATENT_TEST_TRUE("Nothing has changed yet", StateMachine->IsInState(UMachineState_Test1::StaticClass()));
+
+	LATENT_TEST_TRUE("Resolve", StateMachine->ResolveDeferredGotoState() == EFSM_TransitionResult::Success);
+	LATENT_TEST_TRUE("The last request wins", StateMachine->IsInState(UMachineState_Test3::StaticClass()));
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCoalesceGotoStatesByPriority,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCoalesceGotoStatesByPriority::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	StateMachine->SetGotoStateCoalescingPolicy(EFSM_GotoStateCoalescingPolicy::HighestPriority);
+
+	// The later request is less important, hence it mustn't replace the recorded one
+	LATENT_TEST_TRUE("Request Test2", StateMachine->RequestGotoState(UMachineState_Test2::StaticClass(),
+		TAG_StateMachine_Label_Default, 10) == EFSM_TransitionResult::Deferred);
+	LATENT_TEST_TRUE("Request Test1", StateMachine->RequestGotoState(UMachineState_Test1::StaticClass(),
+		TAG_StateMachine_Label_Default, 0) == EFSM_TransitionResult::Deferred);
+	LATENT_TEST_TRUE("Request is pending", StateMachine->HasDeferredGotoState());
+
+	LATENT_TEST_TRUE("Resolve", StateMachine->ResolveDeferredGotoState() == EFSM_TransitionResult::Success);
+	LATENT_TEST_FALSE("Request is resolved", StateMachine->HasDeferredGotoState());
+	LATENT_TEST_TRUE("The highest priority request wins", StateMachine->IsInState(UMachineState_Test2::StaticClass()));
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FQueuePrioritizedPushRequests,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FQueuePrioritizedPushRequests::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	StateMachine->SetPushQueuePolicy(EFSM_PushQueuePolicy::Priority);
+
+	// Test1 is active, hence pushing it again is going to stay pending
+	FFSM_PushRequestHandle LowPriorityHandle;
+	StateMachine->PushStateQueued(LowPriorityHandle, UMachineState_Test1::StaticClass(),
+		TAG_StateMachine_Label_Default, 0, 0.5f);
+	FFSM_PushRequestHandle HighPriorityHandle;
+	StateMachine->PushStateQueued(HighPriorityHandle, UMachineState_Test1::StaticClass(),
+		TAG_StateMachine_Label_Default, 10);
+
+	LATENT_TEST_TRUE("Low priority request is pending", LowPriorityHandle.IsPending());
+	LATENT_TEST_TRUE("High priority request is pending", HighPriorityHandle.IsPending());
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FCheckPendingPushRequestsNum,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor, int32, ExpectedNum);
+bool FCheckPendingPushRequestsNum::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	LATENT_TEST_TRUE("Pending push requests", StateMachine->GetPendingPushRequestsNum() == ExpectedNum);
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FClearStackWithQueuedPush,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FClearStackWithQueuedPush::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	// Test2 is on the stack, hence the request is queued
+	FFSM_PushRequestHandle Handle;
+	StateMachine->PushStateQueued(Handle, UMachineState_Test2::StaticClass());
+	LATENT_TEST_TRUE("Request is pending", Handle.IsPending());
+
+	// The request mustn't be executed in between the pops, otherwise it'd be cleared along with the rest of the stack
+	LATENT_TEST_TRUE("Every state is ended", StateMachine->ClearStack() == 3);
+	LATENT_TEST_FALSE("Request is executed", Handle.IsPending());
+	LATENT_TEST_TRUE("Test2 is active", StateMachine->IsInState(UMachineState_Test2::StaticClass()));
+	LATENT_TEST_FALSE("Test1 is not on the stack", StateMachine->IsInState(UMachineState_Test1::StaticClass(), true));
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_FOUR_PARAMETER(FPopWithBlockedPushRequests,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor, EFSM_PushQueuePolicy, Policy,
+	TSubclassOf<UMachineState>, ExpectedStateClass);
+bool FPopWithBlockedPushRequests::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	// Start from a clean queue with Test2 on top of Test1
+	StateMachine->CancelEveryPushRequest();
+	StateMachine->SetPushQueuePolicy(Policy);
+
+	bool bPushResult = false;
+	StateMachine->PushState(UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default, &bPushResult);
+	LATENT_TEST_TRUE("Push Test2", bPushResult);
+
+	// Both the states are on the stack, hence both the requests are queued; the later one is more important
+	FFSM_PushRequestHandle LowPriorityHandle;
+	StateMachine->PushStateQueued(LowPriorityHandle, UMachineState_Test2::StaticClass(),
+		TAG_StateMachine_Label_Default, 0);
+	FFSM_PushRequestHandle HighPriorityHandle;
+	StateMachine->PushStateQueued(HighPriorityHandle, UMachineState_Test1::StaticClass(),
+		TAG_StateMachine_Label_Default, 10);
+	LATENT_TEST_TRUE("Both requests are pending", StateMachine->GetPendingPushRequestsNum() == 2);
+
+	// Test2 can be pushed again once popped, but it's behind the Test1 request which stays blocked
+	LATENT_TEST_TRUE("Pop Test2", StateMachine->PopState());
+	LATENT_TEST_TRUE("High priority request is pending", HighPriorityHandle.IsPending());
+	LATENT_TEST_TRUE("Expected state is active", StateMachine->IsInState(ExpectedStateClass));
+
+	const bool bLowPriorityExecuted = ExpectedStateClass == UMachineState_Test2::StaticClass();
+	LATENT_TEST_TRUE("Low priority request", LowPriorityHandle.IsPending() != bLowPriorityExecuted);
+	LATENT_TEST_TRUE("Pending push requests",
+		StateMachine->GetPendingPushRequestsNum() == (bLowPriorityExecuted ? 1 : 2));
+
+	StateMachine->CancelEveryPushRequest();
+	if (bLowPriorityExecuted)
+	{
+		LATENT_TEST_TRUE("Pop Test2", StateMachine->PopState());
+	}
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FWaitForStateActions,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FWaitForStateActions::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UMachineState* State2 = StateMachine->GetState(UMachineState_Test2::StaticClass());
+	UMachineState* State3 = StateMachine->GetState(UMachineState_Test3::StaticClass());
+
+	// Results outlive the command, as the coroutines keep waiting if the test fails
+	static FFSM_StateActionWaitResult SingleResult;
+	static FFSM_StateActionWaitResult AnyResult;
+	SingleResult = AnyResult = FFSM_StateActionWaitResult();
+
+	const TCoroutine<> SingleWait = [](FFSM_StateActionAwaiter Awaiter, FFSM_StateActionWaitResult& OutResult)
+		-> TCoroutine<>
+	{
+		OutResult = co_await MoveTemp(Awaiter);
+	}(StateMachine->WaitForStateAction(UMachineState_Test2::StaticClass(),
+		EFSM_StateActionMask::Pop | EFSM_StateActionMask::End), SingleResult);
+
+	const TCoroutine<> AnyWait = [](FFSM_StateActionAwaiter Awaiter, FFSM_StateActionWaitResult& OutResult)
+		-> TCoroutine<>
+	{
+		OutResult = co_await MoveTemp(Awaiter);
+	}(FFSM_StateActionAwaiter::WhenAny({ { State2, EFSM_StateActionMask::End }, { State3, EFSM_StateActionMask::Push } }),
+		AnyResult);
+
+	// Pausing and resuming must not wake up the coroutine waiting for Pop or End
+	StateMachine->PushState(UMachineState_Test2::StaticClass());
+	StateMachine->PushState(UMachineState_Test3::StaticClass());
+	LATENT_TEST_TRUE("Any of the targets has been triggered", AnyWait.IsDone());
+	LATENT_TEST_TRUE("Triggered target", AnyResult.TargetIndex == 1);
+
+	StateMachine->PopState();
+	LATENT_TEST_TRUE("Still waiting", !SingleWait.IsDone());
+
+	StateMachine->PopState();
+	LATENT_TEST_TRUE("The wait is over", SingleWait.IsDone());
+	LATENT_TEST_TRUE("Triggered action", SingleResult.StateAction == EStateAction::Pop);
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FSubscribeToStateActions,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FSubscribeToStateActions::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UMachineState* State2 = StateMachine->GetState(UMachineState_Test2::StaticClass());
+
+	// Counters are shared with the listeners, as they outlive the command if it fails
+	const TSharedRef<int32> AnyCalls = MakeShared<int32>(0);
+	const FDelegateHandle AnyHandle = State2->SubscribeToStateActions(
+		EFSM_StateActionMask::Pop | EFSM_StateActionMask::End,
+		UMachineState::FOnFilteredStateActionSignature::CreateLambda(
+			[AnyCalls](UMachineState*, EStateAction, TSubclassOf<UMachineState>) { (*AnyCalls)++; }));
+
+	const TSharedRef<int32> MatchingCalls = MakeShared<int32>(0);
+	const FDelegateHandle MatchingHandle = State2->SubscribeToStateActions(EFSM_StateActionMask::Pause,
+		UMachineState::FOnFilteredStateActionSignature::CreateLambda(
+			[MatchingCalls](UMachineState*, EStateAction, TSubclassOf<UMachineState>) { (*MatchingCalls)++; }),
+		UMachineState_Test3::StaticClass());
+
+	const TSharedRef<int32> MismatchingCalls = MakeShared<int32>(0);
+	const FDelegateHandle MismatchingHandle = State2->SubscribeToStateActions(EFSM_StateActionMask::Pause,
+		UMachineState::FOnFilteredStateActionSignature::CreateLambda(
+			[MismatchingCalls](UMachineState*, EStateAction, TSubclassOf<UMachineState>) { (*MismatchingCalls)++; }),
+		UMachineState_Test1::StaticClass());
+
+	// The listener keeps using its captures after unsubscribing, hence it must not be destroyed while it's called
+	const TSharedRef<FDelegateHandle> SelfHandle = MakeShared<FDelegateHandle>();
+	const TSharedRef<int32> SelfCalls = MakeShared<int32>(0);
+	*SelfHandle = State2->SubscribeToStateActions(EFSM_StateActionMask::Pop,
+		UMachineState::FOnFilteredStateActionSignature::CreateLambda(
+			[SelfHandle, SelfCalls](UMachineState* State, EStateAction, TSubclassOf<UMachineState>)
+			{
+				State->UnsubscribeFromStateActions(*SelfHandle);
+				(*SelfCalls)++;
+			}));
+
+	// Pausing by pushing Test3 passes only one of the filters, while pushing and resuming aren't listened to at all
+	StateMachine->PushState(UMachineState_Test2::StaticClass());
+	StateMachine->PushState(UMachineState_Test3::StaticClass());
+	StateMachine->PopState();
+	LATENT_TEST_TRUE("Not interested listeners are not called", *AnyCalls == 0 && *MismatchingCalls == 0);
+	LATENT_TEST_TRUE("Matching filter lets the action through", *MatchingCalls == 1);
+
+	StateMachine->PopState();
+	LATENT_TEST_TRUE("Pop has been listened to", *AnyCalls == 1);
+	LATENT_TEST_TRUE("Self-removing listener has been called", *SelfCalls == 1);
+
+	LATENT_TEST_TRUE("Unsubscribe", State2->UnsubscribeFromStateActions(AnyHandle));
+	LATENT_TEST_TRUE("Unsubscribe", State2->UnsubscribeFromStateActions(MatchingHandle));
+	LATENT_TEST_TRUE("Unsubscribe", State2->UnsubscribeFromStateActions(MismatchingHandle));
+	LATENT_TEST_FALSE("Self-removing listener is gone", State2->UnsubscribeFromStateActions(*SelfHandle));
+
+	StateMachine->PushState(UMachineState_Test2::StaticClass());
+	StateMachine->PopState();
+	LATENT_TEST_TRUE("Removed listeners are not called", *AnyCalls == 1 && *SelfCalls == 1);
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FObserveStateActions,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FObserveStateActions::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+	LATENT_TEST_TRUE("State machine is registered", Subsystem->GetStateMachines().Contains(StateMachine));
+
+	// Counters are shared with the observers, as they outlive the command if it fails
+	const TSharedRef<int32> ObservedActions = MakeShared<int32>(0);
+	const TWeakObjectPtr<UFiniteStateMachine> WeakStateMachine = StateMachine;
+	const FDelegateHandle Handle = Subsystem->AddStateActionObserver(UMachineState_Test2::StaticClass(),
+		EFSM_StateActionMask::Push | EFSM_StateActionMask::Pop,
+		UFiniteStateMachineSubsystem::FOnGlobalStateActionSignature::CreateLambda(
+			[ObservedActions, WeakStateMachine](UFiniteStateMachine* InStateMachine, UMachineState*, EStateAction,
+				TSubclassOf<UMachineState>)
+			{
+				*ObservedActions += InStateMachine == WeakStateMachine.Get() ? 1 : 0;
+			}));
+
+	// The observer keeps using its captures after removing itself, hence it must not be destroyed while it's called
+	const TSharedRef<FDelegateHandle> SelfHandle = MakeShared<FDelegateHandle>();
+	const TSharedRef<int32> SelfCalls = MakeShared<int32>(0);
+	const TWeakObjectPtr<UFiniteStateMachineSubsystem> WeakSubsystem = Subsystem;
+	*SelfHandle = Subsystem->AddStateActionObserver(nullptr, EFSM_StateActionMask::Push,
+		UFiniteStateMachineSubsystem::FOnGlobalStateActionSignature::CreateLambda(
+			[SelfHandle, SelfCalls, WeakSubsystem](UFiniteStateMachine*, UMachineState*, EStateAction,
+				TSubclassOf<UMachineState>)
+			{
+				if (WeakSubsystem.IsValid())
+				{
+					WeakSubsystem->RemoveStateActionObserver(*SelfHandle);
+				}
+
+				(*SelfCalls)++;
+			}));
+
+	StateMachine->PushState(UMachineState_Test2::StaticClass());
+	StateMachine->PushState(UMachineState_Test3::StaticClass());
+	StateMachine->PopState();
+	StateMachine->PopState();
+	LATENT_TEST_TRUE("Only the observed actions of the observed state", *ObservedActions == 2);
+	LATENT_TEST_TRUE("Self-removing observer has been called once", *SelfCalls == 1);
+
+	LATENT_TEST_FALSE("Self-removing observer is gone", Subsystem->RemoveStateActionObserver(*SelfHandle));
+	LATENT_TEST_TRUE("Remove observer", Subsystem->RemoveStateActionObserver(Handle));
+	LATENT_TEST_TRUE("No observers left", !Subsystem->HasStateActionObservers());
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCheckStateIndex,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCheckStateIndex::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	const UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+
+	const UClass* State1 = UMachineState_Test1::StaticClass();
+	const UClass* State2 = UMachineState_Test2::StaticClass();
+
+	StateMachine->PushState(UMachineState_Test2::StaticClass());
+	LATENT_TEST_TRUE("Test1 is paused", Subsystem->GetStateMachinesNumInState(State1) == 0);
+	LATENT_TEST_TRUE("Test1 is on the stack", Subsystem->GetStateMachinesNumInState(State1, true) == 1);
+	LATENT_TEST_TRUE("Test2 is active", Subsystem->GetStateMachinesInState(State2).Contains(StateMachine));
+
+	StateMachine->PopState();
+	LATENT_TEST_TRUE("Test1 is active", Subsystem->GetStateMachinesNumInState(State1) == 1);
+	LATENT_TEST_TRUE("Test2 is gone", Subsystem->GetStateMachinesNumInState(State2, true) == 0);
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FGotoStateBulk,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FGotoStateBulk::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+
+	const TArray<UFiniteStateMachine*> StateMachines = { StateMachine, nullptr };
+	TArray<EFSM_TransitionResult> Results;
+
+	// Shared checks fail for everyone
+	LATENT_TEST_TRUE("Invalid state", Subsystem->GotoStateBulk(StateMachines, nullptr,
+		TAG_StateMachine_Label_Default, Results) == 0);
+	LATENT_TEST_TRUE("Result per state machine", Results.Num() == 2 &&
+		Results[0] == EFSM_TransitionResult::InvalidState && Results[1] == EFSM_TransitionResult::InvalidState);
+
+	LATENT_TEST_TRUE("Valid state", Subsystem->GotoStateBulk(StateMachines, UMachineState_Test2::StaticClass(),
+		TAG_StateMachine_Label_Default, Results) == 1);
+	LATENT_TEST_TRUE("Transition has been performed", Results[0] == EFSM_TransitionResult::Success &&
+		StateMachine->IsInState(UMachineState_Test2::StaticClass()));
+	LATENT_TEST_TRUE("Invalid state machine is rejected", Results[1] == EFSM_TransitionResult::NotInitialized);
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FGotoSubState,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FGotoSubState::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UMachineState* State = StateMachine->GetState(UMachineState_SubStatesTest::StaticClass());
+	LATENT_TEST_TRUE("State is valid", IsValid(State));
+
+	UMachineState* SubState1 = State->FindSubState(UMachineState_SubStateTest1::StaticClass());
+	UMachineState* SubState2 = State->FindSubState(UMachineState_SubStateTest2::StaticClass());
+	LATENT_TEST_TRUE("Sub-states have been registered", IsValid(SubState1) && IsValid(SubState2));
+	LATENT_TEST_TRUE("Sub-states are owned by the state", SubState1->GetParentState() == State);
+	LATENT_TEST_TRUE("Initial sub-state is active", State->GetActiveSubState() == SubState1);
+	LATENT_TEST_TRUE("Sub-states are not top-level states",
+		!StateMachine->IsStateRegistered(UMachineState_SubStateTest1::StaticClass()));
+
+	LATENT_TEST_FALSE("Label must exist", State->GotoSubState(UMachineState_SubStateTest2::StaticClass(),
+		FGameplayTag::EmptyTag));
+
+	const uint32 SnapshotVersion = StateMachine->GetStateSnapshot().Version;
+	LATENT_TEST_TRUE("Go to sub-state", State->GotoSubState(UMachineState_SubStateTest2::StaticClass()));
+	LATENT_TEST_TRUE("New sub-state is active", State->GetActiveSubState() == SubState2);
+	LATENT_TEST_TRUE("Sub-state transitions don't publish snapshots",
+		StateMachine->GetStateSnapshot().Version == SnapshotVersion);
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCheckSubStateTicks,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCheckSubStateTicks::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	const UMachineState* State = StateMachine->GetState(UMachineState_SubStatesTest::StaticClass());
+	LATENT_TEST_TRUE("State is valid", IsValid(State));
+
+	const auto* SubState1 = Cast<UMachineState_SubStateTest>(
+		State->FindSubState(UMachineState_SubStateTest1::StaticClass()));
+	const auto* SubState2 = Cast<UMachineState_SubStateTest>(
+		State->FindSubState(UMachineState_SubStateTest2::StaticClass()));
+	LATENT_TEST_TRUE("Active sub-state has been ticked", SubState2->GetTicksNum() > 0);
+	LATENT_TEST_TRUE("Inactive sub-state has not been ticked", SubState1->GetTicksNum() == 0);
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FRunRegion,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FRunRegion::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	FFSM_RegionDefinition Definition;
+	Definition.RegionTag = TAG_StateMachine_Region_Test;
+	Definition.InitialState = UMachineState_Test2::StaticClass();
+
+	LATENT_TEST_TRUE("Add region", StateMachine->AddRegion(Definition));
+	LATENT_TEST_FALSE("Region can be added only once", StateMachine->AddRegion(Definition));
+
+	UMachineState* State2 = StateMachine->GetState(UMachineState_Test2::StaticClass());
+	UMachineState* State3 = StateMachine->GetState(UMachineState_Test3::StaticClass());
+	LATENT_TEST_TRUE("Region has begun its initial state", StateMachine->GetActiveStateInRegion(
+		TAG_StateMachine_Region_Test) == State2 && State2->IsStateActive());
+	LATENT_TEST_TRUE("State knows its region", State2->GetRegion() == TAG_StateMachine_Region_Test);
+
+	LATENT_TEST_FALSE("State in a region can't be on the main stack",
+		StateMachine->GotoState(UMachineState_Test2::StaticClass()));
+	LATENT_TEST_TRUE("Main stack runs concurrently", StateMachine->GotoState(UMachineState_Test1::StaticClass()) &&
+		StateMachine->IsInState(UMachineState_Test1::StaticClass()) && State2->IsStateActive());
+	LATENT_TEST_FALSE("State on the main stack can't be in a region", StateMachine->PushStateInRegion(
+		TAG_StateMachine_Region_Test, UMachineState_Test1::StaticClass()));
+	LATENT_TEST_FALSE("Region must exist", StateMachine->PushStateInRegion(
+		FGameplayTag::EmptyTag, UMachineState_Test3::StaticClass()));
+
+	LATENT_TEST_TRUE("Push state in region", StateMachine->PushStateInRegion(
+		TAG_StateMachine_Region_Test, UMachineState_Test3::StaticClass()));
+	LATENT_TEST_TRUE("Pushed state is active", State3->IsStateActive() && !State2->IsStateActive());
+	LATENT_TEST_TRUE("Region stack has been updated", StateMachine->IsInStateInRegion(TAG_StateMachine_Region_Test,
+		UMachineState_Test2::StaticClass(), true) && StateMachine->GetStatesStackInRegion(
+		TAG_StateMachine_Region_Test).Num() == 2);
+
+	LATENT_TEST_TRUE("Pop state in region", StateMachine->PopStateInRegion(TAG_StateMachine_Region_Test));
+	LATENT_TEST_TRUE("Paused state has been resumed", State2->IsStateActive() && !State3->IsStateActive());
+	LATENT_TEST_TRUE("Clear region", StateMachine->ClearStackInRegion(TAG_StateMachine_Region_Test) == 1);
+	LATENT_TEST_TRUE("Region is empty", !IsValid(StateMachine->GetActiveStateInRegion(TAG_StateMachine_Region_Test)));
+	LATENT_TEST_TRUE("Main stack has not been affected", StateMachine->IsInState(UMachineState_Test1::StaticClass()));
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FEvaluateTransitionRules,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FEvaluateTransitionRules::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+
+	auto* StateData = Cast<UMachineStateData_TransitionRulesTest>(StateMachine->GetStateData(
+		UMachineState_TransitionRulesTest::StaticClass(), UMachineStateData_TransitionRulesTest::StaticClass()));
+	LATENT_TEST_TRUE("State data is valid", IsValid(StateData));
+
+	LATENT_TEST_TRUE("No rule is met", Subsystem->EvaluateTransitionRules() == 0);
+	LATENT_TEST_TRUE("State has not changed", StateMachine->IsInState(UMachineState_TransitionRulesTest::StaticClass()));
+
+	StateData->Health = 10.f;
+	StateData->Tags.AddTag(TAG_StateMachine_Label_Test);
+
+	LATENT_TEST_TRUE("Only the first met rule is applied", Subsystem->EvaluateTransitionRules() == 1);
+	LATENT_TEST_TRUE("State has changed", StateMachine->IsInState(UMachineState_Test2::StaticClass()));
+	LATENT_TEST_TRUE("Rules of inactive states are not evaluated", Subsystem->EvaluateTransitionRules() == 0);
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FStartTimeSlicing,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FStartTimeSlicing::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+
+	// No budget at all; only the starvation protection lets them tick, one state machine per frame
+	constexpr int32 StateMachinesNum = 4;
+	Subsystem->SetStateTicksBudget(0.f);
+	Subsystem->SetMaxStateTickDelay(StateMachinesNum);
+
+	for (int32 i = 1; i < StateMachinesNum; i++)
+	{
+		auto* OtherActor = StateMachine->GetWorld()->SpawnActor<AFiniteStateMachineTestActor>();
+		LATENT_TEST_TRUE("Other test actor created", IsValid(OtherActor));
+		OtherActor->StateMachine->SetTimeSliceStateTicks(true);
+	}
+
+	StateMachine->SetTimeSliceStateTicks(true);
+	LATENT_TEST_TRUE("State ticks are time-sliced", StateMachine->IsTimeSlicingStateTicks());
+
+	FFSM_RegionDefinition Definition;
+	Definition.RegionTag = TAG_StateMachine_Region_Test;
+	Definition.InitialState = UMachineState_UrgentTest::StaticClass();
+
+	LATENT_TEST_TRUE("Add region", StateMachine->AddRegion(Definition));
+	LATENT_TEST_TRUE("Go to state", StateMachine->GotoState(UMachineState_TimeSlicedTest::StaticClass()));
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCheckTimeSlicedTicks,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCheckTimeSlicedTicks::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	const UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(StateMachine);
+	const auto* SlicedState = StateMachine->GetState<UMachineState_TimeSlicedTest>();
+	const auto* UrgentState = StateMachine->GetState<UMachineState_UrgentTest>();
+
+	LATENT_TEST_TRUE("Time-sliced state has not been starved", SlicedState->GetTicksNum() > 0);
+	LATENT_TEST_TRUE("Urgent state has been ticked more often", UrgentState->GetTicksNum() > SlicedState->GetTicksNum());
+
+	// The urgent state ticks every frame; the other one lags behind only by the frames it has been waiting for its turn
+	const float MaxLag = (Subsystem->GetMaxStateTickDelay() + 1) * UrgentState->GetMaxDeltaSeconds();
+	LATENT_TEST_TRUE("Time-sliced state has received the skipped time", FMath::IsNearlyEqual(
+		SlicedState->GetTickedTime(), UrgentState->GetTickedTime(), MaxLag));
+
+	StateMachine->SetTimeSliceStateTicks(false);
+	LATENT_TEST_FALSE("State ticks are not time-sliced anymore", StateMachine->IsTimeSlicingStateTicks());
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FStartLabelResumptionBudget,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor, int32, OtherStateMachinesNum);
+bool FStartLabelResumptionBudget::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+
+	// No budget at all; only the starvation protection lets them carry on, one label per frame
+	Subsystem->SetBudgetLabelResumptions(true);
+	Subsystem->SetLabelResumptionsBudget(0.f);
+
+	LATENT_TEST_TRUE("Go to urgent state", StateMachine->GotoState(
+		UMachineState_UrgentLabelResumptionTest::StaticClass()));
+
+	for (int32 i = 0; i < OtherStateMachinesNum; i++)
+	{
+		auto* OtherActor = StateMachine->GetWorld()->SpawnActor<AFiniteStateMachineTestActor>();
+		LATENT_TEST_TRUE("Other test actor created", IsValid(OtherActor));
+
+		UFiniteStateMachine* OtherStateMachine = OtherActor->StateMachine;
+		LATENT_TEST_TRUE("Register state", OtherStateMachine->RegisterState(
+			UMachineState_LabelResumptionTest::StaticClass()));
+		LATENT_TEST_TRUE("Go to state", OtherStateMachine->GotoState(UMachineState_LabelResumptionTest::StaticClass()));
 	}
 
-	const FWorldContext* WorldContext = GEditor->GetPIEWorldContext();
-	if (!WorldContext)
-	{
-		BeginTime = InvalidTime;
-		return true;
-	}
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCheckDeferredLabelResumptions,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCheckDeferredLabelResumptions::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	const UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+	LATENT_TEST_TRUE("Labels wait for budget", Subsystem->GetDeferredLabelResumptionsNum() > 0);
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FCheckLabelResumptions,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor, int32, OtherStateMachinesNum);
+bool FCheckLabelResumptions::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UFiniteStateMachineSubsystem* Subsystem = UFiniteStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+
+	const auto* UrgentState = StateMachine->GetState<UMachineState_UrgentLabelResumptionTest>();
+	LATENT_TEST_TRUE("Urgent label has finished", UrgentState->GetResumptionsNum() ==
+		UMachineState_LabelResumptionTest::ExpectedResumptionsNum);
+
+	const TConstArrayView<UFiniteStateMachine*> OtherStateMachines = Subsystem->GetStateMachinesInState(
+		UMachineState_LabelResumptionTest::StaticClass());
+	LATENT_TEST_TRUE("Other state machines are indexed", OtherStateMachines.Num() == OtherStateMachinesNum);
+
+	uint64 LastFinishFrame = 0;
+	for (const UFiniteStateMachine* OtherStateMachine : OtherStateMachines)
+	{
+		const auto* State = OtherStateMachine->GetState<UMachineState_LabelResumptionTest>();
+		LATENT_TEST_TRUE("Deferred label has finished", State->GetResumptionsNum() ==
+			UMachineState_LabelResumptionTest::ExpectedResumptionsNum);
+		LATENT_TEST_TRUE("Urgent label has finished first", UrgentState->GetFinishFrame() <= State->GetFinishFrame());
+		LastFinishFrame = FMath::Max(LastFinishFrame, State->GetFinishFrame());
+	}
+
+	LATENT_TEST_TRUE("Deferred labels have been delayed", UrgentState->GetFinishFrame() < LastFinishFrame);
+
+	LATENT_TEST_TRUE("No resumption is deferred", Subsystem->GetDeferredLabelResumptionsNum() == 0);
+	Subsystem->SetBudgetLabelResumptions(false);
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FRunCrowd,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor, int32, AgentsNum);
+bool FRunCrowd::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UCrowdStateMachineSubsystem* Subsystem = UCrowdStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+
+	const TSubclassOf<UCrowdMachineState> Test1Class = UCrowdMachineState_Test1::StaticClass();
+	const TSubclassOf<UCrowdMachineState> Test2Class = UCrowdMachineState_Test2::StaticClass();
+	LATENT_TEST_TRUE("States are registered", Subsystem->RegisterState(Test1Class) &&
+		Subsystem->RegisterState(Test2Class));
+
+	// The shared instances keep the counters of the other tests
+	const auto* Test1 = Cast<UCrowdMachineState_Test>(Subsystem->GetState(Test1Class));
+	const auto* Test2 = Cast<UCrowdMachineState_Test>(Subsystem->GetState(Test2Class));
+	LATENT_TEST_TRUE("States are valid", IsValid(Test1) && IsValid(Test2));
+	const int32 Test1BeganNum = Test1->GetBeganNum();
+	const int32 Test1EndedNum = Test1->GetEndedNum();
+	const int32 Test2PausedNum = Test2->GetPausedNum();
+	const int32 Test2ResumedNum = Test2->GetResumedNum();
+
+	TArray<FFSM_CrowdAgentHandle> Agents;
+	for (int32 i = 0; i < AgentsNum; i++)
+	{
+		Agents.Add(Subsystem->AddAgent(Test1Class));
+		LATENT_TEST_TRUE("Agent is valid", Subsystem->IsAgentValid(Agents.Last()));
+	}
+
+	LATENT_TEST_TRUE("Agents have begun the initial state", Test1->GetBeganNum() == Test1BeganNum + AgentsNum);
+	LATENT_TEST_TRUE("Agents are in the initial state", Subsystem->GetAgentsNumInState(Test1Class) == AgentsNum);
+
+	// Ticked manually to not depend on the frame rate; all the ticks take place within the same frame
+	Subsystem->Tick(0.1f);
+	LATENT_TEST_TRUE("Agents have ended the initial state", Test1->GetEndedNum() == Test1EndedNum + AgentsNum);
+	LATENT_TEST_TRUE("Agents have gone to the second state", Subsystem->GetAgentsNumInState(Test2Class) == AgentsNum);
+	LATENT_TEST_TRUE("Agent is at the default label",
+		Subsystem->GetActiveLabel(Agents[0]) == TAG_StateMachine_Label_Default);
+
+	Subsystem->Tick(UCrowdMachineState_Test2::PushDelay);
+	LATENT_TEST_TRUE("Agents have not pushed anything yet", Test2->GetPausedNum() == Test2PausedNum);
+
+	Subsystem->Tick(0.1f);
+	LATENT_TEST_TRUE("Agents have paused the second state", Test2->GetPausedNum() == Test2PausedNum + AgentsNum);
+	LATENT_TEST_TRUE("Agents have pushed the first state", Subsystem->GetAgentsNumInState(Test1Class) == AgentsNum);
+	LATENT_TEST_TRUE("Stack has grown", Subsystem->GetStackDepth(Agents[0]) == 2);
+	LATENT_TEST_TRUE("Paused state is in the stack", Subsystem->IsInState(Agents[0], Test2Class, true));
+	LATENT_TEST_FALSE("Paused state is not active", Subsystem->IsInState(Agents[0], Test2Class, false));
+	LATENT_TEST_TRUE("Agent is at the pushed label",
+		Subsystem->GetActiveLabel(Agents[0]) == TAG_StateMachine_Label_Test);
+
+	Subsystem->Tick(0.1f);
+	LATENT_TEST_TRUE("Agents have resumed the second state", Test2->GetResumedNum() == Test2ResumedNum + AgentsNum);
+	LATENT_TEST_TRUE("Agents have popped the first state", Test1->GetEndedNum() == Test1EndedNum + AgentsNum * 2);
+	LATENT_TEST_TRUE("Stack has shrunk", Subsystem->GetStackDepth(Agents[0]) == 1);
+	LATENT_TEST_TRUE("Agent is back in the second state", Subsystem->GetActiveState(Agents[0]) == Test2Class);
+
+	for (const FFSM_CrowdAgentHandle Agent : Agents)
+	{
+		LATENT_TEST_TRUE("Remove agent", Subsystem->RemoveAgent(Agent));
+	}
+
+	LATENT_TEST_TRUE("No agent is left", Subsystem->GetAgentsNum() == 0);
+	LATENT_TEST_FALSE("Handle of a removed agent is invalid", Subsystem->IsAgentValid(Agents[0]));
+
+	const FFSM_CrowdAgentHandle ReusedAgent = Subsystem->AddAgent(Test2Class);
+	LATENT_TEST_TRUE("Slot is reused", ReusedAgent.Index == Agents.Last().Index);
+	LATENT_TEST_FALSE("Old handle doesn't refer to the new agent", Subsystem->IsAgentValid(Agents.Last()));
+	Subsystem->RemoveAgent(ReusedAgent);
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_THREE_PARAMETER(FRunMassCrowd,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor, int32, EntitiesNum);
+bool FRunMassCrowd::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	UCrowdStateMachineSubsystem* Subsystem = UCrowdStateMachineSubsystem::Get(StateMachine);
+	LATENT_TEST_TRUE("Subsystem is valid", IsValid(Subsystem));
+
+	const TSubclassOf<UCrowdMachineState> Test1Class = UCrowdMachineState_Test1::StaticClass();
+	const TSubclassOf<UCrowdMachineState> Test2Class = UCrowdMachineState_Test2::StaticClass();
+	const int32 Test1Index = Subsystem->FindOrRegisterState(Test1Class);
+	const int32 Test2Index = Subsystem->FindOrRegisterState(Test2Class);
+	LATENT_TEST_TRUE("States are registered", Test1Index != INDEX_NONE && Test2Index != INDEX_NONE);
+
+	// The shared instances keep the counters of the other tests
+	const auto* Test1 = Cast<UCrowdMachineState_Test>(Subsystem->GetStateByIndex(Test1Index));
+	const auto* Test2 = Cast<UCrowdMachineState_Test>(Subsystem->GetStateByIndex(Test2Index));
+	const int32 Test1BeganNum = Test1->GetBeganNum();
+	const int32 Test1EndedNum = Test1->GetEndedNum();
+	const int32 Test2EndedNum = Test2->GetEndedNum();
+	const int32 Test2PausedNum = Test2->GetPausedNum();
+	const int32 Test2ResumedNum = Test2->GetResumedNum();
+
+	// The processor finds the crowd subsystem through the world the entity manager is owned by
+	UWorld* World = StateMachine->GetWorld();
+	TSharedRef<FMassEntityManager> EntityManager = MakeShared<FMassEntityManager>(World);
+	EntityManager->Initialize();
+
+	const FFSM_MassStateMachineFragment InitialFragment = FFSM_MassStateMachineFragment::Make(StateMachine, Test1Class);
+	LATENT_TEST_TRUE("Fragment has the initial state", InitialFragment.StateIndex == Test1Index);
+	LATENT_TEST_FALSE("Initial state has not begun yet", InitialFragment.HasActiveState());
+
+	const FMassArchetypeHandle Archetype =
+		EntityManager->CreateArchetype({ FFSM_MassStateMachineFragment::StaticStruct() });
+
+	TArray<FMassEntityHandle> Entities;
+	for (int32 i = 0; i < EntitiesNum; i++)
+	{
+		Entities.Add(EntityManager->CreateEntity(Archetype));
+		EntityManager->GetFragmentDataChecked<FFSM_MassStateMachineFragment>(Entities.Last()) = InitialFragment;
+	}
+
+	auto GetFragment = [&EntityManager] (FMassEntityHandle Entity) -> FFSM_MassStateMachineFragment&
+	{
+		return EntityManager->GetFragmentDataChecked<FFSM_MassStateMachineFragment>(Entity);
+	};
+
+	// Run outside of the Mass simulation, so that the processing happens only when the test asks for it
+	auto* Processor = NewObject<UMassStateMachineProcessor>();
+	Processor->CallInitialize(World);
+
+	auto Process = [&EntityManager, Processor] (float DeltaTime)
+	{
+		FMassProcessingContext ProcessingContext(EntityManager, DeltaTime);
+		UE::Mass::Executor::Run(*Processor, ProcessingContext);
+	};
+
+	Process(0.1f);
+	LATENT_TEST_TRUE("Entities have begun the initial state", Test1->GetBeganNum() == Test1BeganNum + EntitiesNum);
+	LATENT_TEST_TRUE("Entities have ended the initial state", Test1->GetEndedNum() == Test1EndedNum + EntitiesNum);
+	LATENT_TEST_TRUE("Entity has gone to the second state", GetFragment(Entities[0]).StateIndex == Test2Index);
+	LATENT_TEST_TRUE("Entity has a single state", GetFragment(Entities[0]).StackDepth == 1);
+
+	// Transitions requested by the gameplay code are performed on the next processing
+	LATENT_TEST_TRUE("Request push",
+		GetFragment(Entities[0]).RequestPushState(StateMachine, Test1Class, TAG_StateMachine_Label_Test));
+	LATENT_TEST_FALSE("Requesting a label that is not present in the active state fails",
+		GetFragment(Entities[0]).RequestGotoLabel(StateMachine, TAG_StateMachine_Label_Test));
+	LATENT_TEST_TRUE("Push has not been performed yet", Test2->GetPausedNum() == Test2PausedNum);
+
+	// The pushed state pops itself from its label
+	Process(0.f);
+	LATENT_TEST_TRUE("Entity has paused the second state", Test2->GetPausedNum() == Test2PausedNum + 1);
+	LATENT_TEST_TRUE("Entity has begun the pushed state", Test1->GetBeganNum() == Test1BeganNum + EntitiesNum + 1);
+	LATENT_TEST_TRUE("Entity has resumed the second state", Test2->GetResumedNum() == Test2ResumedNum + 1);
+	LATENT_TEST_TRUE("Entity is back in the second state", GetFragment(Entities[0]).StateIndex == Test2Index);
+	LATENT_TEST_TRUE("Stack has shrunk", GetFragment(Entities[0]).StackDepth == 1);
+
+	// Only the latest request is performed
+	LATENT_TEST_TRUE("Request push", GetFragment(Entities[1]).RequestPushState(StateMachine, Test1Class));
+	LATENT_TEST_TRUE("Request pop", GetFragment(Entities[1]).RequestPopState());
+
+	Process(0.f);
+	LATENT_TEST_TRUE("Entity has ended the second state", Test2->GetEndedNum() == Test2EndedNum + 1);
+	LATENT_TEST_FALSE("Entity has no state", GetFragment(Entities[1]).HasActiveState());
+	LATENT_TEST_TRUE("Entity doesn't begin its state again", GetFragment(Entities[1]).StateIndex == INDEX_NONE);
+	LATENT_TEST_TRUE("Other entities have not pushed anything",
+		Test1->GetBeganNum() == Test1BeganNum + EntitiesNum + 1);
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCheckTickOnlyState,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCheckTickOnlyState::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	auto* State = StateMachine->GetState<UMachineState_TickOnlyTest>();
+	LATENT_TEST_TRUE("State is active", StateMachine->IsInState(UMachineState_TickOnlyTest::StaticClass()));
+	LATENT_TEST_FALSE("State doesn't use labels", State->UsesLabels());
+	LATENT_TEST_TRUE("State has been ticked", State->GetTicksNum() > 0);
+	LATENT_TEST_TRUE("Going to the default label is allowed", State->GotoLabel(TAG_StateMachine_Label_Default));
+	LATENT_TEST_FALSE("Registering a label fails", State->RegisterTestLabel());
+	LATENT_TEST_FALSE("Going to a non-default label fails", State->GotoLabel(TAG_StateMachine_Label_Test));
+
+	TArray<FGameplayTag> RegisteredLabels;
+	State->GetRegisteredLabels(RegisteredLabels);
+	LATENT_TEST_TRUE("No label is registered", RegisteredLabels.IsEmpty());
+	LATENT_TEST_TRUE("No coroutine has been created", State->GetRunningLabelsNum() == 0);
+	LATENT_TEST_FALSE("No label has been activated", LatentMessages.ContainsByPredicate(
+		[] (const FStateMachineTestMessage& Message) { return Message.Message == TEXT("Label"); }));
+
+	LATENT_TEST_TRUE("Go to another state", StateMachine->GotoState(UMachineState_Test1::StaticClass()));
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FSoftReset,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FSoftReset::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	TArray<UMachineState*> StatesBefore;
+	for (const TSubclassOf<UMachineState> StateClass : StateMachine->GetRegisteredStateClasses())
+	{
+		StatesBefore.Add(StateMachine->GetState(StateClass));
+	}
+
+	// Test1 is paused, hence pushing it again is going to stay pending
+	FFSM_PushRequestHandle Handle;
+	StateMachine->PushStateQueued(Handle, UMachineState_Test1::StaticClass());
+	LATENT_TEST_TRUE("Push request is pending", StateMachine->GetPendingPushRequestsNum() == 1);
+
+	// Leave the active state without any label
+	LATENT_TEST_TRUE("Go to empty label", StateMachine->GetState<UMachineState_Test2>()->GotoLabel(FGameplayTag()));
+
+	auto* StateData = Cast<UMachineStateData_TransitionRulesTest>(StateMachine->GetStateData(
+		UMachineState_TransitionRulesTest::StaticClass(), UMachineStateData_TransitionRulesTest::StaticClass()));
+	LATENT_TEST_TRUE("State data is valid", IsValid(StateData));
+	StateData->Health = 10.f;
+	StateData->Tags.AddTag(TAG_StateMachine_Label_Test);
+
+	LATENT_TEST_TRUE("Soft reset", StateMachine->SoftReset());
+	LATENT_TEST_TRUE("States stack is empty", StateMachine->GetStatesStack().IsEmpty());
+	LATENT_TEST_TRUE("No push request is pending", StateMachine->GetPendingPushRequestsNum() == 0);
+	LATENT_TEST_FALSE("Push request has been canceled", Handle.IsPending());
+
+	TArray<UMachineState*> StatesAfter;
+	for (const TSubclassOf<UMachineState> StateClass : StateMachine->GetRegisteredStateClasses())
+	{
+		UMachineState* State = StateMachine->GetState(StateClass);
+		StatesAfter.Add(State);
+
+		LATENT_TEST_TRUE("State is back at the default label",
+			State->GetActiveLabel() == TAG_StateMachine_Label_Default);
+	}
+
+	LATENT_TEST_TRUE("States have been kept alive", StatesBefore == StatesAfter);
+
+	const auto* DefaultStateData = GetDefault<UMachineStateData_TransitionRulesTest>();
+	LATENT_TEST_TRUE("State data has been kept alive", StateData == StateMachine->GetStateData(
+		UMachineState_TransitionRulesTest::StaticClass(), UMachineStateData_TransitionRulesTest::StaticClass()));
+	LATENT_TEST_TRUE("State data number has been reset", StateData->Health == DefaultStateData->Health);
+	LATENT_TEST_TRUE("State data tags have been reset", StateData->Tags == DefaultStateData->Tags);
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_ONE_PARAMETER(FDestroyClusteredOwner,
+	FAutomationTestBase*, Test);
+bool FDestroyClusteredOwner::Update()
+{
+	const FWorldContext* WorldContext = GEditor->GetPIEWorldContext();
+	UWorld* World = WorldContext ? WorldContext->World() : nullptr;
+	LATENT_TEST_TRUE("World is valid", IsValid(World));
+
+	// Spawned actors are never clustered by the engine, hence the owner creates its cluster just like a loaded one
+	auto* Owner = World->SpawnActor<AFiniteStateMachineClusterTestActor>();
+	LATENT_TEST_TRUE("Owner is valid", IsValid(Owner));
+	Owner->CreateCluster();
+
+	UFiniteStateMachine* StateMachine = Owner->StateMachine;
+	StateMachine->SetAddStatesToOwnerCluster(true);
+	LATENT_TEST_TRUE("State is registered", StateMachine->RegisterState(UMachineState_Test1::StaticClass()));
+	LATENT_TEST_TRUE("Go to state", StateMachine->GotoState(UMachineState_Test1::StaticClass()));
+
+	const TWeakObjectPtr<UMachineState> State = StateMachine->GetState(UMachineState_Test1::StaticClass());
+	LATENT_TEST_TRUE("State is valid", State.IsValid());
+	LATENT_TEST_TRUE("State is in the owner cluster", Owner->IsInCluster(State.Get()));
+
+	// The cluster must not keep the states it doesn't own after they're destroyed along with the state machine
+	Owner->Destroy();
+	LATENT_TEST_FALSE("State has been removed from the owner cluster", Owner->IsInCluster(State.Get()));
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS, true);
+	LATENT_TEST_FALSE("State has been garbage collected", State.IsValid());
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_FOUR_PARAMETER(FWaitPushPopMessage, FAutomationTestBase*, Test, FString, Message,
+	float, MaxDuration, bool, bFirstIteration);
+bool FWaitPushPopMessage::Update()
+{
+	// This command supports only one execution at a time
+	// This is a little hack as it would take a bit more time to make it work properly :(
+	constexpr float InvalidTime = -1.f;
+	static float BeginTime = InvalidTime;
+	static bool bGotMessage = false;
+
+	if (bGotMessage)
+	{
+		bGotMessage = false;
+		BeginTime = InvalidTime;
+		return true;
+	}
+
+	const FWorldContext* WorldContext = GEditor->GetPIEWorldContext();
+	if (!WorldContext)
+	{
+		BeginTime = InvalidTime;
+		return true;
+	}
+
+	const UWorld* World = WorldContext->World();
+	if (!World)
+	{
+		BeginTime = InvalidTime;
+		return true;
+	}
+
+	const float CurrentTime = World->GetRealTimeSeconds();
+	if (bFirstIteration)
+	{
+		ensure(BeginTime == InvalidTime);
+		bFirstIteration = false;
+		BeginTime = CurrentTime;
+
+		OnMessageDelegate.AddLambda([&] (FStateMachineTestMessage InMessage)
+		{
+			if (Message == InMessage.Message)
+			{
+				bGotMessage = true;
+			}
+		});
+	}
+
+	const float DeltaTime = CurrentTime - BeginTime;
+	if (!Test->TestTrue("Waiting latent message time didn't expire", MaxDuration >= DeltaTime))
+	{
+		BeginTime = InvalidTime;
+		return true;
+	}
+
+	return false;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCompareTestMessages,
+	FAutomationTestBase*, Test, const TArray<FStateMachineTestMessage>&, ExpectedTestMessages);
+
+bool FCompareTestMessages::Update()
+{
+	Test->TestTrue("Expected and received test messages are of the same amount",
+		LatentMessages.Num() == ExpectedTestMessages.Num());
+
+	auto LhsStateActionsIt = LatentMessages.CreateConstIterator();
+	auto RhsStateActionsIt = ExpectedTestMessages.CreateConstIterator();
+	for (int32 i = 0; LhsStateActionsIt && RhsStateActionsIt; ++LhsStateActionsIt, ++RhsStateActionsIt, i++)
+	{
+		Test->TestTrue(FString("Single test messages are the same. Iteration: ") + FString::FormatAsNumber(i),
+			LhsStateActionsIt->Class == RhsStateActionsIt->Class);
+		Test->TestTrue(FString("Single test messages are the same. Iteration: ") + FString::FormatAsNumber(i),
+			LhsStateActionsIt->Message == RhsStateActionsIt->Message);
+		Test->TestTrue(FString("Single test messages are the same. Iteration: ") + FString::FormatAsNumber(i),
+			LhsStateActionsIt->bSuccess == RhsStateActionsIt->bSuccess);
+	}
+
+	// Print all the broadcast and expected messages to facilitate testing
+	// {
+	// 	auto RhsPrintStateActionsIt = ExpectedTestMessages.CreateConstIterator();
+	// 	UE_LOG(LogTemp, Warning, TEXT("What we expect: "));
+	// 	for (int32 i = 0; RhsPrintStateActionsIt; ++RhsPrintStateActionsIt, i++)
+	// 	{
+	// 		UE_LOG(LogTemp, Warning, TEXT("%d. [%s] [%s]"),
+	// 			i, *GetNameSafe(RhsPrintStateActionsIt->Class), *RhsPrintStateActionsIt->Message);
+	// 	}
+	//
+	// 	auto LhsPrintStateActionsIt = LatentMessages.CreateConstIterator();
+	// 	UE_LOG(LogTemp, Warning, TEXT("What we got: "));
+	// 	for (int32 i = 0; LhsPrintStateActionsIt; ++LhsPrintStateActionsIt, i++)
+	// 	{
+	// 		UE_LOG(LogTemp, Warning, TEXT("%d. [%s] [%s]"),
+	// 			i, *GetNameSafe(LhsPrintStateActionsIt->Class), *LhsPrintStateActionsIt->Message);
+	// 	}
+	// }
+
+	LATENT_TEST_TRUE("Test messages are the same", !LhsStateActionsIt && !RhsStateActionsIt);
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCreateGlobalStateTestActor,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCreateGlobalStateTestActor::Update()
+{
+	const FWorldContext* WorldContext = GEditor->GetPIEWorldContext();
+	UWorld* World = WorldContext ? WorldContext->World() : nullptr;
+	LATENT_TEST_TRUE("World is valid", IsValid(World));
+
+	// The state machine has to be configured before it's initialized
+	*TestActor = World->SpawnActorDeferred<AFiniteStateMachineTestActor>(AFiniteStateMachineTestActor::StaticClass(),
+		FTransform::Identity);
+	LATENT_TEST_TRUE("Test actor created", IsValid(*TestActor));
+
+	auto* Archetype = NewObject<UFiniteStateMachineArchetype>(*TestActor);
+	Archetype->StateClassesToRegister.Add(UMachineState_Test1::StaticClass());
+	Archetype->StateClassesToRegister.Add(UMachineState_Test2::StaticClass());
+	Archetype->GlobalStateClass = UMachineState_GlobalStateTest::StaticClass();
+	Archetype->InitialState = UMachineState_Test1::StaticClass();
+	(*TestActor)->StateMachine->SetStateMachineArchetype(Archetype);
+
+	(*TestActor)->FinishSpawning(FTransform::Identity);
+	LATENT_TEST_TRUE("State machine initialized", (*TestActor)->StateMachine->HasBeenInitialized());
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCheckGlobalStateGotoState,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FCheckGlobalStateGotoState::Update()
+{
+	LATENT_TEST_BEGIN();
+
+	LATENT_TEST_TRUE("Global state is active",
+		StateMachine->GetGlobalStateClass() == UMachineState_GlobalStateTest::StaticClass());
+	LATENT_TEST_TRUE("Initial state has been replaced", StateMachine->IsInState(UMachineState_Test2::StaticClass()));
+	LATENT_TEST_FALSE("Initial state is not on the stack",
+		StateMachine->IsInState(UMachineState_Test1::StaticClass(), true));
+	return true;
+}
+
+#pragma endregion
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineBasicTest, "UE5FSM.BasicPushPop",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineBasicTest::RunTest(const FString& Parameters)
+{
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_Test1::StaticClass(), "Begin", true },
+		{ UMachineState_Test1::StaticClass(), "Paused", true },
+		{ UMachineState_Test2::StaticClass(), "Pushed", true },
+		{ UMachineState_Test2::StaticClass(), "Paused", true },
+		{ UMachineState_Test3::StaticClass(), "Pushed", true },
+		{ UMachineState_Test3::StaticClass(), "Popped", true },
+		{ UMachineState_Test2::StaticClass(), "Resumed", true },
+		{ UMachineState_Test2::StaticClass(), "Popped", true },
+		{ UMachineState_Test1::StaticClass(), "Resumed", true },
+		{ UMachineState_Test1::StaticClass(), "Popped", true },
+	};
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	// Register states
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test3::StaticClass()));
+
+	// Interact with the states stack
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineErrorTest, "UE5FSM.ErrorPushPop",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineErrorTest::RunTest(const FString& Parameters)
+{
+	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
+	ExpectedTestMessages.Empty();
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	// Register states
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test3::StaticClass()));
+
+	// Try to fail to register states that are already registered
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState_Fail(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState_Fail(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState_Fail(this, &TestActor, UMachineState_Test3::StaticClass()));
+
+	/** Interact with the states stack */
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_Test1::StaticClass()));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Begin", true));
+
+	// Going to the active state is allowed
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsNotInState(this, &TestActor, UMachineState_Test1::StaticClass()));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "End", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Begin", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Popped", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test2, "Pushed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test2, "Paused", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Pushed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Paused", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Pushed", true));
+
+	// Disallow pushing a state that is already present
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState_Fail(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState_Fail(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState_Fail(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
+
+	// But allow to goto to the top-most state
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "End", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Begin", true));
+
+	// Disallow going to a state that is already present below the top-most state in the stack
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_Test3::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Popped", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Resumed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Popped", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test2, "Resumed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test2, "Popped", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_Test3::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Begin", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Popped", true));
+
+	// Popping with empty stack should result in no action
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState_Fail(this, &TestActor, nullptr));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState_Fail(this, &TestActor, nullptr));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineLatentTest, "UE5FSM.LatentPushPop",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineLatentTest::RunTest(const FString& Parameters)
+{
+	// THSI TEST DOES NOT SHOW HOW TO CORRECTLY USE THE LABELS & GOTO STATE, BUT MAKES SURE THAT IT WORKS AS IT'S
+	// EXPECTED WHEN IT'S MISUSED
+
+
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_PushPopTest1::StaticClass(), "Begin", true },
+		{ UMachineState_PushPopTest1::StaticClass(), "Before test label activation", true },
+		{ UMachineState_PushPopTest1::StaticClass(), "Paused", true },
+		{ UMachineState_PushPopTest2::StaticClass(), "Pushed", true },
+		{ UMachineState_PushPopTest2::StaticClass(), "Before test label activation", true },
+		{ UMachineState_PushPopTest2::StaticClass(), "Paused", true },
+		{ UMachineState_PushPopTest3::StaticClass(), "Pushed", true },
+		{ UMachineState_PushPopTest3::StaticClass(), "Before test label activation", true },
+		{ UMachineState_PushPopTest3::StaticClass(), "Latent execution has been cancelled", true },
+		{ UMachineState_PushPopTest3::StaticClass(), "Popped", true },
+		{ UMachineState_PushPopTest2::StaticClass(), "Resumed", true },
+		{ UMachineState_PushPopTest2::StaticClass(), "Latent execution has been cancelled", true },
+		{ UMachineState_PushPopTest2::StaticClass(), "Popped", true },
+		{ UMachineState_PushPopTest1::StaticClass(), "Resumed", true },
+		{ UMachineState_PushPopTest1::StaticClass(), "Latent execution has been cancelled", true },
+		{ UMachineState_PushPopTest1::StaticClass(), "Popped", true },
+		{ UMachineState_PushPopTest1::StaticClass(), "End test", true }
+	};
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	// Register states
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_PushPopTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_PushPopTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_PushPopTest2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_PushPopTest2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_PushPopTest3::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_PushPopTest3::StaticClass()));
+
+	// The PushPopTest states push/pop in the correct order themselves, we're only left with listening for messages they send
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_PushPopTest1::StaticClass(), TAG_StateMachine_Label_Default));
+
+	// Wait until we're notified that the test has ended
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitPushPopMessage(this, "End test", 20.f, true));
+
+	// Wait some time until last state pops itself
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineLatentGotoStateTest, "UE5FSM.LatentGotoState",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineLatentGotoStateTest::RunTest(const FString& Parameters)
+{
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_GotoStateTest1::StaticClass(), "Begin", true },
+		{ UMachineState_GotoStateTest1::StaticClass(), "Goto test 2 fail", true },
+		{ UMachineState_GotoStateTest1::StaticClass(), "Pre goto test 2", true },
+		{ UMachineState_GotoStateTest1::StaticClass(), "End", true },
+		{ UMachineState_GotoStateTest2::StaticClass(), "Begin", true },
+		{ UMachineState_GotoStateTest2::StaticClass(), "End test", true },
+	};
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	// Register states
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_GotoStateTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_GotoStateTest2::StaticClass()));
+
+	// The goto state test states do everything inside, we're only left with listening for messages they send
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_GotoStateTest1::StaticClass(), TAG_StateMachine_Label_Default));
+
+	// Wait until we're notified that the test has ended
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitPushPopMessage(this, "End test", 2.f, true));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineLatentExecutionTest, "UE5FSM.LatentExecution",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineLatentExecutionTest::RunTest(const FString& Parameters)
+{
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_LatentExecutionTest1::StaticClass(), "Begin", true },
+		{ UMachineState_LatentExecutionTest1::StaticClass(), "Pre sleep", true },
+		{ UMachineState_LatentExecutionTest1::StaticClass(), "Pre push latent execution test 2", true },
+		{ UMachineState_LatentExecutionTest1::StaticClass(), "Paused", true },
+		{ UMachineState_LatentExecutionTest2::StaticClass(), "Pushed", true },
+		{ UMachineState_LatentExecutionTest1::StaticClass(), "Post push latent execution test 2", true },
+		{ UMachineState_LatentExecutionTest2::StaticClass(), "Pre sleep", true },
+		{ UMachineState_LatentExecutionTest2::StaticClass(), "Post sleep", true },
+		{ UMachineState_LatentExecutionTest2::StaticClass(), "Pre pop", true },
+		{ UMachineState_LatentExecutionTest2::StaticClass(), "Popped", true },
+		{ UMachineState_LatentExecutionTest1::StaticClass(), "Resumed", true },
+		{ UMachineState_LatentExecutionTest1::StaticClass(), "Post sleep", true },
+		{ UMachineState_LatentExecutionTest1::StaticClass(), "End test", true },
+	};
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	// Register states
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_LatentExecutionTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_LatentExecutionTest2::StaticClass()));
+
+	// The goto state test states do everything inside, we're only left with listening for messages they send
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_LatentExecutionTest1::StaticClass(), TAG_StateMachine_Label_Default));
+
+	// Wait until we're notified that the test has ended
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitPushPopMessage(this, "End test", 6.f, true));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStatesBlocklistTest, "UE5FSM.StatesBlocklist",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineStatesBlocklistTest::RunTest(const FString& Parameters)
+{
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_StatesBlocklistTest1::StaticClass(), "Begin", true },
+		{ UMachineState_StatesBlocklistTest1::StaticClass(), "End", true },
+		{ UMachineState_StatesBlocklistTest3::StaticClass(), "Begin", true },
+		{ UMachineState_StatesBlocklistTest3::StaticClass(), "End", true },
+		{ UMachineState_StatesBlocklistTest2::StaticClass(), "Begin", true },
+		{ UMachineState_StatesBlocklistTest2::StaticClass(), "End", true },
+		{ UMachineState_StatesBlocklistTest1::StaticClass(), "Begin", true },
+		{ UMachineState_StatesBlocklistTest1::StaticClass(), "Popped", true },
+	};
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	// Register states
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass()));
+
+	// Begin
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass()));
+
+	// 1 blocks 2, so it should fail. Going to 3 should work
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass()));
+
+	// 3 blocks 1, so it should fail. Going to 2 should work
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass()));
+
+	// 2 blocks 3, so it should fail. Going to 1 should work
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass()));
+
+	// Finish the test
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineExternalPushPopTest, "UE5FSM.ExternalPushPopTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineExternalPushPopTest::RunTest(const FString& Parameters)
+{
+	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
+	ExpectedTestMessages.Empty();
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	// Register states
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushPopTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushPopTest2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushPopTest3::StaticClass()));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_ExternalPushPopTest1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_ExternalPushPopTest1::StaticClass()));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Begin", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_ExternalPushPopTest2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_ExternalPushPopTest2::StaticClass()));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Paused", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Pushed", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_ExternalPushPopTest3::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_ExternalPushPopTest3::StaticClass()));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Paused", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest3, "Pushed", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest3, "Post default label", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_ExternalPushPopTest2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest3, "Popped", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Resumed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Post default label", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_ExternalPushPopTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Popped", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Resumed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Post default label", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Popped", true));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStartWithNotByDefaultLabelTest, "UE5FSM.StartWithNotByDefaultLabelTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineStartWithNotByDefaultLabelTest::RunTest(const FString& Parameters)
+{
+	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
+	ExpectedTestMessages.Empty();
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass()));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Begin", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Post test label", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Popped", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass(), TAG_StateMachine_Label_Test));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Begin", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Post test label", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Popped", true));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineExternalPushPopTest2, "UE5FSM.ExternalPushPopTest2",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineExternalPushPopTest2::RunTest(const FString& Parameters)
+{
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Begin", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Prior to push", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Paused", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Pushed", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Prior to push", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Paused", true },
+		{ UMachineState_ExternalPushTest3::StaticClass(), "Pushed", true },
+		{ UMachineState_ExternalPushTest3::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest3::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest3::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest3::StaticClass(), "Prior to pop", true },
+		{ UMachineState_ExternalPushTest3::StaticClass(), "Popped", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Resumed", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Prior to pop", true },
+		{ UMachineState_ExternalPushTest2::StaticClass(), "Popped", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Resumed", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Prior to pop", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "Popped", true },
+		{ UMachineState_ExternalPushTest1::StaticClass(), "End test", true },
+	};
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushTest2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushTest3::StaticClass()));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_ExternalPushTest1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_ExternalPushTest1::StaticClass()));
+
+	// Wait until we're notified that the test has ended
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitPushPopMessage(this, "End test", 20.f, true));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FFiniteStateMachineBlockedPushTest_LatentImpl,
+	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
+bool FFiniteStateMachineBlockedPushTest_LatentImpl::Update()
+{
+	LATENT_TEST_BEGIN();
+	StateMachine->RegisterState(UMachineState_BlockedPushTest1::StaticClass());
+	StateMachine->RegisterState(UMachineState_BlockedPushTest2::StaticClass());
+	StateMachine->RegisterState(UMachineState_BlockedPushTest3::StaticClass());
+	StateMachine->RegisterState(UMachineState_BlockedPushTest4::StaticClass());
+	StateMachine->RegisterState(UMachineState_BlockedPushTest5::StaticClass());
+
+	StateMachine->GotoState(UMachineState_BlockedPushTest1::StaticClass());
+
+	FFSM_PushRequestHandle Handle1;
+	StateMachine->PushStateQueued(Handle1, UMachineState_BlockedPushTest2::StaticClass());
+	LATENT_TEST_TRUE("Handle 1 is pending", Handle1.IsPending());
+	Handle1.BindOnResultCallback(FOnPendingPushRequestSignature::FDelegate::CreateLambda(
+		[] (EFSM_PendingPushRequestResult Result)
+		{
+			OnMessageDelegate.Broadcast( {
+				UMachineState_BlockedPushTest1::StaticClass(),
+				UEnum::GetValueAsString(Result),
+				true
+			});
+		}));
+
+	FFSM_PushRequestHandle Handle2;
+	StateMachine->PushStateQueued(Handle2, UMachineState_BlockedPushTest3::StaticClass());
+	LATENT_TEST_TRUE("Handle 2 is not pending", !Handle2.IsPending());
+
+	FFSM_PushRequestHandle Handle3;
+	StateMachine->PushStateQueued(Handle3, UMachineState_BlockedPushTest4::StaticClass());
+	LATENT_TEST_TRUE("Handle 3 is pending", Handle3.IsPending());
+	Handle3.BindOnResultCallback(FOnPendingPushRequestSignature::FDelegate::CreateLambda(
+		[] (EFSM_PendingPushRequestResult Result)
+		{
+			OnMessageDelegate.Broadcast({
+				UMachineState_BlockedPushTest4::StaticClass(),
+				UEnum::GetValueAsString(Result),
+			true
+			});
+		}));
+
+	StateMachine->PopState();
+
+	FFSM_PushRequestHandle Handle4;
+	StateMachine->PushStateQueued(Handle4, UMachineState_BlockedPushTest5::StaticClass());
+	LATENT_TEST_TRUE("Handle 4 is pending", Handle4.IsPending());
+	Handle4.BindOnResultCallback(FOnPendingPushRequestSignature::FDelegate::CreateLambda(
+		[] (EFSM_PendingPushRequestResult Result)
+		{
+			OnMessageDelegate.Broadcast({
+				UMachineState_BlockedPushTest5::StaticClass(),
+				UEnum::GetValueAsString(Result),
+			true
+			});
+		}));
+
+	StateMachine->PopState();
+	StateMachine->PopState();
+
+	FFSM_PushRequestHandle Handle5;
+	StateMachine->PushStateQueued(Handle5, UMachineState_BlockedPushTest5::StaticClass());
+	LATENT_TEST_TRUE("Handle 5 is pending", Handle5.IsPending());
+	Handle5.BindOnResultCallback(FOnPendingPushRequestSignature::FDelegate::CreateLambda(
+		[] (EFSM_PendingPushRequestResult Result)
+		{
+			OnMessageDelegate.Broadcast({
+				UMachineState_BlockedPushTest5::StaticClass(),
+				UEnum::GetValueAsString(Result),
+			true
+			});
+		}));
+
+	Handle5.Cancel();
+
+	StateMachine->PopState();
+	StateMachine->PopState();
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineBlockedPushTest, "UE5FSM.BlockedPushTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineBlockedPushTest::RunTest(const FString& Parameters)
+{
+	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
+	ExpectedTestMessages.Empty();
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FFiniteStateMachineBlockedPushTest_LatentImpl(this, &TestActor));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Begin", true));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Paused", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Pushed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "EFSM_PendingPushRequestResult::Success", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Paused", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest2, "Pushed", true));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest2, "Popped", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Resumed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest4, "EFSM_PendingPushRequestResult::Success", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Paused", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest4, "Pushed", true));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest4, "Popped", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Resumed", true));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Popped", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Resumed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest5, "EFSM_PendingPushRequestResult::Success", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Paused", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest5, "Pushed", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest5, "EFSM_PendingPushRequestResult::Canceled", true));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest5, "Popped", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Resumed", true));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Popped", true));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineLatentActionTest, "UE5FSM.LatentActionTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineLatentActionTest::RunTest(const FString& Parameters)
+{
+	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
+	ExpectedTestMessages.Empty();
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_LatentActions1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_LatentActions2::StaticClass()));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_LatentActions1::StaticClass(), TAG_StateMachine_Label_Default));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_LatentActions1, "Begin", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_LatentActions1, "End", true));
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_LatentActions2, "Begin", true));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FEndState(this, &TestActor, nullptr));
+
+	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_LatentActions2, "End", true));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineClearStackTest, "UE5FSM.ClearStackTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineClearStackTest::RunTest(const FString& Parameters)
+{
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_Test1::StaticClass(), "Begin", true },
+		{ UMachineState_Test1::StaticClass(), "Paused", true },
+		{ UMachineState_Test2::StaticClass(), "Pushed", true },
+		{ UMachineState_Test2::StaticClass(), "Paused", true },
+		{ UMachineState_Test3::StaticClass(), "Pushed", true },
+		{ UMachineState_Test3::StaticClass(), "End", true },
+		{ UMachineState_Test2::StaticClass(), "Resumed", true },
+		{ UMachineState_Test2::StaticClass(), "End", true },
+		{ UMachineState_Test1::StaticClass(), "Resumed", true },
+		{ UMachineState_Test1::StaticClass(), "End", true },
+	};
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FCheckStateSnapshot(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FClearStack(this, &TestActor, 3));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineSoftResetTest, "UE5FSM.SoftResetTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineSoftResetTest::RunTest(const FString& Parameters)
+{
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_Test1::StaticClass(), "Begin", true },
+		{ UMachineState_Test1::StaticClass(), "Paused", true },
+		{ UMachineState_Test2::StaticClass(), "Pushed", true },
+		// The paused state is not resumed, as it's torn down right after
+		{ UMachineState_Test2::StaticClass(), "End", true },
+		{ UMachineState_Test1::StaticClass(), "End", true },
+		{ UMachineState_Test2::StaticClass(), "Begin", true },
+	};
+
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_TransitionRulesTest::StaticClass()));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
+
+	// Reset the state machine as if its owner was reused from a pool
+	ADD_LATENT_AUTOMATION_COMMAND(FSoftReset(this, &TestActor));
+
+	// The states must still be usable afterward
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_Test2::StaticClass()));
+
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineClusteredOwnerDestroyTest, "UE5FSM.ClusteredOwnerDestroyTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineClusteredOwnerDestroyTest::RunTest(const FString& Parameters)
+{
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FDestroyClusteredOwner(this));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineArchetypeTest, "UE5FSM.ArchetypeTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineArchetypeTest::RunTest(const FString& Parameters)
+{
+	auto* Archetype = NewObject<UFiniteStateMachineArchetype>();
+	Archetype->StateClassesToRegister.Add(UMachineState_StatesBlocklistTest1::StaticClass());
+	Archetype->StateClassesToRegister.Add(UMachineState_StatesBlocklistTest2::StaticClass());
+	Archetype->StateClassesToRegister.Add(UMachineState_StatesBlocklistTest3::StaticClass());
+	Archetype->InitialState = UMachineState_StatesBlocklistTest1::StaticClass();
+	Archetype->Compile();
+
+	TestTrue("Configuration is valid", Archetype->IsConfigurationValid());
+	TestEqual("Compiled states", Archetype->GetCompiledStates().Num(), 3);
+
+	const int32 Index1 = Archetype->FindStateIndex(UMachineState_StatesBlocklistTest1::StaticClass());
+	const int32 Index2 = Archetype->FindStateIndex(UMachineState_StatesBlocklistTest2::StaticClass());
+	const int32 Index3 = Archetype->FindStateIndex(UMachineState_StatesBlocklistTest3::StaticClass());
+	TestEqual("Not registered state index", Archetype->FindStateIndex(UMachineState_Test1::StaticClass()), INDEX_NONE);
+
+	// The compiled transitions must follow the blocklists
+	TestTrue("1 -> 2 is blocked", Archetype->IsTransitionBlocked(Index1, Index2));
+	TestFalse("1 -> 3 is not blocked", Archetype->IsTransitionBlocked(Index1, Index3));
+	TestTrue("2 -> 3 is blocked", Archetype->IsTransitionBlocked(Index2, Index3));
+	TestTrue("3 -> 1 is blocked", Archetype->IsTransitionBlocked(Index3, Index1));
+	TestTrue("Default label is present", Archetype->ContainsLabel(Index1, TAG_StateMachine_Label_Default));
+	TestEqual("Validation warnings", Archetype->GetValidationWarnings().Num(), 0);
+
+	// State 2 is only reachable through state 3
+	Archetype->StateClassesToRegister.RemoveAt(2);
+	Archetype->Compile();
+
+	TestTrue("Configuration is still valid", Archetype->IsConfigurationValid());
+	TestEqual("Unreachable state is reported", Archetype->GetValidationWarnings().Num(), 1);
+
+	// Errors must be reported the same way registration would
+	Archetype->StateClassesToRegister.Add(UMachineState_StatesBlocklistTest1::StaticClass());
+	Archetype->InitialState = UMachineState_Test1::StaticClass();
+	Archetype->Compile();
+
+	TestFalse("Configuration is invalid", Archetype->IsConfigurationValid());
+	TestEqual("Validation errors", Archetype->GetValidationErrors().Num(), 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineTransitionGraphAnalysisTest, "UE5FSM.TransitionGraphAnalysisTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineTransitionGraphAnalysisTest::RunTest(const FString& Parameters)
+{
+	auto* Archetype = NewObject<UFiniteStateMachineArchetype>();
+	Archetype->StateClassesToRegister.Add(UMachineState_TransitionGraphTest1::StaticClass());
+	Archetype->StateClassesToRegister.Add(UMachineState_TransitionGraphTest2::StaticClass());
+	Archetype->StateClassesToRegister.Add(UMachineState_TransitionGraphTest3::StaticClass());
+	Archetype->InitialState = UMachineState_TransitionGraphTest1::StaticClass();
+	Archetype->Compile();
+
+	// The states only go where they declare, so the blocked declaration is the only way to the third state
+	const TArray<FString>& Errors = Archetype->GetValidationErrors();
+	TestEqual("Validation errors", Errors.Num(), 1);
+	TestTrue("Blocked declared transition is reported", Errors.Num() == 1 &&
+		Errors[0].Contains(UMachineState_TransitionGraphTest3::StaticClass()->GetName()) &&
+		Errors[0].Contains(TEXT("allowlist or blocklist")));
+
+	const TArray<FString>& Warnings = Archetype->GetValidationWarnings();
+	TestEqual("Validation warnings", Warnings.Num(), 2);
+	TestTrue("Unreachable state is reported", Warnings.ContainsByPredicate([](const FString& Warning)
+	{
+		return Warning.Contains(UMachineState_TransitionGraphTest3::StaticClass()->GetName()) &&
+			Warning.Contains(TEXT("unreachable"));
+	}));
+	TestTrue("Dead label is reported", Warnings.ContainsByPredicate([](const FString& Warning)
+	{
+		return Warning.Contains(UMachineState_TransitionGraphTest1::StaticClass()->GetName()) &&
+			Warning.Contains(TAG_StateMachine_Label_Test.GetTag().ToString());
+	}));
+
+	// Declarations are checked against the registered states as well
+	Archetype->StateClassesToRegister.RemoveAt(2);
+	Archetype->Compile();
+
+	const TArray<FString>& NotRegisteredErrors = Archetype->GetValidationErrors();
+	TestEqual("Validation errors without the third state", NotRegisteredErrors.Num(), 1);
+	TestTrue("Declared transition to a not registered state is reported",
+		NotRegisteredErrors.Num() == 1 && NotRegisteredErrors[0].Contains(TEXT("not registered")));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineAnalysisCommandletTest, "UE5FSM.AnalysisCommandletTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineAnalysisCommandletTest::RunTest(const FString& Parameters)
+{
+	auto* ValidArchetype = NewObject<UFiniteStateMachineArchetype>();
+	ValidArchetype->StateClassesToRegister.Add(UMachineState_StatesBlocklistTest1::StaticClass());
+	ValidArchetype->StateClassesToRegister.Add(UMachineState_StatesBlocklistTest2::StaticClass());
+	ValidArchetype->StateClassesToRegister.Add(UMachineState_StatesBlocklistTest3::StaticClass());
+	ValidArchetype->InitialState = UMachineState_StatesBlocklistTest1::StaticClass();
+
+	// State 2 is only reachable through state 3
+	auto* WarningArchetype = NewObject<UFiniteStateMachineArchetype>();
+	WarningArchetype->StateClassesToRegister.Add(UMachineState_StatesBlocklistTest1::StaticClass());
+	WarningArchetype->StateClassesToRegister.Add(UMachineState_StatesBlocklistTest2::StaticClass());
+	WarningArchetype->InitialState = UMachineState_StatesBlocklistTest1::StaticClass();
+
+	auto* ErrorArchetype = NewObject<UFiniteStateMachineArchetype>();
+	ErrorArchetype->StateClassesToRegister.Add(UMachineState_TransitionGraphTest1::StaticClass());
+	ErrorArchetype->StateClassesToRegister.Add(UMachineState_TransitionGraphTest2::StaticClass());
+	ErrorArchetype->StateClassesToRegister.Add(UMachineState_TransitionGraphTest3::StaticClass());
+	ErrorArchetype->InitialState = UMachineState_TransitionGraphTest1::StaticClass();
+
+	TestEqual("Valid archetype passes", UFiniteStateMachineAnalysisCommandlet::AnalyzeArchetypes(
+		{ ValidArchetype }, true), 0);
+	TestEqual("Warnings pass", UFiniteStateMachineAnalysisCommandlet::AnalyzeArchetypes(
+		{ ValidArchetype, WarningArchetype }, false), 0);
+	TestEqual("Warnings fail as errors", UFiniteStateMachineAnalysisCommandlet::AnalyzeArchetypes(
+		{ ValidArchetype, WarningArchetype }, true), 1);
+
+	AddExpectedError(TEXT("allowlist or blocklist disallows"), EAutomationExpectedErrorFlags::Contains, 1);
+	TestEqual("Errors fail", UFiniteStateMachineAnalysisCommandlet::AnalyzeArchetypes(
+		{ ValidArchetype, ErrorArchetype }, false), 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineArchetypeDataValidationTest, "UE5FSM.ArchetypeDataValidationTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
 
-	const UWorld* World = WorldContext->World();
-	if (!World)
-	{
-		BeginTime = InvalidTime;
-		return true;
-	}
+bool FFiniteStateMachineArchetypeDataValidationTest::RunTest(const FString& Parameters)
+{
+	// Component whose own configuration is invalid, as its initial state is not registered
+	auto* StateMachine = NewObject<UFiniteStateMachine>();
+	StateMachine->InitialStateClassesToRegister.Add(UMachineState_Test1::StaticClass());
+	StateMachine->SetInitialState(UMachineState_Test1::StaticClass());
+	StateMachine->InitialStateClassesToRegister.Empty();
 
-	const float CurrentTime = World->GetRealTimeSeconds();
-	if (bFirstIteration)
-	{
-		ensure(BeginTime == InvalidTime);
-		bFirstIteration = false;
-		BeginTime = CurrentTime;
+	FDataValidationContext InvalidComponentContext;
+	TestTrue("Component configuration is invalid",
+		StateMachine->IsDataValid(InvalidComponentContext) == EDataValidationResult::Invalid);
 
-		OnMessageDelegate.AddLambda([&] (FStateMachineTestMessage InMessage)
-		{
-			if (Message == InMessage.Message)
-			{
-				bGotMessage = true;
-			}
-		});
-	}
+	// The archetype overrides the configuration of the component, hence only the archetype is validated
+	auto* Archetype = NewObject<UFiniteStateMachineArchetype>();
+	Archetype->StateClassesToRegister.Add(UMachineState_Test2::StaticClass());
+	Archetype->InitialState = UMachineState_Test2::StaticClass();
+	StateMachine->SetStateMachineArchetype(Archetype);
 
-	const float DeltaTime = CurrentTime - BeginTime;
-	if (!Test->TestTrue("Waiting latent message time didn't expire", MaxDuration >= DeltaTime))
-	{
-		BeginTime = InvalidTime;
-		return true;
-	}
+	FDataValidationContext ValidArchetypeContext;
+	TestTrue("Archetype configuration is valid",
+		StateMachine->IsDataValid(ValidArchetypeContext) != EDataValidationResult::Invalid);
+	TestFalse("Validation doesn't compile the archetype", Archetype->IsCompiled());
 
-	return false;
+	Archetype->InitialState = UMachineState_Test1::StaticClass();
+
+	FDataValidationContext InvalidArchetypeContext;
+	TestTrue("Archetype configuration is invalid",
+		StateMachine->IsDataValid(InvalidArchetypeContext) == EDataValidationResult::Invalid);
+
+	return true;
 }
 
-DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FCompareTestMessages,
-	FAutomationTestBase*, Test, const TArray<FStateMachineTestMessage>&, ExpectedTestMessages);
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineTransitionResultTest, "UE5FSM.TransitionResultTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
 
-bool FCompareTestMessages::Update()
+bool FFiniteStateMachineTransitionResultTest::RunTest(const FString& Parameters)
 {
-	Test->TestTrue("Expected and received test messages are of the same amount",
-		LatentMessages.Num() == ExpectedTestMessages.Num());
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	auto LhsStateActionsIt = LatentMessages.CreateConstIterator();
-	auto RhsStateActionsIt = ExpectedTestMessages.CreateConstIterator();
-	for (int32 i = 0; LhsStateActionsIt && RhsStateActionsIt; ++LhsStateActionsIt, ++RhsStateActionsIt, i++)
-	{
-		Test->TestTrue(FString("Single test messages are the same. Iteration: ") + FString::FormatAsNumber(i),
-			LhsStateActionsIt->Class == RhsStateActionsIt->Class);
-		Test->TestTrue(FString("Single test messages are the same. Iteration: ") + FString::FormatAsNumber(i),
-			LhsStateActionsIt->Message == RhsStateActionsIt->Message);
-		Test->TestTrue(FString("Single test messages are the same. Iteration: ") + FString::FormatAsNumber(i),
-			LhsStateActionsIt->bSuccess == RhsStateActionsIt->bSuccess);
-	}
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass()));
 
-	// Print all the broadcast and expected messages to facilitate testing
-	// {
-	// 	auto RhsPrintStateActionsIt = ExpectedTestMessages.CreateConstIterator();
-	// 	UE_LOG(LogTemp, Warning, TEXT("What we expect: "));
-	// 	for (int32 i = 0; RhsPrintStateActionsIt; ++RhsPrintStateActionsIt, i++)
-	// 	{
-	// 		UE_LOG(LogTemp, Warning, TEXT("%d. [%s] [%s]"),
-	// 			i, *GetNameSafe(RhsPrintStateActionsIt->Class), *RhsPrintStateActionsIt->Message);
-	// 	}
-	//
-	// 	auto LhsPrintStateActionsIt = LatentMessages.CreateConstIterator();
-	// 	UE_LOG(LogTemp, Warning, TEXT("What we got: "));
-	// 	for (int32 i = 0; LhsPrintStateActionsIt; ++LhsPrintStateActionsIt, i++)
-	// 	{
-	// 		UE_LOG(LogTemp, Warning, TEXT("%d. [%s] [%s]"),
-	// 			i, *GetNameSafe(LhsPrintStateActionsIt->Class), *LhsPrintStateActionsIt->Message);
-	// 	}
-	// }
+	// Each rejection must be reported with its reason
+	ADD_LATENT_AUTOMATION_COMMAND(FTryPopState(this, &TestActor, EFSM_TransitionResult::NoActiveState));
+	ADD_LATENT_AUTOMATION_COMMAND(FTryGotoState(this, &TestActor, nullptr, EFSM_TransitionResult::InvalidState));
+	ADD_LATENT_AUTOMATION_COMMAND(FTryGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), EFSM_TransitionResult::NotRegistered));
+	ADD_LATENT_AUTOMATION_COMMAND(FTryGotoState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass(), EFSM_TransitionResult::Success));
+	ADD_LATENT_AUTOMATION_COMMAND(FTryGotoState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass(), EFSM_TransitionResult::Blocked));
+	ADD_LATENT_AUTOMATION_COMMAND(FTryGotoState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass(), EFSM_TransitionResult::Success));
+	ADD_LATENT_AUTOMATION_COMMAND(FTryPopState(this, &TestActor, EFSM_TransitionResult::Success));
 
-	LATENT_TEST_TRUE("Test messages are the same", !LhsStateActionsIt && !RhsStateActionsIt);
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
 
 	return true;
 }
 
-#pragma endregion
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineTransitionCommandsTest, "UE5FSM.TransitionCommandsTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineBasicTest, "UE5FSM.BasicPushPop",
+bool FFiniteStateMachineTransitionCommandsTest::RunTest(const FString& Parameters)
+{
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPostTransitionCommands(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FPostPrioritizedTransitionCommands(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FPostTransitionCommandsWhileInactive(this, &TestActor));
+
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineCoalescedGotoStateTest, "UE5FSM.CoalescedGotoStateTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineBasicTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineCoalescedGotoStateTest::RunTest(const FString& Parameters)
 {
 	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
 	{
 		{ UMachineState_Test1::StaticClass(), "Begin", true },
-		{ UMachineState_Test1::StaticClass(), "Paused", true },
-		{ UMachineState_Test2::StaticClass(), "Pushed", true },
-		{ UMachineState_Test2::StaticClass(), "Paused", true },
-		{ UMachineState_Test3::StaticClass(), "Pushed", true },
-		{ UMachineState_Test3::StaticClass(), "Popped", true },
-		{ UMachineState_Test2::StaticClass(), "Resumed", true },
-		{ UMachineState_Test2::StaticClass(), "Popped", true },
-		{ UMachineState_Test1::StaticClass(), "Resumed", true },
-		{ UMachineState_Test1::StaticClass(), "Popped", true },
+		{ UMachineState_Test1::StaticClass(), "End", true },
+		{ UMachineState_Test3::StaticClass(), "Begin", true },
+		{ UMachineState_Test3::StaticClass(), "End", true },
+		{ UMachineState_Test2::StaticClass(), "Begin", true },
 	};
 
 	// Setup environment and test objects
@@ -423,21 +2578,13 @@ bool FFiniteStateMachineBasicTest::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	// Register states
 	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test1::StaticClass()));
 	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test2::StaticClass()));
 	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test3::StaticClass()));
 
-	// Interact with the states stack
 	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_Test2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_Test1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+	ADD_LATENT_AUTOMATION_COMMAND(FCoalesceGotoStates(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FCoalesceGotoStatesByPriority(this, &TestActor));
 
 	// Check whether all predicted events took place in the correct order from the correct states
 	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
@@ -449,16 +2596,13 @@ bool FFiniteStateMachineBasicTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineErrorTest, "UE5FSM.ErrorPushPop",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachinePushQueuePolicyTest, "UE5FSM.PushQueuePolicyTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineErrorTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachinePushQueuePolicyTest::RunTest(const FString& Parameters)
 {
-	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
-	ExpectedTestMessages.Empty();
-
 	// Setup environment and test objects
 	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
 	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
@@ -466,83 +2610,100 @@ bool FFiniteStateMachineErrorTest::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	// Register states
 	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test1::StaticClass()));
 	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_Test3::StaticClass()));
-
-	// Try to fail to register states that are already registered
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState_Fail(this, &TestActor, UMachineState_Test1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState_Fail(this, &TestActor, UMachineState_Test2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState_Fail(this, &TestActor, UMachineState_Test3::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
 
-	/** Interact with the states stack */
+	// The request with a timeout must be canceled once it expires, while the other one must stay in the queue
+	ADD_LATENT_AUTOMATION_COMMAND(FQueuePrioritizedPushRequests(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCheckPendingPushRequestsNum(this, &TestActor, 1));
 
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	// The blocked high priority request must stall the queue, unless the first executable request is allowed to run
+	ADD_LATENT_AUTOMATION_COMMAND(FPopWithBlockedPushRequests(this, &TestActor, EFSM_PushQueuePolicy::StrictFIFO,
+		UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopWithBlockedPushRequests(this, &TestActor, EFSM_PushQueuePolicy::Priority,
+		UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopWithBlockedPushRequests(this, &TestActor,
+		EFSM_PushQueuePolicy::FirstExecutable, UMachineState_Test2::StaticClass()));
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Begin", true));
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
 
-	// Going to the active state is allowed
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_Test1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsNotInState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	return true;
+}
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "End", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Begin", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Popped", true));
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachinePushQueueDrainTest, "UE5FSM.PushQueueDrainTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
 
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+bool FFiniteStateMachinePushQueueDrainTest::RunTest(const FString& Parameters)
+{
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_Test1::StaticClass(), "Begin", true },
+		{ UMachineState_Test1::StaticClass(), "Paused", true },
+		{ UMachineState_Test2::StaticClass(), "Pushed", true },
+		{ UMachineState_Test2::StaticClass(), "Paused", true },
+		{ UMachineState_Test3::StaticClass(), "Pushed", true },
+		{ UMachineState_Test3::StaticClass(), "End", true },
+		{ UMachineState_Test2::StaticClass(), "Resumed", true },
+		{ UMachineState_Test2::StaticClass(), "End", true },
+		{ UMachineState_Test1::StaticClass(), "Resumed", true },
+		{ UMachineState_Test1::StaticClass(), "End", true },
+		{ UMachineState_Test2::StaticClass(), "Pushed", true },
+	};
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test2, "Pushed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test2, "Paused", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Pushed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Paused", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Pushed", true));
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	// Disallow pushing a state that is already present
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState_Fail(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState_Fail(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState_Fail(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
 
-	// But allow to goto to the top-most state
 	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "End", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Begin", true));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
 
-	// Disallow going to a state that is already present below the top-most state in the stack
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
+	// The queued push must be executed once, after the whole stack is cleared
+	ADD_LATENT_AUTOMATION_COMMAND(FClearStackWithQueuedPush(this, &TestActor));
 
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_Test3::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_Test2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test1, "Popped", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Resumed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Popped", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test2, "Resumed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test2, "Popped", true));
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
 
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_Test3::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+	return true;
+}
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Begin", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_Test3, "Popped", true));
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStateActionAwaiterTest, "UE5FSM.StateActionAwaiterTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
 
-	// Popping with empty stack should result in no action
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState_Fail(this, &TestActor, nullptr));
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState_Fail(this, &TestActor, nullptr));
+bool FFiniteStateMachineStateActionAwaiterTest::RunTest(const FString& Parameters)
+{
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
 
-	// Check whether all predicted events took place in the correct order from the correct states
-	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitForStateActions(this, &TestActor));
 
 	// Finish test
 	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
@@ -551,36 +2712,19 @@ bool FFiniteStateMachineErrorTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineLatentTest, "UE5FSM.LatentPushPop",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineGlobalStateGotoStateTest, "UE5FSM.GlobalStateGotoStateTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineLatentTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineGlobalStateGotoStateTest::RunTest(const FString& Parameters)
 {
-	// THSI TEST DOES NOT SHOW HOW TO CORRECTLY USE THE LABELS & GOTO STATE, BUT MAKES SURE THAT IT WORKS AS IT'S
-	// EXPECTED WHEN IT'S MISUSED
-
-
 	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
 	{
-		{ UMachineState_PushPopTest1::StaticClass(), "Begin", true },
-		{ UMachineState_PushPopTest1::StaticClass(), "Before test label activation", true },
-		{ UMachineState_PushPopTest1::StaticClass(), "Paused", true },
-		{ UMachineState_PushPopTest2::StaticClass(), "Pushed", true },
-		{ UMachineState_PushPopTest2::StaticClass(), "Before test label activation", true },
-		{ UMachineState_PushPopTest2::StaticClass(), "Paused", true },
-		{ UMachineState_PushPopTest3::StaticClass(), "Pushed", true },
-		{ UMachineState_PushPopTest3::StaticClass(), "Before test label activation", true },
-		{ UMachineState_PushPopTest3::StaticClass(), "Latent execution has been cancelled", true },
-		{ UMachineState_PushPopTest3::StaticClass(), "Popped", true },
-		{ UMachineState_PushPopTest2::StaticClass(), "Resumed", true },
-		{ UMachineState_PushPopTest2::StaticClass(), "Latent execution has been cancelled", true },
-		{ UMachineState_PushPopTest2::StaticClass(), "Popped", true },
-		{ UMachineState_PushPopTest1::StaticClass(), "Resumed", true },
-		{ UMachineState_PushPopTest1::StaticClass(), "Latent execution has been cancelled", true },
-		{ UMachineState_PushPopTest1::StaticClass(), "Popped", true },
-		{ UMachineState_PushPopTest1::StaticClass(), "End test", true }
+		// The initial state never begins, as the global state leaves it first
+		PREDICTED_TEST_MESSAGE(UMachineState_GlobalStateTest, "Begin", true),
+		PREDICTED_TEST_MESSAGE(UMachineState_GlobalStateTest, "GotoState", true),
+		PREDICTED_TEST_MESSAGE(UMachineState_Test2, "Begin", true),
 	};
 
 	// Setup environment and test objects
@@ -588,27 +2732,37 @@ bool FFiniteStateMachineLatentTest::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
 	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
-	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateGlobalStateTestActor(this, &TestActor));
 
-	// Register states
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_PushPopTest1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_PushPopTest1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_PushPopTest2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_PushPopTest2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_PushPopTest3::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsStateRegistered(this, &TestActor, UMachineState_PushPopTest3::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FCheckGlobalStateGotoState(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
 
-	// The PushPopTest states push/pop in the correct order themselves, we're only left with listening for messages they send
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_PushPopTest1::StaticClass(), TAG_StateMachine_Label_Default));
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
 
-	// Wait until we're notified that the test has ended
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitPushPopMessage(this, "End test", 20.f, true));
+	return true;
+}
 
-	// Wait some time until last state pops itself
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStateIndexTest, "UE5FSM.StateIndexTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineStateIndexTest::RunTest(const FString& Parameters)
+{
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	// Check whether all predicted events took place in the correct order from the correct states
-	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FCheckStateIndex(this, &TestActor));
 
 	// Finish test
 	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
@@ -617,23 +2771,13 @@ bool FFiniteStateMachineLatentTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineLatentGotoStateTest, "UE5FSM.LatentGotoState",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineGotoStateBulkTest, "UE5FSM.GotoStateBulkTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineLatentGotoStateTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineGotoStateBulkTest::RunTest(const FString& Parameters)
 {
-	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
-	{
-		{ UMachineState_GotoStateTest1::StaticClass(), "Begin", true },
-		{ UMachineState_GotoStateTest1::StaticClass(), "Goto test 2 fail", true },
-		{ UMachineState_GotoStateTest1::StaticClass(), "Pre goto test 2", true },
-		{ UMachineState_GotoStateTest1::StaticClass(), "End", true },
-		{ UMachineState_GotoStateTest2::StaticClass(), "Begin", true },
-		{ UMachineState_GotoStateTest2::StaticClass(), "End test", true },
-	};
-
 	// Setup environment and test objects
 	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
 	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
@@ -641,18 +2785,11 @@ bool FFiniteStateMachineLatentGotoStateTest::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	// Register states
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_GotoStateTest1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_GotoStateTest2::StaticClass()));
-
-	// The goto state test states do everything inside, we're only left with listening for messages they send
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_GotoStateTest1::StaticClass(), TAG_StateMachine_Label_Default));
-
-	// Wait until we're notified that the test has ended
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitPushPopMessage(this, "End test", 2.f, true));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
 
-	// Check whether all predicted events took place in the correct order from the correct states
-	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoStateBulk(this, &TestActor));
 
 	// Finish test
 	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
@@ -661,30 +2798,13 @@ bool FFiniteStateMachineLatentGotoStateTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineLatentExecutionTest, "UE5FSM.LatentExecution",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStateActionSubscriptionTest, "UE5FSM.StateActionSubscriptionTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineLatentExecutionTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineStateActionSubscriptionTest::RunTest(const FString& Parameters)
 {
-	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
-	{
-		{ UMachineState_LatentExecutionTest1::StaticClass(), "Begin", true },
-		{ UMachineState_LatentExecutionTest1::StaticClass(), "Pre sleep", true },
-		{ UMachineState_LatentExecutionTest1::StaticClass(), "Pre push latent execution test 2", true },
-		{ UMachineState_LatentExecutionTest1::StaticClass(), "Paused", true },
-		{ UMachineState_LatentExecutionTest2::StaticClass(), "Pushed", true },
-		{ UMachineState_LatentExecutionTest1::StaticClass(), "Post push latent execution test 2", true },
-		{ UMachineState_LatentExecutionTest2::StaticClass(), "Pre sleep", true },
-		{ UMachineState_LatentExecutionTest2::StaticClass(), "Post sleep", true },
-		{ UMachineState_LatentExecutionTest2::StaticClass(), "Pre pop", true },
-		{ UMachineState_LatentExecutionTest2::StaticClass(), "Popped", true },
-		{ UMachineState_LatentExecutionTest1::StaticClass(), "Resumed", true },
-		{ UMachineState_LatentExecutionTest1::StaticClass(), "Post sleep", true },
-		{ UMachineState_LatentExecutionTest1::StaticClass(), "End test", true },
-	};
-
 	// Setup environment and test objects
 	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
 	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
@@ -692,18 +2812,40 @@ bool FFiniteStateMachineLatentExecutionTest::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	// Register states
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_LatentExecutionTest1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_LatentExecutionTest2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
 
-	// The goto state test states do everything inside, we're only left with listening for messages they send
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_LatentExecutionTest1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FSubscribeToStateActions(this, &TestActor));
 
-	// Wait until we're notified that the test has ended
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitPushPopMessage(this, "End test", 6.f, true));
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
 
-	// Check whether all predicted events took place in the correct order from the correct states
-	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStateActionObserverTest, "UE5FSM.StateActionObserverTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineStateActionObserverTest::RunTest(const FString& Parameters)
+{
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
+
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FObserveStateActions(this, &TestActor));
 
 	// Finish test
 	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
@@ -712,23 +2854,27 @@ bool FFiniteStateMachineLatentExecutionTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStatesBlocklistTest, "UE5FSM.StatesBlocklist",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineSubStatesTest, "UE5FSM.SubStatesTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineStatesBlocklistTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineSubStatesTest::RunTest(const FString& Parameters)
 {
 	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
 	{
-		{ UMachineState_StatesBlocklistTest1::StaticClass(), "Begin", true },
-		{ UMachineState_StatesBlocklistTest1::StaticClass(), "End", true },
-		{ UMachineState_StatesBlocklistTest3::StaticClass(), "Begin", true },
-		{ UMachineState_StatesBlocklistTest3::StaticClass(), "End", true },
-		{ UMachineState_StatesBlocklistTest2::StaticClass(), "Begin", true },
-		{ UMachineState_StatesBlocklistTest2::StaticClass(), "End", true },
-		{ UMachineState_StatesBlocklistTest1::StaticClass(), "Begin", true },
-		{ UMachineState_StatesBlocklistTest1::StaticClass(), "Popped", true },
+		{ UMachineState_SubStatesTest::StaticClass(), "Begin", true },
+		{ UMachineState_SubStateTest1::StaticClass(), "Begin", true },
+		{ UMachineState_SubStateTest1::StaticClass(), "End", true },
+		{ UMachineState_SubStateTest2::StaticClass(), "Begin", true },
+		{ UMachineState_SubStateTest2::StaticClass(), "Paused", true },
+		{ UMachineState_SubStatesTest::StaticClass(), "Paused", true },
+		{ UMachineState_Test1::StaticClass(), "Pushed", true },
+		{ UMachineState_Test1::StaticClass(), "Popped", true },
+		{ UMachineState_SubStatesTest::StaticClass(), "Resumed", true },
+		{ UMachineState_SubStateTest2::StaticClass(), "Resumed", true },
+		{ UMachineState_SubStateTest2::StaticClass(), "End", true },
+		{ UMachineState_SubStatesTest::StaticClass(), "End", true },
 	};
 
 	// Setup environment and test objects
@@ -738,35 +2884,17 @@ bool FFiniteStateMachineStatesBlocklistTest::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	// Register states
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass()));
-
-	// Begin
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass()));
-
-	// 1 blocks 2, so it should fail. Going to 3 should work
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass()));
-
-	// 3 blocks 1, so it should fail. Going to 2 should work
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass()));
-
-	// 2 blocks 3, so it should fail. Going to 1 should work
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState_Fail(this, &TestActor, UMachineState_StatesBlocklistTest3::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StatesBlocklistTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_SubStatesTest::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
 
-	// Finish the test
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+	// Sub-states follow the lifecycle of their parent, and are ticked by the state machine along with it
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_SubStatesTest::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoSubState(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCheckSubStateTicks(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_SubStatesTest::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FEndState(this, &TestActor, nullptr));
 
 	// Check whether all predicted events took place in the correct order from the correct states
 	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
@@ -778,15 +2906,23 @@ bool FFiniteStateMachineStatesBlocklistTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineExternalPushPopTest, "UE5FSM.ExternalPushPopTest",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineRegionsTest, "UE5FSM.RegionsTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineExternalPushPopTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineRegionsTest::RunTest(const FString& Parameters)
 {
-	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
-	ExpectedTestMessages.Empty();
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_Test2::StaticClass(), "Begin", true },
+		{ UMachineState_Test1::StaticClass(), "Begin", true },
+		{ UMachineState_Test2::StaticClass(), "Paused", true },
+		{ UMachineState_Test3::StaticClass(), "Pushed", true },
+		{ UMachineState_Test3::StaticClass(), "Popped", true },
+		{ UMachineState_Test2::StaticClass(), "Resumed", true },
+		{ UMachineState_Test2::StaticClass(), "End", true },
+	};
 
 	// Setup environment and test objects
 	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
@@ -795,51 +2931,51 @@ bool FFiniteStateMachineExternalPushPopTest::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	// Register states
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushPopTest1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushPopTest2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushPopTest3::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
 
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_ExternalPushPopTest1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_ExternalPushPopTest1::StaticClass()));
+	// The region has its own stack, while sharing the registered states with the main one
+	ADD_LATENT_AUTOMATION_COMMAND(FRunRegion(this, &TestActor));
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Begin", true));
+	// Check whether all predicted events took place in the correct order from the correct states
+	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
 
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_ExternalPushPopTest2::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_ExternalPushPopTest2::StaticClass()));
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Paused", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Pushed", true));
+	return true;
+}
 
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_ExternalPushPopTest3::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_ExternalPushPopTest3::StaticClass()));
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineTransitionRulesTest, "UE5FSM.TransitionRulesTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Paused", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest3, "Pushed", true));
+bool FFiniteStateMachineTransitionRulesTest::RunTest(const FString& Parameters)
+{
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_TransitionRulesTest::StaticClass(), "Begin", true },
+		{ UMachineState_TransitionRulesTest::StaticClass(), "End", true },
+		{ UMachineState_Test2::StaticClass(), "Begin", true },
+	};
 
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest3, "Post default label", true));
-
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_ExternalPushPopTest2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest3, "Popped", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Resumed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Post default label", true));
-
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, UMachineState_ExternalPushPopTest1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest2, "Popped", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Resumed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Post default label", true));
-
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_TransitionRulesTest::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_ExternalPushPopTest1, "Popped", true));
+	// Rules are evaluated by the subsystem, and the first one that is met makes the state machine transit
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_TransitionRulesTest::StaticClass(), TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FEvaluateTransitionRules(this, &TestActor));
 
 	// Check whether all predicted events took place in the correct order from the correct states
 	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
@@ -851,15 +2987,18 @@ bool FFiniteStateMachineExternalPushPopTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStartWithNotByDefaultLabelTest, "UE5FSM.StartWithNotByDefaultLabelTest",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineTimeSlicingTest, "UE5FSM.TimeSlicingTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineStartWithNotByDefaultLabelTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineTimeSlicingTest::RunTest(const FString& Parameters)
 {
-	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
-	ExpectedTestMessages.Empty();
+	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	{
+		{ UMachineState_UrgentTest::StaticClass(), "Begin", true },
+		{ UMachineState_TimeSlicedTest::StaticClass(), "Begin", true },
+	};
 
 	// Setup environment and test objects
 	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
@@ -868,25 +3007,13 @@ bool FFiniteStateMachineStartWithNotByDefaultLabelTest::RunTest(const FString& P
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass()));
-
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Begin", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Post test label", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Popped", true));
-
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass(), TAG_StateMachine_Label_Test));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_StartWithNotDefaultLabel::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.1f)); // tick
-	ADD_LATENT_AUTOMATION_COMMAND(FPopState(this, &TestActor, nullptr));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_TimeSlicedTest::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_UrgentTest::StaticClass()));
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Begin", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Post test label", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_StartWithNotDefaultLabel, "Popped", true));
+	// The urgent state in the region is ticked every frame, while the other one waits for its turn
+	ADD_LATENT_AUTOMATION_COMMAND(FStartTimeSlicing(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.5f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCheckTimeSlicedTicks(this, &TestActor));
 
 	// Check whether all predicted events took place in the correct order from the correct states
 	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
@@ -898,47 +3025,21 @@ bool FFiniteStateMachineStartWithNotByDefaultLabelTest::RunTest(const FString& P
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineExternalPushPopTest2, "UE5FSM.ExternalPushPopTest2",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineLabelResumptionBudgetTest, "UE5FSM.LabelResumptionBudgetTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineExternalPushPopTest2::RunTest(const FString& Parameters)
+bool FFiniteStateMachineLabelResumptionBudgetTest::RunTest(const FString& Parameters)
 {
-	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
+	constexpr int32 OtherStateMachinesNum = 8;
+
+	TArray<FStateMachineTestMessage> ExpectedTestMessages;
+	ExpectedTestMessages.Add({ UMachineState_UrgentLabelResumptionTest::StaticClass(), "Begin", true });
+	for (int32 i = 0; i < OtherStateMachinesNum; i++)
 	{
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Begin", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Prior to push", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Paused", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Pushed", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Prior to push", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Paused", true },
-		{ UMachineState_ExternalPushTest3::StaticClass(), "Pushed", true },
-		{ UMachineState_ExternalPushTest3::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest3::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest3::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest3::StaticClass(), "Prior to pop", true },
-		{ UMachineState_ExternalPushTest3::StaticClass(), "Popped", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Resumed", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Prior to pop", true },
-		{ UMachineState_ExternalPushTest2::StaticClass(), "Popped", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Resumed", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Hello", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Prior to pop", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "Popped", true },
-		{ UMachineState_ExternalPushTest1::StaticClass(), "End test", true },
-	};
+		ExpectedTestMessages.Add({ UMachineState_LabelResumptionTest::StaticClass(), "Begin", true });
+	}
 
 	// Setup environment and test objects
 	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
@@ -947,15 +3048,14 @@ bool FFiniteStateMachineExternalPushPopTest2::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushTest1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushTest2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_ExternalPushTest3::StaticClass()));
-
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_ExternalPushTest1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FIsInState(this, &TestActor, UMachineState_ExternalPushTest1::StaticClass()));
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor,
+		UMachineState_UrgentLabelResumptionTest::StaticClass()));
 
-	// Wait until we're notified that the test has ended
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitPushPopMessage(this, "End test", 20.f, true));
+	// Labels of the states that are not urgent are deferred, but none of them is starved
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLabelResumptionBudget(this, &TestActor, OtherStateMachinesNum));
+	ADD_LATENT_AUTOMATION_COMMAND(FCheckDeferredLabelResumptions(this, &TestActor));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(2.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCheckLabelResumptions(this, &TestActor, OtherStateMachinesNum));
 
 	// Check whether all predicted events took place in the correct order from the correct states
 	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
@@ -967,97 +3067,41 @@ bool FFiniteStateMachineExternalPushPopTest2::RunTest(const FString& Parameters)
 	return true;
 }
 
-DEFINE_LATENT_AUTOMATION_COMMAND_TWO_PARAMETER(FFiniteStateMachineBlockedPushTest_LatentImpl,
-	FAutomationTestBase*, Test, AFiniteStateMachineTestActor**, TestActor);
-bool FFiniteStateMachineBlockedPushTest_LatentImpl::Update()
-{
-	LATENT_TEST_BEGIN();
-	StateMachine->RegisterState(UMachineState_BlockedPushTest1::StaticClass());
-	StateMachine->RegisterState(UMachineState_BlockedPushTest2::StaticClass());
-	StateMachine->RegisterState(UMachineState_BlockedPushTest3::StaticClass());
-	StateMachine->RegisterState(UMachineState_BlockedPushTest4::StaticClass());
-	StateMachine->RegisterState(UMachineState_BlockedPushTest5::StaticClass());
-
-	StateMachine->GotoState(UMachineState_BlockedPushTest1::StaticClass());
-
-	FFSM_PushRequestHandle Handle1;
-	StateMachine->PushStateQueued(Handle1, UMachineState_BlockedPushTest2::StaticClass());
-	LATENT_TEST_TRUE("Handle 1 is pending", Handle1.IsPending());
-	Handle1.BindOnResultCallback(FOnPendingPushRequestSignature::FDelegate::CreateLambda(
-		[] (EFSM_PendingPushRequestResult Result)
-		{
-			OnMessageDelegate.Broadcast( {
-				UMachineState_BlockedPushTest1::StaticClass(),
-				UEnum::GetValueAsString(Result),
-				true
-			});
-		}));
-
-	FFSM_PushRequestHandle Handle2;
-	StateMachine->PushStateQueued(Handle2, UMachineState_BlockedPushTest3::StaticClass());
-	LATENT_TEST_TRUE("Handle 2 is not pending", !Handle2.IsPending());
-
-	FFSM_PushRequestHandle Handle3;
-	StateMachine->PushStateQueued(Handle3, UMachineState_BlockedPushTest4::StaticClass());
-	LATENT_TEST_TRUE("Handle 3 is pending", Handle3.IsPending());
-	Handle3.BindOnResultCallback(FOnPendingPushRequestSignature::FDelegate::CreateLambda(
-		[] (EFSM_PendingPushRequestResult Result)
-		{
-			OnMessageDelegate.Broadcast({
-				UMachineState_BlockedPushTest4::StaticClass(),
-				UEnum::GetValueAsString(Result),
-			true
-			});
-		}));
-
-	StateMachine->PopState();
-
-	FFSM_PushRequestHandle Handle4;
-	StateMachine->PushStateQueued(Handle4, UMachineState_BlockedPushTest5::StaticClass());
-	LATENT_TEST_TRUE("Handle 4 is pending", Handle4.IsPending());
-	Handle4.BindOnResultCallback(FOnPendingPushRequestSignature::FDelegate::CreateLambda(
-		[] (EFSM_PendingPushRequestResult Result)
-		{
-			OnMessageDelegate.Broadcast({
-				UMachineState_BlockedPushTest5::StaticClass(),
-				UEnum::GetValueAsString(Result),
-			true
-			});
-		}));
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineCrowdTest, "UE5FSM.CrowdTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
 
-	StateMachine->PopState();
-	StateMachine->PopState();
+bool FFiniteStateMachineCrowdTest::RunTest(const FString& Parameters)
+{
+	// More than a single chunk
+	constexpr int32 AgentsNum = 1500;
 
-	FFSM_PushRequestHandle Handle5;
-	StateMachine->PushStateQueued(Handle5, UMachineState_BlockedPushTest5::StaticClass());
-	LATENT_TEST_TRUE("Handle 5 is pending", Handle5.IsPending());
-	Handle5.BindOnResultCallback(FOnPendingPushRequestSignature::FDelegate::CreateLambda(
-		[] (EFSM_PendingPushRequestResult Result)
-		{
-			OnMessageDelegate.Broadcast({
-				UMachineState_BlockedPushTest5::StaticClass(),
-				UEnum::GetValueAsString(Result),
-			true
-			});
-		}));
+	// Setup environment and test objects
+	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
+	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	Handle5.Cancel();
+	// Agents go through the states together, and their stacks are kept by the subsystem
+	ADD_LATENT_AUTOMATION_COMMAND(FRunCrowd(this, &TestActor, AgentsNum));
 
-	StateMachine->PopState();
-	StateMachine->PopState();
+	// Finish test
+	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
 
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineBlockedPushTest, "UE5FSM.BlockedPushTest",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineMassCrowdTest, "UE5FSM.MassCrowdTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineBlockedPushTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineMassCrowdTest::RunTest(const FString& Parameters)
 {
-	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
-	ExpectedTestMessages.Empty();
+	constexpr int32 EntitiesNum = 3;
 
 	// Setup environment and test objects
 	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
@@ -1066,39 +3110,8 @@ bool FFiniteStateMachineBlockedPushTest::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
-	ADD_LATENT_AUTOMATION_COMMAND(FFiniteStateMachineBlockedPushTest_LatentImpl(this, &TestActor));
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Begin", true));
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Paused", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Pushed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "EFSM_PendingPushRequestResult::Success", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Paused", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest2, "Pushed", true));
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest2, "Popped", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Resumed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest4, "EFSM_PendingPushRequestResult::Success", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Paused", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest4, "Pushed", true));
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest4, "Popped", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Resumed", true));
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest3, "Popped", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Resumed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest5, "EFSM_PendingPushRequestResult::Success", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Paused", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest5, "Pushed", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest5, "EFSM_PendingPushRequestResult::Canceled", true));
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest5, "Popped", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Resumed", true));
-
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_BlockedPushTest1, "Popped", true));
-
-	// Check whether all predicted events took place in the correct order from the correct states
-	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+	// Entities run the crowd states of the subsystem, and their stacks are kept in their fragments
+	ADD_LATENT_AUTOMATION_COMMAND(FRunMassCrowd(this, &TestActor, EntitiesNum));
 
 	// Finish test
 	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
@@ -1107,65 +3120,79 @@ bool FFiniteStateMachineBlockedPushTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineLatentActionTest, "UE5FSM.LatentActionTest",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineStaticStateMachineTest, "UE5FSM.StaticStateMachineTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineLatentActionTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineStaticStateMachineTest::RunTest(const FString& Parameters)
 {
-	static TArray<FStateMachineTestMessage> ExpectedTestMessages;
-	ExpectedTestMessages.Empty();
+	using FTest1 = TStaticMachineState_Test<1>;
+	using FTest2 = TStaticMachineState_Test<2>;
+	using FTest3 = TStaticMachineState_Test<3>;
 
-	// Setup environment and test objects
-	ADD_LATENT_AUTOMATION_COMMAND(FStartLatentTest());
-	ADD_LATENT_AUTOMATION_COMMAND(FEditorLoadMap(FString("/Engine/Maps/Entry")));
-	ADD_LATENT_AUTOMATION_COMMAND(FStartPIECommand(true));
-	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
-	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
+	StaticTestMessages.Reset();
+	FStaticTestStateMachine StateMachine;
 
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_LatentActions1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_LatentActions2::StaticClass()));
+	TestTrue("Go to state", StateMachine.GotoState<FTest1>());
+	TestTrue("Go to the active state", StateMachine.GotoState<FTest1>());
+	TestTrue("Push state", StateMachine.PushState<FTest2>());
+	TestFalse("Push state that is already on the stack", StateMachine.PushState<FTest1>());
+	TestTrue("Pushed state is active", StateMachine.IsInState<FTest2>());
+	TestTrue("Paused state is on the stack", StateMachine.IsInState<FTest1>(true));
+	TestEqual("Stack depth", StateMachine.GetStackDepth(), 2);
 
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_LatentActions1::StaticClass(), TAG_StateMachine_Label_Default));
+	StateMachine.Tick(0.1f);
+	TestEqual("Only the active state is ticked", StateMachine.GetState<FTest2>().TicksNum, 1);
+	TestEqual("Paused state is not ticked", StateMachine.GetState<FTest1>().TicksNum, 0);
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_LatentActions1, "Begin", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_LatentActions1, "End", true));
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_LatentActions2, "Begin", true));
+	TestTrue("Pop state", StateMachine.PopState());
 
-	ADD_LATENT_AUTOMATION_COMMAND(FEndState(this, &TestActor, nullptr));
+	// The third state goes to the first one once it begins; the transition is performed after the current one
+	TestTrue("Go to state going to another one", StateMachine.GotoState<FTest3>());
+	TestTrue("Queued transition has been performed", StateMachine.IsInState<FTest1>());
+	TestEqual("Stack depth", StateMachine.GetStackDepth(), 1);
 
-	ExpectedTestMessages.Add(PREDICTED_TEST_MESSAGE(UMachineState_LatentActions2, "End", true));
+	TestTrue("Pop last state", StateMachine.PopState());
+	TestFalse("Pop from empty stack", StateMachine.PopState());
+	TestEqual("No active state", StateMachine.GetActiveStateIndex(), static_cast<int32>(INDEX_NONE));
 
-	// Check whether all predicted events took place in the correct order from the correct states
-	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
+	const TArray<FString> ExpectedMessages =
+	{
+		TEXT("Test1 Begin -1"),
+		TEXT("Test1 Paused 1"),
+		TEXT("Test2 Pushed 0"),
+		TEXT("Test2 Popped 0"),
+		TEXT("Test1 Resumed 1"),
+		TEXT("Test1 End 2"),
+		TEXT("Test3 Begin 0"),
+		TEXT("Test3 End 0"),
+		TEXT("Test1 Begin 2"),
+		TEXT("Test1 Popped -1"),
+	};
 
-	// Finish test
-	ADD_LATENT_AUTOMATION_COMMAND(FEndLatentTest());
-	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+	TestEqual("Messages number", StaticTestMessages.Num(), ExpectedMessages.Num());
+	for (int32 i = 0; i < FMath::Min(StaticTestMessages.Num(), ExpectedMessages.Num()); i++)
+	{
+		TestEqual(FString::Printf(TEXT("Message [%d]"), i), StaticTestMessages[i], ExpectedMessages[i]);
+	}
 
 	return true;
 }
 
-IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineClearStackTest, "UE5FSM.ClearStackTest",
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineTickOnlyStateTest, "UE5FSM.TickOnlyStateTest",
 	EAutomationTestFlags::ApplicationContextMask |
 	EAutomationTestFlags::HighPriority |
 	EAutomationTestFlags::ProductFilter);
 
-bool FFiniteStateMachineClearStackTest::RunTest(const FString& Parameters)
+bool FFiniteStateMachineTickOnlyStateTest::RunTest(const FString& Parameters)
 {
+	// The default label of the state would report a failure if it ever got activated
 	static const TArray<FStateMachineTestMessage> ExpectedTestMessages
 	{
+		{ UMachineState_TickOnlyTest::StaticClass(), "Begin", true },
+		{ UMachineState_TickOnlyTest::StaticClass(), "End", true },
 		{ UMachineState_Test1::StaticClass(), "Begin", true },
-		{ UMachineState_Test1::StaticClass(), "Paused", true },
-		{ UMachineState_Test2::StaticClass(), "Pushed", true },
-		{ UMachineState_Test2::StaticClass(), "Paused", true },
-		{ UMachineState_Test3::StaticClass(), "Pushed", true },
-		{ UMachineState_Test3::StaticClass(), "End", true },
-		{ UMachineState_Test2::StaticClass(), "Resumed", true },
-		{ UMachineState_Test2::StaticClass(), "End", true },
-		{ UMachineState_Test1::StaticClass(), "Resumed", true },
-		{ UMachineState_Test1::StaticClass(), "End", true },
 	};
 
 	// Setup environment and test objects
@@ -1175,15 +3202,14 @@ bool FFiniteStateMachineClearStackTest::RunTest(const FString& Parameters)
 	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(1.f));
 	ADD_LATENT_AUTOMATION_COMMAND(FCreateTestActor(this, &TestActor));
 
+	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_TickOnlyTest::StaticClass()));
 	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test1::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test2::StaticClass()));
-	ADD_LATENT_AUTOMATION_COMMAND(FRegisterState(this, &TestActor, UMachineState_Test3::StaticClass()));
-
-	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_Test1::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test2::StaticClass(), TAG_StateMachine_Label_Default));
-	ADD_LATENT_AUTOMATION_COMMAND(FPushState(this, &TestActor, UMachineState_Test3::StaticClass(), TAG_StateMachine_Label_Default));
 
-	ADD_LATENT_AUTOMATION_COMMAND(FClearStack(this, &TestActor, 3));
+	// The state is ticked for a while without activating any label, then leaves without any label to stop
+	ADD_LATENT_AUTOMATION_COMMAND(FGotoState(this, &TestActor, UMachineState_TickOnlyTest::StaticClass(),
+		TAG_StateMachine_Label_Default));
+	ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.2f));
+	ADD_LATENT_AUTOMATION_COMMAND(FCheckTickOnlyState(this, &TestActor));
 
 	// Check whether all predicted events took place in the correct order from the correct states
 	ADD_LATENT_AUTOMATION_COMMAND(FCompareTestMessages(this, ExpectedTestMessages));
@@ -1195,4 +3221,47 @@ bool FFiniteStateMachineClearStackTest::RunTest(const FString& Parameters)
 	return true;
 }
 
-#endif
\ No newline at end of file
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FFiniteStateMachineK2EventsCacheTest, "UE5FSM.K2EventsCacheTest",
+	EAutomationTestFlags::ApplicationContextMask |
+	EAutomationTestFlags::HighPriority |
+	EAutomationTestFlags::ProductFilter);
+
+bool FFiniteStateMachineK2EventsCacheTest::RunTest(const FString& Parameters)
+{
+	const FName BlueprintName = MakeUniqueObjectName(GetTransientPackage(), UBlueprint::StaticClass(),
+		TEXT("MachineState_K2EventsCacheTest"));
+	UBlueprint* Blueprint = FKismetEditorUtilities::CreateBlueprint(UMachineState::StaticClass(),
+		GetTransientPackage(), BlueprintName, BPTYPE_Normal, UBlueprint::StaticClass(),
+		UBlueprintGeneratedClass::StaticClass());
+	if (!TestNotNull("Blueprint", Blueprint))
+	{
+		return false;
+	}
+
+	const UClass* StateClass = Blueprint->GeneratedClass;
+	const uint16 OnBeganBit = 1 << static_cast<uint8>(UMachineState::EK2Event::OnBegan);
+	TestTrue("OnBegan is not implemented", (UMachineState::GetImplementedK2Events(StateClass) & OnBeganBit) == 0);
+
+	// Implement the event, and recompile the class in place
+	int32 NodePositionY = 0;
+	UK2Node_Event* EventNode = FKismetEditorUtilities::AddDefaultEventNode(Blueprint,
+		FBlueprintEditorUtils::FindEventGraph(Blueprint), GET_FUNCTION_NAME_CHECKED(UMachineState, K2_OnBegan),
+		UMachineState::StaticClass(), NodePositionY);
+	if (!TestNotNull("Event node", EventNode))
+	{
+		return false;
+	}
+
+	// Default event nodes are placed disabled
+	EventNode->SetEnabledState(ENodeEnabledState::Enabled, false);
+	FKismetEditorUtilities::CompileBlueprint(Blueprint);
+
+	TestTrue("Class is recompiled in place", Blueprint->GeneratedClass == StateClass);
+	TestTrue("OnBegan is implemented", (UMachineState::GetImplementedK2Events(StateClass) & OnBeganBit) != 0);
+
+	FBlueprintEditorUtils::RemoveGeneratedClasses(Blueprint);
+	Blueprint->MarkAsGarbage();
+	return true;
+}
+
+#endif
@@ -20,11 +20,21 @@ public class UE5FSMTests : ModuleRules
             }
         );
 
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "MassEntity",
+                "UE5FSM_Mass",
+            }
+        );
+
 		if (Target.Type == TargetType.Editor)
 		{
 			PrivateDependencyModuleNames.AddRange(
 				new string[]
 				{
+					"BlueprintGraph",
+					"UE5FSMEditor",
 					"UnrealEd",
 				}
 			);
@@ -0,0 +1,189 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/MassCrowdBackend.h"
+
+#include "Algo/StableSort.h"
+#include "FiniteStateMachine/FiniteStateMachineLog.h"
+#include "MassExecutionContext.h"
+
+const FName FFSM_MassCrowdBackend::BackendName = "Mass";
+
+FName FFSM_MassCrowdBackend::GetBackendName() const
+{
+	return BackendName;
+}
+
+float FFSM_MassCrowdBackend::GetStateTime(int32 AgentIndex) const
+{
+	return Fragments[AgentIndex].StateTime;
+}
+
+float FFSM_MassCrowdBackend::GetLabelTime(int32 AgentIndex) const
+{
+	return Fragments[AgentIndex].LabelTime;
+}
+
+void FFSM_MassCrowdBackend::RequestGotoState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+	FGameplayTag Label)
+{
+	int32 StateIndex;
+	int32 LabelIndex;
+	if (Subsystem->ResolveStateLabel(InStateClass, Label, StateIndex, LabelIndex))
+	{
+		TransitionRequests.Add({ AgentIndex, StateIndex, LabelIndex, ETransitionType::Goto });
+	}
+}
+
+void FFSM_MassCrowdBackend::RequestGotoLabel(int32 AgentIndex, FGameplayTag Label)
+{
+	const FFSM_MassStateMachineFragment& Fragment = Fragments[AgentIndex];
+	if (!Fragment.HasActiveState())
+	{
+		return;
+	}
+
+	// The label is bound to the state that is active at the moment of the request
+	const int32 LabelIndex = Subsystem->GetStateByIndex(Fragment.StateIndex)->FindLabelIndex(Label);
+	if (LabelIndex == INDEX_NONE)
+	{
+		FSM_LOG(Warning, "Label [%s] is not present in state [%s].", *Label.ToString(),
+			*Subsystem->GetStateByIndex(Fragment.StateIndex)->GetClass()->GetName());
+		return;
+	}
+
+	TransitionRequests.Add({ AgentIndex, Fragment.StateIndex, LabelIndex, ETransitionType::GotoLabel });
+}
+
+void FFSM_MassCrowdBackend::RequestPushState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+	FGameplayTag Label)
+{
+	int32 StateIndex;
+	int32 LabelIndex;
+	if (Subsystem->ResolveStateLabel(InStateClass, Label, StateIndex, LabelIndex))
+	{
+		TransitionRequests.Add({ AgentIndex, StateIndex, LabelIndex, ETransitionType::Push });
+	}
+}
+
+void FFSM_MassCrowdBackend::RequestPopState(int32 AgentIndex)
+{
+	TransitionRequests.Add({ AgentIndex, INDEX_NONE, INDEX_NONE, ETransitionType::Pop });
+}
+
+UCrowdMachineState* FFSM_MassCrowdBackend::GetStateByIndex(int32 StateIndex) const
+{
+	return Subsystem->GetStateByIndex(StateIndex);
+}
+
+const FFSM_MassCrowdBackend* FFSM_MassCrowdBackend::Get(const FFSM_CrowdChunk& Chunk)
+{
+	const bool bIsMassBackend = Chunk.Backend && Chunk.Backend->GetBackendName() == BackendName;
+	return bIsMassBackend ? static_cast<const FFSM_MassCrowdBackend*>(Chunk.Backend) : nullptr;
+}
+
+FMassExecutionContext& FFSM_MassCrowdBackend::GetExecutionContext() const
+{
+	check(Context);
+	return *Context;
+}
+
+FMassEntityHandle FFSM_MassCrowdBackend::GetEntity(int32 AgentIndex) const
+{
+	return GetExecutionContext().GetEntity(AgentIndex);
+}
+
+bool FFSM_MassCrowdBackend::GetAgentState(int32 AgentIndex, FAgentState& OutAgent)
+{
+	FFSM_MassStateMachineFragment& Fragment = Fragments[AgentIndex];
+	OutAgent.ActiveState = &Fragment.StateIndex;
+	OutAgent.ActiveLabel = &Fragment.LabelIndex;
+	OutAgent.StateTime = &Fragment.StateTime;
+	OutAgent.LabelTime = &Fragment.LabelTime;
+	OutAgent.StackDepth = &Fragment.StackDepth;
+	OutAgent.StackStates = Fragment.StackStates;
+	OutAgent.StackLabels = Fragment.StackLabels;
+	return true;
+}
+
+void FFSM_MassCrowdBackend::Process(UCrowdStateMachineSubsystem& InSubsystem, FMassExecutionContext& InContext,
+	float DeltaTime)
+{
+	Subsystem = &InSubsystem;
+	Context = &InContext;
+	Fragments = InContext.GetMutableFragmentView<FFSM_MassStateMachineFragment>();
+
+	// New entities begin their initial states before their first labels, and before the requested transitions
+	for (int32 AgentIndex = 0; AgentIndex < Fragments.Num(); AgentIndex++)
+	{
+		FFSM_MassStateMachineFragment& Fragment = Fragments[AgentIndex];
+		if (!Fragment.HasActiveState() && Fragment.StateIndex != INDEX_NONE)
+		{
+			TransitionRequests.Add({ AgentIndex, Fragment.StateIndex, Fragment.LabelIndex, ETransitionType::Goto });
+		}
+
+		FTransitionRequest Request;
+		if (Fragment.ConsumeRequestedTransition(Request))
+		{
+			Request.AgentIndex = AgentIndex;
+			TransitionRequests.Add(Request);
+		}
+	}
+
+	ApplyTransitionRequests();
+
+	// Mass chunks are small enough to sort the agents instead of bucketing them
+	SortedAgents.Reset();
+	for (int32 AgentIndex = 0; AgentIndex < Fragments.Num(); AgentIndex++)
+	{
+		if (Fragments[AgentIndex].HasActiveState())
+		{
+			SortedAgents.Add(AgentIndex);
+		}
+	}
+
+	Algo::StableSort(SortedAgents, [this] (int32 Lhs, int32 Rhs)
+	{
+		const FFSM_MassStateMachineFragment& LhsFragment = Fragments[Lhs];
+		const FFSM_MassStateMachineFragment& RhsFragment = Fragments[Rhs];
+		return LhsFragment.StateIndex != RhsFragment.StateIndex
+			? LhsFragment.StateIndex < RhsFragment.StateIndex
+			: LhsFragment.LabelIndex < RhsFragment.LabelIndex;
+	});
+
+	for (int32 GroupStart = 0; GroupStart < SortedAgents.Num(); )
+	{
+		const FFSM_MassStateMachineFragment& First = Fragments[SortedAgents[GroupStart]];
+
+		int32 GroupEnd = GroupStart + 1;
+		for (; GroupEnd < SortedAgents.Num(); GroupEnd++)
+		{
+			const FFSM_MassStateMachineFragment& Fragment = Fragments[SortedAgents[GroupEnd]];
+			if (Fragment.StateIndex != First.StateIndex || Fragment.LabelIndex != First.LabelIndex)
+			{
+				break;
+			}
+		}
+
+		UCrowdMachineState* State = Subsystem->GetStateByIndex(First.StateIndex);
+		const int32 LabelIndex = First.LabelIndex;
+		ForEachChunk(TConstArrayView<int32>(SortedAgents).Slice(GroupStart, GroupEnd - GroupStart), DeltaTime,
+			[State, LabelIndex] (const FFSM_CrowdChunk& Chunk)
+			{
+				State->ExecuteLabel(LabelIndex, Chunk);
+			});
+
+		GroupStart = GroupEnd;
+	}
+
+	for (FFSM_MassStateMachineFragment& Fragment : Fragments)
+	{
+		Fragment.StateTime += DeltaTime;
+		Fragment.LabelTime += DeltaTime;
+	}
+
+	ApplyTransitionRequests();
+
+	Subsystem = nullptr;
+	Context = nullptr;
+	Fragments = TArrayView<FFSM_MassStateMachineFragment>();
+}
@@ -0,0 +1,101 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/MassStateMachineFragment.h"
+
+#include "FiniteStateMachine/FiniteStateMachineLog.h"
+
+FFSM_MassStateMachineFragment FFSM_MassStateMachineFragment::Make(const UObject* WorldContextObject,
+	TSubclassOf<UCrowdMachineState> InitialState, FGameplayTag Label)
+{
+	FFSM_MassStateMachineFragment Fragment;
+
+	UCrowdStateMachineSubsystem* Subsystem = UCrowdStateMachineSubsystem::Get(WorldContextObject);
+	if (!IsValid(Subsystem) || !Subsystem->ResolveStateLabel(InitialState, Label, Fragment.StateIndex,
+		Fragment.LabelIndex))
+	{
+		Fragment.StateIndex = INDEX_NONE;
+		Fragment.LabelIndex = INDEX_NONE;
+	}
+
+	return Fragment;
+}
+
+bool FFSM_MassStateMachineFragment::RequestGotoState(const UObject* WorldContextObject,
+	TSubclassOf<UCrowdMachineState> InStateClass, FGameplayTag Label)
+{
+	return RequestStateTransition(WorldContextObject, InStateClass, Label,
+		FFSM_CrowdBackendBase::ETransitionType::Goto);
+}
+
+bool FFSM_MassStateMachineFragment::RequestGotoLabel(const UObject* WorldContextObject, FGameplayTag Label)
+{
+	// An entity that hasn't been processed yet goes to the label of its initial state
+	UCrowdStateMachineSubsystem* Subsystem = UCrowdStateMachineSubsystem::Get(WorldContextObject);
+	if (!IsValid(Subsystem) || StateIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// The label is bound to the state that is active at the moment of the request
+	const UCrowdMachineState* State = Subsystem->GetStateByIndex(StateIndex);
+	const int32 RequestedLabelIndex = State->FindLabelIndex(Label);
+	if (RequestedLabelIndex == INDEX_NONE)
+	{
+		FSM_LOG(Warning, "Label [%s] is not present in state [%s].", *Label.ToString(),
+			*State->GetClass()->GetName());
+		return false;
+	}
+
+	RequestedTransition =
+		{ INDEX_NONE, StateIndex, RequestedLabelIndex, FFSM_CrowdBackendBase::ETransitionType::GotoLabel };
+	bHasRequestedTransition = true;
+	return true;
+}
+
+bool FFSM_MassStateMachineFragment::RequestPushState(const UObject* WorldContextObject,
+	TSubclassOf<UCrowdMachineState> InStateClass, FGameplayTag Label)
+{
+	return RequestStateTransition(WorldContextObject, InStateClass, Label,
+		FFSM_CrowdBackendBase::ETransitionType::Push);
+}
+
+bool FFSM_MassStateMachineFragment::RequestPopState()
+{
+	if (StateIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	RequestedTransition = { INDEX_NONE, INDEX_NONE, INDEX_NONE, FFSM_CrowdBackendBase::ETransitionType::Pop };
+	bHasRequestedTransition = true;
+	return true;
+}
+
+bool FFSM_MassStateMachineFragment::ConsumeRequestedTransition(FFSM_CrowdBackendBase::FTransitionRequest& OutRequest)
+{
+	if (!bHasRequestedTransition)
+	{
+		return false;
+	}
+
+	OutRequest = RequestedTransition;
+	bHasRequestedTransition = false;
+	return true;
+}
+
+bool FFSM_MassStateMachineFragment::RequestStateTransition(const UObject* WorldContextObject,
+	TSubclassOf<UCrowdMachineState> InStateClass, FGameplayTag Label, FFSM_CrowdBackendBase::ETransitionType Type)
+{
+	int32 RequestedStateIndex;
+	int32 RequestedLabelIndex;
+	UCrowdStateMachineSubsystem* Subsystem = UCrowdStateMachineSubsystem::Get(WorldContextObject);
+	if (!IsValid(Subsystem) || !Subsystem->ResolveStateLabel(InStateClass, Label, RequestedStateIndex,
+		RequestedLabelIndex))
+	{
+		return false;
+	}
+
+	RequestedTransition = { INDEX_NONE, RequestedStateIndex, RequestedLabelIndex, Type };
+	bHasRequestedTransition = true;
+	return true;
+}
@@ -0,0 +1,39 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "FiniteStateMachine/MassStateMachineProcessor.h"
+
+#include "Engine/World.h"
+#include "MassExecutionContext.h"
+
+DECLARE_CYCLE_STAT(TEXT("Process Mass state machines"), STAT_FSM_ProcessMass, STATGROUP_FiniteStateMachine);
+
+UMassStateMachineProcessor::UMassStateMachineProcessor()
+	: EntityQuery(*this)
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ProcessingPhase = EMassProcessingPhase::PrePhysics;
+
+	// Labels and events are free to access objects that live on the game thread
+	bRequiresGameThreadExecution = true;
+}
+
+void UMassStateMachineProcessor::ConfigureQueries()
+{
+	EntityQuery.AddRequirement<FFSM_MassStateMachineFragment>(EMassFragmentAccess::ReadWrite);
+}
+
+void UMassStateMachineProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	SCOPE_CYCLE_COUNTER(STAT_FSM_ProcessMass);
+
+	UCrowdStateMachineSubsystem* Subsystem = UCrowdStateMachineSubsystem::Get(EntityManager.GetWorld());
+	if (!IsValid(Subsystem))
+	{
+		return;
+	}
+
+	EntityQuery.ForEachEntityChunk(EntityManager, Context, [this, Subsystem] (FMassExecutionContext& ChunkContext)
+	{
+		Backend.Process(*Subsystem, ChunkContext, ChunkContext.GetDeltaTimeSeconds());
+	});
+}
@@ -0,0 +1,17 @@
+﻿// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#include "UE5FSM_Mass.h"
+
+#define LOCTEXT_NAMESPACE "FUE5FSM_MassModule"
+
+void FUE5FSM_MassModule::StartupModule()
+{
+}
+
+void FUE5FSM_MassModule::ShutdownModule()
+{
+}
+
+#undef LOCTEXT_NAMESPACE
+
+IMPLEMENT_MODULE(FUE5FSM_MassModule, UE5FSM_Mass)
@@ -0,0 +1,94 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/MassStateMachineFragment.h"
+
+struct FMassExecutionContext;
+
+/**
+ * Backend running the crowd states of the entities of a single Mass chunk. Agent indices are the indices of the
+ * entities within the Mass chunk.
+ *
+ * Labels and events can access the fragments of the entities through the execution context:
+ * @code
+ * if (const FFSM_MassCrowdBackend* MassBackend = FFSM_MassCrowdBackend::Get(Chunk))
+ * {
+ *     const TConstArrayView<FTransformFragment> Transforms =
+ *         MassBackend->GetExecutionContext().GetFragmentView<FTransformFragment>();
+ * }
+ * @endcode
+ * The fragments have to be required by the query of the processor, though. Subclass UMassStateMachineProcessor to add
+ * the requirements.
+ */
+class UE5FSM_MASS_API FFSM_MassCrowdBackend
+	: public FFSM_CrowdBackendBase
+{
+public:
+	/** Name of the backend. */
+	static const FName BackendName;
+
+public:
+	//~ICrowdStateMachineBackend Interface
+	virtual FName GetBackendName() const override;
+	virtual float GetStateTime(int32 AgentIndex) const override;
+	virtual float GetLabelTime(int32 AgentIndex) const override;
+	virtual void RequestGotoState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label) override;
+	virtual void RequestGotoLabel(int32 AgentIndex, FGameplayTag Label) override;
+	virtual void RequestPushState(int32 AgentIndex, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label) override;
+	virtual void RequestPopState(int32 AgentIndex) override;
+	//~End of ICrowdStateMachineBackend Interface
+
+	//~FFSM_CrowdBackendBase Interface
+	virtual UCrowdMachineState* GetStateByIndex(int32 StateIndex) const override;
+	//~End of FFSM_CrowdBackendBase Interface
+
+	/**
+	 * Get the Mass backend the agents of a chunk belong to.
+	 * @param	Chunk chunk of agents.
+	 * @return	Mass backend. nullptr if the agents belong to another backend.
+	 */
+	static const FFSM_MassCrowdBackend* Get(const FFSM_CrowdChunk& Chunk);
+
+	/**
+	 * Get the execution context of the Mass chunk being processed.
+	 * @return	Execution context.
+	 */
+	FMassExecutionContext& GetExecutionContext() const;
+
+	/**
+	 * Get the entity of an agent.
+	 * @param	AgentIndex index of the agent.
+	 * @return	Entity handle.
+	 */
+	FMassEntityHandle GetEntity(int32 AgentIndex) const;
+
+	/**
+	 * Begin the initial states of the new entities of a Mass chunk, perform the transitions requested through their
+	 * fragments, call the labels of the active states, advance the timers, and perform the requested transitions.
+	 * @param	InSubsystem subsystem owning the shared instances of the states.
+	 * @param	InContext execution context of the Mass chunk.
+	 * @param	DeltaTime time since the previous processing.
+	 */
+	void Process(UCrowdStateMachineSubsystem& InSubsystem, FMassExecutionContext& InContext, float DeltaTime);
+
+protected:
+	//~FFSM_CrowdBackendBase Interface
+	virtual bool GetAgentState(int32 AgentIndex, FAgentState& OutAgent) override;
+	//~End of FFSM_CrowdBackendBase Interface
+
+private:
+	/** Subsystem owning the shared instances of the states. Set only while processing. */
+	UCrowdStateMachineSubsystem* Subsystem = nullptr;
+
+	/** Execution context of the Mass chunk. Set only while processing. */
+	FMassExecutionContext* Context = nullptr;
+
+	/** Fragments of the entities of the Mass chunk. */
+	TArrayView<FFSM_MassStateMachineFragment> Fragments;
+
+	/** Agents having an active state sorted by their state and label. */
+	TArray<int32> SortedAgents;
+};
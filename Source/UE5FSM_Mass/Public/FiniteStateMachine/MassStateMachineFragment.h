@@ -0,0 +1,135 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/CrowdStateMachineSubsystem.h"
+#include "MassEntityTypes.h"
+
+#include "MassStateMachineFragment.generated.h"
+
+/**
+ * Compact state machine of a Mass entity running crowd states. Processed by UMassStateMachineProcessor.
+ *
+ * The state and label indices are the ones of UCrowdStateMachineSubsystem, which owns the shared instances of the
+ * states.
+ *
+ * Gameplay code requests transitions through the fragment of an entity, and they're performed on its next processing:
+ * @code
+ * FFSM_MassStateMachineFragment& Fragment =
+ *     EntityManager.GetFragmentDataChecked<FFSM_MassStateMachineFragment>(Entity);
+ * Fragment.RequestPushState(this, UCrowdMachineState_Flee::StaticClass());
+ * @endcode
+ */
+USTRUCT()
+struct UE5FSM_MASS_API FFSM_MassStateMachineFragment
+	: public FMassFragment
+{
+	GENERATED_BODY()
+
+public:
+	/** Maximum amount of states on the stack of an entity, including the active one. */
+	static constexpr int32 MaxStackDepth = FFSM_CrowdBackendBase::MaxStackDepth;
+
+public:
+	/**
+	 * Create the fragment of an entity that is to start with a given state. The state begins on the first processing of
+	 * the entity.
+	 * @param	WorldContextObject object to get the world the entity is in from.
+	 * @param	InitialState state the entity starts with.
+	 * @param	Label label the initial state starts with.
+	 * @return	Fragment. It has no state if the initial state or label are invalid.
+	 */
+	static FFSM_MassStateMachineFragment Make(const UObject* WorldContextObject,
+		TSubclassOf<UCrowdMachineState> InitialState, FGameplayTag Label = TAG_StateMachine_Label_Default);
+
+	/**
+	 * Check whether the entity has an active state.
+	 * @return	If true, there's an active state, false otherwise.
+	 */
+	bool HasActiveState() const
+	{
+		return StackDepth > 0;
+	}
+
+	/**
+	 * Request the entity to go to a state. Only the latest request is performed.
+	 * @param	WorldContextObject object to get the world the entity is in from.
+	 * @param	InStateClass state to go to.
+	 * @param	Label label to start the state with.
+	 * @return	If true, the transition has been requested, false otherwise.
+	 */
+	bool RequestGotoState(const UObject* WorldContextObject, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default);
+
+	/**
+	 * Request the entity to go to a label of its active state. Only the latest request is performed.
+	 * @param	WorldContextObject object to get the world the entity is in from.
+	 * @param	Label label to go to.
+	 * @return	If true, the transition has been requested, false otherwise.
+	 */
+	bool RequestGotoLabel(const UObject* WorldContextObject, FGameplayTag Label);
+
+	/**
+	 * Request the entity to push a state. Only the latest request is performed.
+	 * @param	WorldContextObject object to get the world the entity is in from.
+	 * @param	InStateClass state to push.
+	 * @param	Label label to start the state with.
+	 * @return	If true, the transition has been requested, false otherwise.
+	 */
+	bool RequestPushState(const UObject* WorldContextObject, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label = TAG_StateMachine_Label_Default);
+
+	/**
+	 * Request the entity to pop its active state. Only the latest request is performed.
+	 * @return	If true, the transition has been requested, false otherwise.
+	 */
+	bool RequestPopState();
+
+	/**
+	 * Take the transition requested by the gameplay code, if any.
+	 * @param	OutRequest output parameter. Requested transition.
+	 * @return	If true, a transition has been requested, false otherwise.
+	 */
+	bool ConsumeRequestedTransition(FFSM_CrowdBackendBase::FTransitionRequest& OutRequest);
+
+private:
+	/**
+	 * Resolve a state and its label, and store the request.
+	 * @param	WorldContextObject object to get the world the entity is in from.
+	 * @param	InStateClass state class.
+	 * @param	Label label of the state.
+	 * @param	Type kind of the transition.
+	 * @return	If true, the transition has been requested, false otherwise.
+	 */
+	bool RequestStateTransition(const UObject* WorldContextObject, TSubclassOf<UCrowdMachineState> InStateClass,
+		FGameplayTag Label, FFSM_CrowdBackendBase::ETransitionType Type);
+
+public:
+	/** Index of the active state. If there's no active state yet, it's the one to begin with. */
+	int32 StateIndex = INDEX_NONE;
+
+	/** Index of the active label within the active state. */
+	int32 LabelIndex = INDEX_NONE;
+
+	/** Time since the active state has been entered. */
+	float StateTime = 0.f;
+
+	/** Time since the active label has been entered. */
+	float LabelTime = 0.f;
+
+	/** Amount of states on the stack, including the active one. */
+	uint8 StackDepth = 0;
+
+	/** Paused states below the active one. */
+	int32 StackStates[MaxStackDepth] = {};
+
+	/** Labels of the paused states. */
+	int32 StackLabels[MaxStackDepth] = {};
+
+private:
+	/** Transition requested by the gameplay code. Its agent index is set once it's processed. */
+	FFSM_CrowdBackendBase::FTransitionRequest RequestedTransition;
+
+	/** If true, RequestedTransition is waiting to be performed, false otherwise. */
+	bool bHasRequestedTransition = false;
+};
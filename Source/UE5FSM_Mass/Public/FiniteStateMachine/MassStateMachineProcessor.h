@@ -0,0 +1,40 @@
+// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+#pragma once
+
+#include "FiniteStateMachine/MassCrowdBackend.h"
+#include "MassEntityQuery.h"
+#include "MassProcessor.h"
+
+#include "MassStateMachineProcessor.generated.h"
+
+/**
+ * Processor running the crowd states of the entities having FFSM_MassStateMachineFragment, one Mass chunk at a time.
+ *
+ * The states are the same UCrowdMachineState classes UCrowdStateMachineSubsystem runs, and their shared instances are
+ * owned by it; the Mass entities only keep their compact state machines in their fragments. Transitions requested by
+ * the labels of a Mass chunk are performed once all of its labels have been called.
+ */
+UCLASS()
+class UE5FSM_MASS_API UMassStateMachineProcessor
+	: public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UMassStateMachineProcessor();
+
+protected:
+	//~UMassProcessor Interface
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+	//~End of UMassProcessor Interface
+
+protected:
+	/** Entities having a state machine. */
+	FMassEntityQuery EntityQuery;
+
+private:
+	/** Backend reused for every Mass chunk. */
+	FFSM_MassCrowdBackend Backend;
+};
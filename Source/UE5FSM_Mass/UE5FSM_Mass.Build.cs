@@ -0,0 +1,29 @@
+﻿// Author: Antonio Sidenko (Tonetfal). All rights reserved.
+
+using UnrealBuildTool;
+
+public class UE5FSM_Mass : ModuleRules
+{
+    public UE5FSM_Mass(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "GameplayTags",
+                "MassEntity",
+                "UE5FSM",
+            }
+        );
+
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "CoreUObject",
+                "Engine",
+            }
+        );
+    }
+}